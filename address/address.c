@@ -981,7 +981,8 @@ static void addr_set_local(struct Address *a, char *local_mailbox)
  * @retval ptr Address to display
  *
  * @warning This function may return a static pointer.  It must not be freed by
- * the caller.  Later calls may overwrite the returned pointer.
+ * the caller.  Later calls may overwrite the returned pointer.  It is only for
+ * the main thread; the header parsing workers must not call it.
  */
 const char *mutt_addr_for_display(const struct Address *a)
 {
@@ -328,6 +328,8 @@ struct AddressList *mutt_get_address(struct Envelope *env, const char **prefix)
   struct AddressList *al = NULL;
   const char *pfx = NULL;
 
+  mutt_env_lazy_restore(env);
+
   if (mutt_addr_is_user(TAILQ_FIRST(&env->from)))
   {
     if (!TAILQ_EMPTY(&env->to) && !mutt_is_mail_list(TAILQ_FIRST(&env->to)))
@@ -812,6 +812,38 @@ warn:
   return MUTT_CMD_WARNING;
 }
 
+#ifdef USE_HCACHE
+/**
+ * parse_hcache_compact - Parse the 'hcache-compact' command - Implements Command::parse()
+ *
+ * Remove the stale header cache records of the current mailbox, then compact
+ * the database.
+ */
+enum CommandResult parse_hcache_compact(struct Buffer *buf, struct Buffer *s,
+                                        intptr_t data, struct Buffer *err)
+{
+  if (MoreArgs(s))
+  {
+    mutt_buffer_printf(err, _("%s: too many arguments"), "hcache-compact");
+    return MUTT_CMD_WARNING;
+  }
+
+  if (!Context || !Context->mailbox)
+  {
+    mutt_buffer_strcpy(err, _("No mailbox is open"));
+    return MUTT_CMD_WARNING;
+  }
+
+  if (mx_mbox_gc(Context->mailbox, true) < 0)
+  {
+    mutt_buffer_strcpy(err, _("The header cache of this mailbox can't be compacted"));
+    return MUTT_CMD_ERROR;
+  }
+
+  return MUTT_CMD_SUCCESS;
+}
+#endif
+
 /**
  * parse_ifdef - Parse the 'ifdef' and 'ifndef' commands - Implements Command::parse()
  *
@@ -950,6 +950,7 @@ struct MxOps MxCompOps = {
   .msg_close        = comp_msg_close,
   .msg_padding_size = comp_msg_padding_size,
   .msg_save_hcache  = comp_msg_save_hcache,
+  .mbox_gc          = NULL,
   .tags_edit        = comp_tags_edit,
   .tags_commit      = comp_tags_commit,
   .path_probe       = comp_path_probe,
@@ -909,7 +909,7 @@ static void draw_envelope(struct ComposeRedrawData *rd)
     row += redraw_crypt_lines(rd, row);
 
 #ifdef MIXMASTER
-  redraw_mix_line(&e->chain, rd, row++);
+  redraw_mix_line(&e->cold->chain, rd, row++);
 #endif
 
   mutt_curses_set_color(MT_COLOR_STATUS);
@@ -2144,7 +2144,7 @@ int mutt_compose_menu(struct Email *e, struct Buffer *fcc, struct Email *e_cur,
         }
 
 #ifdef MIXMASTER
-        if (!STAILQ_EMPTY(&e->chain) && (mix_check_message(e) != 0))
+        if (!STAILQ_EMPTY(&e->cold->chain) && (mix_check_message(e) != 0))
           break;
 #endif
 
@@ -2495,7 +2495,7 @@ int mutt_compose_menu(struct Email *e, struct Buffer *fcc, struct Email *e_cur,
 
 #ifdef MIXMASTER
       case OP_COMPOSE_MIX:
-        mix_make_chain(rd->win_envelope, &e->chain, rd->win_envelope->state.cols);
+        mix_make_chain(rd->win_envelope, &e->cold->chain, rd->win_envelope->state.cols);
         mutt_message_hook(NULL, e, MUTT_SEND2_HOOK);
         redraw_env = true;
         break;
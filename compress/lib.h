@@ -42,11 +42,15 @@
  * Usage with Compression Level set to X:
  * - open(level X) -> N times compress() -> close()
  * - open(level X) -> N times decompress() -> close()
+ *
+ * Backends may also support dictionaries:
+ * - train() -> open(level X) -> set_dict() -> N times compress() -> close()
  */
 
 #ifndef MUTT_COMPRESS_LIB_H
 #define MUTT_COMPRESS_LIB_H
 
+#include <stdbool.h>
 #include <stdlib.h>
 
 /**
@@ -101,6 +105,28 @@ struct ComprOps
    *       allocated by open(), compress() or decompress()
    */
   void (*close)(void **cctx);
+
+  /**
+   * train - Create a dictionary from some sample data (optional)
+   * @param[in]  samples Sample data, one after another
+   * @param[in]  sizes   Length of each sample
+   * @param[in]  num     Number of samples
+   * @param[out] dlen    Length of the dictionary
+   * @retval ptr  Success, dictionary, must be freed by the caller
+   * @retval NULL Otherwise
+   */
+  void *(*train)(const void *samples, const size_t *sizes, size_t num, size_t *dlen);
+
+  /**
+   * set_dict - Use a dictionary for compression and decompression (optional)
+   * @param[in] cctx Compression context
+   * @param[in] dict Dictionary created by train()
+   * @param[in] dlen Length of the dictionary
+   * @retval true Success
+   *
+   * Data compressed without a dictionary can still be decompressed.
+   */
+  bool (*set_dict)(void *cctx, const void *dict, size_t dlen);
 };
 
 extern const struct ComprOps compr_lz4_ops;
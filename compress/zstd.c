@@ -25,10 +25,16 @@
  *
  * Zstandard (zstd) compression.
  * https://www.zstd.net
+ *
+ * Small records compress poorly on their own, so zstd can train a dictionary
+ * from sample records.  Once a dictionary is set, it's used for all the
+ * compression.  Records compressed without a dictionary can still be read.
  */
 
 #include "config.h"
+#include <stdbool.h>
 #include <stdio.h>
+#include <zdict.h>
 #include <zstd.h>
 #include "private.h"
 #include "mutt/lib.h"
@@ -37,6 +43,7 @@
 
 #define MIN_COMP_LEVEL 1  ///< Minimum compression level for zstd
 #define MAX_COMP_LEVEL 22 ///< Maximum compression level for zstd
+#define DICT_SIZE (16 * 1024) ///< Maximum size of a trained dictionary
 
 /**
  * struct ComprZstdCtx - Private Zstandard Compression Context
@@ -48,6 +55,10 @@ struct ComprZstdCtx
 
   ZSTD_CCtx *cctx; ///< Compression context
   ZSTD_DCtx *dctx; ///< Decompression context
+
+  ZSTD_CDict *cdict;    ///< Compression dictionary
+  ZSTD_DDict *ddict;    ///< Decompression dictionary
+  unsigned int dict_id; ///< Id of the dictionary
 };
 
 /**
@@ -55,7 +66,7 @@ struct ComprZstdCtx
  */
 static void *compr_zstd_open(short level)
 {
-  struct ComprZstdCtx *ctx = mutt_mem_malloc(sizeof(struct ComprZstdCtx));
+  struct ComprZstdCtx *ctx = mutt_mem_calloc(1, sizeof(struct ComprZstdCtx));
 
   ctx->buf = mutt_mem_malloc(ZSTD_compressBound(1024 * 128));
   ctx->cctx = ZSTD_createCCtx();
@@ -97,7 +108,11 @@ static void *compr_zstd_compress(void *cctx, const char *data, size_t dlen, size
   size_t len = ZSTD_compressBound(dlen);
   mutt_mem_realloc(&ctx->buf, len);
 
-  size_t ret = ZSTD_compressCCtx(ctx->cctx, ctx->buf, len, data, dlen, ctx->level);
+  size_t ret;
+  if (ctx->cdict)
+    ret = ZSTD_compress_usingCDict(ctx->cctx, ctx->buf, len, data, dlen, ctx->cdict);
+  else
+    ret = ZSTD_compressCCtx(ctx->cctx, ctx->buf, len, data, dlen, ctx->level);
   if (ZSTD_isError(ret))
     return NULL; // LCOV_EXCL_LINE
 
@@ -123,15 +138,76 @@ static void *compr_zstd_decompress(void *cctx, const char *cbuf, size_t clen)
     return NULL;
   else if (len == 0)
     return NULL; // LCOV_EXCL_LINE
+
+  /* Records written before the dictionary was created don't need it */
+  const unsigned int dict_id = ZSTD_getDictID_fromFrame(cbuf, clen);
+  if ((dict_id != 0) && (!ctx->ddict || (dict_id != ctx->dict_id)))
+    return NULL;
+
   mutt_mem_realloc(&ctx->buf, len);
 
-  size_t ret = ZSTD_decompressDCtx(ctx->dctx, ctx->buf, len, cbuf, clen);
+  size_t ret;
+  if (dict_id != 0)
+    ret = ZSTD_decompress_usingDDict(ctx->dctx, ctx->buf, len, cbuf, clen, ctx->ddict);
+  else
+    ret = ZSTD_decompressDCtx(ctx->dctx, ctx->buf, len, cbuf, clen);
   if (ZSTD_isError(ret))
     return NULL; // LCOV_EXCL_LINE
 
   return ctx->buf;
 }
 
+/**
+ * compr_zstd_train - Implements ComprOps::train()
+ */
+static void *compr_zstd_train(const void *samples, const size_t *sizes,
+                              size_t num, size_t *dlen)
+{
+  if (!samples || !sizes || (num == 0) || !dlen)
+    return NULL;
+
+  void *dict = mutt_mem_malloc(DICT_SIZE);
+  size_t ret = ZDICT_trainFromBuffer(dict, DICT_SIZE, samples, sizes, num);
+  if (ZDICT_isError(ret))
+  {
+    mutt_debug(LL_DEBUG1, "Can't train a zstd dictionary: %s\n", ZDICT_getErrorName(ret));
+    FREE(&dict);
+    return NULL;
+  }
+
+  *dlen = ret;
+  return dict;
+}
+
+/**
+ * compr_zstd_set_dict - Implements ComprOps::set_dict()
+ */
+static bool compr_zstd_set_dict(void *cctx, const void *dict, size_t dlen)
+{
+  if (!cctx || !dict || (dlen == 0))
+    return false;
+
+  struct ComprZstdCtx *ctx = cctx;
+
+  ZSTD_CDict *cdict = ZSTD_createCDict(dict, dlen, ctx->level);
+  ZSTD_DDict *ddict = ZSTD_createDDict(dict, dlen);
+  const unsigned int dict_id = ZSTD_getDictID_fromDict(dict, dlen);
+  if (!cdict || !ddict || (dict_id == 0))
+  {
+    ZSTD_freeCDict(cdict);
+    ZSTD_freeDDict(ddict);
+    return false;
+  }
+
+  ZSTD_freeCDict(ctx->cdict);
+  ZSTD_freeDDict(ctx->ddict);
+  ctx->cdict = cdict;
+  ctx->ddict = ddict;
+  ctx->dict_id = dict_id;
+
+  return true;
+}
+
 /**
  * compr_zstd_close - Implements ComprOps::close()
  */
@@ -148,8 +224,11 @@ static void compr_zstd_close(void **cctx)
   if (ctx->dctx)
     ZSTD_freeDCtx(ctx->dctx);
 
+  ZSTD_freeCDict(ctx->cdict);
+  ZSTD_freeDDict(ctx->ddict);
+
   FREE(&ctx->buf);
   FREE(cctx);
 }
 
-COMPRESS_OPS(zstd, MIN_COMP_LEVEL, MAX_COMP_LEVEL)
+COMPRESS_DICT_OPS(zstd, MIN_COMP_LEVEL, MAX_COMP_LEVEL)
@@ -97,6 +97,32 @@ static void ctx_cleanup(struct Context *ctx)
   ctx->mailbox = m;
 }
 
+/**
+ * ctx_threaded_count - Count the emails that are already in the threads
+ * @param ctx Mailbox
+ * @retval num Number of threaded emails
+ * @retval 0   The threads must be rebuilt
+ *
+ * The threaded emails come first.  If new mail has just been appended to the
+ * Mailbox, the threads are still valid and only the new emails need threading.
+ */
+static int ctx_threaded_count(struct Context *ctx)
+{
+  struct Mailbox *m = ctx->mailbox;
+
+  if (!ctx->tree || (ctx->msg_threaded == 0) || (ctx->msg_threaded > m->msg_count))
+    return 0;
+
+  for (int i = 0; i < m->msg_count; i++)
+  {
+    struct Email *e = m->emails[i];
+    if (!e || ((i < ctx->msg_threaded) != (e->thread != NULL)))
+      return 0;
+  }
+
+  return ctx->msg_threaded;
+}
+
 /**
  * ctx_update - Update the Context's message counts
  * @param ctx          Mailbox
@@ -110,8 +136,13 @@ void ctx_update(struct Context *ctx)
 
   struct Mailbox *m = ctx->mailbox;
 
-  mutt_hash_free(&m->subj_hash);
-  mutt_hash_free(&m->id_hash);
+  /* new mail doesn't invalidate the threads, or the hash tables */
+  const int threaded = ctx_threaded_count(ctx);
+  if (threaded == 0)
+  {
+    mutt_hash_free(&m->subj_hash);
+    mutt_hash_free(&m->id_hash);
+  }
 
   /* reset counters */
   m->msg_unread = 0;
@@ -119,10 +150,15 @@ void ctx_update(struct Context *ctx)
   m->msg_new = 0;
   m->msg_deleted = 0;
   m->msg_tagged = 0;
-  m->vcount = 0;
   m->changed = false;
 
-  mutt_clear_threads(ctx);
+  /* nothing has changed since the emails were sorted */
+  const bool sorted = (threaded == m->msg_count);
+  if (!sorted)
+    m->vcount = 0;
+
+  if (threaded == 0)
+    mutt_clear_threads(ctx);
 
   struct Email *e = NULL;
   for (int msgno = 0; msgno < m->msg_count; msgno++)
@@ -131,48 +167,54 @@ void ctx_update(struct Context *ctx)
     if (!e)
       continue;
 
-    if (WithCrypto)
-    {
-      /* NOTE: this _must_ be done before the check for mailcap! */
-      e->security = crypt_query(e->content);
-    }
-
-    if (ctx->pattern)
+    if (!sorted)
     {
-      e->vnum = -1;
-    }
-    else
-    {
-      m->v2r[m->vcount] = msgno;
-      e->vnum = m->vcount++;
+      if (ctx->pattern)
+      {
+        e->vnum = -1;
+      }
+      else
+      {
+        m->v2r[m->vcount] = msgno;
+        e->vnum = m->vcount++;
+      }
+      e->msgno = msgno;
     }
-    e->msgno = msgno;
 
-    if (e->env->supersedes)
+    if (msgno >= threaded)
     {
-      struct Email *e2 = NULL;
-
-      if (!m->id_hash)
-        m->id_hash = mutt_make_id_hash(m);
+      if (WithCrypto)
+      {
+        /* NOTE: this _must_ be done before the check for mailcap! */
+        e->security = crypt_query(e->content);
+      }
 
-      e2 = mutt_hash_find(m->id_hash, e->env->supersedes);
-      if (e2)
+      if (e->env->supersedes)
       {
-        e2->superseded = true;
-        if (C_Score)
-          mutt_score_message(ctx->mailbox, e2, true);
+        struct Email *e2 = NULL;
+
+        if (!m->id_hash)
+          m->id_hash = mutt_make_id_hash(m);
+
+        e2 = mutt_hash_find(m->id_hash, e->env->supersedes);
+        if (e2)
+        {
+          e2->superseded = true;
+          if (C_Score)
+            mutt_score_message(ctx->mailbox, e2, true);
+        }
       }
-    }
 
-    /* add this message to the hash tables */
-    if (m->id_hash && e->env->message_id)
-      mutt_hash_insert(m->id_hash, e->env->message_id, e);
-    if (m->subj_hash && e->env->real_subj)
-      mutt_hash_insert(m->subj_hash, e->env->real_subj, e);
-    mutt_label_hash_add(m, e);
+      /* add this message to the hash tables */
+      if (m->id_hash && e->env->message_id)
+        mutt_hash_insert(m->id_hash, e->env->message_id, e);
+      if (m->subj_hash && e->env->real_subj)
+        mutt_hash_insert(m->subj_hash, e->env->real_subj, e);
+      mutt_label_hash_add(m, e);
 
-    if (C_Score)
-      mutt_score_message(ctx->mailbox, e, false);
+      if (C_Score)
+        mutt_score_message(ctx->mailbox, e, false);
+    }
 
     if (e->changed)
       m->changed = true;
@@ -190,7 +232,10 @@ void ctx_update(struct Context *ctx)
     }
   }
 
-  mutt_sort_headers(ctx, true); /* rethread from scratch */
+  if (threaded == 0)
+    mutt_sort_headers(ctx, true); /* rethread from scratch */
+  else if (!sorted)
+    mutt_sort_headers(ctx, false); /* thread the new mail */
 }
 
 /**
@@ -41,6 +41,7 @@ struct Context
   struct PatternList *limit_pattern; ///< Compiled limit pattern
   struct MuttThread *tree;           ///< Top of thread tree
   struct HashTable *thread_hash;     ///< Hash Table for threading
+  int msg_threaded;                  ///< Number of emails in the thread tree
   int msg_not_read_yet;              ///< Which msg "new" in pager, -1 if none
 
   struct Menu *menu;                 ///< Needed for pattern compilation
@@ -410,7 +410,7 @@ int mutt_copy_header(FILE *fp_in, struct Email *e, FILE *fp_out,
                ((e->env->changed & MUTT_ENV_CHANGED_SUBJECT) ? CH_UPDATE_SUBJECT : 0);
   }
 
-  if (mutt_copy_hdr(fp_in, fp_out, e->offset, e->content->offset, chflags,
+  if (mutt_copy_hdr(fp_in, fp_out, e->cold->offset, e->content->offset, chflags,
                     prefix, wraplen) == -1)
     return -1;
 
@@ -493,7 +493,7 @@ int mutt_copy_header(FILE *fp_in, struct Email *e, FILE *fp_out,
     }
   }
 #endif
-  char *tags = driver_tags_get(&e->tags);
+  char *tags = driver_tags_get(&e->cold->tags);
   if (tags && !(C_Weed && mutt_matches_ignore("tags")))
   {
     fputs("Tags: ", fp_out);
@@ -864,7 +864,7 @@ static int append_message(struct Mailbox *dest, FILE *fp_in, struct Mailbox *src
   struct Message *msg = NULL;
   int rc;
 
-  if (fseeko(fp_in, e->offset, SEEK_SET) < 0)
+  if (fseeko(fp_in, e->cold->offset, SEEK_SET) < 0)
     return -1;
   if (!fgets(buf, sizeof(buf), fp_in))
     return -1;
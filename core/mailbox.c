@@ -71,6 +71,8 @@ void mailbox_free(struct Mailbox **ptr)
 
   for (size_t i = 0; i < m->email_max; i++)
     email_free(&m->emails[i]);
+  mutt_arena_free(&m->arena);
+  mutt_arena_free(&m->arena_parts);
 
   mutt_buffer_dealloc(&m->pathbuf);
   cs_subset_free(&m->sub);
@@ -97,6 +97,8 @@ struct Mailbox
   int msg_tagged;                     ///< How many messages are tagged?
 
   struct Email **emails;              ///< Array of Emails
+  struct Arena *arena;                ///< Memory for the Emails read when opening the Mailbox
+  struct Arena *arena_parts;          ///< Memory for their Envelopes, Bodies and EmailColds
   int email_max;                      ///< Number of pointers in emails
   int *v2r;                           ///< Mapping from virtual to real msgno
   int vcount;                         ///< The number of virtual messages
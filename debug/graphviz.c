@@ -1293,7 +1293,7 @@ static void dot_email(FILE *fp, struct Email *e, struct ListHead *links)
 
   dot_object_header(fp, e, "Email", "#ff80ff");
 
-  dot_type_string(fp, "path", e->path, true);
+  dot_type_string(fp, "path", e->cold->path, true);
 
 #define ADD_BOOL(F) add_flag(&buf, e->F, #F)
   ADD_BOOL(active);
@@ -1344,7 +1344,7 @@ static void dot_email(FILE *fp, struct Email *e, struct ListHead *links)
                   mutt_buffer_is_empty(&buf) ? "[NONE]" : mutt_b2s(&buf), true);
 
   dot_type_number(fp, "num_hidden", e->num_hidden);
-  dot_type_number(fp, "offset", e->offset);
+  dot_type_number(fp, "offset", e->cold->offset);
   dot_type_number(fp, "lines", e->lines);
   dot_type_number(fp, "index", e->index);
   dot_type_number(fp, "msgno", e->msgno);
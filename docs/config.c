@@ -1493,8 +1493,46 @@
 ** When NeoMutt is compiled with lz4, zstd or zlib, the header cache backend
 ** can use these compression methods for compressing the cache files.
 ** This results in much smaller cache file sizes and may even improve speed.
+** .pp
+** With zstd, the first records that are saved are used to train a
+** compression dictionary, which is stored in the cache.  Headers are very
+** similar to each other, so this makes the cache smaller still.
 */
 #endif
+
+{ "header_cache_lazy", DT_BOOL, false },
+/*
+** .pp
+** When \fIset\fP, NeoMutt will only decode the headers needed to display the
+** index when reading an email from the header cache.  The rest, e.g.
+** Bcc:, Reply-To: and any user-defined headers, are decoded the first time
+** they're needed.  This speeds up opening large mailboxes.
+*/
+
+{ "header_cache_memory", DT_LONG, 0 },
+/*
+** .pp
+** The amount of memory, in kilobytes, that NeoMutt may use to keep header
+** cache records in memory, for all the databases together.  Records that
+** were used recently are kept after their folder is closed, so reopening it
+** is faster.  If the database has been recreated, or changed by another
+** process, in the meantime, its records are discarded instead.
+** When the limit is reached, the least-recently used records are discarded.
+** The number of records found in memory is written to the debug log.
+** .pp
+** A value of 0 disables the memory cache.
+*/
+
+{ "header_cache_shared", DT_BOOL, false },
+/*
+** .pp
+** When \fIset\fP, and $$header_cache is a directory, all the folders of an
+** account share one database, e.g. one for each IMAP server and one for all
+** the local mailboxes.  The records are identified by the folder name.
+** .pp
+** The database stays open while any of the account's folders is using it.
+** It is closed, and its locks released, when the last one is done with it.
+*/
 #endif
 
 { "header_color_partial", DT_BOOL, false },
@@ -2179,6 +2217,25 @@
 */
 #endif
 
+#ifdef USE_PTHREADS
+{ "maildir_parse_threads", DT_NUMBER, 0 },
+/*
+** .pp
+** The number of threads NeoMutt uses to read the headers of new messages
+** when opening a Maildir or MH folder.  Messages that are found in the
+** header cache aren't affected.  Reading many messages on a fast disk is
+** mostly limited by the CPU, so using one thread per core can make opening
+** large folders much quicker.
+** .pp
+** The threads are also used to read the Maildir ``new'' and ``cur''
+** directories at the same time and, if $$maildir_header_cache_verify is set,
+** to check the files of cached messages.  On network storage, these are
+** limited by the latency of the server, so more threads than cores can help.
+** .pp
+** If this is 0 or 1, the messages are read one at a time.
+*/
+#endif
+
 { "maildir_trash", DT_BOOL, false },
 /*
 ** .pp
@@ -3889,6 +3946,24 @@
 ** before search results. By default, search results will be top-aligned.
 */
 
+#ifdef USE_PTHREADS
+{ "search_threads", DT_NUMBER, 0 },
+/*
+** .pp
+** The number of threads NeoMutt uses to match a pattern against the
+** messages of a local (mbox, MMDF, Maildir or MH) folder, when limiting,
+** tagging or deleting.  Matching the body or header of many messages is
+** mostly limited by the CPU, so using one thread per core makes it quicker.
+** .pp
+** Only patterns that just read the messages are matched in parallel, e.g.
+** thread patterns like \fC~(...)\fP aren't.  If $$thorough_search is set,
+** only the bodies of plain text messages, which don't need decoding, are
+** searched in parallel.  The other messages are searched one at a time.
+** .pp
+** If this is 0 or 1, the messages are searched one at a time.
+*/
+#endif
+
 { "send_charset", DT_STRING, "us-ascii:iso-8859-1:utf-8" },
 /*
 ** .pp
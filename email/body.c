@@ -33,16 +33,20 @@
 #include "body.h"
 #include "email.h"
 #include "envelope.h"
+#include "globals.h"
 #include "mime.h"
 #include "parameter.h"
 
 /**
  * mutt_body_new - Create a new Body
  * @retval ptr Newly allocated Body
+ *
+ * If #EnvelopeArena is set, the Body is allocated from it.
  */
 struct Body *mutt_body_new(void)
 {
-  struct Body *p = mutt_mem_calloc(1, sizeof(struct Body));
+  struct Body *p = mutt_arena_calloc(EnvelopeArena, sizeof(struct Body));
+  p->arena = (EnvelopeArena != NULL);
 
   p->disposition = DISP_ATTACH;
   p->use_disp = true;
@@ -93,7 +97,8 @@ void mutt_body_free(struct Body **ptr)
 
     mutt_env_free(&b->mime_headers);
     mutt_body_free(&b->parts);
-    FREE(&b);
+    if (!b->arena)
+      FREE(&b);
   }
 
   *ptr = NULL;
@@ -81,6 +81,7 @@ struct Body
 
   bool collapsed : 1;             ///< Used by recvattach
   bool attach_qualifies : 1;      ///< This attachment should be counted
+  bool arena : 1;                 ///< Allocated from an Arena, freed with it
 };
 
 bool         mutt_body_cmp_strict(const struct Body *b1, const struct Body *b2);
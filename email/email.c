@@ -32,6 +32,7 @@
 #include "email.h"
 #include "body.h"
 #include "envelope.h"
+#include "globals.h"
 #include "tags.h"
 
 void nm_edata_free(void **ptr);
@@ -46,36 +47,55 @@ void email_free(struct Email **ptr)
     return;
 
   struct Email *e = *ptr;
+  struct EmailCold *cold = e->cold;
 
-  if (e->edata && e->edata_free)
-    e->edata_free(&e->edata);
+  if (cold)
+  {
+    if (cold->edata && cold->edata_free)
+      cold->edata_free(&cold->edata);
 
-  mutt_env_free(&e->env);
-  mutt_body_free(&e->content);
-  FREE(&e->tree);
-  FREE(&e->path);
+    FREE(&cold->tree);
+    FREE(&cold->path);
 #ifdef MIXMASTER
-  mutt_list_free(&e->chain);
+    mutt_list_free(&cold->chain);
 #endif
 #ifdef USE_NOTMUCH
-  nm_edata_free(&e->nm_edata);
+    nm_edata_free(&cold->nm_edata);
 #endif
-  driver_tags_free(&e->tags);
+    driver_tags_free(&cold->tags);
+
+    if (e->cold_arena)
+      e->cold = NULL;
+    else
+      FREE(&e->cold);
+  }
 
-  FREE(ptr);
+  mutt_env_free(&e->env);
+  mutt_body_free(&e->content);
+
+  if (e->arena)
+    *ptr = NULL;
+  else
+    FREE(ptr);
 }
 
 /**
  * email_new - Create a new Email
  * @retval ptr Newly created Email
+ *
+ * If #EmailArena is set, the Email is allocated from it.  If #EnvelopeArena is
+ * set, its EmailCold is allocated from that, away from the other Emails.
  */
 struct Email *email_new(void)
 {
-  struct Email *e = mutt_mem_calloc(1, sizeof(struct Email));
+  struct Email *e = mutt_arena_calloc(EmailArena, sizeof(struct Email));
+  e->arena = (EmailArena != NULL);
+  e->cold = mutt_arena_calloc(EnvelopeArena, sizeof(struct EmailCold));
+  e->cold_arena = (EnvelopeArena != NULL);
 #ifdef MIXMASTER
-  STAILQ_INIT(&e->chain);
+  STAILQ_INIT(&e->cold->chain);
 #endif
-  STAILQ_INIT(&e->tags);
+  STAILQ_INIT(&e->cold->tags);
   return e;
 }
 
@@ -85,7 +105,7 @@ struct Email *email_new(void)
  * @param e2 Second Email
  * @retval true Emails are strictly identical
  */
-bool email_cmp_strict(const struct Email *e1, const struct Email *e2)
+bool email_cmp_strict(struct Email *e1, struct Email *e2)
 {
   if (e1 && e2)
   {
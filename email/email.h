@@ -31,8 +31,47 @@
 #include "tags.h"
 #include "ncrypt/lib.h"
 
+/**
+ * struct EmailCold - The rarely used parts of an Email
+ *
+ * These are only needed for one Email at a time, e.g. when it's opened,
+ * synced or drawn, so they're kept out of the way of the sort and limit
+ * passes, which read every Email.
+ */
+struct EmailCold
+{
+  LOFF_T offset;               ///< Where in the stream does this message begin?
+  char *path;                  ///< Path of Email (for local Mailboxes)
+  char *tree;                  ///< Character string to print thread tree
+
+#ifdef MIXMASTER
+  struct ListHead chain;       ///< Mixmaster chain
+#endif
+
+#ifdef USE_NOTMUCH
+  void *nm_edata;              ///< Notmuch private data
+#endif
+
+  struct TagList tags;         ///< For drivers that support server tagging
+
+  void *edata;                    ///< Driver-specific data
+
+  /**
+   * edata_free - Free the private data attached to the Email
+   * @param ptr Private data to be freed
+   */
+  void (*edata_free)(void **ptr);
+
+  struct Notify *notify;          ///< Notifications handler
+};
+
 /**
  * struct Email - The envelope/body of an email
+ *
+ * An Email only holds the fields read by every sort, limit and redraw of the
+ * index.  While a Mailbox is open, its Emails are allocated from one Arena, so
+ * those passes walk a dense array.  The rest of the data is behind
+ * Email::cold, allocated separately.
  */
 struct Email
 {
@@ -58,6 +97,8 @@ struct Email
   bool recip_valid     : 1;    ///< Is_recipient is valid
   bool active          : 1;    ///< Message is not to be removed
   bool trash           : 1;    ///< Message is marked as trashed on disk (used by the maildir_trash option)
+  bool arena           : 1;    ///< Allocated from an Arena, freed with it
+  bool cold_arena      : 1;    ///< Email::cold was allocated from an Arena
 
   // timezone of the sender of this message
   unsigned int zhours   : 5;   ///< Hours away from UTC
@@ -72,49 +113,24 @@ struct Email
   // the following are used to support collapsing threads
   bool collapsed : 1;          ///< Is this message part of a collapsed thread?
   bool limited   : 1;          ///< Is this message in a limited view?
-  size_t num_hidden;           ///< Number of hidden messages in this view
-                               ///< (only valid when collapsed is set)
-
-  short recipient;             ///< User_is_recipient()'s return value, cached
-
-  int pair;                    ///< Color-pair to use when displaying in the index
 
   time_t date_sent;            ///< Time when the message was sent (UTC)
   time_t received;             ///< Time when the message was placed in the mailbox
-  LOFF_T offset;               ///< Where in the stream does this message begin?
-  int lines;                   ///< How many lines in the body of this message?
   int index;                   ///< The absolute (unsorted) message number
   int msgno;                   ///< Number displayed to the user
   int vnum;                    ///< Virtual message number
   int score;                   ///< Message score
   struct Envelope *env;        ///< Envelope information
   struct Body *content;        ///< List of MIME parts
-  char *path;                  ///< Path of Email (for local Mailboxes)
-
-  char *tree;                  ///< Character string to print thread tree
   struct MuttThread *thread;   ///< Thread of Emails
 
+  int pair;                    ///< Color-pair to use when displaying in the index
+  int lines;                   ///< How many lines in the body of this message?
+  short recipient;             ///< User_is_recipient()'s return value, cached
   short attach_total;          ///< Number of qualifying attachments in message, if attach_valid
-
-#ifdef MIXMASTER
-  struct ListHead chain;       ///< Mixmaster chain
-#endif
-
-#ifdef USE_NOTMUCH
-  void *nm_edata;              ///< Notmuch private data
-#endif
-
-  struct TagList tags;         ///< For drivers that support server tagging
-
-  void *edata;                    ///< Driver-specific data
-
-  /**
-   * edata_free - Free the private data attached to the Email
-   * @param ptr Private data to be freed
-   */
-  void (*edata_free)(void **ptr);
-
-  struct Notify *notify;          ///< Notifications handler
+  size_t num_hidden;           ///< Number of hidden messages in this view
+                               ///< (only valid when collapsed is set)
+  struct EmailCold *cold;      ///< Rarely used data
 };
 
 /**
@@ -147,7 +163,7 @@ struct EventEmail
   struct Email **emails;
 };
 
-bool          email_cmp_strict(const struct Email *e1, const struct Email *e2);
+bool          email_cmp_strict(struct Email *e1, struct Email *e2);
 void          email_free      (struct Email **ptr);
 struct Email *email_new       (void);
 size_t        email_size      (const struct Email *e);
@@ -34,14 +34,18 @@
 #include "mutt/lib.h"
 #include "address/lib.h"
 #include "envelope.h"
+#include "globals.h"
 
 /**
  * mutt_env_new - Create a new Envelope
  * @retval ptr New Envelope
+ *
+ * If #EnvelopeArena is set, the Envelope is allocated from it.
  */
 struct Envelope *mutt_env_new(void)
 {
-  struct Envelope *e = mutt_mem_calloc(1, sizeof(struct Envelope));
+  struct Envelope *e = mutt_arena_calloc(EnvelopeArena, sizeof(struct Envelope));
+  e->arena = (EnvelopeArena != NULL);
   TAILQ_INIT(&e->return_path);
   TAILQ_INIT(&e->from);
   TAILQ_INIT(&e->to);
@@ -110,15 +114,15 @@ void mutt_env_free(struct Envelope **ptr)
   mutt_addrlist_clear(&env->mail_followup_to);
   mutt_addrlist_clear(&env->x_original_to);
 
-  FREE(&env->list_post);
+  mutt_intern_release(&env->list_post);
   FREE(&env->subject);
   /* real_subj is just an offset to subject and shouldn't be freed */
   FREE(&env->disp_subj);
   FREE(&env->message_id);
   FREE(&env->supersedes);
   FREE(&env->date);
-  FREE(&env->x_label);
-  FREE(&env->organization);
+  mutt_intern_release(&env->x_label);
+  mutt_intern_release(&env->organization);
 #ifdef USE_NNTP
   FREE(&env->newsgroups);
   FREE(&env->xref);
@@ -137,7 +141,29 @@ void mutt_env_free(struct Envelope **ptr)
   mutt_autocrypthdr_free(&env->autocrypt_gossip);
 #endif
 
-  FREE(ptr);
+  FREE(&env->lazy);
+
+  if (env->arena)
+    *ptr = NULL;
+  else
+    FREE(ptr);
+}
+
+/**
+ * mutt_env_lazy_restore - Decode any fields that were deferred
+ * @param env Envelope
+ *
+ * The header cache can leave the rarely used fields of an Envelope undecoded
+ * until they're needed.  Call this before reading any of:
+ * return_path, bcc, sender, reply_to, mail_followup_to, date, organization,
+ * userhdrs, followup_to or x_comment_to.
+ */
+void mutt_env_lazy_restore(struct Envelope *env)
+{
+  if (!env || !env->lazy || !env->lazy_restore)
+    return;
+
+  env->lazy_restore(env);
 }
 
 /**
@@ -153,6 +179,9 @@ void mutt_env_merge(struct Envelope *base, struct Envelope **extra)
   if (!base || !extra || !*extra)
     return;
 
+  mutt_env_lazy_restore(base);
+  mutt_env_lazy_restore(*extra);
+
 /* copies each existing element if necessary, and sets the element
  * to NULL in the source so that mutt_env_free doesn't leave us
  * with dangling pointers. */
@@ -237,11 +266,17 @@ void mutt_env_merge(struct Envelope *base, struct Envelope **extra)
  * @param e1 First Envelope
  * @param e2 Second Envelope
  * @retval true Envelopes are strictly identical
+ *
+ * Some of the fields compared may be deferred, so both Envelopes are restored
+ * first, see mutt_env_lazy_restore().
  */
-bool mutt_env_cmp_strict(const struct Envelope *e1, const struct Envelope *e2)
+bool mutt_env_cmp_strict(struct Envelope *e1, struct Envelope *e2)
 {
   if (e1 && e2)
   {
+    mutt_env_lazy_restore(e1);
+    mutt_env_lazy_restore(e2);
+
     if (!mutt_str_equal(e1->message_id, e2->message_id) ||
         !mutt_str_equal(e1->subject, e2->subject) ||
         !mutt_list_compare(&e1->references, &e2->references) ||
@@ -273,6 +308,7 @@ void mutt_env_to_local(struct Envelope *env)
   if (!env)
     return;
 
+  mutt_env_lazy_restore(env);
   mutt_addrlist_to_local(&env->return_path);
   mutt_addrlist_to_local(&env->from);
   mutt_addrlist_to_local(&env->to);
@@ -311,6 +347,8 @@ int mutt_env_to_intl(struct Envelope *env, const char **tag, char **err)
   if (!env)
     return 1;
 
+  mutt_env_lazy_restore(env);
+
   int e = 0;
   H_TO_INTL(return_path);
   H_TO_INTL(from);
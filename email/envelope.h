@@ -62,15 +62,15 @@ struct Envelope
   struct AddressList reply_to;         ///< Email's 'reply-to'
   struct AddressList mail_followup_to; ///< Email's 'mail-followup-to'
   struct AddressList x_original_to;    ///< Email's 'X-Orig-to'
-  char *list_post;                     ///< This stores a mailto URL, or nothing
+  char *list_post;                     ///< This stores a mailto URL, or nothing (shared, set with mutt_intern_replace())
   char *subject;                       ///< Email's subject
   char *real_subj;                     ///< Offset of the real subject
   char *disp_subj;                     ///< Display subject (modified copy of subject)
   char *message_id;                    ///< Message ID
   char *supersedes;                    ///< Supersedes header
   char *date;                          ///< Sent date
-  char *x_label;                       ///< X-Label
-  char *organization;                  ///< Organisation header
+  char *x_label;                       ///< X-Label (shared, set with mutt_intern_replace())
+  char *organization;                  ///< Organisation header (shared, set with mutt_intern_get())
 #ifdef USE_NNTP
   char *newsgroups;                    ///< List of newsgroups
   char *xref;                          ///< List of cross-references
@@ -86,10 +86,21 @@ struct Envelope
   struct AutocryptHeader *autocrypt_gossip;
 #endif
   unsigned char changed;               ///< Changed fields, e.g. #MUTT_ENV_CHANGED_SUBJECT
+  bool arena;                          ///< Allocated from an Arena, freed with it
+  void *lazy;                          ///< Fields not yet decoded, see mutt_env_lazy_restore()
+
+  /**
+   * lazy_restore - Decode the lazy fields
+   * @param env Envelope
+   *
+   * The function must decode all the fields and free the lazy data.
+   */
+  void (*lazy_restore)(struct Envelope *env);
 };
 
-bool             mutt_env_cmp_strict(const struct Envelope *e1, const struct Envelope *e2);
+bool             mutt_env_cmp_strict(struct Envelope *e1, struct Envelope *e2);
 void             mutt_env_free      (struct Envelope **ptr);
+void             mutt_env_lazy_restore(struct Envelope *env);
 void             mutt_env_merge     (struct Envelope *base, struct Envelope **extra);
 struct Envelope *mutt_env_new       (void);
 int              mutt_env_to_intl   (struct Envelope *env, const char **tag, char **err);
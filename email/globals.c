@@ -40,6 +40,8 @@ char *C_SpamSeparator = NULL; ///< Config: Separator for multiple spam headers
 bool C_Weed = false; ///< Config: Filter headers when displaying/forwarding/printing/replying
 
 /* Global variables */
+struct Arena *EmailArena = NULL;
+struct Arena *EnvelopeArena = NULL;
 struct RegexList NoSpamList = STAILQ_HEAD_INITIALIZER(NoSpamList);
 struct ReplaceList SpamList = STAILQ_HEAD_INITIALIZER(SpamList);
 struct ListHead Ignore = STAILQ_HEAD_INITIALIZER(Ignore);
@@ -35,6 +35,8 @@ extern char *        C_SpamSeparator;
 extern bool          C_Weed;
 
 /* Global variables */
+extern struct Arena *EmailArena;            ///< Allocate new Emails from here
+extern struct Arena *EnvelopeArena;         ///< Allocate new Envelopes, Bodies and EmailColds from here
 extern struct ListHead Ignore;              ///< List of header patterns to ignore
 extern struct RegexList NoSpamList;         ///< List of regexes to whitelist non-spam emails
 extern struct ReplaceList SpamList;         ///< List of regexes and patterns to match spam emails
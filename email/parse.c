@@ -31,6 +31,9 @@
 #include <ctype.h>
 #include <string.h>
 #include <time.h>
+#ifdef USE_PTHREADS
+#include <pthread.h>
+#endif
 #include "mutt/lib.h"
 #include "address/lib.h"
 #include "mutt.h"
@@ -57,10 +60,21 @@
  * Cap the value to prevent overflow of Body.length */
 #define CONTENT_TOO_BIG (1 << 30)
 
-static void parse_part(FILE *fp, struct Body *b, int *counter);
-static struct Body *rfc822_parse_message(FILE *fp, struct Body *parent, int *counter);
-static struct Body *parse_multipart(FILE *fp, const char *boundary,
-                                    LOFF_T end_off, bool digest, int *counter);
+#ifdef USE_PTHREADS
+/* Emails may be parsed by worker threads, e.g. maildir_parse_parallel() */
+static pthread_mutex_t AutoSubscribeLock = PTHREAD_MUTEX_INITIALIZER;
+#define subscribe_lock() pthread_mutex_lock(&AutoSubscribeLock)
+#define subscribe_unlock() pthread_mutex_unlock(&AutoSubscribeLock)
+#else
+#define subscribe_lock()
+#define subscribe_unlock()
+#endif
+
+static void parse_part(FILE *fp, struct Body *b, int *counter, int depth);
+static struct Body *rfc822_parse_message(FILE *fp, struct Body *parent,
+                                         int *counter, int depth);
+static struct Body *parse_multipart(FILE *fp, const char *boundary, LOFF_T end_off,
+                                    bool digest, int *counter, int depth);
 
 /**
  * mutt_auto_subscribe - Check if user is subscribed to mailing list
@@ -71,19 +85,24 @@ void mutt_auto_subscribe(const char *mailto)
   if (!mailto)
     return;
 
+  subscribe_lock();
   if (!AutoSubscribeCache)
     AutoSubscribeCache = mutt_hash_new(200, MUTT_HASH_STRCASECMP | MUTT_HASH_STRDUP_KEYS);
 
-  if (mutt_hash_find(AutoSubscribeCache, mailto))
-    return;
+  const bool seen = mutt_hash_find(AutoSubscribeCache, mailto);
+  if (!seen)
+    mutt_hash_insert(AutoSubscribeCache, mailto, AutoSubscribeCache);
+  subscribe_unlock();
 
-  mutt_hash_insert(AutoSubscribeCache, mailto, AutoSubscribeCache);
+  if (seen)
+    return;
 
   struct Envelope *lpenv = mutt_env_new(); /* parsed envelope from the List-Post mailto: URL */
 
   if (mutt_parse_mailto(lpenv, NULL, mailto) && !TAILQ_EMPTY(&lpenv->to))
   {
     const char *mailbox = TAILQ_FIRST(&lpenv->to)->mailbox;
+    subscribe_lock();
     if (mailbox && !mutt_regexlist_match(&SubscribedLists, mailbox) &&
         !mutt_regexlist_match(&UnMailLists, mailbox) &&
         !mutt_regexlist_match(&UnSubscribedLists, mailbox))
@@ -93,6 +112,7 @@ void mutt_auto_subscribe(const char *mailto)
       mutt_regexlist_add(&MailLists, mailbox, REG_ICASE, NULL);
       mutt_regexlist_add(&SubscribedLists, mailbox, REG_ICASE, NULL);
     }
+    subscribe_unlock();
   }
 
   mutt_env_free(&lpenv);
@@ -514,8 +534,9 @@ void mutt_parse_content_type(const char *s, struct Body *ct)
     }
     else
     {
+      char cs[128];
       mutt_param_set(&ct->parameter, "charset",
-                     (C_AssumedCharset) ? (const char *) mutt_ch_get_default_charset() :
+                     (C_AssumedCharset) ? mutt_ch_get_default_charset(cs, sizeof(cs)) :
                                           "us-ascii");
     }
   }
@@ -778,8 +799,8 @@ int mutt_rfc822_parse_line(struct Envelope *env, struct Email *e, char *line,
             /* Take the first mailto URL */
             if (url_check_scheme(mlist) == U_MAILTO)
             {
-              FREE(&env->list_post);
-              env->list_post = mlist;
+              mutt_intern_replace(&env->list_post, mlist);
+              FREE(&mlist);
               if (C_AutoSubscribe)
                 mutt_auto_subscribe(env->list_post);
 
@@ -844,7 +865,7 @@ int mutt_rfc822_parse_line(struct Envelope *env, struct Email *e, char *line,
       if (mutt_istr_equal(line + 1, "rganization"))
       {
         if (!env->organization && !mutt_istr_equal(p, "unknown"))
-          env->organization = mutt_str_dup(p);
+          env->organization = mutt_intern_get(p);
       }
       break;
 
@@ -976,8 +997,7 @@ int mutt_rfc822_parse_line(struct Envelope *env, struct Email *e, char *line,
       }
       else if (mutt_istr_equal(line + 1, "-label"))
       {
-        FREE(&env->x_label);
-        env->x_label = mutt_str_dup(p);
+        mutt_intern_replace(&env->x_label, p);
         matched = true;
       }
 #ifdef USE_NNTP
@@ -1214,7 +1234,7 @@ struct Envelope *mutt_rfc822_read_header(FILE *fp, struct Email *e, bool user_hd
 
   if (e)
   {
-    e->content->hdr_offset = e->offset;
+    e->content->hdr_offset = e->cold->offset;
     e->content->offset = ftello(fp);
 
     rfc2047_decode_envelope(env);
@@ -1378,21 +1398,20 @@ bool mutt_is_message_type(int type, const char *subtype)
  * @param fp      File to read from
  * @param b       Body to store the results in
  * @param counter Number of parts processed so far
+ * @param depth   Nesting level of this part
  */
-static void parse_part(FILE *fp, struct Body *b, int *counter)
+static void parse_part(FILE *fp, struct Body *b, int *counter, int depth)
 {
   if (!fp || !b)
     return;
 
   const char *bound = NULL;
-  static unsigned short recurse_level = 0;
 
-  if (recurse_level >= MUTT_MIME_MAX_DEPTH)
+  if (depth >= MUTT_MIME_MAX_DEPTH)
   {
     mutt_debug(LL_DEBUG1, "recurse level too deep. giving up.\n");
     return;
   }
-  recurse_level++;
 
   switch (b->type)
   {
@@ -1406,7 +1425,8 @@ static void parse_part(FILE *fp, struct Body *b, int *counter)
 
       fseeko(fp, b->offset, SEEK_SET);
       b->parts = parse_multipart(fp, bound, b->offset + b->length,
-                                 mutt_istr_equal("digest", b->subtype), counter);
+                                 mutt_istr_equal("digest", b->subtype), counter,
+                                 depth + 1);
       break;
 
     case TYPE_MESSAGE:
@@ -1415,15 +1435,15 @@ static void parse_part(FILE *fp, struct Body *b, int *counter)
 
       fseeko(fp, b->offset, SEEK_SET);
       if (mutt_is_message_type(b->type, b->subtype))
-        b->parts = rfc822_parse_message(fp, b, counter);
+        b->parts = rfc822_parse_message(fp, b, counter, depth + 1);
       else if (mutt_istr_equal(b->subtype, "external-body"))
         b->parts = mutt_read_mime_header(fp, 0);
       else
-        goto bail;
+        return;
       break;
 
     default:
-      goto bail;
+      return;
   }
 
   /* try to recover from parsing error */
@@ -1432,8 +1452,6 @@ static void parse_part(FILE *fp, struct Body *b, int *counter)
     b->type = TYPE_TEXT;
     mutt_str_replace(&b->subtype, "plain");
   }
-bail:
-  recurse_level--;
 }
 
 /**
@@ -1444,10 +1462,11 @@ bail:
  *                 boundary is missing to avoid reading too far)
  * @param digest   true if reading a multipart/digest
  * @param counter  Number of parts processed so far
+ * @param depth    Nesting level of the parts
  * @retval ptr New Body containing parsed structure
  */
-static struct Body *parse_multipart(FILE *fp, const char *boundary,
-                                    LOFF_T end_off, bool digest, int *counter)
+static struct Body *parse_multipart(FILE *fp, const char *boundary, LOFF_T end_off,
+                                    bool digest, int *counter, int depth)
 {
   if (!fp)
     return NULL;
@@ -1543,7 +1562,7 @@ static struct Body *parse_multipart(FILE *fp, const char *boundary,
 
   /* parse recursive MIME parts */
   for (last = head; last; last = last->next)
-    parse_part(fp, last, counter);
+    parse_part(fp, last, counter, depth);
 
   return head;
 }
@@ -1553,17 +1572,19 @@ static struct Body *parse_multipart(FILE *fp, const char *boundary,
  * @param fp      Stream to read from
  * @param parent  Info about the message/rfc822 body part
  * @param counter Number of parts processed so far
+ * @param depth   Nesting level of the message
  * @retval ptr New Body containing parsed message
  *
  * @note This assumes that 'parent->length' has been set!
  */
-static struct Body *rfc822_parse_message(FILE *fp, struct Body *parent, int *counter)
+static struct Body *rfc822_parse_message(FILE *fp, struct Body *parent,
+                                         int *counter, int depth)
 {
   if (!fp || !parent)
     return NULL;
 
   parent->email = email_new();
-  parent->email->offset = ftello(fp);
+  parent->email->cold->offset = ftello(fp);
   parent->email->env = mutt_rfc822_read_header(fp, parent->email, false, false);
   struct Body *msg = parent->email->content;
 
@@ -1576,7 +1597,7 @@ static struct Body *rfc822_parse_message(FILE *fp, struct Body *parent, int *cou
   if (msg->length < 0)
     msg->length = 0;
 
-  parse_part(fp, msg, counter);
+  parse_part(fp, msg, counter, depth);
   return msg;
 }
 
@@ -1658,7 +1679,7 @@ void mutt_parse_part(FILE *fp, struct Body *b)
 {
   int counter = 0;
 
-  parse_part(fp, b, &counter);
+  parse_part(fp, b, &counter, 0);
 }
 
 /**
@@ -1673,7 +1694,7 @@ struct Body *mutt_rfc822_parse_message(FILE *fp, struct Body *parent)
 {
   int counter = 0;
 
-  return rfc822_parse_message(fp, parent, &counter);
+  return rfc822_parse_message(fp, parent, &counter, 0);
 }
 
 /**
@@ -1689,5 +1710,5 @@ struct Body *mutt_parse_multipart(FILE *fp, const char *boundary, LOFF_T end_off
 {
   int counter = 0;
 
-  return parse_multipart(fp, boundary, end_off, digest, &counter);
+  return parse_multipart(fp, boundary, end_off, digest, &counter, 0);
 }
@@ -772,6 +772,42 @@ void rfc2047_decode_addrlist(struct AddressList *al)
   }
 }
 
+/**
+ * decode_intern - Decode a shared string
+ * @param[out] pd Shared string, see mutt_intern_get()
+ *
+ * Shared strings can't be changed in place, so the decoded copy is shared.
+ */
+static void decode_intern(char **pd)
+{
+  if (!pd || !*pd)
+    return;
+
+  char *s = mutt_str_dup(*pd);
+  rfc2047_decode(&s);
+  if (!mutt_str_equal(s, *pd))
+    mutt_intern_replace(pd, s);
+  FREE(&s);
+}
+
+/**
+ * encode_intern - Encode a shared string
+ * @param[out] pd       Shared string, see mutt_intern_get()
+ * @param[in]  col      Starting column to convert
+ * @param[in]  charsets List of character sets to choose from
+ */
+static void encode_intern(char **pd, int col, const char *charsets)
+{
+  if (!pd || !*pd)
+    return;
+
+  char *s = mutt_str_dup(*pd);
+  rfc2047_encode(&s, NULL, col, charsets);
+  if (!mutt_str_equal(s, *pd))
+    mutt_intern_replace(pd, s);
+  FREE(&s);
+}
+
 /**
  * rfc2047_decode_envelope - Decode the fields of an Envelope
  * @param env Envelope
@@ -788,7 +824,7 @@ void rfc2047_decode_envelope(struct Envelope *env)
   rfc2047_decode_addrlist(&env->mail_followup_to);
   rfc2047_decode_addrlist(&env->return_path);
   rfc2047_decode_addrlist(&env->sender);
-  rfc2047_decode(&env->x_label);
+  decode_intern(&env->x_label);
   rfc2047_decode(&env->subject);
 }
 
@@ -807,6 +843,6 @@ void rfc2047_encode_envelope(struct Envelope *env)
   rfc2047_encode_addrlist(&env->reply_to, "Reply-To");
   rfc2047_encode_addrlist(&env->mail_followup_to, "Mail-Followup-To");
   rfc2047_encode_addrlist(&env->sender, "Sender");
-  rfc2047_encode(&env->x_label, NULL, sizeof("X-Label:"), C_SendCharset);
+  encode_intern(&env->x_label, sizeof("X-Label:"), C_SendCharset);
   rfc2047_encode(&env->subject, NULL, sizeof("Subject:"), C_SendCharset);
 }
@@ -1795,6 +1795,52 @@ cleanup:
   return rc;
 }
 
+/**
+ * mutt_body_is_verbatim - Will decoding the attachment leave its text unchanged
+ * @param b Body of email to test
+ * @retval true The decoded text is the same as the raw text
+ *
+ * This is true of an inline text/plain part that isn't encoded, converted to
+ * another character set, or reformatted.  Such a part can be searched without
+ * decoding it.
+ */
+bool mutt_body_is_verbatim(struct Body *b)
+{
+  if (!b || (b->type != TYPE_TEXT) || !mutt_istr_equal("plain", b->subtype))
+    return false;
+
+  if ((b->encoding != ENC_7BIT) && (b->encoding != ENC_8BIT) && (b->encoding != ENC_BINARY))
+    return false;
+
+  if (b->disposition != DISP_INLINE)
+    return false;
+
+  if (((WithCrypto & APPLICATION_PGP) != 0) && mutt_is_application_pgp(b))
+    return false;
+
+  if (C_TextFlowed ||
+      (C_ReflowText && mutt_istr_equal("flowed", mutt_param_get(&b->parameter, "format"))))
+  {
+    return false;
+  }
+
+  char assumed[128];
+  const char *charset = b->charset;
+  if (!charset)
+  {
+    charset = mutt_param_get(&b->parameter, "charset");
+    if (!charset && C_AssumedCharset)
+      charset = mutt_ch_get_default_charset(assumed, sizeof(assumed));
+  }
+  if (charset && C_Charset && !mutt_ch_chscmp(charset, C_Charset) &&
+      !((b->encoding == ENC_7BIT) && mutt_ch_is_us_ascii(charset)))
+  {
+    return false;
+  }
+
+  return !is_autoview(b);
+}
+
 /**
  * mutt_can_decode - Will decoding the attachment produce any output
  * @param a Body of email to test
@@ -1847,12 +1893,13 @@ void mutt_decode_attachment(struct Body *b, struct State *s)
 
   if (istext && (b->charset || (s->flags & MUTT_CHARCONV)))
   {
+    char assumed[128];
     const char *charset = b->charset;
     if (!charset)
     {
       charset = mutt_param_get(&b->parameter, "charset");
       if (!charset && C_AssumedCharset)
-        charset = mutt_ch_get_default_charset();
+        charset = mutt_ch_get_default_charset(assumed, sizeof(assumed));
     }
     if (charset && C_Charset)
       cd = mutt_ch_iconv_open(C_Charset, charset, MUTT_ICONV_HOOK_FROM);
@@ -36,6 +36,9 @@
 // clang-format off
 char *C_HeaderCache;               ///< Config: (hcache) Directory/file for the header cache database
 char *C_HeaderCacheBackend;        ///< Config: (hcache) Header cache backend to use
+bool  C_HeaderCacheLazy;           ///< Config: (hcache) Defer decoding rarely-used headers from the cache
+long  C_HeaderCacheMemory;         ///< Config: (hcache) Memory to use for caching records (KiB)
+bool  C_HeaderCacheShared;         ///< Config: (hcache) Use one database for all the folders of an account
 #ifdef USE_HCACHE_COMPRESSION
 short C_HeaderCacheCompressLevel;  ///< Config: (hcache) Level of compression for method
 char *C_HeaderCacheCompressMethod; ///< Config: (hcache) Enable generic hcache database compression
@@ -56,6 +59,15 @@ struct ConfigDef HcacheVars[] = {
   { "header_cache_backend", DT_STRING, &C_HeaderCacheBackend, 0, 0, hcache_validator,
     "(hcache) Header cache backend to use"
   },
+  { "header_cache_lazy", DT_BOOL, &C_HeaderCacheLazy, false, 0, NULL,
+    "(hcache) Defer decoding rarely-used headers from the cache"
+  },
+  { "header_cache_memory", DT_LONG|DT_NOT_NEGATIVE, &C_HeaderCacheMemory, 0, 0, NULL,
+    "(hcache) Memory to use for caching records (KiB)"
+  },
+  { "header_cache_shared", DT_BOOL, &C_HeaderCacheShared, false, 0, NULL,
+    "(hcache) Use one database for all the folders of an account"
+  },
 #if defined(USE_HCACHE_COMPRESSION)
   { "header_cache_compress_level", DT_NUMBER|DT_NOT_NEGATIVE, &C_HeaderCacheCompressLevel, 1, 0, compress_level_validator,
     "(hcache) Level of compression for method"
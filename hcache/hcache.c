@@ -34,8 +34,12 @@
 
 #include "config.h"
 #include <assert.h>
+#include <dirent.h>
 #include <errno.h>
 #include <limits.h>
+#ifdef USE_PTHREADS
+#include <pthread.h>
+#endif
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
@@ -45,8 +49,10 @@
 #include <unistd.h>
 #include "mutt/lib.h"
 #include "email/lib.h"
+#include "conn/lib.h"
 #include "lib.h"
 #include "hcache/hcversion.h"
+#include "mutt_account.h"
 #include "muttlib.h"
 #include "serialize.h"
 #include "compress/lib.h"
@@ -62,6 +68,86 @@ static unsigned int hcachever = 0x0;
 
 #define hcache_get_ops() store_get_backend_ops(C_HeaderCacheBackend)
 
+#define HC_QUEUE_BATCH 256  ///< Number of records to write in one transaction
+#define HC_QUEUE_MAX   1024 ///< Number of records waiting to be compressed, before the caller blocks
+
+/**
+ * struct HCacheQueue - Records waiting to be written to the Store
+ *
+ * mutt_hcache_store_async() serialises an Email and adds it to the queue.
+ * If compression is enabled, a background thread compresses the records.
+ * Once a batch is ready, it's written to the Store in one transaction.
+ *
+ * The Store itself is only ever used by the thread that opened the cache.
+ */
+struct HCacheQueue
+{
+  struct StoreKv *todo;         ///< Records waiting to be compressed
+  size_t num_todo;              ///< Number of records in todo
+  size_t num_busy;              ///< Number of records being compressed
+  struct StoreKv *ready;        ///< Records ready to be written
+  size_t num_ready;             ///< Number of records in ready
+  size_t size_ready;            ///< Size of the ready array
+  struct HashTable *pending;    ///< Store keys of all the queued records
+#ifdef USE_PTHREADS
+  bool threaded;                ///< A compression thread is running
+  bool shutdown;                ///< Tell the compression thread to exit
+  pthread_t thread;             ///< Compression thread
+  pthread_mutex_t lock;         ///< Protects the arrays, counters and flags
+  pthread_cond_t cond_work;     ///< Signalled when there's work for the thread
+  pthread_cond_t cond_done;     ///< Signalled when the thread has finished some work
+#endif
+#ifdef USE_HCACHE_COMPRESSION
+  const struct ComprOps *cops;  ///< Compression backend
+  void *cctx;                   ///< Compression context, owned by the thread
+  struct HCacheDict *train;     ///< Samples for the thread to train a dictionary from
+  void *trained;                ///< Dictionary trained by the thread
+  size_t trained_len;           ///< Length of the trained dictionary
+#endif
+};
+
+#define HC_DICT_KEY         "hcache.dictionary" ///< Store key of the compression dictionary
+#define HC_DICT_SAMPLES     1000                ///< Train the dictionary after this many records
+#define HC_DICT_MIN_SAMPLES 100                 ///< Fewest records that a dictionary can be trained from
+#define HC_DICT_SAMPLE_SIZE (2 * 1024 * 1024)   ///< Train the dictionary after this much data
+
+/**
+ * struct HCacheDict - Compression dictionary
+ *
+ * If the compression backend supports it, the first records that are stored
+ * are used to train a dictionary.  It's saved in the Store under the key
+ * #HC_DICT_KEY and used for all the compression that follows.
+ */
+struct HCacheDict
+{
+  void *data;                    ///< Dictionary, if there is one
+  size_t len;                    ///< Length of the dictionary
+  bool training;                 ///< Samples are being collected
+  struct Buffer samples;         ///< Sample records, one after another
+  size_t sizes[HC_DICT_SAMPLES]; ///< Length of each sample
+  size_t num;                    ///< Number of samples
+};
+
+/**
+ * struct HCacheShared - A Store shared by several HeaderCaches
+ *
+ * A database is only opened once, however many HeaderCaches are using it.
+ * It's kept open while any of them is.  If $header_cache_shared is set, that
+ * includes all the folders of an account.
+ */
+struct HCacheShared
+{
+  char *path;                         ///< Path to the database file
+  const struct StoreOps *backend;     ///< Store backend
+  const struct StoreOps *ops;         ///< Store backend, or LRU cache
+  void *ctx;                          ///< Store
+  int refs;                           ///< Number of HeaderCaches using the Store
+  STAILQ_ENTRY(HCacheShared) entries; ///< Linked list
+};
+STAILQ_HEAD(HCacheSharedList, HCacheShared);
+
+static struct HCacheSharedList SharedStores = STAILQ_HEAD_INITIALIZER(SharedStores);
+
 #ifdef USE_HCACHE_COMPRESSION
 #define compr_get_ops() compress_get_ops(C_HeaderCacheCompressMethod)
 #endif
@@ -84,11 +170,11 @@ static size_t header_size(void)
  * @retval ptr Binary blob representing the Email
  *
  * This function transforms an Email into a binary string so that it can be
- * saved to a database.
+ * saved to a database.  After the uidvalidity and crc, the Email is stored as
+ * a tagged record, see \ref hc_serial.
  */
 static void *dump(struct HeaderCache *hc, const struct Email *e, int *off, uint32_t uidvalidity)
 {
-  struct Email e_dump;
   bool convert = !CharsetIsUtf8;
 
   *off = 0;
@@ -99,75 +185,31 @@ static void *dump(struct HeaderCache *hc, const struct Email *e, int *off, uint3
 
   assert((size_t) *off == header_size());
 
-  lazy_realloc(&d, *off + sizeof(struct Email));
-  memcpy(&e_dump, e, sizeof(struct Email));
-
-  /* some fields are not safe to cache */
-  e_dump.tagged = false;
-  e_dump.changed = false;
-  e_dump.threaded = false;
-  e_dump.recip_valid = false;
-  e_dump.searched = false;
-  e_dump.matched = false;
-  e_dump.collapsed = false;
-  e_dump.limited = false;
-  e_dump.num_hidden = 0;
-  e_dump.recipient = 0;
-  e_dump.pair = 0;
-  e_dump.attach_valid = false;
-  e_dump.path = NULL;
-  e_dump.tree = NULL;
-  e_dump.thread = NULL;
-  STAILQ_INIT(&e_dump.tags);
-#ifdef MIXMASTER
-  STAILQ_INIT(&e_dump.chain);
-#endif
-  e_dump.edata = NULL;
-
-  memcpy(d + *off, &e_dump, sizeof(struct Email));
-  *off += sizeof(struct Email);
-
-  d = serial_dump_envelope(e_dump.env, d, off, convert);
-  d = serial_dump_body(e_dump.content, d, off, convert);
+  d = serial_dump_email(e, d, off, convert);
 
   return d;
 }
 
 /**
  * restore - Restore an Email from data retrieved from the cache
- * @param d Data retrieved using mutt_hcache_dump
- * @retval ptr Success, the restored header (can't be NULL)
+ * @param d    Data retrieved using mutt_hcache_dump
+ * @param dlen Length of the data
+ * @retval ptr  Success, the restored header
+ * @retval NULL The data isn't a valid record
+ *
+ * Unknown fields are ignored and missing fields keep their default value.
  *
  * @note The returned Email must be free'd by caller code with
  *       email_free()
  */
-static struct Email *restore(const unsigned char *d)
+static struct Email *restore(const unsigned char *d, size_t dlen)
 {
-  int off = 0;
-  struct Email *e = email_new();
-  bool convert = !CharsetIsUtf8;
-
-  /* skip validate */
-  off += sizeof(uint32_t);
-
-  /* skip crc */
-  off += sizeof(unsigned int);
-
-  memcpy(e, d + off, sizeof(struct Email));
-  off += sizeof(struct Email);
-
-  STAILQ_INIT(&e->tags);
-#ifdef MIXMASTER
-  STAILQ_INIT(&e->chain);
-#endif
-
-  e->env = mutt_env_new();
-  serial_restore_envelope(e->env, d, &off, convert);
-
-  e->content = mutt_body_new();
-  serial_restore_body(e->content, d, &off, convert);
+  /* skip validate and crc */
+  const size_t hlen = header_size();
+  if (dlen < hlen)
+    return NULL;
 
-  return e;
+  return serial_restore_email(d + hlen, dlen - hlen, C_HeaderCacheLazy, !CharsetIsUtf8);
 }
 
 struct RealKey
@@ -228,12 +270,39 @@ static bool create_hcache_dir(const char *path)
   return (rc == 0);
 }
 
+/**
+ * hcache_account - Get the account that a folder belongs to
+ * @param cac Account of a remote folder, or NULL
+ * @param buf Buffer for the result
+ *
+ * For a remote folder, the account is the protocol, user, host and port,
+ * e.g. `imaps://user@example.com:993/`.  All local folders belong to one
+ * account, "local".
+ */
+static void hcache_account(struct ConnAccount *cac, struct Buffer *buf)
+{
+  if (!cac || (cac->host[0] == '\0'))
+  {
+    mutt_buffer_strcpy(buf, "local");
+    return;
+  }
+
+  struct Url url = { 0 };
+  mutt_account_tourl(cac, &url);
+  if (url_tobuffer(&url, buf, 0) != 0)
+  {
+    mutt_buffer_printf(buf, "%s://%s@%s:%hu/", NONULL(cac->service), cac->user,
+                       cac->host, cac->port);
+  }
+}
+
 /**
  * hcache_per_folder - Generate the hcache pathname
  * @param hcpath Buffer for the result
  * @param path   Base directory, from $header_cache
  * @param folder Mailbox name (including protocol)
  * @param namer  Callback to generate database filename - Implements ::hcache_namer_t
+ * @param cac    Account of a remote folder, or NULL
  *
  * Generate the pathname for the hcache database, it will be of the form:
  *     BASE/FOLDER/NAME
@@ -248,9 +317,12 @@ static bool create_hcache_dir(const char *path)
  * If @a path exists and is a directory, it is used.
  * If @a path has a trailing '/' it is assumed to be a directory.
  * Otherwise @a path is assumed to be a file.
+ *
+ * If $header_cache_shared is set, the NAME is the md5sum of the account,
+ * instead of the folder.
  */
-static void hcache_per_folder(struct Buffer *hcpath, const char *path,
-                              const char *folder, hcache_namer_t namer)
+static void hcache_per_folder(struct Buffer *hcpath, const char *path, const char *folder,
+                              hcache_namer_t namer, struct ConnAccount *cac)
 {
   struct stat sb;
 
@@ -267,6 +339,14 @@ static void hcache_per_folder(struct Buffer *hcpath, const char *path,
 
   /* We have a directory - no matter whether it exists, or not */
   struct Buffer *hcfile = mutt_buffer_pool_get();
+  if (C_HeaderCacheShared)
+  {
+    /* One database for all the folders of the account */
+    hcache_account(cac, hcfile);
+    folder = mutt_b2s(hcfile);
+    namer = NULL;
+  }
+
   if (namer)
   {
     namer(folder, hcfile);
@@ -310,10 +390,286 @@ static char *get_foldername(const char *folder)
   return p;
 }
 
+#ifdef USE_HCACHE_COMPRESSION
+/**
+ * hcache_compress - Compress a serialised record
+ * @param[in]     cops Compression backend
+ * @param[in]     cctx Compression context
+ * @param[in]     data Record created by dump(), will be freed
+ * @param[in,out] dlen Length of the record
+ * @retval ptr  Compressed record, must be freed by the caller
+ * @retval NULL Error
+ *
+ * The uidvalidity and crc aren't compressed, so they can be checked before
+ * decompressing on fetch().
+ */
+static char *hcache_compress(const struct ComprOps *cops, void *cctx,
+                             char *data, size_t *dlen)
+{
+  size_t hlen = header_size();
+
+  /* data / dlen gets ptr to compressed data here */
+  size_t clen = *dlen;
+  void *cdata = cops->compress(cctx, data + hlen, *dlen - hlen, &clen);
+  if (!cdata)
+  {
+    FREE(&data);
+    return NULL;
+  }
+
+  char *whole = mutt_mem_malloc(hlen + clen);
+  memcpy(whole, data, hlen);
+  memcpy(whole + hlen, cdata, clen);
+
+  FREE(&data);
+
+  *dlen = hlen + clen;
+  return whole;
+}
+
+/**
+ * hcache_dict_load - Load the compression dictionary from the Store
+ * @param hc Header cache handle
+ *
+ * If there isn't a dictionary, start collecting samples to train one.
+ * The sample buffer isn't allocated until a record is stored.
+ */
+static void hcache_dict_load(struct HeaderCache *hc)
+{
+  const struct ComprOps *cops = compr_get_ops();
+  if (!cops->set_dict)
+    return;
+
+  struct HCacheDict *dict = mutt_mem_calloc(1, sizeof(struct HCacheDict));
+  hc->dict = dict;
+
+  struct RealKey *rk = realkey(HC_DICT_KEY, strlen(HC_DICT_KEY));
+  size_t dlen = 0;
+  void *data = mutt_hcache_fetch_raw(hc, rk->key, rk->len, &dlen);
+  if (data)
+  {
+    if (cops->set_dict(hc->cctx, data, dlen))
+    {
+      dict->data = mutt_mem_malloc(dlen);
+      memcpy(dict->data, data, dlen);
+      dict->len = dlen;
+    }
+    mutt_hcache_free_raw(hc, &data);
+  }
+
+  if (!dict->data && cops->train)
+    dict->training = true;
+}
+
+/**
+ * hcache_dict_build - Train a compression dictionary from the samples
+ * @param[in]  cops Compression backend
+ * @param[in]  dict Dictionary holding the samples, which will be freed
+ * @param[out] len  Length of the dictionary
+ * @retval ptr  Dictionary, must be freed by the caller
+ * @retval NULL Too few samples, or training failed
+ *
+ * This only touches the samples, so it may be run by the queue's thread.
+ */
+static void *hcache_dict_build(const struct ComprOps *cops, struct HCacheDict *dict, size_t *len)
+{
+  void *data = NULL;
+  if (dict->num >= HC_DICT_MIN_SAMPLES)
+  {
+    data = cops->train(dict->samples.data, dict->sizes, dict->num, len);
+    mutt_debug(LL_DEBUG3, "Trained a %zu byte dictionary from %zu records\n",
+               *len, dict->num);
+  }
+
+  mutt_buffer_dealloc(&dict->samples);
+  dict->num = 0;
+
+  return data;
+}
+
+/**
+ * hcache_dict_use - Start using a new dictionary
+ * @param hc   Header cache handle
+ * @param data Dictionary, will be freed
+ * @param len  Length of the dictionary
+ *
+ * The dictionary is saved to the Store, then used for the following records.
+ */
+static void hcache_dict_use(struct HeaderCache *hc, void *data, size_t len)
+{
+  if (!data)
+    return;
+
+  if (!compr_get_ops()->set_dict(hc->cctx, data, len))
+  {
+    FREE(&data);
+    return;
+  }
+
+  struct HCacheDict *dict = hc->dict;
+  dict->data = data;
+  dict->len = len;
+
+  struct RealKey *rk = realkey(HC_DICT_KEY, strlen(HC_DICT_KEY));
+  mutt_hcache_store_raw(hc, rk->key, rk->len, dict->data, dict->len);
+}
+
+/**
+ * hcache_dict_train - Train a compression dictionary on the caller's thread
+ * @param hc Header cache handle
+ */
+static void hcache_dict_train(struct HeaderCache *hc)
+{
+  size_t len = 0;
+  void *data = hcache_dict_build(compr_get_ops(), hc->dict, &len);
+  hcache_dict_use(hc, data, len);
+}
+
+/**
+ * hcache_dict_sample - Collect a record for training the dictionary
+ * @param hc   Header cache handle
+ * @param data Record created by dump()
+ * @param dlen Length of the record
+ *
+ * Training is slow, so it's never done here.  Once there are enough samples,
+ * they're given to the queue's thread, if it's running.  Otherwise, the
+ * dictionary is trained when the cache is closed.
+ */
+static void hcache_dict_sample(struct HeaderCache *hc, const char *data, size_t dlen)
+{
+  struct HCacheDict *dict = hc->dict;
+  if (!dict || !dict->training)
+    return;
+
+  if (!dict->samples.data)
+    mutt_buffer_alloc(&dict->samples, HC_DICT_SAMPLE_SIZE);
+
+  /* Only the part that gets compressed */
+  size_t hlen = header_size();
+  mutt_buffer_addstr_n(&dict->samples, data + hlen, dlen - hlen);
+  dict->sizes[dict->num++] = dlen - hlen;
+
+  if ((dict->num < HC_DICT_SAMPLES) && (mutt_buffer_len(&dict->samples) < HC_DICT_SAMPLE_SIZE))
+    return;
+
+  dict->training = false;
+
+#ifdef USE_PTHREADS
+  struct HCacheQueue *q = hc->queue;
+  if (q && q->threaded)
+  {
+    pthread_mutex_lock(&q->lock);
+    q->train = dict;
+    pthread_cond_signal(&q->cond_work);
+    pthread_mutex_unlock(&q->lock);
+  }
+#endif
+}
+
+/**
+ * hcache_dict_free - Free the compression dictionary
+ * @param hc Header cache handle
+ *
+ * If enough samples have been collected, a dictionary is trained first.
+ */
+static void hcache_dict_free(struct HeaderCache *hc)
+{
+  struct HCacheDict *dict = hc->dict;
+  if (!dict)
+    return;
+
+  /* Any samples the queue's thread didn't take */
+  dict->training = false;
+  if (dict->num != 0)
+    hcache_dict_train(hc);
+
+  FREE(&dict->data);
+  FREE(&hc->dict);
+}
+#endif
+
+/**
+ * hcache_lru_wrap - Put the in-memory cache in front of the Store
+ * @param hc   Header cache handle
+ * @param path Path to the database file
+ */
+static void hcache_lru_wrap(struct HeaderCache *hc, const char *path)
+{
+  if (C_HeaderCacheMemory <= 0)
+    return;
+
+  hc->ctx = store_lru_wrap(hc->ops, hc->ctx, path, C_HeaderCacheMemory * 1024);
+  hc->ops = &store_lru_ops;
+}
+
+/**
+ * hcache_shared_open - Open a Store, or share one that's already open
+ * @param hc     Header cache handle
+ * @param path   Path to the database file
+ * @param remove If the database can't be opened, delete it and try again
+ *
+ * Opening the same database twice in one process isn't safe for some
+ * backends, e.g. closing either copy releases the other's locks, so an open
+ * Store is reused.
+ *
+ * On failure, HeaderCache::ctx will be NULL.
+ */
+static void hcache_shared_open(struct HeaderCache *hc, const char *path, bool remove)
+{
+  struct HCacheShared *sh = NULL;
+  STAILQ_FOREACH(sh, &SharedStores, entries)
+  {
+    if ((sh->backend == hc->ops) && mutt_str_equal(sh->path, path))
+    {
+      sh->refs++;
+      hc->ops = sh->ops;
+      hc->ctx = sh->ctx;
+      return;
+    }
+  }
+
+  const struct StoreOps *backend = hc->ops;
+  hc->ctx = backend->open(path);
+  /* remove a possibly incompatible version */
+  if (!hc->ctx && remove && (unlink(path) == 0))
+    hc->ctx = backend->open(path);
+  if (!hc->ctx)
+    return;
+
+  hcache_lru_wrap(hc, path);
+
+  sh = mutt_mem_calloc(1, sizeof(struct HCacheShared));
+  sh->path = mutt_str_dup(path);
+  sh->backend = backend;
+  sh->ops = hc->ops;
+  sh->ctx = hc->ctx;
+  sh->refs = 1;
+  STAILQ_INSERT_TAIL(&SharedStores, sh, entries);
+  mutt_debug(LL_DEBUG3, "Opened header cache %s\n", path);
+}
+
+/**
+ * hcache_shared_find - Find the shared Store used by a header cache
+ * @param hc Header cache handle
+ * @retval ptr  Shared Store
+ * @retval NULL Not found
+ */
+static struct HCacheShared *hcache_shared_find(struct HeaderCache *hc)
+{
+  struct HCacheShared *sh = NULL;
+  STAILQ_FOREACH(sh, &SharedStores, entries)
+  {
+    if (sh->ctx == hc->ctx)
+      return sh;
+  }
+  return NULL;
+}
+
 /**
  * mutt_hcache_open - Multiplexor for StoreOps::open
  */
-struct HeaderCache *mutt_hcache_open(const char *path, const char *folder, hcache_namer_t namer)
+struct HeaderCache *mutt_hcache_open(const char *path, const char *folder,
+                                     hcache_namer_t namer, struct ConnAccount *cac)
 {
   const struct StoreOps *ops = hcache_get_ops();
   if (!ops)
@@ -386,72 +742,53 @@ struct HeaderCache *mutt_hcache_open(const char *path, const char *folder, hcach
   }
 
   struct Buffer *hcpath = mutt_buffer_pool_get();
-  hcache_per_folder(hcpath, path, hc->folder, namer);
+  hcache_per_folder(hcpath, path, hc->folder, namer, cac);
 
-  hc->ctx = ops->open(mutt_b2s(hcpath));
-  if (!hc->ctx)
+  hc->ops = ops;
+  /* Don't delete a database that holds every folder of the account */
+  hcache_shared_open(hc, mutt_b2s(hcpath), !C_HeaderCacheShared);
+  if (hc->ctx)
   {
-    /* remove a possibly incompatible version */
-    if (unlink(mutt_b2s(hcpath)) == 0)
-    {
-      hc->ctx = ops->open(mutt_b2s(hcpath));
-      if (!hc->ctx)
-      {
-        FREE(&hc->folder);
-        FREE(&hc);
-      }
-    }
+    hc->path = mutt_buffer_strdup(hcpath);
+  }
+  else
+  {
+    FREE(&hc->folder);
+    FREE(&hc);
   }
 
   mutt_buffer_pool_release(&hcpath);
-  return hc;
-}
-
-/**
- * mutt_hcache_close - Multiplexor for StoreOps::close
- */
-void mutt_hcache_close(struct HeaderCache *hc)
-{
-  const struct StoreOps *ops = hcache_get_ops();
-  if (!hc || !ops)
-    return;
 
 #ifdef USE_HCACHE_COMPRESSION
-  if (C_HeaderCacheCompressMethod)
-    compr_get_ops()->close(&hc->cctx);
+  if (hc && hc->ctx && C_HeaderCacheCompressMethod)
+    hcache_dict_load(hc);
 #endif
 
-  ops->close(&hc->ctx);
-  FREE(&hc->folder);
-  FREE(&hc);
+  return hc;
 }
 
 /**
- * mutt_hcache_fetch - Multiplexor for StoreOps::fetch
+ * hcache_decode - Turn a record from the Store back into an Email
+ * @param[in]  hc          Header cache handle
+ * @param[in]  data        Data retrieved from the Store
+ * @param[in]  dlen        Length of the data
+ * @param[in]  uidvalidity Only restore if it matches the stored uidvalidity
+ * @param[out] entry       Entry to fill
+ *
+ * If the crc or uidvalidity don't match, entry->email will be NULL.
  */
-struct HCacheEntry mutt_hcache_fetch(struct HeaderCache *hc, const char *key,
-                                     size_t keylen, uint32_t uidvalidity)
+static void hcache_decode(struct HeaderCache *hc, void *data, size_t dlen,
+                          uint32_t uidvalidity, struct HCacheEntry *entry)
 {
-  struct RealKey *rk = realkey(key, keylen);
-  struct HCacheEntry entry = { 0 };
-
-  size_t dlen;
-  void *data = mutt_hcache_fetch_raw(hc, rk->key, rk->len, &dlen);
-  void *to_free = data;
-  if (!data)
-  {
-    goto end;
-  }
-
   /* restore uidvalidity and crc */
   size_t hlen = header_size();
   int off = 0;
-  serial_restore_uint32_t(&entry.uidvalidity, data, &off);
-  serial_restore_int(&entry.crc, data, &off);
+  serial_restore_uint32_t(&entry->uidvalidity, data, &off);
+  serial_restore_int(&entry->crc, data, &off);
   assert((size_t) off == hlen);
-  if (entry.crc != hc->crc || ((uidvalidity != 0) && uidvalidity != entry.uidvalidity))
+  if (entry->crc != hc->crc || ((uidvalidity != 0) && uidvalidity != entry->uidvalidity))
   {
-    goto end;
+    return;
   }
 
 #ifdef USE_HCACHE_COMPRESSION
@@ -462,100 +799,582 @@ struct HCacheEntry mutt_hcache_fetch(struct HeaderCache *hc, const char *key,
     void *dblob = cops->decompress(hc->cctx, (char *) data + hlen, dlen - hlen);
     if (!dblob)
     {
-      goto end;
+      return;
     }
     data = (char *) dblob - hlen; /* restore skips uidvalidity and crc */
+    /* The decompressor checked the data, the record holds its own size */
+    dlen = SIZE_MAX;
   }
 #endif
 
-  entry.email = restore(data);
-
-end:
-  mutt_hcache_free_raw(hc, &to_free);
-  return entry;
+  entry->email = restore(data, dlen);
 }
 
 /**
- * mutt_hcache_fetch_raw - Fetch a message's header from the cache
- * @param[in]  hc     Pointer to the struct HeaderCache structure got by mutt_hcache_open()
- * @param[in]  key    Message identification string
- * @param[in]  keylen Length of the string pointed to by key
- * @param[out] dlen   Length of the fetched data
- * @retval ptr  Success, the data if found
- * @retval NULL Otherwise
- *
- * @note This function does not perform any check on the validity of the data found.
- * @note The returned data must be free with mutt_hcache_free_raw().
+ * hcache_encode - Turn an Email into a record for the Store
+ * @param[in]  hc          Header cache handle
+ * @param[in]  e           Email to serialise
+ * @param[in]  uidvalidity IMAP server identifier
+ * @param[out] dlen        Length of the record
+ * @retval ptr  Record, must be freed by the caller
+ * @retval NULL Error
  */
-void *mutt_hcache_fetch_raw(struct HeaderCache *hc, const char *key,
-                            size_t keylen, size_t *dlen)
+static char *hcache_encode(struct HeaderCache *hc, struct Email *e,
+                           uint32_t uidvalidity, size_t *dlen)
 {
-  const struct StoreOps *ops = hcache_get_ops();
+  int off = 0;
+  char *data = dump(hc, e, &off, uidvalidity);
+  *dlen = off;
 
-  if (!hc || !ops)
-    return NULL;
+#ifdef USE_HCACHE_COMPRESSION
+  if (C_HeaderCacheCompressMethod)
+  {
+    hcache_dict_sample(hc, data, *dlen);
+    data = hcache_compress(compr_get_ops(), hc->cctx, data, dlen);
+  }
+#endif
 
-  struct Buffer path = mutt_buffer_make(1024);
-  keylen = mutt_buffer_printf(&path, "%s%.*s", hc->folder, (int) keylen, key);
-  void *blob = ops->fetch(hc->ctx, mutt_b2s(&path), keylen, dlen);
-  mutt_buffer_dealloc(&path);
-  return blob;
+  return data;
 }
 
 /**
- * mutt_hcache_free - Multiplexor for StoreOps::free
+ * hcache_store_key - Compute the key used in the Store
+ * @param hc     Header cache handle
+ * @param key    Message identification string
+ * @param keylen Length of the key
+ * @param buf    Buffer for the result
+ * @retval num Length of the Store key
  */
-void mutt_hcache_free_raw(struct HeaderCache *hc, void **data)
+static size_t hcache_store_key(struct HeaderCache *hc, const char *key,
+                               size_t keylen, struct Buffer *buf)
 {
-  const struct StoreOps *ops = hcache_get_ops();
-
-  if (!hc || !ops || !data || !*data)
-    return;
-
-  ops->free(hc->ctx, data);
+  struct RealKey *rk = realkey(key, keylen);
+  return mutt_buffer_printf(buf, "%s%.*s", hc->folder, (int) rk->len, rk->key);
 }
 
 /**
- * mutt_hcache_store - Multiplexor for StoreOps::store
+ * queue_take_ready - Detach the records that are ready to be written
+ * @param[in]  q   Queue
+ * @param[out] num Number of records
+ * @retval ptr Array of records, must be freed by the caller
  */
-int mutt_hcache_store(struct HeaderCache *hc, const char *key, size_t keylen,
-                      struct Email *e, uint32_t uidvalidity)
+static struct StoreKv *queue_take_ready(struct HCacheQueue *q, size_t *num)
 {
-  if (!hc)
-    return -1;
+  struct StoreKv *kvs = q->ready;
+  *num = q->num_ready;
 
-  int dlen = 0;
-  char *data = dump(hc, e, &dlen, uidvalidity);
+  q->ready = NULL;
+  q->num_ready = 0;
+  q->size_ready = 0;
 
-#ifdef USE_HCACHE_COMPRESSION
+  return kvs;
+}
+
+/**
+ * queue_add_ready - Add some records to the ready list
+ * @param q   Queue
+ * @param kvs Records
+ * @param num Number of records
+ */
+static void queue_add_ready(struct HCacheQueue *q, const struct StoreKv *kvs, size_t num)
+{
+  if ((q->num_ready + num) > q->size_ready)
+  {
+    q->size_ready = MAX(q->num_ready + num, q->size_ready * 2);
+    mutt_mem_realloc(&q->ready, q->size_ready * sizeof(struct StoreKv));
+  }
+
+  memcpy(q->ready + q->num_ready, kvs, num * sizeof(struct StoreKv));
+  q->num_ready += num;
+}
+
+/**
+ * queue_commit - Write some records to the Store
+ * @param hc  Header cache handle
+ * @param kvs Records, will be freed
+ * @param num Number of records
+ *
+ * Records that couldn't be compressed have a NULL value and are skipped.
+ */
+static void queue_commit(struct HeaderCache *hc, struct StoreKv *kvs, size_t num)
+{
+  const struct StoreOps *ops = hc->ops;
+
+  size_t count = 0;
+  for (size_t i = 0; i < num; i++)
+  {
+    mutt_hash_delete(hc->queue->pending, kvs[i].key, kvs[i].key);
+    if (kvs[i].value)
+      kvs[count++] = kvs[i];
+    else
+      FREE(&kvs[i].key);
+  }
+
+  if (ops && (count > 0))
+    store_store_many(ops, hc->ctx, kvs, count);
+
+  for (size_t i = 0; i < count; i++)
+  {
+    FREE(&kvs[i].key);
+    FREE(&kvs[i].value);
+  }
+  FREE(&kvs);
+}
+
+#if defined(USE_PTHREADS) && defined(USE_HCACHE_COMPRESSION)
+/**
+ * queue_worker - Compress the queued records in the background
+ * @param arg Queue
+ * @retval NULL Always
+ */
+static void *queue_worker(void *arg)
+{
+  struct HCacheQueue *q = arg;
+
+  pthread_mutex_lock(&q->lock);
+  while (true)
+  {
+    while ((q->num_todo == 0) && !q->train && !q->shutdown)
+      pthread_cond_wait(&q->cond_work, &q->lock);
+
+    if (q->train)
+    {
+      /* Train the dictionary before compressing any more records */
+      struct HCacheDict *dict = q->train;
+      pthread_mutex_unlock(&q->lock);
+
+      size_t len = 0;
+      void *data = hcache_dict_build(q->cops, dict, &len);
+      if (data && !q->cops->set_dict(q->cctx, data, len))
+        FREE(&data);
+
+      pthread_mutex_lock(&q->lock);
+      q->trained = data;
+      q->trained_len = len;
+      q->train = NULL;
+      pthread_cond_broadcast(&q->cond_done);
+      continue;
+    }
+
+    if (q->num_todo == 0)
+      break;
+
+    struct StoreKv *kvs = q->todo;
+    size_t num = q->num_todo;
+    q->todo = NULL;
+    q->num_todo = 0;
+    q->num_busy = num;
+    pthread_mutex_unlock(&q->lock);
+
+    for (size_t i = 0; i < num; i++)
+      kvs[i].value = hcache_compress(q->cops, q->cctx, kvs[i].value, &kvs[i].vlen);
+
+    pthread_mutex_lock(&q->lock);
+    queue_add_ready(q, kvs, num);
+    q->num_busy = 0;
+    FREE(&kvs);
+    pthread_cond_broadcast(&q->cond_done);
+  }
+  pthread_mutex_unlock(&q->lock);
+
+  return NULL;
+}
+
+/**
+ * queue_take_dict - Detach the dictionary trained by the queue's thread
+ * @param[in]  q   Queue
+ * @param[out] len Length of the dictionary
+ * @retval ptr  Dictionary, to be passed to hcache_dict_use()
+ * @retval NULL There's no new dictionary
+ *
+ * The caller must hold the queue's lock.
+ */
+static void *queue_take_dict(struct HCacheQueue *q, size_t *len)
+{
+  void *dict = q->trained;
+  *len = q->trained_len;
+
+  q->trained = NULL;
+  q->trained_len = 0;
+
+  return dict;
+}
+#endif
+
+/**
+ * queue_new - Create a queue of asynchronous writes
+ * @param hc Header cache handle
+ * @retval ptr New queue
+ *
+ * If compression is enabled, a thread is started to do the compression.
+ */
+static struct HCacheQueue *queue_new(struct HeaderCache *hc)
+{
+  struct HCacheQueue *q = mutt_mem_calloc(1, sizeof(struct HCacheQueue));
+  q->pending = mutt_hash_new(HC_QUEUE_MAX, MUTT_HASH_ALLOW_DUPS);
+
+#if defined(USE_PTHREADS) && defined(USE_HCACHE_COMPRESSION)
   if (C_HeaderCacheCompressMethod)
   {
-    /* We don't compress uidvalidity and the crc, so we can check them before
-     * decompressing on fetch().  */
-    size_t hlen = header_size();
+    q->cops = compr_get_ops();
+    q->cctx = q->cops->open(C_HeaderCacheCompressLevel);
+    if (!q->cctx)
+      return q;
 
-    const struct ComprOps *cops = compr_get_ops();
+    if (hc->dict && hc->dict->data)
+      q->cops->set_dict(q->cctx, hc->dict->data, hc->dict->len);
+
+    pthread_mutex_init(&q->lock, NULL);
+    pthread_cond_init(&q->cond_work, NULL);
+    pthread_cond_init(&q->cond_done, NULL);
 
-    /* data / dlen gets ptr to compressed data here */
-    size_t clen = dlen;
-    void *cdata = cops->compress(hc->cctx, data + hlen, dlen - hlen, &clen);
-    if (!cdata)
+    if (pthread_create(&q->thread, NULL, queue_worker, q) == 0)
     {
-      FREE(&data);
-      return -1;
+      q->threaded = true;
     }
+    else
+    {
+      mutt_debug(LL_DEBUG1, "Can't start the header cache thread\n");
+      pthread_cond_destroy(&q->cond_done);
+      pthread_cond_destroy(&q->cond_work);
+      pthread_mutex_destroy(&q->lock);
+      q->cops->close(&q->cctx);
+    }
+  }
+#endif
 
-    char *whole = mutt_mem_malloc(hlen + clen);
-    memcpy(whole, data, hlen);
-    memcpy(whole + hlen, cdata, clen);
+  return q;
+}
 
-    FREE(&data);
+/**
+ * queue_flush - Write all the queued records to the Store
+ * @param hc Header cache handle
+ */
+static void queue_flush(struct HeaderCache *hc)
+{
+  struct HCacheQueue *q = hc->queue;
+  if (!q)
+    return;
+
+  size_t num = 0;
+  struct StoreKv *kvs = NULL;
+
+#if defined(USE_PTHREADS) && defined(USE_HCACHE_COMPRESSION)
+  if (q->threaded)
+  {
+    pthread_mutex_lock(&q->lock);
+    while ((q->num_todo != 0) || (q->num_busy != 0) || q->train)
+      pthread_cond_wait(&q->cond_done, &q->lock);
+    kvs = queue_take_ready(q, &num);
+    size_t dict_len = 0;
+    void *dict = queue_take_dict(q, &dict_len);
+    pthread_mutex_unlock(&q->lock);
+
+    hcache_dict_use(hc, dict, dict_len);
+  }
+  else
+#endif
+  {
+    kvs = queue_take_ready(q, &num);
+  }
+
+  queue_commit(hc, kvs, num);
+}
+
+/**
+ * queue_push - Add a record to the queue
+ * @param hc   Header cache handle
+ * @param key  Store key, will be freed
+ * @param klen Length of the key
+ * @param data Uncompressed record created by dump(), will be freed
+ * @param dlen Length of the record
+ *
+ * Once a batch of records is ready, it's written to the Store.
+ */
+static void queue_push(struct HeaderCache *hc, char *key, size_t klen, char *data, size_t dlen)
+{
+  struct HCacheQueue *q = hc->queue;
+  struct StoreKv kv = { key, klen, data, dlen };
+  size_t num = 0;
+  struct StoreKv *kvs = NULL;
+
+  mutt_hash_insert(q->pending, key, key);
+
+#ifdef USE_HCACHE_COMPRESSION
+  if (C_HeaderCacheCompressMethod)
+    hcache_dict_sample(hc, data, dlen);
+#endif
+
+#if defined(USE_PTHREADS) && defined(USE_HCACHE_COMPRESSION)
+  if (q->threaded)
+  {
+    pthread_mutex_lock(&q->lock);
+    while (q->num_todo >= HC_QUEUE_MAX)
+      pthread_cond_wait(&q->cond_done, &q->lock);
+
+    if (!q->todo)
+      q->todo = mutt_mem_calloc(HC_QUEUE_MAX, sizeof(struct StoreKv));
+    q->todo[q->num_todo++] = kv;
+    pthread_cond_signal(&q->cond_work);
+
+    if (q->num_ready >= HC_QUEUE_BATCH)
+      kvs = queue_take_ready(q, &num);
+    size_t dict_len = 0;
+    void *dict = queue_take_dict(q, &dict_len);
+    pthread_mutex_unlock(&q->lock);
+
+    /* Save the dictionary before the records that were compressed with it */
+    hcache_dict_use(hc, dict, dict_len);
+    queue_commit(hc, kvs, num);
+    return;
+  }
+#endif
+
+#ifdef USE_HCACHE_COMPRESSION
+  if (C_HeaderCacheCompressMethod)
+    kv.value = hcache_compress(compr_get_ops(), hc->cctx, kv.value, &kv.vlen);
+#endif
+
+  queue_add_ready(q, &kv, 1);
+  if (q->num_ready >= HC_QUEUE_BATCH)
+  {
+    kvs = queue_take_ready(q, &num);
+    queue_commit(hc, kvs, num);
+  }
+}
+
+/**
+ * queue_free - Write the queued records and free the queue
+ * @param hc Header cache handle
+ */
+static void queue_free(struct HeaderCache *hc)
+{
+  struct HCacheQueue *q = hc->queue;
+  if (!q)
+    return;
+
+  queue_flush(hc);
 
-    data = whole;
-    dlen = hlen + clen;
+#if defined(USE_PTHREADS) && defined(USE_HCACHE_COMPRESSION)
+  if (q->threaded)
+  {
+    pthread_mutex_lock(&q->lock);
+    q->shutdown = true;
+    pthread_cond_signal(&q->cond_work);
+    pthread_mutex_unlock(&q->lock);
+
+    pthread_join(q->thread, NULL);
+    pthread_cond_destroy(&q->cond_done);
+    pthread_cond_destroy(&q->cond_work);
+    pthread_mutex_destroy(&q->lock);
   }
+
+  if (q->cctx)
+    q->cops->close(&q->cctx);
 #endif
 
+  mutt_hash_free(&q->pending);
+  FREE(&hc->queue);
+}
+
+/**
+ * queue_sync - Make sure a key's queued records have been written
+ * @param hc  Header cache handle
+ * @param key Store key
+ *
+ * This must be called before the Store is read or written directly, so that
+ * the caller sees its own asynchronous writes, in order.
+ */
+static void queue_sync(struct HeaderCache *hc, const char *key)
+{
+  if (hc->queue && mutt_hash_find(hc->queue->pending, key))
+    queue_flush(hc);
+}
+
+/**
+ * mutt_hcache_close - Multiplexor for StoreOps::close
+ */
+void mutt_hcache_close(struct HeaderCache *hc)
+{
+  const struct StoreOps *ops = hc ? hc->ops : NULL;
+  if (!hc || !ops)
+    return;
+
+  queue_free(hc);
+
+#ifdef USE_HCACHE_COMPRESSION
+  hcache_dict_free(hc);
+  if (C_HeaderCacheCompressMethod)
+    compr_get_ops()->close(&hc->cctx);
+#endif
+
+  /* Closing the last user of a shared Store commits its writes and releases
+   * its locks, so that other processes can use the database */
+  struct HCacheShared *sh = hcache_shared_find(hc);
+  if (sh)
+  {
+    sh->refs--;
+    if (sh->refs == 0)
+    {
+      STAILQ_REMOVE(&SharedStores, sh, HCacheShared, entries);
+      sh->ops->close(&sh->ctx);
+      FREE(&sh->path);
+      FREE(&sh);
+    }
+  }
+  else
+  {
+    ops->close(&hc->ctx);
+  }
+
+  FREE(&hc->path);
+  FREE(&hc->folder);
+  FREE(&hc);
+}
+
+/**
+ * mutt_hcache_cleanup - Close the shared Stores and free the in-memory cache
+ */
+void mutt_hcache_cleanup(void)
+{
+  struct HCacheShared *sh = NULL;
+  struct HCacheShared *tmp = NULL;
+  STAILQ_FOREACH_SAFE(sh, &SharedStores, entries, tmp)
+  {
+    if (sh->refs > 0)
+      mutt_debug(LL_DEBUG1, "Shared header cache %s is still in use\n", sh->path);
+    sh->ops->close(&sh->ctx);
+    FREE(&sh->path);
+    FREE(&sh);
+  }
+  STAILQ_INIT(&SharedStores);
+
+  store_lru_cleanup();
+}
+
+/**
+ * mutt_hcache_fetch - Multiplexor for StoreOps::fetch
+ */
+struct HCacheEntry mutt_hcache_fetch(struct HeaderCache *hc, const char *key,
+                                     size_t keylen, uint32_t uidvalidity)
+{
+  struct RealKey *rk = realkey(key, keylen);
+  struct HCacheEntry entry = { 0 };
+
+  size_t dlen;
+  void *data = mutt_hcache_fetch_raw(hc, rk->key, rk->len, &dlen);
+  if (!data)
+    return entry;
+
+  hcache_decode(hc, data, dlen, uidvalidity, &entry);
+
+  mutt_hcache_free_raw(hc, &data);
+  return entry;
+}
+
+/**
+ * mutt_hcache_fetch_many - Multiplexor for StoreOps::fetch_many
+ */
+size_t mutt_hcache_fetch_many(struct HeaderCache *hc, struct HCacheItem *items,
+                              size_t num, uint32_t uidvalidity)
+{
+  if (!items)
+    return 0;
+
+  for (size_t i = 0; i < num; i++)
+    memset(&items[i].entry, 0, sizeof(struct HCacheEntry));
+
+  const struct StoreOps *ops = hc ? hc->ops : NULL;
+  if (!hc || !ops || (num == 0))
+    return 0;
+
+  struct Buffer *keys = mutt_mem_calloc(num, sizeof(struct Buffer));
+  struct StoreKv *kvs = mutt_mem_calloc(num, sizeof(struct StoreKv));
+
+  for (size_t i = 0; i < num; i++)
+  {
+    mutt_buffer_alloc(&keys[i], 256);
+    kvs[i].klen = hcache_store_key(hc, items[i].key, items[i].keylen, &keys[i]);
+    kvs[i].key = mutt_b2s(&keys[i]);
+    queue_sync(hc, kvs[i].key);
+  }
+
+  size_t found = 0;
+  store_fetch_many(ops, hc->ctx, kvs, num);
+  for (size_t i = 0; i < num; i++)
+  {
+    if (!kvs[i].value)
+      continue;
+
+    hcache_decode(hc, kvs[i].value, kvs[i].vlen, uidvalidity, &items[i].entry);
+    if (items[i].entry.email)
+      found++;
+    ops->free(hc->ctx, &kvs[i].value);
+  }
+
+  for (size_t i = 0; i < num; i++)
+    mutt_buffer_dealloc(&keys[i]);
+  FREE(&kvs);
+  FREE(&keys);
+
+  return found;
+}
+
+/**
+ * mutt_hcache_fetch_raw - Fetch a message's header from the cache
+ * @param[in]  hc     Pointer to the struct HeaderCache structure got by mutt_hcache_open()
+ * @param[in]  key    Message identification string
+ * @param[in]  keylen Length of the string pointed to by key
+ * @param[out] dlen   Length of the fetched data
+ * @retval ptr  Success, the data if found
+ * @retval NULL Otherwise
+ *
+ * @note This function does not perform any check on the validity of the data found.
+ * @note The returned data must be free with mutt_hcache_free_raw().
+ */
+void *mutt_hcache_fetch_raw(struct HeaderCache *hc, const char *key,
+                            size_t keylen, size_t *dlen)
+{
+  const struct StoreOps *ops = hc ? hc->ops : NULL;
+
+  if (!hc || !ops)
+    return NULL;
+
+  struct Buffer path = mutt_buffer_make(1024);
+  keylen = mutt_buffer_printf(&path, "%s%.*s", hc->folder, (int) keylen, key);
+  queue_sync(hc, mutt_b2s(&path));
+  void *blob = ops->fetch(hc->ctx, mutt_b2s(&path), keylen, dlen);
+  mutt_buffer_dealloc(&path);
+  return blob;
+}
+
+/**
+ * mutt_hcache_free - Multiplexor for StoreOps::free
+ */
+void mutt_hcache_free_raw(struct HeaderCache *hc, void **data)
+{
+  const struct StoreOps *ops = hc ? hc->ops : NULL;
+
+  if (!hc || !ops || !data || !*data)
+    return;
+
+  ops->free(hc->ctx, data);
+}
+
+/**
+ * mutt_hcache_store - Multiplexor for StoreOps::store
+ */
+int mutt_hcache_store(struct HeaderCache *hc, const char *key, size_t keylen,
+                      struct Email *e, uint32_t uidvalidity)
+{
+  if (!hc)
+    return -1;
+
+  size_t dlen = 0;
+  char *data = hcache_encode(hc, e, uidvalidity, &dlen);
+  if (!data)
+    return -1;
+
   /* store uncompressed data */
   struct RealKey *rk = realkey(key, keylen);
   int rc = mutt_hcache_store_raw(hc, rk->key, rk->len, data, dlen);
@@ -565,6 +1384,76 @@ int mutt_hcache_store(struct HeaderCache *hc, const char *key, size_t keylen,
   return rc;
 }
 
+/**
+ * mutt_hcache_store_async - Queue a Header to be stored in the background
+ */
+int mutt_hcache_store_async(struct HeaderCache *hc, const char *key, size_t keylen,
+                            struct Email *e, uint32_t uidvalidity)
+{
+  if (!hc || !e)
+    return -1;
+
+  if (!hc->queue)
+    hc->queue = queue_new(hc);
+
+  int off = 0;
+  char *data = dump(hc, e, &off, uidvalidity);
+
+  struct Buffer skey = mutt_buffer_make(256);
+  size_t klen = hcache_store_key(hc, key, keylen, &skey);
+  queue_push(hc, mutt_buffer_strdup(&skey), klen, data, off);
+  mutt_buffer_dealloc(&skey);
+
+  return 0;
+}
+
+/**
+ * mutt_hcache_store_many - Multiplexor for StoreOps::store_many
+ */
+int mutt_hcache_store_many(struct HeaderCache *hc, struct HCacheItem *items, size_t num)
+{
+  const struct StoreOps *ops = hc ? hc->ops : NULL;
+  if (!hc || !ops || !items)
+    return -1;
+
+  if (num == 0)
+    return 0;
+
+  struct Buffer *keys = mutt_mem_calloc(num, sizeof(struct Buffer));
+  struct StoreKv *kvs = mutt_mem_calloc(num, sizeof(struct StoreKv));
+
+  size_t count = 0;
+  for (size_t i = 0; i < num; i++)
+  {
+    if (!items[i].entry.email)
+      continue;
+
+    char *data = hcache_encode(hc, items[i].entry.email, items[i].entry.uidvalidity,
+                               &kvs[count].vlen);
+    if (!data)
+      continue;
+
+    mutt_buffer_alloc(&keys[count], 256);
+    kvs[count].klen = hcache_store_key(hc, items[i].key, items[i].keylen, &keys[count]);
+    kvs[count].key = mutt_b2s(&keys[count]);
+    kvs[count].value = data;
+    queue_sync(hc, kvs[count].key);
+    count++;
+  }
+
+  int rc = store_store_many(ops, hc->ctx, kvs, count);
+
+  for (size_t i = 0; i < count; i++)
+  {
+    FREE(&kvs[i].value);
+    mutt_buffer_dealloc(&keys[i]);
+  }
+  FREE(&kvs);
+  FREE(&keys);
+
+  return rc;
+}
+
 /**
  * mutt_hcache_store_raw - store a key / data pair
  * @param hc     Pointer to the struct HeaderCache structure got by mutt_hcache_open()
@@ -578,7 +1467,7 @@ int mutt_hcache_store(struct HeaderCache *hc, const char *key, size_t keylen,
 int mutt_hcache_store_raw(struct HeaderCache *hc, const char *key,
                           size_t keylen, void *data, size_t dlen)
 {
-  const struct StoreOps *ops = hcache_get_ops();
+  const struct StoreOps *ops = hc ? hc->ops : NULL;
 
   if (!hc || !ops)
     return -1;
@@ -586,6 +1475,7 @@ int mutt_hcache_store_raw(struct HeaderCache *hc, const char *key,
   struct Buffer path = mutt_buffer_make(1024);
 
   keylen = mutt_buffer_printf(&path, "%s%.*s", hc->folder, (int) keylen, key);
+  queue_sync(hc, mutt_b2s(&path));
   int rc = ops->store(hc->ctx, mutt_b2s(&path), keylen, data, dlen);
   mutt_buffer_dealloc(&path);
 
@@ -597,15 +1487,273 @@ int mutt_hcache_store_raw(struct HeaderCache *hc, const char *key,
  */
 int mutt_hcache_delete_record(struct HeaderCache *hc, const char *key, size_t keylen)
 {
-  const struct StoreOps *ops = hcache_get_ops();
+  const struct StoreOps *ops = hc ? hc->ops : NULL;
   if (!hc)
     return -1;
 
   struct Buffer path = mutt_buffer_make(1024);
 
   keylen = mutt_buffer_printf(&path, "%s%s", hc->folder, key);
+  queue_sync(hc, mutt_b2s(&path));
 
   int rc = ops->delete_record(hc->ctx, mutt_b2s(&path), keylen);
   mutt_buffer_dealloc(&path);
   return rc;
 }
+
+/**
+ * struct HCacheGc - Remove the stale records of a folder
+ *
+ * The caller records the keys of all the folder's messages.  The Store is
+ * walked, a piece at a time, to find the folder's records that don't match
+ * any of them.  Then the stale records are deleted a few at a time.
+ */
+struct HCacheGc
+{
+  hcache_gc_filter_t filter; ///< Does a key belong to the folder?
+  struct HashTable *live;    ///< Keys of the folder's messages
+  struct ListHead stale;     ///< Store keys of the stale records
+  char *cursor;              ///< Last Store key walked, or NULL
+  size_t cursor_len;         ///< Length of the cursor
+  bool scanned;              ///< The Store has been walked
+  size_t removed;            ///< Number of records deleted
+};
+
+/**
+ * struct HCacheGcWalk - Private data for hcache_gc_walk_cb()
+ */
+struct HCacheGcWalk
+{
+  struct HeaderCache *hc; ///< Header cache handle
+  struct HCacheGc *gc;    ///< Garbage collector
+  struct Buffer *key;     ///< Temporary buffer
+  size_t flen;            ///< Length of the folder prefix
+  const char *suffix;     ///< Compression suffix of current records, or NULL
+  size_t slen;            ///< Length of the suffix
+  size_t seen;            ///< Number of keys walked
+  size_t max;             ///< Stop after this many keys
+};
+
+/**
+ * hcache_gc_walk_cb - Check whether a record is stale - Implements ::store_walk_t
+ */
+static bool hcache_gc_walk_cb(const char *key, size_t klen, void *data)
+{
+  struct HCacheGcWalk *w = data;
+
+  /* Every key counts, even other folders', so the time taken is bounded */
+  if (++w->seen == w->max)
+  {
+    FREE(&w->gc->cursor);
+    w->gc->cursor = mutt_strn_dup(key, klen);
+    w->gc->cursor_len = klen;
+  }
+
+  if ((klen <= w->flen) || (memcmp(key, w->hc->folder, w->flen) != 0))
+    return (w->seen < w->max);
+
+  key += w->flen;
+  klen -= w->flen;
+  if (!w->gc->filter(key, klen))
+    return (w->seen < w->max);
+
+  /* Records written with a different compression method are stale */
+  bool live = false;
+  if (!w->suffix || ((klen > w->slen) && (memcmp(key + klen - w->slen, w->suffix, w->slen) == 0)))
+  {
+    mutt_buffer_strcpy_n(w->key, key, klen - (w->suffix ? w->slen : 0));
+    live = mutt_hash_find(w->gc->live, mutt_b2s(w->key));
+  }
+
+  if (!live)
+  {
+    mutt_buffer_printf(w->key, "%s%.*s", w->hc->folder, (int) klen, key);
+    mutt_list_insert_tail(&w->gc->stale, mutt_buffer_strdup(w->key));
+  }
+
+  return (w->seen < w->max);
+}
+
+/**
+ * mutt_hcache_gc_new - Create a garbage collector for a folder
+ */
+struct HCacheGc *mutt_hcache_gc_new(hcache_gc_filter_t filter)
+{
+  if (!filter)
+    return NULL;
+
+  struct HCacheGc *gc = mutt_mem_calloc(1, sizeof(struct HCacheGc));
+  gc->filter = filter;
+  gc->live = mutt_hash_new(1024, MUTT_HASH_STRDUP_KEYS);
+  STAILQ_INIT(&gc->stale);
+  return gc;
+}
+
+/**
+ * mutt_hcache_gc_free - Free a garbage collector
+ */
+void mutt_hcache_gc_free(struct HCacheGc **ptr)
+{
+  if (!ptr || !*ptr)
+    return;
+
+  struct HCacheGc *gc = *ptr;
+  mutt_hash_free(&gc->live);
+  mutt_list_free(&gc->stale);
+  FREE(&gc->cursor);
+  FREE(ptr);
+}
+
+/**
+ * mutt_hcache_gc_live - Record the key of a live message
+ */
+void mutt_hcache_gc_live(struct HCacheGc *gc, const char *key, size_t keylen)
+{
+  if (!gc || !gc->live || !key)
+    return;
+
+  struct Buffer *buf = mutt_buffer_pool_get();
+  mutt_buffer_strcpy_n(buf, key, keylen);
+  if (!mutt_hash_find(gc->live, mutt_b2s(buf)))
+    mutt_hash_insert(gc->live, mutt_b2s(buf), gc);
+  mutt_buffer_pool_release(&buf);
+}
+
+/**
+ * mutt_hcache_gc_step - Delete some stale records
+ */
+bool mutt_hcache_gc_step(struct HeaderCache *hc, struct HCacheGc *gc, size_t max)
+{
+  if (!hc || !gc || !hc->ops || !hc->ops->walk)
+    return true;
+
+  if (!gc->scanned)
+  {
+    if (hc->queue)
+      queue_flush(hc);
+
+    struct HCacheGcWalk w = { hc, gc, mutt_buffer_pool_get(), mutt_str_len(hc->folder), NULL, 0, 0, max };
+#ifdef USE_HCACHE_COMPRESSION
+    struct Buffer suffix = mutt_buffer_make(0);
+    if (C_HeaderCacheCompressMethod)
+    {
+      mutt_buffer_printf(&suffix, "-%s", compr_get_ops()->name);
+      w.suffix = mutt_b2s(&suffix);
+      w.slen = mutt_buffer_len(&suffix);
+    }
+#endif
+
+    /* A copy, the walk may move the cursor */
+    char *start = mutt_strn_dup(gc->cursor, gc->cursor_len);
+    int rc = hc->ops->walk(hc->ctx, start, gc->cursor_len, hcache_gc_walk_cb, &w);
+    FREE(&start);
+
+#ifdef USE_HCACHE_COMPRESSION
+    mutt_buffer_dealloc(&suffix);
+#endif
+    mutt_buffer_pool_release(&w.key);
+
+    if (rc != 0)
+    {
+      mutt_debug(LL_DEBUG1, "Can't walk the header cache %s\n", hc->path);
+      mutt_list_free(&gc->stale);
+    }
+    else if (w.seen == max)
+    {
+      /* The walk was stopped, continue it next time */
+      return false;
+    }
+
+    mutt_hash_free(&gc->live);
+    FREE(&gc->cursor);
+    gc->scanned = true;
+
+    return STAILQ_EMPTY(&gc->stale);
+  }
+
+  for (size_t i = 0; (i < max) && !STAILQ_EMPTY(&gc->stale); i++)
+  {
+    struct ListNode *np = STAILQ_FIRST(&gc->stale);
+    if (hc->ops->delete_record(hc->ctx, np->data, mutt_str_len(np->data)) == 0)
+      gc->removed++;
+    STAILQ_REMOVE_HEAD(&gc->stale, entries);
+    FREE(&np->data);
+    FREE(&np);
+  }
+
+  if (STAILQ_EMPTY(&gc->stale))
+  {
+    mutt_debug(LL_DEBUG1, "Removed %zu stale records of %s from the header cache\n",
+               gc->removed, hc->folder);
+    return true;
+  }
+
+  return false;
+}
+
+/**
+ * mutt_hcache_gc_removed - How many records has the garbage collector deleted?
+ */
+size_t mutt_hcache_gc_removed(const struct HCacheGc *gc)
+{
+  return gc ? gc->removed : 0;
+}
+
+/**
+ * hcache_db_size - Get the size of a database
+ * @param path Path to the database file, or directory
+ * @retval num Size in bytes
+ */
+static long hcache_db_size(const char *path)
+{
+  struct stat st = { 0 };
+  if (stat(path, &st) != 0)
+    return 0;
+
+  if (!S_ISDIR(st.st_mode))
+    return st.st_size;
+
+  /* Some backends, e.g. RocksDB, use a directory of files */
+  long size = 0;
+  DIR *dir = opendir(path);
+  if (!dir)
+    return 0;
+
+  struct Buffer *file = mutt_buffer_pool_get();
+  struct dirent *de = NULL;
+  while ((de = readdir(dir)))
+  {
+    mutt_buffer_concat_path(file, path, de->d_name);
+    if ((stat(mutt_b2s(file), &st) == 0) && S_ISREG(st.st_mode))
+      size += st.st_size;
+  }
+  mutt_buffer_pool_release(&file);
+  closedir(dir);
+
+  return size;
+}
+
+/**
+ * mutt_hcache_compact - Release the space used by deleted records
+ */
+long mutt_hcache_compact(struct HeaderCache *hc)
+{
+  if (!hc || !hc->ops || !hc->ops->compact || !hc->path)
+    return -1;
+
+  if (hc->queue)
+    queue_flush(hc);
+
+  long before = hcache_db_size(hc->path);
+  int rc = hc->ops->compact(hc->ctx);
+  if (rc != 0)
+  {
+    mutt_debug(LL_DEBUG1, "Can't compact the header cache %s: %d\n", hc->path, rc);
+    return -1;
+  }
+  long after = hcache_db_size(hc->path);
+
+  mutt_debug(LL_DEBUG1, "Compacted the header cache %s: %ld -> %ld bytes\n",
+             hc->path, before, after);
+  return MAX(before - after, 0);
+}
@@ -1,59 +1,9 @@
 #!/bin/sh
 
-BASEVERSION=6
-STRUCTURES="Address Body Buffer Email Envelope ListNode Parameter"
-
-cleanstruct () {
-  echo "$1" | sed -e 's/.* //'
-}
-
-cleanbody () {
-  echo "$1" | sed -e 's/{ *//'
-}
-
-getstruct () {
-  STRUCT=""
-  BODY=''
-  inbody=0
-  case "$1" in
-    *'{') inbody=1 ;;
-    *';') return ;;
-  esac
-
-  STRUCT=`cleanstruct "$1"`
-
-  while read line
-  do
-    if test $inbody -eq 0
-    then
-      case "$line" in
-        '{'*) inbody=1 ;;
-        *';') return ;;
-      esac
-    fi
-
-    case "$line" in
-      '};'*)
-        break
-      ;;
-      '#'*) continue ;;
-      *)
-        if test $inbody -ne 0
-        then
-          BODY="$BODY $line"
-        fi
-      ;;
-    esac
-  done
-
-  for s in ${STRUCTURES}; do
-    if [ ${STRUCT} = $s ]; then
-      BODY=`cleanbody "$BODY"`
-      echo "$STRUCT: $BODY"
-    fi
-  done
-  return
-}
+# The cache stores tagged records (see hcache/serialize.c), so it doesn't
+# depend on the layout of the C structs.  Bump BASEVERSION if the encoding
+# of an existing field changes.
+BASEVERSION=8
 
 md5prog () {
   prog=""
@@ -91,30 +41,10 @@ md5prog () {
 DEST="$1"
 TMPD="$DEST.tmp"
 
-TEXT="$BASEVERSION"
-
-echo "/* base version: $BASEVERSION" > $TMPD
-while read line
-do
-  case "$line" in
-    'struct'*)
-       STRUCT=`getstruct "$line"`
-       if test -n "$STRUCT"
-       then
-         NAME=`echo $STRUCT | cut -d: -f1`
-         BODY=`echo $STRUCT | cut -d' ' -f2-`
-         echo " * $NAME:" $BODY >> $TMPD
-         TEXT="$TEXT $NAME {$BODY}"
-       fi
-    ;;
-  esac
-done
-echo " */" >> $TMPD
+echo "/* base version: $BASEVERSION */" > $TMPD
 
 MD5PROG=$(md5prog)
-MD5TEXT=`echo "$TEXT" | $MD5PROG | cut -c-8`
+MD5TEXT=`echo "$BASEVERSION" | $MD5PROG | cut -c-8`
 echo "#define HCACHEVER 0x$MD5TEXT" >> $TMPD
 
-# TODO: validate we have all structs
-
 mv $TMPD $DEST
@@ -42,18 +42,18 @@
  * @sa Address Body Buffer Email Envelope ListNode Parameter
  *
  * To save the data, the Header Cache uses a set of 'dump' functions
- * (\ref hc_serial) to 'serialise' the structures.  The cache also stores a CRC
- * checksum of the C structs that were used.  When retrieving the data, the
- * Header Cache uses a set of 'restore' functions to turn the data back into
- * structs.
+ * (\ref hc_serial) to 'serialise' the structures into a tagged record.  Each
+ * field of the record is identified by a tag, so the format doesn't depend on
+ * the layout of the C structs.  Readers skip fields they don't know and use
+ * defaults for fields that are missing.  When retrieving the data, the Header
+ * Cache uses a set of 'restore' functions to turn the data back into structs.
  *
- * The CRC checksum is created by `hcache/hcachever.sh` during the build
- * process.  Whenever the definition of any of the structs changes, the CRC will
- * change, invalidating any existing cached data.
+ * The cache also stores a CRC checksum, created by `hcache/hcachever.sh`
+ * during the build process, mixed with the user's spam config.
  *
- * @note Adding or removing a field from the set of serialised fields will
- * **not** affect the CRC.  In this case, it is vital that you bump the
- * **`BASEVERSION`** variable in `hcache/hcachever.sh`
+ * @note Adding a new field to the record does **not** need a new CRC.
+ * If the encoding of an existing field changes, either give it a new tag or
+ * bump the **`BASEVERSION`** variable in `hcache/hcachever.sh`
  *
  * ## Source
  *
@@ -67,12 +67,18 @@
 #ifndef MUTT_HCACHE_LIB_H
 #define MUTT_HCACHE_LIB_H
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
 struct Buffer;
 struct ConfigSet;
+struct ConnAccount;
 struct Email;
+struct HCacheDict;
+struct HCacheGc;
+struct HCacheQueue;
+struct StoreOps;
 
 /**
  * struct HeaderCache - header cache structure
@@ -86,8 +92,12 @@ struct HeaderCache
 {
   char *folder;
   unsigned int crc;
+  char *path;                 ///< Path to the database
+  const struct StoreOps *ops; ///< Store backend
   void *ctx;
   void *cctx;
+  struct HCacheQueue *queue; ///< Records waiting to be written
+  struct HCacheDict *dict;   ///< Compression dictionary
 };
 
 /**
@@ -96,10 +106,23 @@ struct HeaderCache
 struct HCacheEntry
 {
   uint32_t uidvalidity; ///< IMAP-specific UIDVALIDITY
-  unsigned int crc;     ///< CRC of Email/Body/etc structs
+  unsigned int crc;     ///< CRC of the record format and spam config
   struct Email *email;  ///< Retrieved email
 };
 
+/**
+ * struct HCacheItem - One entry in a batch header cache operation
+ *
+ * For mutt_hcache_store_many(), the caller fills in the entry's Email and
+ * uidvalidity.  For mutt_hcache_fetch_many(), they are filled in by the cache.
+ */
+struct HCacheItem
+{
+  const char *key;          ///< Message identification string
+  size_t keylen;            ///< Length of the key string
+  struct HCacheEntry entry; ///< Email and its validity
+};
+
 /**
  * typedef hcache_namer_t - Prototype for function to compose hcache file names
  * @param path    Path of message
@@ -107,8 +130,24 @@ struct HCacheEntry
  */
 typedef void (*hcache_namer_t)(const char *path, struct Buffer *dest);
 
+/**
+ * typedef hcache_gc_filter_t - Prototype for a function to recognise a folder's keys
+ * @param key    Key, without the folder prefix
+ * @param keylen Length of the key
+ * @retval true The key belongs to a message of the folder
+ *
+ * The key passed to the filter is whatever follows the folder's name, so the
+ * filter must reject any key that doesn't start with a separator: the records
+ * of `/mail/box2` also begin with `/mail/box`.  It must also reject the keys
+ * of subfolders, e.g. `/mail/box/sub`, and any non-message records.
+ */
+typedef bool (*hcache_gc_filter_t)(const char *key, size_t keylen);
+
 extern char *C_HeaderCache;
 extern char *C_HeaderCacheBackend;
+extern bool  C_HeaderCacheLazy;
+extern long  C_HeaderCacheMemory;
+extern bool  C_HeaderCacheShared;
 extern short C_HeaderCacheCompressLevel;
 extern char *C_HeaderCacheCompressMethod;
 extern bool  C_MaildirHeaderCacheVerify;
@@ -119,10 +158,12 @@ extern bool  C_MaildirHeaderCacheVerify;
  * @param folder Name of the folder containing the messages
  * @param namer  Optional (might be NULL) client-specific function to form the
  *               final name of the hcache database file.
+ * @param cac    Account of a remote folder, NULL for a local folder
  * @retval ptr  Success, struct HeaderCache struct
  * @retval NULL Otherwise
  */
-struct HeaderCache *mutt_hcache_open(const char *path, const char *folder, hcache_namer_t namer);
+struct HeaderCache *mutt_hcache_open(const char *path, const char *folder,
+                                     hcache_namer_t namer, struct ConnAccount *cac);
 
 /**
  * mutt_hcache_close - close the connection to the header cache
@@ -130,6 +171,13 @@ struct HeaderCache *mutt_hcache_open(const char *path, const char *folder, hcach
  */
 void mutt_hcache_close(struct HeaderCache *hc);
 
+/**
+ * mutt_hcache_cleanup - close any shared Stores that are still open
+ *
+ * Called once, when NeoMutt exits.
+ */
+void mutt_hcache_cleanup(void);
+
 /**
  * mutt_hcache_store - store a Header along with a validity datum
  * @param hc          Pointer to the struct HeaderCache structure got by mutt_hcache_open()
@@ -156,6 +204,49 @@ int mutt_hcache_store(struct HeaderCache *hc, const char *key, size_t keylen,
  */
 struct HCacheEntry mutt_hcache_fetch(struct HeaderCache *hc, const char *key, size_t keylen, uint32_t uidvalidity);
 
+/**
+ * mutt_hcache_fetch_many - fetch and validate many messages' headers from the cache
+ * @param hc          Pointer to the struct HeaderCache structure got by mutt_hcache_open()
+ * @param items       Array of keys, the entries will be filled in
+ * @param num         Number of items in the array
+ * @param uidvalidity Only restore if it matches the stored uidvalidity
+ * @retval num Number of Emails restored
+ *
+ * All the keys are looked up in a single backend transaction.
+ * Entries that aren't found, or aren't valid, will have a NULL Email.
+ */
+size_t mutt_hcache_fetch_many(struct HeaderCache *hc, struct HCacheItem *items, size_t num, uint32_t uidvalidity);
+
+/**
+ * mutt_hcache_store_async - queue a Header to be stored in the background
+ * @param hc          Pointer to the struct HeaderCache structure got by mutt_hcache_open()
+ * @param key         Message identification string
+ * @param keylen      Length of the key string
+ * @param e           Email to store
+ * @param uidvalidity IMAP-specific UIDVALIDITY value, or 0 to use the current time
+ * @retval 0   Success
+ * @retval num Generic or backend-specific error code otherwise
+ *
+ * The Email is serialised immediately, so the caller may change or free it.
+ * The record is compressed in the background and written to the store in
+ * batches.  Any queued records are written by mutt_hcache_close(), or before
+ * their key is read or written by another function.
+ */
+int mutt_hcache_store_async(struct HeaderCache *hc, const char *key, size_t keylen,
+                            struct Email *e, uint32_t uidvalidity);
+
+/**
+ * mutt_hcache_store_many - store many Headers in one transaction
+ * @param hc    Pointer to the struct HeaderCache structure got by mutt_hcache_open()
+ * @param items Array of keys, Emails and validity data
+ * @param num   Number of items in the array
+ * @retval 0   Success
+ * @retval num Generic or backend-specific error code otherwise
+ *
+ * Items with a NULL Email are skipped.
+ */
+int mutt_hcache_store_many(struct HeaderCache *hc, struct HCacheItem *items, size_t num);
+
 int mutt_hcache_store_raw(struct HeaderCache *hc, const char *key, size_t keylen,
                           void *data, size_t dlen);
 
@@ -178,4 +269,57 @@ void mutt_hcache_free_raw(struct HeaderCache *hc, void **data);
  */
 int mutt_hcache_delete_record(struct HeaderCache *hc, const char *key, size_t keylen);
 
+/**
+ * mutt_hcache_gc_new - create a garbage collector for a folder
+ * @param filter Function to recognise the folder's keys
+ * @retval ptr New garbage collector
+ *
+ * Record the key of every message using mutt_hcache_gc_live(), then call
+ * mutt_hcache_gc_step() until it returns true.  Any of the folder's records
+ * that don't match a live key are deleted.
+ */
+struct HCacheGc *mutt_hcache_gc_new(hcache_gc_filter_t filter);
+
+/**
+ * mutt_hcache_gc_free - free a garbage collector
+ * @param ptr Garbage collector to free
+ */
+void mutt_hcache_gc_free(struct HCacheGc **ptr);
+
+/**
+ * mutt_hcache_gc_live - record the key of a live message
+ * @param gc     Garbage collector
+ * @param key    Message identification string
+ * @param keylen Length of the key string
+ */
+void mutt_hcache_gc_live(struct HCacheGc *gc, const char *key, size_t keylen);
+
+/**
+ * mutt_hcache_gc_step - delete some stale records
+ * @param hc  Pointer to the struct HeaderCache structure got by mutt_hcache_open()
+ * @param gc  Garbage collector
+ * @param max Maximum number of records to look at, or to delete
+ * @retval true  All the stale records have been deleted
+ * @retval false There's more work to do
+ *
+ * The first steps walk the Store to find the stale records, looking at @a max
+ * records each time; later steps delete them.
+ */
+bool mutt_hcache_gc_step(struct HeaderCache *hc, struct HCacheGc *gc, size_t max);
+
+/**
+ * mutt_hcache_gc_removed - get the number of records a garbage collector has deleted
+ * @param gc Garbage collector
+ * @retval num Number of records deleted
+ */
+size_t mutt_hcache_gc_removed(const struct HCacheGc *gc);
+
+/**
+ * mutt_hcache_compact - release the space used by deleted records
+ * @param hc Pointer to the struct HeaderCache structure got by mutt_hcache_open()
+ * @retval num Number of bytes reclaimed
+ * @retval -1  The Store can't be compacted
+ */
+long mutt_hcache_compact(struct HeaderCache *hc);
+
 #endif /* MUTT_HCACHE_LIB_H */
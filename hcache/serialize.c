@@ -27,10 +27,27 @@
  * @page hc_serial Email-object serialiser
  *
  * Email-object serialiser
+ *
+ * An Email is stored as a tagged record, so the cache doesn't depend on the
+ * layout of any of the C structs:
+ *
+ * | Size              | Description                                    |
+ * | :---------------- | :--------------------------------------------- |
+ * | uint16_t          | Record format, #HC_RECORD_VERSION              |
+ * | uint16_t          | Number of fields                               |
+ * | uint32_t          | Size of the record, including this header      |
+ * | 12 bytes, N times | Field: uint16_t tag, 2 reserved bytes, uint32_t offset, uint32_t length |
+ * | ...               | Data of the fields                             |
+ *
+ * The offsets are relative to the start of the record.  A reader looks up the
+ * fields it knows (see #HcacheTag) and ignores the rest.  Missing fields take
+ * a default value.  A field may contain a nested record, e.g. #HC_TAG_BODY.
  */
 
 #include "config.h"
+#include <assert.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <string.h>
 #include <sys/types.h>
 #include "mutt/lib.h"
@@ -111,6 +128,239 @@ void serial_restore_uint32_t(uint32_t *s, const unsigned char *d, int *off)
   (*off) += sizeof(uint32_t);
 }
 
+/**
+ * serial_dump_int64_t - Pack an int64_t into a binary blob
+ * @param i   int64_t to save
+ * @param d   Binary blob to add to
+ * @param off Offset into the blob
+ * @retval ptr End of the newly packed binary
+ */
+unsigned char *serial_dump_int64_t(int64_t i, unsigned char *d, int *off)
+{
+  lazy_realloc(&d, *off + sizeof(int64_t));
+  memcpy(d + *off, &i, sizeof(int64_t));
+  (*off) += sizeof(int64_t);
+
+  return d;
+}
+
+/**
+ * serial_record_begin - Start packing a tagged record
+ * @param w   Record writer to initialise
+ * @param num Maximum number of fields in the record
+ * @param d   Binary blob to add to
+ * @param off Offset into the blob
+ * @retval ptr End of the newly packed binary
+ *
+ * Reserve space for the record's header and its table of fields.
+ * Each field is then added with serial_record_field_begin() and
+ * serial_record_field_end() and the record is completed with
+ * serial_record_end().
+ */
+unsigned char *serial_record_begin(struct SerialRecordWriter *w, uint16_t num,
+                                   unsigned char *d, int *off)
+{
+  const size_t size = HC_RECORD_HEADER_SIZE + (num * HC_RECORD_FIELD_SIZE);
+
+  w->start = *off;
+  w->num = num;
+  w->used = 0;
+  w->field = 0;
+
+  lazy_realloc(&d, *off + size);
+  memset(d + *off, 0, size);
+  *off += size;
+
+  return d;
+}
+
+/**
+ * serial_record_field_begin - Start packing a field of a tagged record
+ * @param w   Record writer
+ * @param off Offset into the blob
+ */
+void serial_record_field_begin(struct SerialRecordWriter *w, int *off)
+{
+  w->field = *off;
+}
+
+/**
+ * serial_record_field_end - Finish packing a field of a tagged record
+ * @param w   Record writer
+ * @param tag Tag identifying the field, e.g. #HC_TAG_BODY
+ * @param d   Binary blob
+ * @param off Offset into the blob
+ *
+ * Everything packed since serial_record_field_begin() becomes the field's data.
+ */
+void serial_record_field_end(struct SerialRecordWriter *w, uint16_t tag,
+                             unsigned char *d, int *off)
+{
+  assert(w->used < w->num);
+
+  unsigned char *entry = d + w->start + HC_RECORD_HEADER_SIZE +
+                         (w->used * HC_RECORD_FIELD_SIZE);
+  const uint32_t foff = w->field - w->start;
+  const uint32_t flen = *off - w->field;
+
+  memcpy(entry, &tag, sizeof(uint16_t));
+  memcpy(entry + 4, &foff, sizeof(uint32_t));
+  memcpy(entry + 8, &flen, sizeof(uint32_t));
+  w->used++;
+}
+
+/**
+ * serial_record_int - Pack a numeric field into a tagged record
+ * @param w   Record writer
+ * @param tag Tag identifying the field, e.g. #HC_TAG_LINES
+ * @param i   Value to save
+ * @param d   Binary blob to add to
+ * @param off Offset into the blob
+ * @retval ptr End of the newly packed binary
+ */
+unsigned char *serial_record_int(struct SerialRecordWriter *w, uint16_t tag,
+                                 int64_t i, unsigned char *d, int *off)
+{
+  serial_record_field_begin(w, off);
+  d = serial_dump_int64_t(i, d, off);
+  serial_record_field_end(w, tag, d, off);
+  return d;
+}
+
+/**
+ * serial_record_end - Finish packing a tagged record
+ * @param w   Record writer
+ * @param d   Binary blob
+ * @param off Offset into the blob
+ */
+void serial_record_end(struct SerialRecordWriter *w, unsigned char *d, int *off)
+{
+  const uint16_t version = HC_RECORD_VERSION;
+  const uint32_t size = *off - w->start;
+
+  memcpy(d + w->start, &version, sizeof(uint16_t));
+  memcpy(d + w->start + 2, &w->used, sizeof(uint16_t));
+  memcpy(d + w->start + 4, &size, sizeof(uint32_t));
+}
+
+/**
+ * serial_record_open - Check and open a tagged record
+ * @param rec  Record to initialise
+ * @param d    Binary blob to read from
+ * @param dlen Length of the blob
+ * @retval true  Success, the record is valid
+ * @retval false The blob isn't a record this version understands
+ */
+bool serial_record_open(struct SerialRecord *rec, const unsigned char *d, size_t dlen)
+{
+  if (!rec || !d || (dlen < HC_RECORD_HEADER_SIZE))
+    return false;
+
+  uint16_t version = 0;
+  uint16_t num = 0;
+  uint32_t size = 0;
+  memcpy(&version, d, sizeof(uint16_t));
+  memcpy(&num, d + 2, sizeof(uint16_t));
+  memcpy(&size, d + 4, sizeof(uint32_t));
+
+  if (version != HC_RECORD_VERSION)
+    return false;
+  if ((size > dlen) || (size < (HC_RECORD_HEADER_SIZE + (num * HC_RECORD_FIELD_SIZE))))
+    return false;
+
+  rec->data = d;
+  rec->size = size;
+  rec->num = num;
+  return true;
+}
+
+/**
+ * serial_record_field - Find a field in a tagged record
+ * @param[in]  rec Record to search
+ * @param[in]  tag Tag of the field, e.g. #HC_TAG_BODY
+ * @param[out] len Length of the field's data
+ * @retval ptr  Field's data
+ * @retval NULL Field isn't present
+ *
+ * Only the table of fields is read, none of the data is decoded.
+ */
+const unsigned char *serial_record_field(const struct SerialRecord *rec,
+                                         uint16_t tag, size_t *len)
+{
+  if (!rec || !rec->data)
+    return NULL;
+
+  const unsigned char *entry = rec->data + HC_RECORD_HEADER_SIZE;
+  for (uint16_t i = 0; i < rec->num; i++, entry += HC_RECORD_FIELD_SIZE)
+  {
+    uint16_t etag = 0;
+    memcpy(&etag, entry, sizeof(uint16_t));
+    if (etag != tag)
+      continue;
+
+    uint32_t foff = 0;
+    uint32_t flen = 0;
+    memcpy(&foff, entry + 4, sizeof(uint32_t));
+    memcpy(&flen, entry + 8, sizeof(uint32_t));
+    if ((foff > rec->size) || (flen > (rec->size - foff)))
+      return NULL;
+
+    if (len)
+      *len = flen;
+    return rec->data + foff;
+  }
+
+  return NULL;
+}
+
+/**
+ * serial_record_get_int - Read a numeric field from a tagged record
+ * @param rec Record to search
+ * @param tag Tag of the field, e.g. #HC_TAG_LINES
+ * @param def Default value if the field isn't present
+ * @retval num Value of the field
+ *
+ * Fields of 1, 2, 4 or 8 bytes are understood, so a field may be widened
+ * without invalidating old records.
+ */
+int64_t serial_record_get_int(const struct SerialRecord *rec, uint16_t tag, int64_t def)
+{
+  size_t len = 0;
+  const unsigned char *d = serial_record_field(rec, tag, &len);
+  if (!d)
+    return def;
+
+  switch (len)
+  {
+    case sizeof(int8_t):
+    {
+      int8_t i;
+      memcpy(&i, d, sizeof(i));
+      return i;
+    }
+    case sizeof(int16_t):
+    {
+      int16_t i;
+      memcpy(&i, d, sizeof(i));
+      return i;
+    }
+    case sizeof(int32_t):
+    {
+      int32_t i;
+      memcpy(&i, d, sizeof(i));
+      return i;
+    }
+    case sizeof(int64_t):
+    {
+      int64_t i;
+      memcpy(&i, d, sizeof(i));
+      return i;
+    }
+    default:
+      return def;
+  }
+}
+
 /**
  * serial_dump_char_size - Pack a fixed-length string into a binary blob
  * @param c       String to pack
@@ -201,6 +451,35 @@ void serial_restore_char(char **c, const unsigned char *d, int *off, bool conver
   *off += size;
 }
 
+/**
+ * serial_restore_intern - Unpack a shared string from a binary blob
+ * @param[out] c       Store the shared string here, see mutt_intern_get()
+ * @param[in]  d       Binary blob to read from
+ * @param[out] off     Offset into the blob
+ * @param[in]  convert If true, the string will be converted from utf-8
+ *
+ * If the string doesn't need converting, it's shared straight from the blob.
+ */
+void serial_restore_intern(char **c, const unsigned char *d, int *off, bool convert)
+{
+  unsigned int size = 0;
+  int pos = *off;
+  serial_restore_int(&size, d, &pos);
+
+  const char *s = (const char *) d + pos;
+  if ((size > 0) && (s[size - 1] == '\0') && (!convert || mutt_str_is_ascii(s, size)))
+  {
+    *c = mutt_intern_get(s);
+    *off = pos + size;
+    return;
+  }
+
+  char *tmp = NULL;
+  serial_restore_char(&tmp, d, off, convert);
+  *c = mutt_intern_get(tmp);
+  FREE(&tmp);
+}
+
 /**
  * serial_dump_address - Pack an Address into a binary blob
  * @param al      AddressList to pack
@@ -417,36 +696,63 @@ void serial_restore_parameter(struct ParameterList *pl, const unsigned char *d,
  * @param off     Offset into the blob
  * @param convert If true, the strings will be converted to utf-8
  * @retval ptr End of the newly packed binary
+ *
+ * The Body is packed as a nested record, see #HcacheBodyTag.
  */
 unsigned char *serial_dump_body(struct Body *c, unsigned char *d, int *off, bool convert)
 {
-  struct Body nb;
+  struct SerialRecordWriter w = { 0 };
+  uint32_t flags = 0;
+
+  /* the pointers, and the 'tagged' and 'deleted' states aren't cached */
+  if (c->use_disp)
+    flags |= HC_BODY_USE_DISP;
+  if (c->unlink)
+    flags |= HC_BODY_UNLINK;
+  if (c->noconv)
+    flags |= HC_BODY_NOCONV;
+  if (c->force_charset)
+    flags |= HC_BODY_FORCE_CHARSET;
+  if (c->goodsig)
+    flags |= HC_BODY_GOODSIG;
+  if (c->warnsig)
+    flags |= HC_BODY_WARNSIG;
+  if (c->badsig)
+    flags |= HC_BODY_BADSIG;
+#ifdef USE_AUTOCRYPT
+  if (c->is_autocrypt)
+    flags |= HC_BODY_IS_AUTOCRYPT;
+#endif
+  if (c->collapsed)
+    flags |= HC_BODY_COLLAPSED;
+  if (c->attach_qualifies)
+    flags |= HC_BODY_ATTACH_QUALIFIES;
 
-  memcpy(&nb, c, sizeof(struct Body));
+  d = serial_record_begin(&w, HC_BODY_TAG_MAX, d, off);
 
-  /* some fields are not safe to cache */
-  nb.content = NULL;
-  nb.charset = NULL;
-  nb.next = NULL;
-  nb.parts = NULL;
-  nb.email = NULL;
-  nb.aptr = NULL;
-  nb.mime_headers = NULL;
-  nb.language = NULL;
+  d = serial_record_int(&w, HC_BODY_TAG_TYPE, c->type, d, off);
+  d = serial_record_int(&w, HC_BODY_TAG_ENCODING, c->encoding, d, off);
+  d = serial_record_int(&w, HC_BODY_TAG_DISPOSITION, c->disposition, d, off);
+  d = serial_record_int(&w, HC_BODY_TAG_FLAGS, flags, d, off);
+  d = serial_record_int(&w, HC_BODY_TAG_HDR_OFFSET, c->hdr_offset, d, off);
+  d = serial_record_int(&w, HC_BODY_TAG_OFFSET, c->offset, d, off);
+  d = serial_record_int(&w, HC_BODY_TAG_LENGTH, c->length, d, off);
+  d = serial_record_int(&w, HC_BODY_TAG_ATTACH_COUNT, c->attach_count, d, off);
+  d = serial_record_int(&w, HC_BODY_TAG_STAMP, c->stamp, d, off);
 
-  lazy_realloc(&d, *off + sizeof(struct Body));
-  memcpy(d + *off, &nb, sizeof(struct Body));
-  *off += sizeof(struct Body);
+  serial_record_field_begin(&w, off);
+  d = serial_dump_char(c->xtype, d, off, false);
+  d = serial_dump_char(c->subtype, d, off, false);
 
-  d = serial_dump_char(nb.xtype, d, off, false);
-  d = serial_dump_char(nb.subtype, d, off, false);
+  d = serial_dump_parameter(&c->parameter, d, off, convert);
 
-  d = serial_dump_parameter(&nb.parameter, d, off, convert);
+  d = serial_dump_char(c->description, d, off, convert);
+  d = serial_dump_char(c->form_name, d, off, convert);
+  d = serial_dump_char(c->filename, d, off, convert);
+  d = serial_dump_char(c->d_filename, d, off, convert);
+  serial_record_field_end(&w, HC_BODY_TAG_STRINGS, d, off);
 
-  d = serial_dump_char(nb.description, d, off, convert);
-  d = serial_dump_char(nb.form_name, d, off, convert);
-  d = serial_dump_char(nb.filename, d, off, convert);
-  d = serial_dump_char(nb.d_filename, d, off, convert);
+  serial_record_end(&w, d, off);
 
   return d;
 }
@@ -455,25 +761,283 @@ unsigned char *serial_dump_body(struct Body *c, unsigned char *d, int *off, bool
  * serial_restore_body - Unpack a Body from a binary blob
  * @param c       Store the unpacked Body here
  * @param d       Binary blob to read from
+ * @param dlen    Length of the blob
+ * @param convert If true, the strings will be converted from utf-8
+ * @retval true  Success
+ * @retval false The blob isn't a valid Body record
+ */
+bool serial_restore_body(struct Body *c, const unsigned char *d, size_t dlen, bool convert)
+{
+  struct SerialRecord rec = { 0 };
+  if (!serial_record_open(&rec, d, dlen))
+    return false;
+
+  c->type = serial_record_get_int(&rec, HC_BODY_TAG_TYPE, c->type);
+  c->encoding = serial_record_get_int(&rec, HC_BODY_TAG_ENCODING, c->encoding);
+  c->disposition = serial_record_get_int(&rec, HC_BODY_TAG_DISPOSITION, c->disposition);
+  c->hdr_offset = serial_record_get_int(&rec, HC_BODY_TAG_HDR_OFFSET, c->hdr_offset);
+  c->offset = serial_record_get_int(&rec, HC_BODY_TAG_OFFSET, c->offset);
+  c->length = serial_record_get_int(&rec, HC_BODY_TAG_LENGTH, c->length);
+  c->attach_count = serial_record_get_int(&rec, HC_BODY_TAG_ATTACH_COUNT, c->attach_count);
+  c->stamp = serial_record_get_int(&rec, HC_BODY_TAG_STAMP, c->stamp);
+
+  const uint32_t flags = serial_record_get_int(&rec, HC_BODY_TAG_FLAGS, 0);
+  c->use_disp = (flags & HC_BODY_USE_DISP);
+  c->unlink = (flags & HC_BODY_UNLINK);
+  c->noconv = (flags & HC_BODY_NOCONV);
+  c->force_charset = (flags & HC_BODY_FORCE_CHARSET);
+  c->goodsig = (flags & HC_BODY_GOODSIG);
+  c->warnsig = (flags & HC_BODY_WARNSIG);
+  c->badsig = (flags & HC_BODY_BADSIG);
+#ifdef USE_AUTOCRYPT
+  c->is_autocrypt = (flags & HC_BODY_IS_AUTOCRYPT);
+#endif
+  c->collapsed = (flags & HC_BODY_COLLAPSED);
+  c->attach_qualifies = (flags & HC_BODY_ATTACH_QUALIFIES);
+
+  const unsigned char *strings = serial_record_field(&rec, HC_BODY_TAG_STRINGS, NULL);
+  if (!strings)
+    return true;
+
+  int off = 0;
+  serial_restore_char(&c->xtype, strings, &off, false);
+  serial_restore_char(&c->subtype, strings, &off, false);
+
+  serial_restore_parameter(&c->parameter, strings, &off, convert);
+
+  serial_restore_char(&c->description, strings, &off, convert);
+  serial_restore_char(&c->form_name, strings, &off, convert);
+  serial_restore_char(&c->filename, strings, &off, convert);
+  serial_restore_char(&c->d_filename, strings, &off, convert);
+
+  return true;
+}
+
+/**
+ * record_address - Pack an AddressList field into a tagged record
+ * @param w       Record writer
+ * @param tag     Tag identifying the field, e.g. #HC_ENV_TAG_FROM
+ * @param al      AddressList to pack
+ * @param d       Binary blob to add to
+ * @param off     Offset into the blob
+ * @param convert If true, the strings will be converted to utf-8
+ * @retval ptr End of the newly packed binary
+ *
+ * An empty list isn't packed.
+ */
+static unsigned char *record_address(struct SerialRecordWriter *w, uint16_t tag,
+                                     struct AddressList *al, unsigned char *d,
+                                     int *off, bool convert)
+{
+  if (TAILQ_EMPTY(al))
+    return d;
+
+  serial_record_field_begin(w, off);
+  d = serial_dump_address(al, d, off, convert);
+  serial_record_field_end(w, tag, d, off);
+  return d;
+}
+
+/**
+ * record_char - Pack a string field into a tagged record
+ * @param w       Record writer
+ * @param tag     Tag identifying the field, e.g. #HC_ENV_TAG_SUBJECT
+ * @param c       String to pack
+ * @param d       Binary blob to add to
  * @param off     Offset into the blob
+ * @param convert If true, the strings will be converted to utf-8
+ * @retval ptr End of the newly packed binary
+ *
+ * A NULL string isn't packed.
+ */
+static unsigned char *record_char(struct SerialRecordWriter *w, uint16_t tag,
+                                  char *c, unsigned char *d, int *off, bool convert)
+{
+  if (!c)
+    return d;
+
+  serial_record_field_begin(w, off);
+  d = serial_dump_char(c, d, off, convert);
+  serial_record_field_end(w, tag, d, off);
+  return d;
+}
+
+/**
+ * record_stailq - Pack a STAILQ field into a tagged record
+ * @param w       Record writer
+ * @param tag     Tag identifying the field, e.g. #HC_ENV_TAG_REFERENCES
+ * @param l       List to pack
+ * @param d       Binary blob to add to
+ * @param off     Offset into the blob
+ * @param convert If true, the strings will be converted to utf-8
+ * @retval ptr End of the newly packed binary
+ *
+ * An empty list isn't packed.
+ */
+static unsigned char *record_stailq(struct SerialRecordWriter *w, uint16_t tag,
+                                    struct ListHead *l, unsigned char *d,
+                                    int *off, bool convert)
+{
+  if (STAILQ_EMPTY(l))
+    return d;
+
+  serial_record_field_begin(w, off);
+  d = serial_dump_stailq(l, d, off, convert);
+  serial_record_field_end(w, tag, d, off);
+  return d;
+}
+
+/**
+ * record_restore_address - Unpack an AddressList field from a tagged record
+ * @param rec     Record to read from
+ * @param tag     Tag of the field, e.g. #HC_ENV_TAG_FROM
+ * @param al      Store the unpacked AddressList here
  * @param convert If true, the strings will be converted from utf-8
  */
-void serial_restore_body(struct Body *c, const unsigned char *d, int *off, bool convert)
+static void record_restore_address(const struct SerialRecord *rec, uint16_t tag,
+                                   struct AddressList *al, bool convert)
 {
-  memcpy(c, d + *off, sizeof(struct Body));
-  *off += sizeof(struct Body);
-  c->language = NULL;
+  const unsigned char *d = serial_record_field(rec, tag, NULL);
+  if (!d)
+    return;
 
-  serial_restore_char(&c->xtype, d, off, false);
-  serial_restore_char(&c->subtype, d, off, false);
+  int off = 0;
+  serial_restore_address(al, d, &off, convert);
+}
 
-  TAILQ_INIT(&c->parameter);
-  serial_restore_parameter(&c->parameter, d, off, convert);
+/**
+ * record_restore_char - Unpack a string field from a tagged record
+ * @param rec     Record to read from
+ * @param tag     Tag of the field, e.g. #HC_ENV_TAG_SUBJECT
+ * @param c       Store the unpacked string here
+ * @param intern  If true, share the string, see serial_restore_intern()
+ * @param convert If true, the strings will be converted from utf-8
+ */
+static void record_restore_char(const struct SerialRecord *rec, uint16_t tag,
+                                char **c, bool intern, bool convert)
+{
+  const unsigned char *d = serial_record_field(rec, tag, NULL);
+  if (!d)
+    return;
+
+  int off = 0;
+  if (intern)
+    serial_restore_intern(c, d, &off, convert);
+  else
+    serial_restore_char(c, d, &off, convert);
+}
+
+/**
+ * record_restore_stailq - Unpack a STAILQ field from a tagged record
+ * @param rec     Record to read from
+ * @param tag     Tag of the field, e.g. #HC_ENV_TAG_REFERENCES
+ * @param l       Store the unpacked list here
+ * @param convert If true, the strings will be converted from utf-8
+ */
+static void record_restore_stailq(const struct SerialRecord *rec, uint16_t tag,
+                                  struct ListHead *l, bool convert)
+{
+  const unsigned char *d = serial_record_field(rec, tag, NULL);
+  if (!d)
+    return;
 
-  serial_restore_char(&c->description, d, off, convert);
-  serial_restore_char(&c->form_name, d, off, convert);
-  serial_restore_char(&c->filename, d, off, convert);
-  serial_restore_char(&c->d_filename, d, off, convert);
+  int off = 0;
+  serial_restore_stailq(l, d, &off, convert);
+}
+
+/**
+ * serial_dump_envelope_cold - Pack the rarely-used Envelope fields
+ * @param env     Envelope to pack
+ * @param d       Binary blob to add to
+ * @param off     Offset into the blob
+ * @param convert If true, the strings will be converted to utf-8
+ * @retval ptr End of the newly packed binary
+ *
+ * These fields aren't needed to display the index, so they may be decoded
+ * lazily.  See serial_restore_envelope_lazy().
+ *
+ * The fields are packed as a nested record, see #HcacheEnvelopeTag.
+ */
+unsigned char *serial_dump_envelope_cold(struct Envelope *env, unsigned char *d,
+                                         int *off, bool convert)
+{
+  struct SerialRecordWriter w = { 0 };
+
+  d = serial_record_begin(&w, HC_ENV_COLD_MAX, d, off);
+
+  d = record_address(&w, HC_ENV_TAG_RETURN_PATH, &env->return_path, d, off, convert);
+  d = record_address(&w, HC_ENV_TAG_BCC, &env->bcc, d, off, convert);
+  d = record_address(&w, HC_ENV_TAG_SENDER, &env->sender, d, off, convert);
+  d = record_address(&w, HC_ENV_TAG_REPLY_TO, &env->reply_to, d, off, convert);
+  d = record_address(&w, HC_ENV_TAG_MAIL_FOLLOWUP_TO, &env->mail_followup_to, d, off, convert);
+
+  d = record_char(&w, HC_ENV_TAG_DATE, env->date, d, off, false);
+  d = record_char(&w, HC_ENV_TAG_ORGANIZATION, env->organization, d, off, convert);
+
+  d = record_stailq(&w, HC_ENV_TAG_USERHDRS, &env->userhdrs, d, off, convert);
+
+#ifdef USE_NNTP
+  d = record_char(&w, HC_ENV_TAG_FOLLOWUP_TO, env->followup_to, d, off, false);
+  d = record_char(&w, HC_ENV_TAG_X_COMMENT_TO, env->x_comment_to, d, off, convert);
+#endif
+
+  serial_record_end(&w, d, off);
+
+  return d;
+}
+
+/**
+ * serial_restore_envelope_cold - Unpack the rarely-used Envelope fields
+ * @param env     Store the unpacked Envelope here
+ * @param d       Binary blob to read from
+ * @param dlen    Length of the blob
+ * @param convert If true, the strings will be converted from utf-8
+ * @retval true  Success
+ * @retval false The blob isn't a valid Envelope record
+ */
+bool serial_restore_envelope_cold(struct Envelope *env, const unsigned char *d,
+                                  size_t dlen, bool convert)
+{
+  struct SerialRecord rec = { 0 };
+  if (!serial_record_open(&rec, d, dlen))
+    return false;
+
+  record_restore_address(&rec, HC_ENV_TAG_RETURN_PATH, &env->return_path, convert);
+  record_restore_address(&rec, HC_ENV_TAG_BCC, &env->bcc, convert);
+  record_restore_address(&rec, HC_ENV_TAG_SENDER, &env->sender, convert);
+  record_restore_address(&rec, HC_ENV_TAG_REPLY_TO, &env->reply_to, convert);
+  record_restore_address(&rec, HC_ENV_TAG_MAIL_FOLLOWUP_TO, &env->mail_followup_to, convert);
+
+  record_restore_char(&rec, HC_ENV_TAG_DATE, &env->date, false, false);
+  record_restore_char(&rec, HC_ENV_TAG_ORGANIZATION, &env->organization, true, convert);
+
+  record_restore_stailq(&rec, HC_ENV_TAG_USERHDRS, &env->userhdrs, convert);
+
+#ifdef USE_NNTP
+  record_restore_char(&rec, HC_ENV_TAG_FOLLOWUP_TO, &env->followup_to, false, false);
+  record_restore_char(&rec, HC_ENV_TAG_X_COMMENT_TO, &env->x_comment_to, false, convert);
+#endif
+
+  return true;
+}
+
+/**
+ * envelope_lazy_restore - Decode the deferred Envelope fields
+ * @param env Envelope
+ *
+ * The lazy data is the length of the record, one byte holding the 'convert'
+ * flag, then the record packed by serial_dump_envelope_cold().
+ */
+static void envelope_lazy_restore(struct Envelope *env)
+{
+  const unsigned char *d = env->lazy;
+  size_t dlen = 0;
+  memcpy(&dlen, d, sizeof(dlen));
+  d += sizeof(dlen);
+
+  serial_restore_envelope_cold(env, d + 1, dlen, (d[0] != 0));
+  FREE(&env->lazy);
+  env->lazy_restore = NULL;
 }
 
 /**
@@ -483,45 +1047,49 @@ void serial_restore_body(struct Body *c, const unsigned char *d, int *off, bool
  * @param off     Offset into the blob
  * @param convert If true, the strings will be converted to utf-8
  * @retval ptr End of the newly packed binary
+ *
+ * Only the fields needed by the index are packed.
+ * The rest are packed by serial_dump_envelope_cold().
+ *
+ * The fields are packed as a nested record, see #HcacheEnvelopeTag.
  */
 unsigned char *serial_dump_envelope(struct Envelope *env, unsigned char *d,
                                     int *off, bool convert)
 {
-  d = serial_dump_address(&env->return_path, d, off, convert);
-  d = serial_dump_address(&env->from, d, off, convert);
-  d = serial_dump_address(&env->to, d, off, convert);
-  d = serial_dump_address(&env->cc, d, off, convert);
-  d = serial_dump_address(&env->bcc, d, off, convert);
-  d = serial_dump_address(&env->sender, d, off, convert);
-  d = serial_dump_address(&env->reply_to, d, off, convert);
-  d = serial_dump_address(&env->mail_followup_to, d, off, convert);
+  struct SerialRecordWriter w = { 0 };
 
-  d = serial_dump_char(env->list_post, d, off, convert);
-  d = serial_dump_char(env->subject, d, off, convert);
+  d = serial_record_begin(&w, HC_ENV_HOT_MAX, d, off);
 
-  if (env->real_subj)
-    d = serial_dump_int(env->real_subj - env->subject, d, off);
-  else
-    d = serial_dump_int(-1, d, off);
+  d = record_address(&w, HC_ENV_TAG_FROM, &env->from, d, off, convert);
+  d = record_address(&w, HC_ENV_TAG_TO, &env->to, d, off, convert);
+  d = record_address(&w, HC_ENV_TAG_CC, &env->cc, d, off, convert);
+
+  d = record_char(&w, HC_ENV_TAG_LIST_POST, env->list_post, d, off, convert);
+  d = record_char(&w, HC_ENV_TAG_SUBJECT, env->subject, d, off, convert);
+
+  if (env->subject && env->real_subj)
+    d = serial_record_int(&w, HC_ENV_TAG_REAL_SUBJ, env->real_subj - env->subject, d, off);
 
-  d = serial_dump_char(env->message_id, d, off, false);
-  d = serial_dump_char(env->supersedes, d, off, false);
-  d = serial_dump_char(env->date, d, off, false);
-  d = serial_dump_char(env->x_label, d, off, convert);
-  d = serial_dump_char(env->organization, d, off, convert);
+  d = record_char(&w, HC_ENV_TAG_MESSAGE_ID, env->message_id, d, off, false);
+  d = record_char(&w, HC_ENV_TAG_SUPERSEDES, env->supersedes, d, off, false);
+  d = record_char(&w, HC_ENV_TAG_X_LABEL, env->x_label, d, off, convert);
 
-  d = serial_dump_buffer(&env->spam, d, off, convert);
+  if (!mutt_buffer_is_empty(&env->spam))
+  {
+    serial_record_field_begin(&w, off);
+    d = serial_dump_buffer(&env->spam, d, off, convert);
+    serial_record_field_end(&w, HC_ENV_TAG_SPAM, d, off);
+  }
 
-  d = serial_dump_stailq(&env->references, d, off, false);
-  d = serial_dump_stailq(&env->in_reply_to, d, off, false);
-  d = serial_dump_stailq(&env->userhdrs, d, off, convert);
+  d = record_stailq(&w, HC_ENV_TAG_REFERENCES, &env->references, d, off, false);
+  d = record_stailq(&w, HC_ENV_TAG_IN_REPLY_TO, &env->in_reply_to, d, off, false);
 
 #ifdef USE_NNTP
-  d = serial_dump_char(env->xref, d, off, false);
-  d = serial_dump_char(env->followup_to, d, off, false);
-  d = serial_dump_char(env->x_comment_to, d, off, convert);
+  d = record_char(&w, HC_ENV_TAG_XREF, env->xref, d, off, false);
 #endif
 
+  serial_record_end(&w, d, off);
+
   return d;
 }
 
@@ -529,50 +1097,275 @@ unsigned char *serial_dump_envelope(struct Envelope *env, unsigned char *d,
  * serial_restore_envelope - Unpack an Envelope from a binary blob
  * @param env     Store the unpacked Envelope here
  * @param d       Binary blob to read from
- * @param off     Offset into the blob
+ * @param dlen    Length of the blob
  * @param convert If true, the strings will be converted from utf-8
+ * @retval true  Success
+ * @retval false The blob isn't a valid Envelope record
  */
-void serial_restore_envelope(struct Envelope *env, const unsigned char *d, int *off, bool convert)
+bool serial_restore_envelope(struct Envelope *env, const unsigned char *d,
+                             size_t dlen, bool convert)
 {
-  int real_subj_off;
+  struct SerialRecord rec = { 0 };
+  if (!serial_record_open(&rec, d, dlen))
+    return false;
 
-  serial_restore_address(&env->return_path, d, off, convert);
-  serial_restore_address(&env->from, d, off, convert);
-  serial_restore_address(&env->to, d, off, convert);
-  serial_restore_address(&env->cc, d, off, convert);
-  serial_restore_address(&env->bcc, d, off, convert);
-  serial_restore_address(&env->sender, d, off, convert);
-  serial_restore_address(&env->reply_to, d, off, convert);
-  serial_restore_address(&env->mail_followup_to, d, off, convert);
+  record_restore_address(&rec, HC_ENV_TAG_FROM, &env->from, convert);
+  record_restore_address(&rec, HC_ENV_TAG_TO, &env->to, convert);
+  record_restore_address(&rec, HC_ENV_TAG_CC, &env->cc, convert);
 
-  serial_restore_char(&env->list_post, d, off, convert);
+  record_restore_char(&rec, HC_ENV_TAG_LIST_POST, &env->list_post, true, convert);
 
   if (C_AutoSubscribe)
     mutt_auto_subscribe(env->list_post);
 
-  serial_restore_char(&env->subject, d, off, convert);
-  serial_restore_int((unsigned int *) (&real_subj_off), d, off);
+  record_restore_char(&rec, HC_ENV_TAG_SUBJECT, &env->subject, false, convert);
 
-  if (real_subj_off >= 0)
+  const int64_t real_subj_off = serial_record_get_int(&rec, HC_ENV_TAG_REAL_SUBJ, -1);
+  if (env->subject && (real_subj_off >= 0) &&
+      (real_subj_off <= (int64_t) mutt_str_len(env->subject)))
+  {
     env->real_subj = env->subject + real_subj_off;
+  }
   else
+  {
     env->real_subj = NULL;
+  }
 
-  serial_restore_char(&env->message_id, d, off, false);
-  serial_restore_char(&env->supersedes, d, off, false);
-  serial_restore_char(&env->date, d, off, false);
-  serial_restore_char(&env->x_label, d, off, convert);
-  serial_restore_char(&env->organization, d, off, convert);
+  record_restore_char(&rec, HC_ENV_TAG_MESSAGE_ID, &env->message_id, false, false);
+  record_restore_char(&rec, HC_ENV_TAG_SUPERSEDES, &env->supersedes, false, false);
+  record_restore_char(&rec, HC_ENV_TAG_X_LABEL, &env->x_label, true, convert);
 
-  serial_restore_buffer(&env->spam, d, off, convert);
+  const unsigned char *spam = serial_record_field(&rec, HC_ENV_TAG_SPAM, NULL);
+  if (spam)
+  {
+    int off = 0;
+    serial_restore_buffer(&env->spam, spam, &off, convert);
+  }
 
-  serial_restore_stailq(&env->references, d, off, false);
-  serial_restore_stailq(&env->in_reply_to, d, off, false);
-  serial_restore_stailq(&env->userhdrs, d, off, convert);
+  record_restore_stailq(&rec, HC_ENV_TAG_REFERENCES, &env->references, false);
+  record_restore_stailq(&rec, HC_ENV_TAG_IN_REPLY_TO, &env->in_reply_to, false);
 
 #ifdef USE_NNTP
-  serial_restore_char(&env->xref, d, off, false);
-  serial_restore_char(&env->followup_to, d, off, false);
-  serial_restore_char(&env->x_comment_to, d, off, convert);
+  record_restore_char(&rec, HC_ENV_TAG_XREF, &env->xref, false, false);
 #endif
+
+  return true;
+}
+
+/**
+ * serial_restore_envelope_lazy - Defer unpacking the rarely-used Envelope fields
+ * @param env     Envelope
+ * @param d       Record packed by serial_dump_envelope_cold()
+ * @param dlen    Length of the record
+ * @param convert If true, the strings will be converted from utf-8
+ *
+ * mutt_env_lazy_restore() must be called before any of the fields are used.
+ */
+void serial_restore_envelope_lazy(struct Envelope *env, const unsigned char *d,
+                                  size_t dlen, bool convert)
+{
+  /* The cache's data is only valid until the next lookup, so keep a copy */
+  unsigned char *cold = mutt_mem_malloc(sizeof(dlen) + 1 + dlen);
+  memcpy(cold, &dlen, sizeof(dlen));
+  cold[sizeof(dlen)] = convert;
+  memcpy(cold + sizeof(dlen) + 1, d, dlen);
+
+  env->lazy = cold;
+  env->lazy_restore = envelope_lazy_restore;
+}
+
+/**
+ * email_pack_flags - Pack an Email's boolean fields into a bitmask
+ * @param e Email
+ * @retval num Bitmask, e.g. #HC_EMAIL_READ
+ *
+ * Fields that are only meaningful while the mailbox is open, e.g. tagged,
+ * aren't cached.
+ */
+static uint32_t email_pack_flags(const struct Email *e)
+{
+  uint32_t flags = 0;
+
+  if (e->mime)
+    flags |= HC_EMAIL_MIME;
+  if (e->flagged)
+    flags |= HC_EMAIL_FLAGGED;
+  if (e->deleted)
+    flags |= HC_EMAIL_DELETED;
+  if (e->purge)
+    flags |= HC_EMAIL_PURGE;
+  if (e->quasi_deleted)
+    flags |= HC_EMAIL_QUASI_DELETED;
+  if (e->attach_del)
+    flags |= HC_EMAIL_ATTACH_DEL;
+  if (e->old)
+    flags |= HC_EMAIL_OLD;
+  if (e->read)
+    flags |= HC_EMAIL_READ;
+  if (e->expired)
+    flags |= HC_EMAIL_EXPIRED;
+  if (e->superseded)
+    flags |= HC_EMAIL_SUPERSEDED;
+  if (e->replied)
+    flags |= HC_EMAIL_REPLIED;
+  if (e->subject_changed)
+    flags |= HC_EMAIL_SUBJECT_CHANGED;
+  if (e->display_subject)
+    flags |= HC_EMAIL_DISPLAY_SUBJECT;
+  if (e->active)
+    flags |= HC_EMAIL_ACTIVE;
+  if (e->trash)
+    flags |= HC_EMAIL_TRASH;
+
+  return flags;
+}
+
+/**
+ * email_unpack_flags - Set an Email's boolean fields from a bitmask
+ * @param e     Email
+ * @param flags Bitmask, e.g. #HC_EMAIL_READ
+ */
+static void email_unpack_flags(struct Email *e, uint32_t flags)
+{
+  e->mime = (flags & HC_EMAIL_MIME);
+  e->flagged = (flags & HC_EMAIL_FLAGGED);
+  e->deleted = (flags & HC_EMAIL_DELETED);
+  e->purge = (flags & HC_EMAIL_PURGE);
+  e->quasi_deleted = (flags & HC_EMAIL_QUASI_DELETED);
+  e->attach_del = (flags & HC_EMAIL_ATTACH_DEL);
+  e->old = (flags & HC_EMAIL_OLD);
+  e->read = (flags & HC_EMAIL_READ);
+  e->expired = (flags & HC_EMAIL_EXPIRED);
+  e->superseded = (flags & HC_EMAIL_SUPERSEDED);
+  e->replied = (flags & HC_EMAIL_REPLIED);
+  e->subject_changed = (flags & HC_EMAIL_SUBJECT_CHANGED);
+  e->display_subject = (flags & HC_EMAIL_DISPLAY_SUBJECT);
+  e->active = (flags & HC_EMAIL_ACTIVE);
+  e->trash = (flags & HC_EMAIL_TRASH);
+}
+
+/**
+ * serial_dump_email - Pack an Email into a tagged record
+ * @param e       Email to pack
+ * @param d       Binary blob to add to
+ * @param off     Offset into the blob
+ * @param convert If true, the strings will be converted to utf-8
+ * @retval ptr End of the newly packed binary
+ *
+ * The record holds the Email's fields, its Envelope and its Body, see
+ * #HcacheTag.
+ */
+unsigned char *serial_dump_email(const struct Email *e, unsigned char *d, int *off, bool convert)
+{
+  struct SerialRecordWriter w = { 0 };
+
+  /* the deferred fields must be decoded before they can be re-packed */
+  mutt_env_lazy_restore(e->env);
+
+  const int zone = e->zhours | (e->zminutes << 8) | (e->zoccident << 16);
+
+  d = serial_record_begin(&w, HC_TAG_MAX, d, off);
+
+  d = serial_record_int(&w, HC_TAG_SECURITY, e->security, d, off);
+  d = serial_record_int(&w, HC_TAG_FLAGS, email_pack_flags(e), d, off);
+  d = serial_record_int(&w, HC_TAG_ZONE, zone, d, off);
+  d = serial_record_int(&w, HC_TAG_DATE_SENT, e->date_sent, d, off);
+  d = serial_record_int(&w, HC_TAG_RECEIVED, e->received, d, off);
+  d = serial_record_int(&w, HC_TAG_OFFSET, e->cold->offset, d, off);
+  d = serial_record_int(&w, HC_TAG_LINES, e->lines, d, off);
+  d = serial_record_int(&w, HC_TAG_INDEX, e->index, d, off);
+  d = serial_record_int(&w, HC_TAG_MSGNO, e->msgno, d, off);
+  d = serial_record_int(&w, HC_TAG_VNUM, e->vnum, d, off);
+  d = serial_record_int(&w, HC_TAG_SCORE, e->score, d, off);
+  d = serial_record_int(&w, HC_TAG_ATTACH_TOTAL, e->attach_total, d, off);
+
+  serial_record_field_begin(&w, off);
+  d = serial_dump_envelope(e->env, d, off, convert);
+  serial_record_field_end(&w, HC_TAG_ENV_HOT, d, off);
+
+  serial_record_field_begin(&w, off);
+  d = serial_dump_envelope_cold(e->env, d, off, convert);
+  serial_record_field_end(&w, HC_TAG_ENV_COLD, d, off);
+
+  serial_record_field_begin(&w, off);
+  d = serial_dump_body(e->content, d, off, convert);
+  serial_record_field_end(&w, HC_TAG_BODY, d, off);
+
+  serial_record_end(&w, d, off);
+
+  return d;
+}
+
+/**
+ * serial_restore_email - Unpack an Email from a tagged record
+ * @param d       Record packed by serial_dump_email()
+ * @param dlen    Length of the record
+ * @param lazy    If true, defer unpacking the rarely-used Envelope fields
+ * @param convert If true, the strings will be converted from utf-8
+ * @retval ptr  Success, the restored Email
+ * @retval NULL The data isn't a valid record
+ *
+ * Unknown fields are ignored and missing fields keep their default value.
+ *
+ * @note The returned Email must be free'd by caller code with email_free()
+ */
+struct Email *serial_restore_email(const unsigned char *d, size_t dlen, bool lazy, bool convert)
+{
+  struct SerialRecord rec = { 0 };
+  if (!serial_record_open(&rec, d, dlen))
+    return NULL;
+
+  size_t env_len = 0;
+  size_t cold_len = 0;
+  size_t body_len = 0;
+  const unsigned char *env = serial_record_field(&rec, HC_TAG_ENV_HOT, &env_len);
+  const unsigned char *cold = serial_record_field(&rec, HC_TAG_ENV_COLD, &cold_len);
+  const unsigned char *body = serial_record_field(&rec, HC_TAG_BODY, &body_len);
+  if (!env || !body)
+    return NULL;
+
+  struct Email *e = email_new();
+
+  e->security = serial_record_get_int(&rec, HC_TAG_SECURITY, 0);
+  email_unpack_flags(e, serial_record_get_int(&rec, HC_TAG_FLAGS, 0));
+
+  const int zone = serial_record_get_int(&rec, HC_TAG_ZONE, 0);
+  e->zhours = zone & 0xff;
+  e->zminutes = (zone >> 8) & 0xff;
+  e->zoccident = (zone >> 16) & 0x1;
+
+  e->date_sent = serial_record_get_int(&rec, HC_TAG_DATE_SENT, 0);
+  e->received = serial_record_get_int(&rec, HC_TAG_RECEIVED, 0);
+  e->cold->offset = serial_record_get_int(&rec, HC_TAG_OFFSET, 0);
+  e->lines = serial_record_get_int(&rec, HC_TAG_LINES, 0);
+  e->index = serial_record_get_int(&rec, HC_TAG_INDEX, 0);
+  e->msgno = serial_record_get_int(&rec, HC_TAG_MSGNO, 0);
+  e->vnum = serial_record_get_int(&rec, HC_TAG_VNUM, 0);
+  e->score = serial_record_get_int(&rec, HC_TAG_SCORE, 0);
+  e->attach_total = serial_record_get_int(&rec, HC_TAG_ATTACH_TOTAL, 0);
+
+  e->env = mutt_env_new();
+  if (!serial_restore_envelope(e->env, env, env_len, convert))
+  {
+    email_free(&e);
+    return NULL;
+  }
+
+  if (cold && lazy)
+  {
+    serial_restore_envelope_lazy(e->env, cold, cold_len, convert);
+  }
+  else if (cold)
+  {
+    serial_restore_envelope_cold(e->env, cold, cold_len, convert);
+  }
+
+  e->content = mutt_body_new();
+  if (!serial_restore_body(e->content, body, body_len, convert))
+  {
+    email_free(&e);
+    return NULL;
+  }
+
+  return e;
 }
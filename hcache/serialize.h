@@ -34,31 +34,191 @@
 struct AddressList;
 struct Body;
 struct Buffer;
+struct Email;
 struct Envelope;
 struct ListHead;
 struct ParameterList;
 
+#define HC_RECORD_VERSION     1  ///< Format of a tagged record
+#define HC_RECORD_HEADER_SIZE 8  ///< Size of a record's header: version, number of fields, size
+#define HC_RECORD_FIELD_SIZE  12 ///< Size of an entry in a record's table: tag, reserved, offset, length
+
+/**
+ * enum HcacheTag - Fields of an Email record
+ *
+ * @note These values are stored in the cache.  Never change or reuse them.
+ *       If the encoding of a field changes, give it a new tag.
+ */
+enum HcacheTag
+{
+  HC_TAG_SECURITY      = 1,  ///< Email.security
+  HC_TAG_FLAGS         = 2,  ///< Email's boolean fields, e.g. #HC_EMAIL_READ
+  HC_TAG_ZONE          = 3,  ///< Email.zhours, zminutes and zoccident
+  HC_TAG_DATE_SENT     = 4,  ///< Email.date_sent
+  HC_TAG_RECEIVED      = 5,  ///< Email.received
+  HC_TAG_OFFSET        = 6,  ///< Email.offset
+  HC_TAG_LINES         = 7,  ///< Email.lines
+  HC_TAG_INDEX         = 8,  ///< Email.index
+  HC_TAG_MSGNO         = 9,  ///< Email.msgno
+  HC_TAG_VNUM          = 10, ///< Email.vnum
+  HC_TAG_SCORE         = 11, ///< Email.score
+  HC_TAG_ATTACH_TOTAL  = 12, ///< Email.attach_total
+  HC_TAG_ENVELOPE      = 13, ///< Retired, the index's Envelope fields, packed by position
+  HC_TAG_ENVELOPE_COLD = 14, ///< Retired, the rarely-used Envelope fields, packed by position
+  HC_TAG_BODY          = 15, ///< Body, a nested record, see #HcacheBodyTag
+  HC_TAG_ENV_HOT       = 16, ///< Envelope fields needed by the index, a nested record, see serial_dump_envelope()
+  HC_TAG_ENV_COLD      = 17, ///< Rarely-used Envelope fields, a nested record, see serial_dump_envelope_cold()
+};
+
+#define HC_TAG_MAX 15 ///< Number of fields in an Email record
+
+/* Bits of #HC_TAG_FLAGS.  These are stored in the cache, never reuse them. */
+#define HC_EMAIL_MIME            (1 << 0)  ///< Email.mime
+#define HC_EMAIL_FLAGGED         (1 << 1)  ///< Email.flagged
+#define HC_EMAIL_DELETED         (1 << 2)  ///< Email.deleted
+#define HC_EMAIL_PURGE           (1 << 3)  ///< Email.purge
+#define HC_EMAIL_QUASI_DELETED   (1 << 4)  ///< Email.quasi_deleted
+#define HC_EMAIL_ATTACH_DEL      (1 << 5)  ///< Email.attach_del
+#define HC_EMAIL_OLD             (1 << 6)  ///< Email.old
+#define HC_EMAIL_READ            (1 << 7)  ///< Email.read
+#define HC_EMAIL_EXPIRED         (1 << 8)  ///< Email.expired
+#define HC_EMAIL_SUPERSEDED      (1 << 9)  ///< Email.superseded
+#define HC_EMAIL_REPLIED         (1 << 10) ///< Email.replied
+#define HC_EMAIL_SUBJECT_CHANGED (1 << 11) ///< Email.subject_changed
+#define HC_EMAIL_DISPLAY_SUBJECT (1 << 12) ///< Email.display_subject
+#define HC_EMAIL_ACTIVE          (1 << 13) ///< Email.active
+#define HC_EMAIL_TRASH           (1 << 14) ///< Email.trash
+
+/**
+ * enum HcacheBodyTag - Fields of a Body record
+ *
+ * @note These values are stored in the cache.  Never change or reuse them.
+ */
+enum HcacheBodyTag
+{
+  HC_BODY_TAG_TYPE         = 1,  ///< Body.type
+  HC_BODY_TAG_ENCODING     = 2,  ///< Body.encoding
+  HC_BODY_TAG_DISPOSITION  = 3,  ///< Body.disposition
+  HC_BODY_TAG_FLAGS        = 4,  ///< Body's boolean fields, e.g. #HC_BODY_GOODSIG
+  HC_BODY_TAG_HDR_OFFSET   = 5,  ///< Body.hdr_offset
+  HC_BODY_TAG_OFFSET       = 6,  ///< Body.offset
+  HC_BODY_TAG_LENGTH       = 7,  ///< Body.length
+  HC_BODY_TAG_ATTACH_COUNT = 8,  ///< Body.attach_count
+  HC_BODY_TAG_STAMP        = 9,  ///< Body.stamp
+  HC_BODY_TAG_STRINGS      = 10, ///< Body's strings and parameters
+};
+
+#define HC_BODY_TAG_MAX 10 ///< Number of fields in a Body record
+
+/* Bits of #HC_BODY_TAG_FLAGS */
+#define HC_BODY_USE_DISP         (1 << 0) ///< Body.use_disp
+#define HC_BODY_UNLINK           (1 << 1) ///< Body.unlink
+#define HC_BODY_NOCONV           (1 << 2) ///< Body.noconv
+#define HC_BODY_FORCE_CHARSET    (1 << 3) ///< Body.force_charset
+#define HC_BODY_GOODSIG          (1 << 4) ///< Body.goodsig
+#define HC_BODY_WARNSIG          (1 << 5) ///< Body.warnsig
+#define HC_BODY_BADSIG           (1 << 6) ///< Body.badsig
+#define HC_BODY_IS_AUTOCRYPT     (1 << 7) ///< Body.is_autocrypt
+#define HC_BODY_COLLAPSED        (1 << 8) ///< Body.collapsed
+#define HC_BODY_ATTACH_QUALIFIES (1 << 9) ///< Body.attach_qualifies
+
+/**
+ * enum HcacheEnvelopeTag - Fields of the Envelope records
+ *
+ * The fields needed by the index are in one record, #HC_TAG_ENV_HOT, and the
+ * rest are in another, #HC_TAG_ENV_COLD.  Empty fields aren't stored.
+ *
+ * @note These values are stored in the cache.  Never change or reuse them.
+ */
+enum HcacheEnvelopeTag
+{
+  HC_ENV_TAG_FROM             = 1,  ///< Envelope.from
+  HC_ENV_TAG_TO               = 2,  ///< Envelope.to
+  HC_ENV_TAG_CC               = 3,  ///< Envelope.cc
+  HC_ENV_TAG_LIST_POST        = 4,  ///< Envelope.list_post
+  HC_ENV_TAG_SUBJECT          = 5,  ///< Envelope.subject
+  HC_ENV_TAG_REAL_SUBJ        = 6,  ///< Offset of Envelope.real_subj in Envelope.subject
+  HC_ENV_TAG_MESSAGE_ID       = 7,  ///< Envelope.message_id
+  HC_ENV_TAG_SUPERSEDES       = 8,  ///< Envelope.supersedes
+  HC_ENV_TAG_X_LABEL          = 9,  ///< Envelope.x_label
+  HC_ENV_TAG_SPAM             = 10, ///< Envelope.spam
+  HC_ENV_TAG_REFERENCES       = 11, ///< Envelope.references
+  HC_ENV_TAG_IN_REPLY_TO      = 12, ///< Envelope.in_reply_to
+  HC_ENV_TAG_XREF             = 13, ///< Envelope.xref
+  HC_ENV_TAG_RETURN_PATH      = 14, ///< Envelope.return_path
+  HC_ENV_TAG_BCC              = 15, ///< Envelope.bcc
+  HC_ENV_TAG_SENDER           = 16, ///< Envelope.sender
+  HC_ENV_TAG_REPLY_TO         = 17, ///< Envelope.reply_to
+  HC_ENV_TAG_MAIL_FOLLOWUP_TO = 18, ///< Envelope.mail_followup_to
+  HC_ENV_TAG_DATE             = 19, ///< Envelope.date
+  HC_ENV_TAG_ORGANIZATION     = 20, ///< Envelope.organization
+  HC_ENV_TAG_USERHDRS         = 21, ///< Envelope.userhdrs
+  HC_ENV_TAG_FOLLOWUP_TO      = 22, ///< Envelope.followup_to
+  HC_ENV_TAG_X_COMMENT_TO     = 23, ///< Envelope.x_comment_to
+};
+
+#define HC_ENV_HOT_MAX  13 ///< Number of fields in the #HC_TAG_ENV_HOT record
+#define HC_ENV_COLD_MAX 10 ///< Number of fields in the #HC_TAG_ENV_COLD record
+
+/**
+ * struct SerialRecordWriter - State while packing a tagged record
+ */
+struct SerialRecordWriter
+{
+  int start;     ///< Offset of the record in the blob
+  uint16_t num;  ///< Number of fields reserved
+  uint16_t used; ///< Number of fields written
+  int field;     ///< Offset of the field being written
+};
+
+/**
+ * struct SerialRecord - A tagged record being unpacked
+ */
+struct SerialRecord
+{
+  const unsigned char *data; ///< Start of the record
+  size_t size;               ///< Size of the record
+  uint16_t num;              ///< Number of fields
+};
+
 unsigned char *serial_dump_address  (struct AddressList *al,   unsigned char *d, int *off, bool convert);
 unsigned char *serial_dump_body     (struct Body *c,           unsigned char *d, int *off, bool convert);
 unsigned char *serial_dump_buffer   (struct Buffer *buf,       unsigned char *d, int *off, bool convert);
 unsigned char *serial_dump_char     (char *c,                  unsigned char *d, int *off, bool convert);
 unsigned char *serial_dump_char_size(char *c, ssize_t size,    unsigned char *d, int *off, bool convert);
+unsigned char *serial_dump_email    (const struct Email *e,    unsigned char *d, int *off, bool convert);
 unsigned char *serial_dump_envelope (struct Envelope *e,       unsigned char *d, int *off, bool convert);
+unsigned char *serial_dump_envelope_cold(struct Envelope *e,   unsigned char *d, int *off, bool convert);
 unsigned char *serial_dump_int      (unsigned int i,           unsigned char *d, int *off);
+unsigned char *serial_dump_int64_t  (int64_t i,                unsigned char *d, int *off);
 unsigned char *serial_dump_uint32_t (uint32_t s,               unsigned char *d, int *off);
 unsigned char *serial_dump_parameter(struct ParameterList *pl, unsigned char *d, int *off, bool convert);
 unsigned char *serial_dump_stailq   (struct ListHead *l,       unsigned char *d, int *off, bool convert);
 
 void serial_restore_address  (struct AddressList *al,   const unsigned char *d, int *off, bool convert);
-void serial_restore_body     (struct Body *c,           const unsigned char *d, int *off, bool convert);
+bool serial_restore_body     (struct Body *c,           const unsigned char *d, size_t dlen, bool convert);
 void serial_restore_buffer   (struct Buffer *buf,       const unsigned char *d, int *off, bool convert);
 void serial_restore_char     (char **c,                 const unsigned char *d, int *off, bool convert);
-void serial_restore_envelope (struct Envelope *e,       const unsigned char *d, int *off, bool convert);
+struct Email * serial_restore_email(const unsigned char *d, size_t dlen, bool lazy, bool convert);
+bool serial_restore_envelope (struct Envelope *e,       const unsigned char *d, size_t dlen, bool convert);
+bool serial_restore_envelope_cold(struct Envelope *e,   const unsigned char *d, size_t dlen, bool convert);
+void serial_restore_envelope_lazy(struct Envelope *e,   const unsigned char *d, size_t dlen, bool convert);
 void serial_restore_int      (unsigned int *i,          const unsigned char *d, int *off);
+void serial_restore_intern   (char **c,                 const unsigned char *d, int *off, bool convert);
 void serial_restore_uint32_t (uint32_t *s,              const unsigned char *d, int *off);
 void serial_restore_parameter(struct ParameterList *pl, const unsigned char *d, int *off, bool convert);
 void serial_restore_stailq   (struct ListHead *l,       const unsigned char *d, int *off, bool convert);
 
+unsigned char *serial_record_begin      (struct SerialRecordWriter *w, uint16_t num, unsigned char *d, int *off);
+void           serial_record_end        (struct SerialRecordWriter *w, unsigned char *d, int *off);
+void           serial_record_field_begin(struct SerialRecordWriter *w, int *off);
+void           serial_record_field_end  (struct SerialRecordWriter *w, uint16_t tag, unsigned char *d, int *off);
+unsigned char *serial_record_int        (struct SerialRecordWriter *w, uint16_t tag, int64_t i, unsigned char *d, int *off);
+
+const unsigned char *serial_record_field  (const struct SerialRecord *rec, uint16_t tag, size_t *len);
+int64_t              serial_record_get_int(const struct SerialRecord *rec, uint16_t tag, int64_t def);
+bool                 serial_record_open   (struct SerialRecord *rec, const unsigned char *d, size_t dlen);
+
 void lazy_realloc(void *ptr, size_t size);
 
 #endif /* MUTT_HCACHE_SERIALIZE_H */
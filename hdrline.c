@@ -219,6 +219,8 @@ static void make_from(struct Envelope *env, char *buf, size_t buflen,
   struct AddressList *name = NULL;
 
   me = mutt_addr_is_user(TAILQ_FIRST(&env->from));
+  if (me)
+    mutt_env_lazy_restore(env); // for Bcc
 
   if (do_lists || me)
   {
@@ -340,10 +342,14 @@ static int user_is_recipient(struct Email *e)
       e->recipient = 5;
     else if (check_for_mailing_list(&env->cc, NULL, NULL, 0))
       e->recipient = 5;
-    else if (user_in_addr(&env->reply_to))
-      e->recipient = 6;
     else
-      e->recipient = 0;
+    {
+      mutt_env_lazy_restore(env);
+      if (user_in_addr(&env->reply_to))
+        e->recipient = 6;
+      else
+        e->recipient = 0;
+    }
   }
 
   return e->recipient;
@@ -473,7 +479,6 @@ static const char *index_format_str(char *buf, size_t buflen, size_t col, int co
   if (!e || !e->env)
     return src;
 
-  const struct Address *reply_to = TAILQ_FIRST(&e->env->reply_to);
   const struct Address *from = TAILQ_FIRST(&e->env->from);
   const struct Address *to = TAILQ_FIRST(&e->env->to);
   const struct Address *cc = TAILQ_FIRST(&e->env->cc);
@@ -485,6 +490,8 @@ static const char *index_format_str(char *buf, size_t buflen, size_t col, int co
     case 'I':
       if (op == 'A')
       {
+        mutt_env_lazy_restore(e->env);
+        const struct Address *reply_to = TAILQ_FIRST(&e->env->reply_to);
         if (reply_to && reply_to->mailbox)
         {
           colorlen = add_index_color(buf, buflen, flags, MT_COLOR_INDEX_AUTHOR);
@@ -809,7 +816,7 @@ static const char *index_format_str(char *buf, size_t buflen, size_t col, int co
       break;
 
     case 'g':
-      tags = driver_tags_get_transformed(&e->tags);
+      tags = driver_tags_get_transformed(&e->cold->tags);
       if (!optional)
       {
         colorlen = add_index_color(buf, buflen, flags, MT_COLOR_INDEX_TAGS);
@@ -835,7 +842,7 @@ static const char *index_format_str(char *buf, size_t buflen, size_t col, int co
         tag = mutt_hash_find(TagFormats, format);
         if (tag)
         {
-          tags = driver_tags_get_transformed_for(&e->tags, tag);
+          tags = driver_tags_get_transformed_for(&e->cold->tags, tag);
           colorlen = add_index_color(buf, buflen, flags, MT_COLOR_INDEX_TAG);
           mutt_format_s(buf + colorlen, buflen - colorlen, prec, NONULL(tags));
           add_index_color(buf + colorlen, buflen - colorlen, flags, MT_COLOR_INDEX);
@@ -852,7 +859,7 @@ static const char *index_format_str(char *buf, size_t buflen, size_t col, int co
         tag = mutt_hash_find(TagFormats, format);
         if (tag)
         {
-          tags = driver_tags_get_transformed_for(&e->tags, tag);
+          tags = driver_tags_get_transformed_for(&e->cold->tags, tag);
           if (!tags)
             optional = false;
           FREE(&tags);
@@ -876,7 +883,7 @@ static const char *index_format_str(char *buf, size_t buflen, size_t col, int co
     case 'J':
     {
       bool have_tags = true;
-      tags = driver_tags_get_transformed(&e->tags);
+      tags = driver_tags_get_transformed(&e->cold->tags);
       if (tags)
       {
         if (flags & MUTT_FORMAT_TREE)
@@ -884,12 +891,12 @@ static const char *index_format_str(char *buf, size_t buflen, size_t col, int co
           char *parent_tags = NULL;
           if (e->thread->prev && e->thread->prev->message)
           {
-            parent_tags = driver_tags_get_transformed(&e->thread->prev->message->tags);
+            parent_tags = driver_tags_get_transformed(&e->thread->prev->message->cold->tags);
           }
           if (!parent_tags && e->thread->parent && e->thread->parent->message)
           {
             parent_tags =
-                driver_tags_get_transformed(&e->thread->parent->message->tags);
+                driver_tags_get_transformed(&e->thread->parent->message->cold->tags);
           }
           if (parent_tags && mutt_istr_equal(tags, parent_tags))
             have_tags = false;
@@ -1050,11 +1057,11 @@ static const char *index_format_str(char *buf, size_t buflen, size_t col, int co
           colorlen = add_index_color(buf, buflen, flags, MT_COLOR_INDEX_SUBJECT);
           mutt_format_s(buf + colorlen, buflen - colorlen, "", NONULL(subj));
           add_index_color(buf + colorlen, buflen - colorlen, flags, MT_COLOR_INDEX);
-          snprintf(tmp, sizeof(tmp), "%s%s", e->tree, buf);
+          snprintf(tmp, sizeof(tmp), "%s%s", e->cold->tree, buf);
           mutt_format_s_tree(buf, buflen, prec, tmp);
         }
         else
-          mutt_format_s_tree(buf, buflen, prec, e->tree);
+          mutt_format_s_tree(buf, buflen, prec, e->cold->tree);
       }
       else
       {
@@ -1148,6 +1155,7 @@ static const char *index_format_str(char *buf, size_t buflen, size_t col, int co
       break;
 
     case 'W':
+      mutt_env_lazy_restore(e->env);
       if (!optional)
       {
         mutt_format_s(buf, buflen, prec, e->env->organization ? e->env->organization : "");
@@ -1158,6 +1166,7 @@ static const char *index_format_str(char *buf, size_t buflen, size_t col, int co
 
 #ifdef USE_NNTP
     case 'x':
+      mutt_env_lazy_restore(e->env);
       if (!optional)
       {
         mutt_format_s(buf, buflen, prec, e->env->x_comment_to ? e->env->x_comment_to : "");
@@ -657,6 +657,7 @@ void mutt_default_save(char *path, size_t pathlen, struct Email *e)
     return;
 
   struct Envelope *env = e->env;
+  mutt_env_lazy_restore(env);
   const struct Address *from = TAILQ_FIRST(&env->from);
   const struct Address *reply_to = TAILQ_FIRST(&env->reply_to);
   const struct Address *to = TAILQ_FIRST(&env->to);
@@ -694,6 +695,7 @@ void mutt_select_fcc(struct Buffer *path, struct Email *e)
 
   if (addr_hook(path->data, path->dsize, MUTT_FCC_HOOK, NULL, e) != 0)
   {
+    mutt_env_lazy_restore(e->env);
     const struct Address *to = TAILQ_FIRST(&e->env->to);
     const struct Address *cc = TAILQ_FIRST(&e->env->cc);
     const struct Address *bcc = TAILQ_FIRST(&e->env->bcc);
@@ -275,7 +275,7 @@ static int make_msg_set(struct Mailbox *m, struct Buffer *buf, int flag,
  */
 static bool compare_flags_for_copy(struct Email *e)
 {
-  struct ImapEmailData *edata = e->edata;
+  struct ImapEmailData *edata = e->cold->edata;
 
   if (e->read != edata->read)
     return true;
@@ -660,7 +660,7 @@ void imap_expunge_mailbox(struct Mailbox *m)
 
       mutt_hash_int_delete(mdata->uid_hash, imap_edata_get(e)->uid, e);
 
-      imap_edata_free((void **) &e->edata);
+      imap_edata_free((void **) &e->cold->edata);
     }
     else
     {
@@ -994,7 +994,7 @@ int imap_sync_message_for_copy(struct Mailbox *m, struct Email *e,
     if (imap_edata_get(e)->flags_system)
       mutt_str_cat(flags, sizeof(flags), imap_edata_get(e)->flags_system);
     /* set custom flags */
-    tags = driver_tags_get_with_hidden(&e->tags);
+    tags = driver_tags_get_with_hidden(&e->cold->tags);
     if (tags)
     {
       mutt_str_cat(flags, sizeof(flags), tags);
@@ -1041,7 +1041,7 @@ int imap_sync_message_for_copy(struct Mailbox *m, struct Email *e,
 
   /* server have now the updated flags */
   FREE(&imap_edata_get(e)->flags_remote);
-  imap_edata_get(e)->flags_remote = driver_tags_get_with_hidden(&e->tags);
+  imap_edata_get(e)->flags_remote = driver_tags_get_with_hidden(&e->cold->tags);
 
   if (e->deleted == imap_edata_get(e)->deleted)
     e->changed = false;
@@ -2046,8 +2046,7 @@ static int imap_mbox_open(struct Mailbox *m)
     m->readonly = true;
   }
 
-  while (m->email_max < count)
-    mx_alloc_memory(m);
+  mx_alloc_memory(m, count);
 
   m->msg_count = 0;
   m->msg_unread = 0;
@@ -2340,9 +2339,9 @@ static int imap_tags_commit(struct Mailbox *m, struct Email *e, char *buf)
 
   /* We are good sync them */
   mutt_debug(LL_DEBUG1, "NEW TAGS: %s\n", buf);
-  driver_tags_replace(&e->tags, buf);
+  driver_tags_replace(&e->cold->tags, buf);
   FREE(&imap_edata_get(e)->flags_remote);
-  imap_edata_get(e)->flags_remote = driver_tags_get_with_hidden(&e->tags);
+  imap_edata_get(e)->flags_remote = driver_tags_get_with_hidden(&e->cold->tags);
   return 0;
 }
 
@@ -2447,6 +2446,7 @@ struct MxOps MxImapOps = {
   .msg_close        = imap_msg_close,
   .msg_padding_size = NULL,
   .msg_save_hcache  = imap_msg_save_hcache,
+  .mbox_gc          = NULL,
   .tags_edit        = imap_tags_edit,
   .tags_commit      = imap_tags_commit,
   .path_probe       = imap_path_probe,
@@ -66,6 +66,8 @@
 
 struct BodyCache;
 
+#define IMAP_HCACHE_BATCH 256 ///< Number of Emails to save to the header cache at once
+
 /**
  * imap_edata_free - Free the private Email data - Implements Email::edata_free()
  */
@@ -99,7 +101,7 @@ struct ImapEmailData *imap_edata_get(struct Email *e)
 {
   if (!e)
     return NULL;
-  return e->edata;
+  return e->cold->edata;
 }
 
 /**
@@ -730,6 +732,8 @@ static int read_headers_normal_eval_cache(struct ImapAccountData *adata,
 {
   struct Progress progress;
   char buf[1024];
+  struct Email *pending[IMAP_HCACHE_BATCH];
+  size_t num_pending = 0;
 
   struct Mailbox *m = adata->mailbox;
   struct ImapMboxData *mdata = imap_mdata_get(m);
@@ -755,7 +759,10 @@ static int read_headers_normal_eval_cache(struct ImapAccountData *adata,
   for (int msgno = 1; rc == IMAP_RES_CONTINUE; msgno++)
   {
     if (SigInt && query_abort_header_download(adata))
-      return -1;
+    {
+      rc = -1;
+      goto done;
+    }
 
     if (m->verbose)
       mutt_progress_update(&progress, msgno, -1);
@@ -824,13 +831,13 @@ static int read_headers_normal_eval_cache(struct ImapAccountData *adata,
         }
 
         /*  mailbox->emails[msgno]->received is restored from mutt_hcache_restore */
-        e->edata = h.edata;
-        e->edata_free = imap_edata_free;
-        STAILQ_INIT(&e->tags);
+        e->cold->edata = h.edata;
+        e->cold->edata_free = imap_edata_free;
+        STAILQ_INIT(&e->cold->tags);
 
         /* We take a copy of the tags so we can split the string */
         char *tags_copy = mutt_str_dup(h.edata->flags_remote);
-        driver_tags_replace(&e->tags, tags_copy);
+        driver_tags_replace(&e->cold->tags, tags_copy);
         FREE(&tags_copy);
 
         m->msg_count++;
@@ -839,7 +846,14 @@ static int read_headers_normal_eval_cache(struct ImapAccountData *adata,
         /* If this is the first time we are fetching, we need to
          * store the current state of flags back into the header cache */
         if (!eval_condstore && store_flag_updates)
-          imap_hcache_put(mdata, e);
+        {
+          pending[num_pending++] = e;
+          if (num_pending == IMAP_HCACHE_BATCH)
+          {
+            imap_hcache_put_many(mdata, pending, num_pending);
+            num_pending = 0;
+          }
+        }
 
         h.edata = NULL;
         idx++;
@@ -849,10 +863,16 @@ static int read_headers_normal_eval_cache(struct ImapAccountData *adata,
     imap_edata_free((void **) &h.edata);
 
     if ((mfhrc < -1) || ((rc != IMAP_RES_CONTINUE) && (rc != IMAP_RES_OK)))
-      return -1;
+    {
+      rc = -1;
+      goto done;
+    }
   }
+  rc = 0;
 
-  return 0;
+done:
+  imap_hcache_put_many(mdata, pending, num_pending);
+  return rc;
 }
 
 /**
@@ -895,11 +915,11 @@ static int read_headers_qresync_eval_cache(struct ImapAccountData *adata, char *
       mdata->msn_index[msn - 1] = e;
 
       if (m->msg_count >= m->email_max)
-        mx_alloc_memory(m);
+        mx_alloc_memory(m, m->msg_count + 1);
 
       struct ImapEmailData *edata = imap_edata_new();
-      e->edata = edata;
-      e->edata_free = imap_edata_free;
+      e->cold->edata = edata;
+      e->cold->edata_free = imap_edata_free;
 
       e->index = m->msg_count;
       e->active = true;
@@ -1197,13 +1217,13 @@ static int read_headers_fetch_new(struct Mailbox *m, unsigned int msn_begin,
         e->flagged = h.edata->flagged;
         e->replied = h.edata->replied;
         e->received = h.received;
-        e->edata = (void *) (h.edata);
-        e->edata_free = imap_edata_free;
-        STAILQ_INIT(&e->tags);
+        e->cold->edata = (void *) (h.edata);
+        e->cold->edata_free = imap_edata_free;
+        STAILQ_INIT(&e->cold->tags);
 
         /* We take a copy of the tags so we can split the string */
         char *tags_copy = mutt_str_dup(h.edata->flags_remote);
-        driver_tags_replace(&e->tags, tags_copy);
+        driver_tags_replace(&e->cold->tags, tags_copy);
         FREE(&tags_copy);
 
         if (*maxuid < h.edata->uid)
@@ -1218,7 +1238,7 @@ static int read_headers_fetch_new(struct Mailbox *m, unsigned int msn_begin,
         mailbox_size_add(m, e);
 
 #ifdef USE_HCACHE
-        imap_hcache_put(mdata, e);
+        imap_hcache_put_async(mdata, e);
 #endif /* USE_HCACHE */
 
         m->msg_count++;
@@ -1237,8 +1257,7 @@ static int read_headers_fetch_new(struct Mailbox *m, unsigned int msn_begin,
     if (mdata->reopen & IMAP_NEWMAIL_PENDING)
     {
       msn_end = mdata->new_mail_count;
-      while (msn_end > m->email_max)
-        mx_alloc_memory(m);
+      mx_alloc_memory(m, msn_end);
       alloc_msn_index(adata, msn_end);
       mdata->reopen &= ~IMAP_NEWMAIL_PENDING;
       mdata->new_mail_count = 0;
@@ -1308,8 +1327,7 @@ int imap_read_headers(struct Mailbox *m, unsigned int msn_begin,
     return -1;
 
   /* make sure context has room to hold the mailbox */
-  while (msn_end > m->email_max)
-    mx_alloc_memory(m);
+  mx_alloc_memory(m, msn_end);
   alloc_msn_index(adata, msn_end);
   imap_alloc_uid_hash(adata, msn_end);
 
@@ -1445,7 +1463,7 @@ int imap_read_headers(struct Mailbox *m, unsigned int msn_begin,
   {
     /* TODO: it's not clear to me why we are calling mx_alloc_memory
      *       yet again. */
-    mx_alloc_memory(m);
+    mx_alloc_memory(m, m->msg_count + 1);
   }
 
   mdata->reopen |= IMAP_REOPEN_ALLOW;
@@ -1831,7 +1849,7 @@ char *imap_set_flags(struct Mailbox *m, struct Email *e, char *s, bool *server_c
   struct ImapEmailData old_edata = { 0 };
   int local_changes = e->changed;
 
-  struct ImapEmailData *edata = e->edata;
+  struct ImapEmailData *edata = e->cold->edata;
   newh.edata = edata;
 
   mutt_debug(LL_DEBUG2, "parsing FLAGS\n");
@@ -1842,7 +1860,7 @@ char *imap_set_flags(struct Mailbox *m, struct Email *e, char *s, bool *server_c
   /* Update tags system */
   /* We take a copy of the tags so we can split the string */
   char *tags_copy = mutt_str_dup(edata->flags_remote);
-  driver_tags_replace(&e->tags, tags_copy);
+  driver_tags_replace(&e->cold->tags, tags_copy);
   FREE(&tags_copy);
 
   /* YAUH (yet another ugly hack): temporarily set context to
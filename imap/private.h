@@ -326,6 +326,8 @@ void imap_hcache_open(struct ImapAccountData *adata, struct ImapMboxData *mdata)
 void imap_hcache_close(struct ImapMboxData *mdata);
 struct Email *imap_hcache_get(struct ImapMboxData *mdata, unsigned int uid);
 int imap_hcache_put(struct ImapMboxData *mdata, struct Email *e);
+int imap_hcache_put_async(struct ImapMboxData *mdata, struct Email *e);
+int imap_hcache_put_many(struct ImapMboxData *mdata, struct Email **emails, size_t num);
 int imap_hcache_del(struct ImapMboxData *mdata, unsigned int uid);
 int imap_hcache_store_uid_seqset(struct ImapMboxData *mdata);
 int imap_hcache_clear_uid_seqset(struct ImapMboxData *mdata);
@@ -460,7 +460,8 @@ void imap_hcache_open(struct ImapAccountData *adata, struct ImapMboxData *mdata)
   url.path = mbox->data;
   url_tobuffer(&url, cachepath, U_PATH);
 
-  hc = mutt_hcache_open(C_HeaderCache, mutt_b2s(cachepath), imap_hcache_namer);
+  hc = mutt_hcache_open(C_HeaderCache, mutt_b2s(cachepath), imap_hcache_namer,
+                        &adata->conn->account);
 
 cleanup:
   mutt_buffer_pool_release(&mbox);
@@ -524,6 +525,64 @@ int imap_hcache_put(struct ImapMboxData *mdata, struct Email *e)
   return mutt_hcache_store(mdata->hcache, key, mutt_str_len(key), e, mdata->uidvalidity);
 }
 
+/**
+ * imap_hcache_put_async - Queue an entry to be added to the header cache
+ * @param mdata Imap Mailbox data
+ * @param e     Email
+ * @retval  0 Success
+ * @retval -1 Failure
+ *
+ * The entry is written in the background, see mutt_hcache_store_async().
+ */
+int imap_hcache_put_async(struct ImapMboxData *mdata, struct Email *e)
+{
+  if (!mdata->hcache)
+    return -1;
+
+  char key[16];
+
+  sprintf(key, "/%u", imap_edata_get(e)->uid);
+  return mutt_hcache_store_async(mdata->hcache, key, mutt_str_len(key), e,
+                                 mdata->uidvalidity);
+}
+
+/**
+ * imap_hcache_put_many - Add many entries to the header cache
+ * @param mdata  Imap Mailbox data
+ * @param emails Emails to store
+ * @param num    Number of Emails
+ * @retval  0 Success
+ * @retval -1 Failure
+ *
+ * The Emails are written in a single header cache transaction.
+ */
+int imap_hcache_put_many(struct ImapMboxData *mdata, struct Email **emails, size_t num)
+{
+  if (!mdata->hcache)
+    return -1;
+
+  if (num == 0)
+    return 0;
+
+  struct HCacheItem *items = mutt_mem_calloc(num, sizeof(struct HCacheItem));
+  char(*keys)[16] = mutt_mem_calloc(num, sizeof(*keys));
+
+  for (size_t i = 0; i < num; i++)
+  {
+    sprintf(keys[i], "/%u", imap_edata_get(emails[i])->uid);
+    items[i].key = keys[i];
+    items[i].keylen = mutt_str_len(keys[i]);
+    items[i].entry.email = emails[i];
+    items[i].entry.uidvalidity = mdata->uidvalidity;
+  }
+
+  int rc = mutt_hcache_store_many(mdata->hcache, items, num);
+
+  FREE(&keys);
+  FREE(&items);
+  return (rc == 0) ? 0 : -1;
+}
+
 /**
  * imap_hcache_del - Delete an item from the header cache
  * @param mdata Imap Mailbox data
@@ -487,10 +487,15 @@ static void update_index_threaded(struct Context *ctx, int check, int oldcount)
   }
 
   /* Sort first to thread the new messages, because some patterns
-   * require the threading information.
+   * require the threading information.  New mail may already have been
+   * threaded, as it arrived.
    *
    * If the mailbox was reopened, need to rethread from scratch. */
-  mutt_sort_headers(ctx, (check == MUTT_REOPENED));
+  if ((check == MUTT_REOPENED) || (oldcount == ctx->mailbox->msg_count) ||
+      (ctx->msg_threaded != ctx->mailbox->msg_count))
+  {
+    mutt_sort_headers(ctx, (check == MUTT_REOPENED));
+  }
 
   if (ctx->pattern)
   {
@@ -903,7 +908,7 @@ void index_make_entry(char *buf, size_t buflen, struct Menu *menu, int line)
   MuttFormatFlags flags = MUTT_FORMAT_ARROWCURSOR | MUTT_FORMAT_INDEX;
   struct MuttThread *tmp = NULL;
 
-  if (((C_Sort & SORT_MASK) == SORT_THREADS) && e->tree)
+  if (((C_Sort & SORT_MASK) == SORT_THREADS) && e->cold->tree)
   {
     flags |= MUTT_FORMAT_TREE; /* display the thread tree */
     if (e->display_subject)
@@ -1418,6 +1423,9 @@ int mutt_index_menu(struct MuttWindow *dlg)
       if (op < 0)
       {
         mutt_timeout_hook();
+        /* Use the idle time to clean the header cache */
+        if (Context && Context->mailbox)
+          mx_mbox_gc(Context->mailbox, false);
         if (tag)
           mutt_window_clearline(MessageWindow, 0);
         continue;
@@ -2243,7 +2251,7 @@ int mutt_index_menu(struct MuttWindow *dlg)
           break;
         char *tags = NULL;
         if (!tag)
-          tags = driver_tags_get_with_hidden(&cur.e->tags);
+          tags = driver_tags_get_with_hidden(&cur.e->cold->tags);
         int rc = mx_tags_edit(m, tags, buf, sizeof(buf));
         FREE(&tags);
         if (rc < 0)
@@ -3759,6 +3767,7 @@ int mutt_index_menu(struct MuttWindow *dlg)
           break;
         if (!cur.e)
           break;
+        mutt_env_lazy_restore(cur.e->env);
         if ((op != OP_FOLLOWUP) || !cur.e->env->followup_to ||
             !mutt_istr_equal(cur.e->env->followup_to, "poster") ||
             (query_quadoption(C_FollowupToPoster,
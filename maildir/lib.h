@@ -30,6 +30,8 @@
  * | maildir/config.c  | @subpage maildir_config  |
  * | maildir/maildir.c | @subpage maildir_maildir |
  * | maildir/mh.c      | @subpage maildir_mh      |
+ * | maildir/parallel.c | @subpage maildir_parallel |
+ * | maildir/scan.c    | @subpage maildir_scan    |
  * | maildir/shared.c  | @subpage maildir_shared  |
  */
 
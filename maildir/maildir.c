@@ -230,10 +230,10 @@ int maildir_sync_message(struct Mailbox *m, int msgno)
   {
     /* we just have to rename the file. */
 
-    char *p = strrchr(e->path, '/');
+    char *p = strrchr(e->cold->path, '/');
     if (!p)
     {
-      mutt_debug(LL_DEBUG1, "%s: unable to find subdir!\n", e->path);
+      mutt_debug(LL_DEBUG1, "%s: unable to find subdir!\n", e->cold->path);
       return -1;
     }
     p++;
@@ -257,7 +257,7 @@ int maildir_sync_message(struct Mailbox *m, int msgno)
     mutt_buffer_printf(partpath, "%s/%s%s", (e->read || e->old) ? "cur" : "new",
                        mutt_b2s(newpath), suffix);
     mutt_buffer_printf(fullpath, "%s/%s", mailbox_path(m), mutt_b2s(partpath));
-    mutt_buffer_printf(oldpath, "%s/%s", mailbox_path(m), e->path);
+    mutt_buffer_printf(oldpath, "%s/%s", mailbox_path(m), e->cold->path);
 
     if (mutt_str_equal(mutt_b2s(fullpath), mutt_b2s(oldpath)))
     {
@@ -274,7 +274,7 @@ int maildir_sync_message(struct Mailbox *m, int msgno)
       rc = -1;
       goto cleanup;
     }
-    mutt_str_replace(&e->path, mutt_b2s(partpath));
+    mutt_str_replace(&e->cold->path, mutt_b2s(partpath));
   }
 
 cleanup:
@@ -293,10 +293,23 @@ static int maildir_mbox_open(struct Mailbox *m)
 {
   /* maildir looks sort of like MH, except that there are two subdirectories
    * of the main folder path from which to read messages */
-  if ((mh_read_dir(m, "new") == -1) || (mh_read_dir(m, "cur") == -1))
-    return -1;
+  static const char *const subdirs[] = { "new", "cur" };
+#ifdef USE_INOTIFY
+  /* Record the changes from now on, so that checks needn't read the dirs */
+  mutt_monitor_deltas_reset(m);
+#endif
+  return mh_read_dirs(m, subdirs, mutt_array_size(subdirs));
+}
 
-  return 0;
+/**
+ * maildir_mbox_close - Close a Mailbox - Implements MxOps::mbox_close()
+ */
+static int maildir_mbox_close(struct Mailbox *m)
+{
+#ifdef USE_INOTIFY
+  mutt_monitor_deltas_stop(m);
+#endif
+  return mh_mbox_close(m);
 }
 
 /**
@@ -356,6 +369,45 @@ static int maildir_mbox_open_append(struct Mailbox *m, OpenMailboxFlags flags)
   return 0;
 }
 
+#ifdef USE_INOTIFY
+/**
+ * maildir_parse_deltas - Create Maildir entries for the changed files
+ * @param[in]  m      Mailbox
+ * @param[out] last   Last Maildir
+ * @param[in]  deltas Changed files, e.g. "new/1234.host"
+ * @param[out] count  Counter of the entries created
+ * @retval ptr Hash table of the canonical names of the changed files
+ *
+ * Only the files that still exist get an entry.  The hash table tells the
+ * caller which of the existing messages may have moved or disappeared.
+ */
+static struct HashTable *maildir_parse_deltas(struct Mailbox *m, struct Maildir ***last,
+                                              struct ListHead *deltas, int *count)
+{
+  struct MaildirScan scans[] = { { .subdir = "new" }, { .subdir = "cur" } };
+
+  maildir_scan_names(m, scans, mutt_array_size(scans), deltas);
+  for (size_t i = 0; i < mutt_array_size(scans); i++)
+  {
+    maildir_parse_scan(m, last, &scans[i], count, NULL);
+    maildir_scan_free(&scans[i]);
+  }
+
+  struct HashTable *touched = mutt_hash_new(64, MUTT_HASH_STRDUP_KEYS);
+  struct Buffer *buf = mutt_buffer_pool_get();
+  struct ListNode *np = NULL;
+  STAILQ_FOREACH(np, deltas, entries)
+  {
+    maildir_canon_filename(buf, np->data);
+    if (!mutt_hash_find(touched, mutt_b2s(buf)))
+      mutt_hash_insert(touched, mutt_b2s(buf), np);
+  }
+  mutt_buffer_pool_release(&buf);
+
+  return touched;
+}
+#endif
+
 /**
  * maildir_mbox_check - Check for new mail - Implements MxOps::mbox_check()
  *
@@ -365,6 +417,9 @@ static int maildir_mbox_open_append(struct Mailbox *m, OpenMailboxFlags flags)
  * We check for newly added messages, and then merge the flags messages we
  * already knew about.  We don't treat either subdirectory differently, as mail
  * could be copied directly into the cur directory from another agent.
+ *
+ * If the monitor has recorded the files that have changed, only those files
+ * are looked at, see mutt_monitor_deltas_get().
  */
 int maildir_mbox_check(struct Mailbox *m)
 {
@@ -383,6 +438,8 @@ int maildir_mbox_check(struct Mailbox *m)
   int count = 0;
   struct HashTable *fnames = NULL; /* hash table for quickly looking up the base filename
                                  for a maildir message */
+  struct HashTable *touched = NULL; /* canonical names of the changed files */
+  bool use_deltas = false;          /* only look at the files the monitor saw change */
   struct MaildirMboxData *mdata = maildir_mdata_get(m);
 
   /* XXX seems like this check belongs in mx_mbox_check() rather than here.  */
@@ -410,7 +467,24 @@ int maildir_mbox_check(struct Mailbox *m)
   if (mutt_file_stat_timespec_compare(&st_cur, MUTT_STAT_MTIME, &mdata->mtime_cur) > 0)
     changed |= MMC_CUR_DIR;
 
-  if (changed == MMC_NO_DIRS)
+#ifdef USE_INOTIFY
+  /* The directories have been stat'd first, so any change that isn't in the
+   * list will be in the next one. */
+  struct ListHead deltas = STAILQ_HEAD_INITIALIZER(deltas);
+  if (mutt_monitor_deltas_get(m, &deltas))
+  {
+    /* If nothing was seen, but the mtimes changed, e.g. on a network
+     * filesystem, fall back to reading the directories */
+    use_deltas = !STAILQ_EMPTY(&deltas);
+  }
+  else if (mutt_monitor_deltas_reset(m))
+  {
+    /* Changes are recorded from now on, so catch up with a full scan */
+    changed = MMC_NEW_DIR | MMC_CUR_DIR;
+  }
+#endif
+
+  if ((changed == MMC_NO_DIRS) && !use_deltas)
   {
     mutt_buffer_pool_release(&buf);
     return 0; /* nothing to do */
@@ -423,9 +497,9 @@ int maildir_mbox_check(struct Mailbox *m)
    * noticed during the SAME group of mtime stat updates.  To work around
    * the problem, don't update the stat times for a monitor caused check. */
 #ifdef USE_INOTIFY
-  if (MonitorContextChanged)
-    MonitorContextChanged = false;
-  else
+  const bool monitor_changed = MonitorContextChanged;
+  MonitorContextChanged = false;
+  if (!monitor_changed || use_deltas)
 #endif
   {
     mutt_file_get_stat_timespec(&mdata->mtime_cur, &st_cur, MUTT_STAT_MTIME);
@@ -436,10 +510,23 @@ int maildir_mbox_check(struct Mailbox *m)
    * the subdirectories that have changed.  */
   md = NULL;
   last = &md;
-  if (changed & MMC_NEW_DIR)
-    maildir_parse_dir(m, &last, "new", &count, NULL);
-  if (changed & MMC_CUR_DIR)
-    maildir_parse_dir(m, &last, "cur", &count, NULL);
+#ifdef USE_INOTIFY
+  if (use_deltas)
+  {
+    mutt_debug(LL_DEBUG2, "%s: reading only the changed files\n", mailbox_path(m));
+    touched = maildir_parse_deltas(m, &last, &deltas, &count);
+  }
+  else
+#endif
+  {
+    const char *subdirs[2];
+    size_t num_subdirs = 0;
+    if (changed & MMC_NEW_DIR)
+      subdirs[num_subdirs++] = "new";
+    if (changed & MMC_CUR_DIR)
+      subdirs[num_subdirs++] = "cur";
+    maildir_parse_dirs(m, &last, subdirs, num_subdirs, &count, NULL);
+  }
 
   /* we create a hash table keyed off the canonical (sans flags) filename
    * of each message we scanned.  This is used in the loop over the
@@ -448,7 +535,7 @@ int maildir_mbox_check(struct Mailbox *m)
 
   for (p = md; p; p = p->next)
   {
-    maildir_canon_filename(buf, p->email->path);
+    maildir_canon_filename(buf, p->email->cold->path);
     p->canon_fname = mutt_buffer_strdup(buf);
     mutt_hash_insert(fnames, p->canon_fname, p);
   }
@@ -461,7 +548,7 @@ int maildir_mbox_check(struct Mailbox *m)
       break;
 
     e->active = false;
-    maildir_canon_filename(buf, e->path);
+    maildir_canon_filename(buf, e->cold->path);
     p = mutt_hash_find(fnames, mutt_b2s(buf));
     if (p && p->email)
     {
@@ -470,8 +557,8 @@ int maildir_mbox_check(struct Mailbox *m)
 
       /* check to see if the message has moved to a different
        * subdirectory.  If so, update the associated filename.  */
-      if (!mutt_str_equal(e->path, p->email->path))
-        mutt_str_replace(&e->path, p->email->path);
+      if (!mutt_str_equal(e->cold->path, p->email->cold->path))
+        mutt_str_replace(&e->cold->path, p->email->cold->path);
 
       /* if the user hasn't modified the flags on this message, update
        * the flags we just detected.  */
@@ -495,8 +582,9 @@ int maildir_mbox_check(struct Mailbox *m)
     /* This message was not in the list of messages we just scanned.
      * Check to see if we have enough information to know if the
      * message has disappeared out from underneath us.  */
-    else if (((changed & MMC_NEW_DIR) && mutt_strn_equal(e->path, "new/", 4)) ||
-             ((changed & MMC_CUR_DIR) && mutt_strn_equal(e->path, "cur/", 4)))
+    else if (touched ? (mutt_hash_find(touched, mutt_b2s(buf)) != NULL) :
+                       (((changed & MMC_NEW_DIR) && mutt_strn_equal(e->cold->path, "new/", 4)) ||
+                        ((changed & MMC_CUR_DIR) && mutt_strn_equal(e->cold->path, "cur/", 4))))
     {
       /* This message disappeared, so we need to simulate a "reopen"
        * event.  We know it disappeared because we just scanned the
@@ -516,6 +604,10 @@ int maildir_mbox_check(struct Mailbox *m)
 
   /* destroy the file name hash */
   mutt_hash_free(&fnames);
+  mutt_hash_free(&touched);
+#ifdef USE_INOTIFY
+  mutt_list_free(&deltas);
+#endif
 
   /* If we didn't just get new mail, update the tables. */
   if (occult)
@@ -674,8 +766,8 @@ static int maildir_msg_save_hcache(struct Mailbox *m, struct Email *e)
 {
   int rc = 0;
 #ifdef USE_HCACHE
-  struct HeaderCache *hc = mutt_hcache_open(C_HeaderCache, mailbox_path(m), NULL);
-  char *key = e->path + 3;
+  struct HeaderCache *hc = mutt_hcache_open(C_HeaderCache, mailbox_path(m), NULL, NULL);
+  char *key = e->cold->path + 3;
   int keylen = maildir_hcache_keylen(key);
   rc = mutt_hcache_store(hc, key, keylen, e, 0);
   mutt_hcache_close(hc);
@@ -719,13 +811,14 @@ struct MxOps MxMaildirOps = {
   .mbox_check       = maildir_mbox_check,
   .mbox_check_stats = maildir_mbox_check_stats,
   .mbox_sync        = mh_mbox_sync,
-  .mbox_close       = mh_mbox_close,
+  .mbox_close       = maildir_mbox_close,
   .msg_open         = maildir_msg_open,
   .msg_open_new     = maildir_msg_open_new,
   .msg_commit       = maildir_msg_commit,
   .msg_close        = mh_msg_close,
   .msg_padding_size = NULL,
   .msg_save_hcache  = maildir_msg_save_hcache,
+  .mbox_gc          = maildir_mbox_gc,
   .tags_edit        = NULL,
   .tags_commit      = NULL,
   .path_probe       = maildir_path_probe,
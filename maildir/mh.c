@@ -220,11 +220,11 @@ void mh_update_sequences(struct Mailbox *m)
     if (e->deleted)
       continue;
 
-    p = strrchr(e->path, '/');
+    p = strrchr(e->cold->path, '/');
     if (p)
       p++;
     else
-      p = e->path;
+      p = e->cold->path;
 
     if (mutt_str_atoi(p, &seq_num) < 0)
       continue;
@@ -496,11 +496,11 @@ void mh_update_maildir(struct Maildir *md, struct MhSequences *mhs)
 
   for (; md; md = md->next)
   {
-    char *p = strrchr(md->email->path, '/');
+    char *p = strrchr(md->email->cold->path, '/');
     if (p)
       p++;
     else
-      p = md->email->path;
+      p = md->email->cold->path;
 
     if (mutt_str_atoi(p, &i) < 0)
       continue;
@@ -675,7 +675,7 @@ int mh_mbox_check(struct Mailbox *m)
   for (p = md; p; p = p->next)
   {
     /* the hash key must survive past the header, which is freed below. */
-    p->canon_fname = mutt_str_dup(p->email->path);
+    p->canon_fname = mutt_str_dup(p->email->cold->path);
     mutt_hash_insert(fnames, p->canon_fname, p);
   }
 
@@ -687,7 +687,7 @@ int mh_mbox_check(struct Mailbox *m)
 
     e->active = false;
 
-    p = mutt_hash_find(fnames, e->path);
+    p = mutt_hash_find(fnames, e->cold->path);
     if (p && p->email && email_cmp_strict(e, p->email))
     {
       e->active = true;
@@ -825,6 +825,7 @@ struct MxOps MxMhOps = {
   .msg_close        = mh_msg_close,
   .msg_padding_size = NULL,
   .msg_save_hcache  = mh_msg_save_hcache,
+  .mbox_gc          = maildir_mbox_gc,
   .tags_edit        = NULL,
   .tags_commit      = NULL,
   .path_probe       = mh_path_probe,
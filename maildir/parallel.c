@@ -0,0 +1,96 @@
+/**
+ * @file
+ * Parse Maildir messages in parallel
+ *
+ * @authors
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * @copyright
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @page maildir_parallel Parse Maildir messages in parallel
+ *
+ * When a large Maildir is opened for the first time, reading the headers of
+ * every message is CPU-bound.  This spreads the work across a small pool of
+ * threads, see mutt_parallel_run().  The same pool is used to read the
+ * directories and to check the files' modification times, see
+ * maildir_scan_dirs().
+ *
+ * Each worker takes the next unparsed entry and stores the result in place.
+ * The list isn't reordered, so the caller sees the entries in the same
+ * (inode) order as before.
+ */
+
+#include "config.h"
+#include <limits.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include "private.h"
+#include "mutt/lib.h"
+#include "email/lib.h"
+#include "core/lib.h"
+#include "maildir/lib.h"
+
+/**
+ * struct ParseJob - Maildir entries to parse
+ */
+struct ParseJob
+{
+  enum MailboxType type; ///< Mailbox type, e.g. #MUTT_MAILDIR
+  const char *path;      ///< Path of the Mailbox
+  struct Maildir **list; ///< Entries to parse
+};
+
+/**
+ * parse_one - Parse one Maildir entry - Implements ::parallel_work_t
+ */
+static void parse_one(void *data, size_t i)
+{
+  struct ParseJob *job = data;
+  char fn[PATH_MAX];
+
+  struct Maildir *p = job->list[i];
+  snprintf(fn, sizeof(fn), "%s/%s", job->path, p->email->cold->path);
+
+  if (maildir_parse_message(job->type, fn, p->email->old, p->email))
+    p->header_parsed = true;
+  else
+    email_free(&p->email);
+}
+
+/**
+ * maildir_parse_parallel - Parse a set of Maildir entries using several threads
+ * @param m       Mailbox
+ * @param list    Entries to parse
+ * @param num     Number of entries
+ * @param threads Number of threads to use
+ *
+ * On success, each entry's header_parsed flag is set.
+ * On failure, the entry's Email is freed.
+ */
+void maildir_parse_parallel(struct Mailbox *m, struct Maildir **list, size_t num, int threads)
+{
+  if (!m || !list || (num == 0))
+    return;
+
+  struct ParseJob job = {
+    .type = m->type,
+    .path = mailbox_path(m),
+    .list = list,
+  };
+
+  mutt_parallel_run(parse_one, NULL, &job, num, threads);
+}
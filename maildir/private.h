@@ -31,7 +31,9 @@
 
 struct Account;
 struct Buffer;
+struct ListHead;
 struct Email;
+struct HCacheGc;
 struct Mailbox;
 struct Message;
 struct Progress;
@@ -51,6 +53,9 @@ struct MaildirMboxData
 {
   struct timespec mtime_cur;
   mode_t mh_umask;
+  struct HCacheGc *hcache_gc; ///< Garbage collector for the header cache
+  struct HeaderCache *hcache; ///< Header cache, kept open while the garbage collector runs
+  bool hcache_gc_done;        ///< The header cache has been cleaned since the last scan
 };
 
 /**
@@ -65,6 +70,31 @@ struct Maildir
   struct Maildir *next;
 };
 
+/**
+ * struct MaildirScanEntry - A file found in a Maildir directory
+ */
+struct MaildirScanEntry
+{
+  size_t name; ///< Offset of the name in MaildirScan::names
+  ino_t inode; ///< Inode number
+};
+
+/**
+ * struct MaildirScan - The files in a Maildir directory
+ */
+struct MaildirScan
+{
+  const char *mailbox;              ///< Path of the Mailbox
+  const char *subdir;               ///< Subdirectory, e.g. "cur", or NULL
+  struct MaildirScanEntry *entries; ///< Files found
+  size_t num;                       ///< Number of files
+  size_t max;                       ///< Size of the entries array
+  char *names;                      ///< File names, each NUL-terminated
+  size_t names_len;                 ///< Length of the names
+  size_t names_max;                 ///< Size of the names buffer
+  int error;                        ///< errno, if the directory couldn't be read
+};
+
 typedef uint8_t MhSeqFlags;     ///< Flags, e.g. #MH_SEQ_UNSEEN
 #define MH_SEQ_NO_FLAGS      0  ///< No flags are set
 #define MH_SEQ_UNSEEN  (1 << 0) ///< Email hasn't been read
@@ -83,6 +113,9 @@ struct MhSequences
 extern bool  C_CheckNew;
 extern bool  C_MaildirCheckCur;
 extern bool  C_MaildirTrash;
+#ifdef USE_PTHREADS
+extern short C_MaildirParseThreads;
+#endif
 extern bool  C_MhPurge;
 extern char *C_MhSeqFlagged;
 extern char *C_MhSeqReplied;
@@ -105,14 +138,23 @@ int             mh_msg_save_hcache (struct Mailbox *m, struct Email *e);
 void                    maildir_canon_filename (struct Buffer *dest, const char *src);
 void                    maildir_delayed_parsing(struct Mailbox *m, struct Maildir **md, struct Progress *progress);
 size_t                  maildir_hcache_keylen  (const char *fn);
+int                     maildir_mbox_gc        (struct Mailbox *m, bool compact);
 struct MaildirMboxData *maildir_mdata_get      (struct Mailbox *m);
 int                     maildir_mh_open_message(struct Mailbox *m, struct Message *msg, int msgno, bool is_maildir);
 int                     maildir_move_to_mailbox(struct Mailbox *m, struct Maildir **ptr);
 int                     maildir_parse_dir      (struct Mailbox *m, struct Maildir ***last, const char *subdir, int *count, struct Progress *progress);
+int                     maildir_parse_dirs     (struct Mailbox *m, struct Maildir ***last, const char *const *subdirs, size_t num, int *count, struct Progress *progress);
+void                    maildir_parse_parallel (struct Mailbox *m, struct Maildir **list, size_t num, int threads);
+void                    maildir_parse_scan     (struct Mailbox *m, struct Maildir ***last, const struct MaildirScan *scan, int *count, struct Progress *progress);
+void                    maildir_scan_dirs      (struct Mailbox *m, struct MaildirScan *scans, size_t num, int threads);
+void                    maildir_scan_free      (struct MaildirScan *scan);
+void                    maildir_scan_mtimes    (struct Mailbox *m, struct Maildir **list, size_t num, time_t *mtimes, int threads);
+void                    maildir_scan_names     (struct Mailbox *m, struct MaildirScan *scans, size_t num, const struct ListHead *names);
 int                     md_commit_message      (struct Mailbox *m, struct Message *msg, struct Email *e);
 int                     mh_commit_msg          (struct Mailbox *m, struct Message *msg, struct Email *e, bool updseq);
 int                     mh_mkstemp             (struct Mailbox *m, FILE **fp, char **tgt);
 int                     mh_read_dir            (struct Mailbox *m, const char *subdir);
+int                     mh_read_dirs           (struct Mailbox *m, const char *const *subdirs, size_t num);
 int                     mh_read_sequences      (struct MhSequences *mhs, const char *path);
 MhSeqFlags              mhs_check              (struct MhSequences *mhs, int i);
 void                    mhs_sequences_free     (struct MhSequences *mhs);
@@ -0,0 +1,323 @@
+/**
+ * @file
+ * Read the files in Maildir directories
+ *
+ * @authors
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * @copyright
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @page maildir_scan Read the files in Maildir directories
+ *
+ * Opening a large Maildir on network storage is dominated by system calls:
+ * reading the directories and, if $maildir_header_cache_verify is set,
+ * checking the modification time of every file.
+ *
+ * The directories are read with large getdents64() calls, where they're
+ * available, and the names are stored in one block of memory.  If
+ * $maildir_parse_threads is set, the directories, e.g. 'new' and 'cur', are
+ * read at the same time, and the files are checked using a pool of threads.
+ * The files are checked relative to the Mailbox's directory, which saves
+ * looking up its path every time.
+ */
+
+#include "config.h"
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "private.h"
+#include "mutt/lib.h"
+#include "email/lib.h"
+#include "core/lib.h"
+#include "mutt_globals.h"
+
+#define MAILDIR_SCAN_BUFSIZE (256 * 1024) ///< Size of the buffer for getdents64()
+
+/**
+ * struct MtimeJob - Maildir entries to check
+ */
+struct MtimeJob
+{
+  int dirfd;             ///< Directory of the Mailbox, or AT_FDCWD
+  const char *path;      ///< Path of the Mailbox
+  struct Maildir **list; ///< Entries to check
+  time_t *mtimes;        ///< Modification times
+};
+
+/**
+ * scan_add - Add a file to a scan
+ * @param scan  Scan
+ * @param name  File name
+ * @param inode Inode number
+ */
+static void scan_add(struct MaildirScan *scan, const char *name, ino_t inode)
+{
+  if ((name[0] == '.') && ((name[1] == '\0') || ((name[1] == '.') && (name[2] == '\0'))))
+    return;
+
+  const size_t len = strlen(name) + 1;
+  if ((scan->names_len + len) > scan->names_max)
+  {
+    scan->names_max = MAX(scan->names_max * 2, scan->names_len + len + 4096);
+    mutt_mem_realloc(&scan->names, scan->names_max);
+  }
+
+  if (scan->num == scan->max)
+  {
+    scan->max = MAX(scan->max * 2, 256);
+    mutt_mem_realloc(&scan->entries, scan->max * sizeof(struct MaildirScanEntry));
+  }
+
+  struct MaildirScanEntry *entry = &scan->entries[scan->num++];
+  entry->name = scan->names_len;
+  entry->inode = inode;
+
+  memcpy(scan->names + scan->names_len, name, len);
+  scan->names_len += len;
+}
+
+/**
+ * scan_dir - Read the files in a directory
+ * @param path Directory
+ * @param scan Scan to fill
+ */
+static void scan_dir(const char *path, struct MaildirScan *scan)
+{
+#ifdef HAVE_GETDENTS64
+  int fd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (fd < 0)
+  {
+    scan->error = errno;
+    return;
+  }
+
+  char *buf = mutt_mem_malloc(MAILDIR_SCAN_BUFSIZE);
+  while (SigInt != 1)
+  {
+    ssize_t len = getdents64(fd, buf, MAILDIR_SCAN_BUFSIZE);
+    if (len < 0)
+    {
+      if (errno == EINTR)
+        continue;
+      scan->error = errno;
+      break;
+    }
+    if (len == 0)
+      break;
+
+    for (ssize_t pos = 0; pos < len;)
+    {
+      struct dirent64 *de = (struct dirent64 *) (buf + pos);
+      scan_add(scan, de->d_name, de->d_ino);
+      pos += de->d_reclen;
+    }
+  }
+  FREE(&buf);
+  close(fd);
+#else
+  DIR *dirp = opendir(path);
+  if (!dirp)
+  {
+    scan->error = errno;
+    return;
+  }
+
+  struct dirent *de = NULL;
+  while ((SigInt != 1) && (de = readdir(dirp)))
+    scan_add(scan, de->d_name, de->d_ino);
+
+  closedir(dirp);
+#endif
+}
+
+/**
+ * scan_one - Read one directory of a Mailbox - Implements ::parallel_work_t
+ */
+static void scan_one(void *data, size_t i)
+{
+  struct MaildirScan *scan = &((struct MaildirScan *) data)[i];
+  char path[PATH_MAX];
+
+  if (scan->subdir)
+    snprintf(path, sizeof(path), "%s/%s", scan->mailbox, scan->subdir);
+  else
+    mutt_str_copy(path, scan->mailbox, sizeof(path));
+
+  scan_dir(path, scan);
+}
+
+/**
+ * maildir_scan_dirs - Read the files in a Mailbox's directories
+ * @param m       Mailbox
+ * @param scans   Scans to fill, with their subdir set, e.g. "new"
+ * @param num     Number of scans
+ * @param threads Number of threads to use
+ *
+ * If a directory can't be read, the scan's error is set to the errno.
+ * The scans must be freed with maildir_scan_free().
+ */
+void maildir_scan_dirs(struct Mailbox *m, struct MaildirScan *scans, size_t num, int threads)
+{
+  if (!m || !scans)
+    return;
+
+  for (size_t i = 0; i < num; i++)
+    scans[i].mailbox = mailbox_path(m);
+
+#ifdef USE_PTHREADS
+  if ((threads > 1) && (num > 1))
+  {
+    mutt_parallel_run(scan_one, NULL, scans, num, threads);
+    return;
+  }
+#endif
+
+  for (size_t i = 0; i < num; i++)
+    scan_one(scans, i);
+}
+
+/**
+ * maildir_scan_free - Free the contents of a scan
+ * @param scan Scan to free
+ */
+void maildir_scan_free(struct MaildirScan *scan)
+{
+  if (!scan)
+    return;
+
+  FREE(&scan->entries);
+  FREE(&scan->names);
+  memset(scan, 0, sizeof(*scan));
+}
+
+/**
+ * maildir_scan_names - Find which of a set of files exist
+ * @param m     Mailbox
+ * @param scans Scans to fill, with their subdir set, e.g. "new"
+ * @param num   Number of scans
+ * @param names Files to look for, e.g. "new/1234.host"
+ *
+ * Each file that exists is added to the scan of its subdirectory, once.
+ * Files in other directories are ignored.
+ */
+void maildir_scan_names(struct Mailbox *m, struct MaildirScan *scans, size_t num,
+                        const struct ListHead *names)
+{
+  if (!m || !scans || !names)
+    return;
+
+  int dirfd = open(mailbox_path(m), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (dirfd < 0)
+    return;
+
+  struct HashTable *seen = mutt_hash_new(64, MUTT_HASH_NO_FLAGS);
+  struct ListNode *np = NULL;
+  STAILQ_FOREACH(np, names, entries)
+  {
+    const char *slash = strchr(np->data, '/');
+    if (!slash || mutt_hash_find(seen, np->data))
+      continue;
+    mutt_hash_insert(seen, np->data, np);
+
+    size_t i = 0;
+    for (; i < num; i++)
+    {
+      if (scans[i].subdir && mutt_strn_equal(np->data, scans[i].subdir, slash - np->data) &&
+          (scans[i].subdir[slash - np->data] == '\0'))
+      {
+        break;
+      }
+    }
+
+    struct stat st = { 0 };
+    if ((i < num) && (fstatat(dirfd, np->data, &st, 0) == 0))
+    {
+      scans[i].mailbox = mailbox_path(m);
+      scan_add(&scans[i], slash + 1, st.st_ino);
+    }
+  }
+
+  mutt_hash_free(&seen);
+  close(dirfd);
+}
+
+/**
+ * mtime_one - Get the modification time of one Maildir entry - Implements ::parallel_work_t
+ */
+static void mtime_one(void *data, size_t i)
+{
+  struct MtimeJob *job = data;
+  struct stat st = { 0 };
+  const char *name = job->list[i]->email->cold->path;
+  int rc;
+
+  if (job->dirfd == AT_FDCWD)
+  {
+    char fn[PATH_MAX];
+    snprintf(fn, sizeof(fn), "%s/%s", job->path, name);
+    rc = stat(fn, &st);
+  }
+  else
+  {
+    rc = fstatat(job->dirfd, name, &st, 0);
+  }
+
+  job->mtimes[i] = (rc == 0) ? st.st_mtime : -1;
+}
+
+/**
+ * maildir_scan_mtimes - Get the modification times of a set of Maildir entries
+ * @param[in]  m       Mailbox
+ * @param[in]  list    Entries to check
+ * @param[in]  num     Number of entries
+ * @param[out] mtimes  Modification time of each entry, -1 if it can't be found
+ * @param[in]  threads Number of threads to use
+ */
+void maildir_scan_mtimes(struct Mailbox *m, struct Maildir **list, size_t num,
+                         time_t *mtimes, int threads)
+{
+  if (!m || !list || !mtimes || (num == 0))
+    return;
+
+  struct MtimeJob job = {
+    .dirfd = open(mailbox_path(m), O_RDONLY | O_DIRECTORY | O_CLOEXEC),
+    .path = mailbox_path(m),
+    .list = list,
+    .mtimes = mtimes,
+  };
+  if (job.dirfd < 0)
+    job.dirfd = AT_FDCWD;
+
+#ifdef USE_PTHREADS
+  if ((threads > 1) && (num > 1))
+    mutt_parallel_run(mtime_one, NULL, &job, num, threads);
+  else
+#endif
+  {
+    for (size_t i = 0; i < num; i++)
+      mtime_one(&job, i);
+  }
+
+  if (job.dirfd != AT_FDCWD)
+    close(job.dirfd);
+}
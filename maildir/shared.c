@@ -62,6 +62,9 @@
 #endif
 
 #define INS_SORT_THRESHOLD 6
+#define MAILDIR_BATCH_SIZE 256 ///< Number of header cache entries to fetch/store at once
+#define MAILDIR_GC_BATCH 1000  ///< Number of stale header cache records to delete at once
+#define MH_KEY_LEN 32          ///< Length of an MH header cache key, e.g. "/123"
 
 /**
  * maildir_edata_free - Free the private Email data - Implements Email::edata_free()
@@ -96,9 +99,22 @@ struct MaildirEmailData *maildir_edata_get(struct Email *e)
 {
   if (!e)
     return NULL;
-  return e->edata;
+  return e->cold->edata;
 }
 
+#ifdef USE_HCACHE
+/**
+ * maildir_gc_stop - Stop the header cache garbage collector
+ * @param mdata Maildir Mailbox data
+ */
+static void maildir_gc_stop(struct MaildirMboxData *mdata)
+{
+  mutt_hcache_gc_free(&mdata->hcache_gc);
+  mutt_hcache_close(mdata->hcache);
+  mdata->hcache = NULL;
+}
+#endif
+
 /**
  * maildir_mdata_free - Free the private Mailbox data - Implements Mailbox::mdata_free()
  */
@@ -107,7 +123,9 @@ static void maildir_mdata_free(void **ptr)
   if (!ptr || !*ptr)
     return;
 
-  // struct MaildirMboxData *mdata = *ptr;
+#ifdef USE_HCACHE
+  maildir_gc_stop(*ptr);
+#endif
   FREE(ptr);
 }
 
@@ -352,60 +370,55 @@ static void maildir_update_mtime(struct Mailbox *m)
 }
 
 /**
- * maildir_parse_dir - Read a Maildir mailbox
+ * maildir_threads - Get the number of threads to use
+ * @retval num Number of threads, 1 if threads aren't supported
+ */
+static int maildir_threads(void)
+{
+#ifdef USE_PTHREADS
+  return C_MaildirParseThreads;
+#else
+  return 1;
+#endif
+}
+
+/**
+ * maildir_parse_scan - Create Maildir entries for the files of a scan
  * @param[in]  m        Mailbox
  * @param[out] last     Last Maildir
- * @param[in]  subdir   Subdirectory, e.g. 'new'
+ * @param[in]  scan     Files found in one directory
  * @param[out] count    Counter for the progress bar
  * @param[in]  progress Progress bar
- * @retval  0 Success
- * @retval -1 Error
- * @retval -2 Aborted
  */
-int maildir_parse_dir(struct Mailbox *m, struct Maildir ***last,
-                      const char *subdir, int *count, struct Progress *progress)
+void maildir_parse_scan(struct Mailbox *m, struct Maildir ***last,
+                        const struct MaildirScan *scan, int *count, struct Progress *progress)
 {
-  struct dirent *de = NULL;
-  int rc = 0;
-  bool is_old = false;
+  const char *subdir = scan->subdir;
+  const bool is_old = (subdir && C_MarkOld) ? mutt_str_equal("cur", subdir) : false;
   struct Maildir *entry = NULL;
   struct Email *e = NULL;
 
   struct Buffer *buf = mutt_buffer_pool_get();
 
-  if (subdir)
-  {
-    mutt_buffer_printf(buf, "%s/%s", mailbox_path(m), subdir);
-    is_old = C_MarkOld ? mutt_str_equal("cur", subdir) : false;
-  }
-  else
-    mutt_buffer_strcpy(buf, mailbox_path(m));
-
-  DIR *dirp = opendir(mutt_b2s(buf));
-  if (!dirp)
-  {
-    rc = -1;
-    goto cleanup;
-  }
-
-  while (((de = readdir(dirp))) && (SigInt != 1))
+  for (size_t i = 0; (i < scan->num) && (SigInt != 1); i++)
   {
-    if (((m->type == MUTT_MH) && !mh_valid_message(de->d_name)) ||
-        ((m->type == MUTT_MAILDIR) && (*de->d_name == '.')))
+    const char *name = scan->names + scan->entries[i].name;
+    if (((m->type == MUTT_MH) && !mh_valid_message(name)) ||
+        ((m->type == MUTT_MAILDIR) && (*name == '.')))
     {
       continue;
     }
 
     /* FOO - really ignore the return value? */
-    mutt_debug(LL_DEBUG2, "queueing %s\n", de->d_name);
+    mutt_debug(LL_DEBUG2, "queueing %s\n", name);
 
     e = email_new();
-    e->edata = maildir_edata_new();
-    e->edata_free = maildir_edata_free;
+    e->cold->edata = maildir_edata_new();
+    e->cold->edata_free = maildir_edata_free;
 
     e->old = is_old;
     if (m->type == MUTT_MAILDIR)
-      maildir_parse_flags(e, de->d_name);
+      maildir_parse_flags(e, name);
 
     if (count)
     {
@@ -416,20 +429,65 @@ int maildir_parse_dir(struct Mailbox *m, struct Maildir ***last,
 
     if (subdir)
     {
-      mutt_buffer_printf(buf, "%s/%s", subdir, de->d_name);
-      e->path = mutt_buffer_strdup(buf);
+      mutt_buffer_printf(buf, "%s/%s", subdir, name);
+      e->cold->path = mutt_buffer_strdup(buf);
     }
     else
-      e->path = mutt_str_dup(de->d_name);
+      e->cold->path = mutt_str_dup(name);
 
     entry = maildir_entry_new();
     entry->email = e;
-    entry->inode = de->d_ino;
+    entry->inode = scan->entries[i].inode;
     **last = entry;
     *last = &entry->next;
   }
 
-  closedir(dirp);
+  mutt_buffer_pool_release(&buf);
+}
+
+/**
+ * maildir_parse_dirs - Read several directories of a Maildir mailbox
+ * @param[in]  m        Mailbox
+ * @param[out] last     Last Maildir
+ * @param[in]  subdirs  Subdirectories, e.g. 'new' and 'cur'
+ * @param[in]  num      Number of subdirectories
+ * @param[out] count    Counter for the progress bar
+ * @param[in]  progress Progress bar
+ * @retval  0 Success
+ * @retval -1 Error
+ * @retval -2 Aborted
+ *
+ * The directories are read together, see maildir_scan_dirs(), but the entries
+ * are added in the order of the subdirectories.  If a directory can't be read,
+ * it's skipped and -1 is returned.
+ */
+int maildir_parse_dirs(struct Mailbox *m, struct Maildir ***last,
+                       const char *const *subdirs, size_t num, int *count,
+                       struct Progress *progress)
+{
+  if (!m || !subdirs || (num == 0))
+    return -1;
+
+  int rc = 0;
+  struct MaildirScan *scans = mutt_mem_calloc(num, sizeof(struct MaildirScan));
+  for (size_t i = 0; i < num; i++)
+    scans[i].subdir = subdirs[i];
+
+  maildir_scan_dirs(m, scans, num, maildir_threads());
+
+  for (size_t i = 0; i < num; i++)
+  {
+    if (scans[i].error != 0)
+    {
+      rc = -1;
+      continue;
+    }
+    maildir_parse_scan(m, last, &scans[i], count, progress);
+  }
+
+  for (size_t i = 0; i < num; i++)
+    maildir_scan_free(&scans[i]);
+  FREE(&scans);
 
   if (SigInt == 1)
   {
@@ -437,12 +495,26 @@ int maildir_parse_dir(struct Mailbox *m, struct Maildir ***last,
     return -2; /* action aborted */
   }
 
-cleanup:
-  mutt_buffer_pool_release(&buf);
-
   return rc;
 }
 
+/**
+ * maildir_parse_dir - Read a Maildir mailbox
+ * @param[in]  m        Mailbox
+ * @param[out] last     Last Maildir
+ * @param[in]  subdir   Subdirectory, e.g. 'new'
+ * @param[out] count    Counter for the progress bar
+ * @param[in]  progress Progress bar
+ * @retval  0 Success
+ * @retval -1 Error
+ * @retval -2 Aborted
+ */
+int maildir_parse_dir(struct Mailbox *m, struct Maildir ***last,
+                      const char *subdir, int *count, struct Progress *progress)
+{
+  return maildir_parse_dirs(m, last, &subdir, 1, count, progress);
+}
+
 /**
  * maildir_move_to_mailbox - Copy the Maildir list to the Mailbox
  * @param[in]  m   Mailbox
@@ -458,7 +530,14 @@ int maildir_move_to_mailbox(struct Mailbox *m, struct Maildir **ptr)
   struct Maildir *md = *ptr;
   int oldmsgcount = m->msg_count;
 
+  /* Make room for all the emails at once */
+  int num_emails = 0;
   for (; md; md = md->next)
+    if (md->email)
+      num_emails++;
+  mx_alloc_memory(m, m->msg_count + num_emails);
+
+  for (md = *ptr; md; md = md->next)
   {
     mutt_debug(LL_DEBUG2, "Considering %s\n", NONULL(md->canon_fname));
     if (!md->email)
@@ -469,7 +548,7 @@ int maildir_move_to_mailbox(struct Mailbox *m, struct Maildir **ptr)
                md->email->replied ? "r" : "", md->email->old ? "O" : "",
                md->email->read ? "R" : "");
     if (m->msg_count == m->email_max)
-      mx_alloc_memory(m);
+      mx_alloc_memory(m, m->msg_count + 1);
 
     m->emails[m->msg_count] = md->email;
     m->emails[m->msg_count]->index = m->msg_count;
@@ -523,7 +602,7 @@ static int md_cmp_inode(struct Maildir *a, struct Maildir *b)
  */
 static int md_cmp_path(struct Maildir *a, struct Maildir *b)
 {
-  return strcmp(a->email->path, b->email->path);
+  return strcmp(a->email->cold->path, b->email->cold->path);
 }
 
 /**
@@ -701,6 +780,142 @@ static struct Maildir *skip_duplicates(struct Maildir *p, struct Maildir **last)
   return p;
 }
 
+/**
+ * maildir_parse_entries - Read the headers of a set of Maildir entries
+ * @param m    Mailbox
+ * @param list Entries to parse
+ * @param num  Number of entries
+ *
+ * If $maildir_parse_threads is set, the entries are read in parallel.
+ * On success, each entry's header_parsed flag is set.
+ * On failure, the entry's Email is freed.
+ */
+static void maildir_parse_entries(struct Mailbox *m, struct Maildir **list, size_t num)
+{
+#ifdef USE_PTHREADS
+  if ((C_MaildirParseThreads > 1) && (num > 1))
+  {
+    maildir_parse_parallel(m, list, num, C_MaildirParseThreads);
+    return;
+  }
+#endif
+
+  char fn[PATH_MAX];
+  for (size_t i = 0; i < num; i++)
+  {
+    struct Maildir *p = list[i];
+    snprintf(fn, sizeof(fn), "%s/%s", mailbox_path(m), p->email->cold->path);
+
+    if (maildir_parse_message(m->type, fn, p->email->old, p->email))
+      p->header_parsed = true;
+    else
+      email_free(&p->email);
+  }
+}
+
+#ifdef USE_HCACHE
+/**
+ * maildir_hcache_key - Get the header cache key for an Email
+ * @param[in]  m      Mailbox
+ * @param[in]  e      Email
+ * @param[in]  buf    Buffer for an MH key
+ * @param[in]  buflen Length of the buffer
+ * @param[out] keylen Length of the key
+ * @retval ptr Key (points into the Email's path, or buf)
+ *
+ * Like the Maildir keys, the MH keys start with a '/', so the folder's
+ * records can't be confused with those of a folder whose name continues
+ * with digits, e.g. `/mail/box` and `/mail/box2`.
+ */
+static const char *maildir_hcache_key(struct Mailbox *m, struct Email *e,
+                                      char *buf, size_t buflen, size_t *keylen)
+{
+  if (m->type == MUTT_MH)
+  {
+    snprintf(buf, buflen, "/%s", e->cold->path);
+    *keylen = strlen(buf);
+    return buf;
+  }
+
+  const char *key = e->cold->path + 3;
+  *keylen = maildir_hcache_keylen(key);
+  return key;
+}
+
+/**
+ * maildir_parse_batch - Parse a batch of Maildir entries
+ * @param m     Mailbox
+ * @param hc    Header cache
+ * @param batch Maildir entries to parse
+ * @param num   Number of entries
+ *
+ * The header cache is queried for the whole batch at once.  Any misses are
+ * parsed from disk, see maildir_parse_entries(), then queued to be stored
+ * back to the cache in the background.
+ */
+static void maildir_parse_batch(struct Mailbox *m, struct HeaderCache *hc,
+                                struct Maildir **batch, size_t num)
+{
+  struct HCacheItem items[MAILDIR_BATCH_SIZE];
+  char keys[MAILDIR_BATCH_SIZE][MH_KEY_LEN];
+  struct Maildir *misses[MAILDIR_BATCH_SIZE];
+  time_t mtimes[MAILDIR_BATCH_SIZE] = { 0 };
+  size_t num_misses = 0;
+  char fn[PATH_MAX];
+
+  if (num == 0)
+    return;
+
+  for (size_t i = 0; i < num; i++)
+    items[i].key = maildir_hcache_key(m, batch[i]->email, keys[i],
+                                      sizeof(keys[i]), &items[i].keylen);
+
+  mutt_hcache_fetch_many(hc, items, num, 0);
+
+  if (C_MaildirHeaderCacheVerify)
+    maildir_scan_mtimes(m, batch, num, mtimes, maildir_threads());
+
+  for (size_t i = 0; i < num; i++)
+  {
+    struct Maildir *p = batch[i];
+    struct HCacheEntry *hce = &items[i].entry;
+
+    snprintf(fn, sizeof(fn), "%s/%s", mailbox_path(m), p->email->cold->path);
+
+    if (hce->email && (mtimes[i] >= 0) && (mtimes[i] <= hce->uidvalidity))
+    {
+      hce->email->cold->edata = maildir_edata_new();
+      hce->email->cold->edata_free = maildir_edata_free;
+      hce->email->old = p->email->old;
+      hce->email->cold->path = mutt_str_dup(p->email->cold->path);
+      email_free(&p->email);
+      p->email = hce->email;
+      if (m->type == MUTT_MAILDIR)
+        maildir_parse_flags(p->email, fn);
+      continue;
+    }
+
+    /* The cached copy is stale */
+    email_free(&hce->email);
+    misses[num_misses++] = p;
+  }
+
+  maildir_parse_entries(m, misses, num_misses);
+
+  for (size_t i = 0; i < num_misses; i++)
+  {
+    struct Maildir *p = misses[i];
+    if (!p->email || !p->header_parsed)
+      continue;
+
+    char buf[MH_KEY_LEN];
+    size_t keylen = 0;
+    const char *key = maildir_hcache_key(m, p->email, buf, sizeof(buf), &keylen);
+    mutt_hcache_store_async(hc, key, keylen, p->email, 0);
+  }
+}
+#endif
+
 /**
  * maildir_delayed_parsing - This function does the second parsing pass
  * @param[in]  m  Mailbox
@@ -710,12 +925,13 @@ static struct Maildir *skip_duplicates(struct Maildir *p, struct Maildir **last)
 void maildir_delayed_parsing(struct Mailbox *m, struct Maildir **md, struct Progress *progress)
 {
   struct Maildir *p = NULL, *last = NULL;
-  char fn[PATH_MAX];
   int count;
   bool sort = false;
 
+  struct Maildir *batch[MAILDIR_BATCH_SIZE];
+  size_t num = 0;
 #ifdef USE_HCACHE
-  struct HeaderCache *hc = mutt_hcache_open(C_HeaderCache, mailbox_path(m), NULL);
+  struct HeaderCache *hc = mutt_hcache_open(C_HeaderCache, mailbox_path(m), NULL, NULL);
 #endif
 
   for (p = *md, count = 0; p; p = p->next, count++)
@@ -739,93 +955,52 @@ void maildir_delayed_parsing(struct Mailbox *m, struct Maildir **md, struct Prog
         *md = p;
       sort = true;
       p = skip_duplicates(p, &last);
-      snprintf(fn, sizeof(fn), "%s/%s", mailbox_path(m), p->email->path);
-    }
-
-    snprintf(fn, sizeof(fn), "%s/%s", mailbox_path(m), p->email->path);
-
-#ifdef USE_HCACHE
-    struct stat lastchanged = { 0 };
-    int rc = 0;
-    if (C_MaildirHeaderCacheVerify)
-    {
-      rc = stat(fn, &lastchanged);
     }
 
-    const char *key = NULL;
-    size_t keylen = 0;
-    if (m->type == MUTT_MH)
-    {
-      key = p->email->path;
-      keylen = strlen(key);
-    }
-    else
+    batch[num++] = p;
+    if (num == MAILDIR_BATCH_SIZE)
     {
-      key = p->email->path + 3;
-      keylen = maildir_hcache_keylen(key);
-    }
-    struct HCacheEntry hce = mutt_hcache_fetch(hc, key, keylen, 0);
-
-    if (hce.email && (rc == 0) && (lastchanged.st_mtime <= hce.uidvalidity))
-    {
-      hce.email->edata = maildir_edata_new();
-      hce.email->edata_free = maildir_edata_free;
-      hce.email->old = p->email->old;
-      hce.email->path = mutt_str_dup(p->email->path);
-      email_free(&p->email);
-      p->email = hce.email;
-      if (m->type == MUTT_MAILDIR)
-        maildir_parse_flags(p->email, fn);
-    }
-    else
-#endif
-    {
-      if (maildir_parse_message(m->type, fn, p->email->old, p->email))
-      {
-        p->header_parsed = true;
 #ifdef USE_HCACHE
-        if (m->type == MUTT_MH)
-        {
-          key = p->email->path;
-          keylen = strlen(key);
-        }
-        else
-        {
-          key = p->email->path + 3;
-          keylen = maildir_hcache_keylen(key);
-        }
-        mutt_hcache_store(hc, key, keylen, p->email, 0);
+      maildir_parse_batch(m, hc, batch, num);
+#else
+      maildir_parse_entries(m, batch, num);
 #endif
-      }
-      else
-        email_free(&p->email);
+      num = 0;
     }
     last = p;
   }
 #ifdef USE_HCACHE
+  maildir_parse_batch(m, hc, batch, num);
   mutt_hcache_close(hc);
+#else
+  maildir_parse_entries(m, batch, num);
 #endif
 
   mh_sort_natural(m, md);
 }
 
 /**
- * mh_read_dir - Read a MH/maildir style mailbox
- * @param m      Mailbox
- * @param subdir NULL for MH mailboxes,
- *               otherwise the subdir of the maildir mailbox to read from
+ * mh_read_dirs - Read the directories of a MH/maildir style mailbox
+ * @param m       Mailbox
+ * @param subdirs Subdirectories of the maildir mailbox to read from,
+ *                or a single NULL for MH mailboxes
+ * @param num     Number of subdirectories
  * @retval  0 Success
  * @retval -1 Failure
+ *
+ * The directories are read together, see maildir_scan_dirs(), then the
+ * messages of each directory are added to the Mailbox in turn.
  */
-int mh_read_dir(struct Mailbox *m, const char *subdir)
+int mh_read_dirs(struct Mailbox *m, const char *const *subdirs, size_t num)
 {
-  if (!m)
+  if (!m || !subdirs || (num == 0))
     return -1;
 
   struct Maildir *md = NULL;
   struct MhSequences mhs = { 0 };
   struct Maildir **last = NULL;
   struct Progress progress;
+  int rc = 0;
 
   if (m->verbose)
   {
@@ -842,34 +1017,70 @@ int mh_read_dir(struct Mailbox *m, const char *subdir)
     m->mdata_free = maildir_mdata_free;
   }
 
+#ifdef USE_HCACHE
+  /* A full scan gives the garbage collector a new set of live keys */
+  maildir_gc_stop(mdata);
+  mdata->hcache_gc_done = false;
+#endif
+
   maildir_update_mtime(m);
 
-  md = NULL;
-  last = &md;
-  int count = 0;
-  if (maildir_parse_dir(m, &last, subdir, &count, &progress) < 0)
-    return -1;
+  struct MaildirScan *scans = mutt_mem_calloc(num, sizeof(struct MaildirScan));
+  for (size_t i = 0; i < num; i++)
+    scans[i].subdir = subdirs[i];
 
-  if (m->verbose)
-  {
-    char msg[PATH_MAX];
-    snprintf(msg, sizeof(msg), _("Reading %s..."), mailbox_path(m));
-    mutt_progress_init(&progress, msg, MUTT_PROGRESS_READ, count);
-  }
-  maildir_delayed_parsing(m, &md, &progress);
+  maildir_scan_dirs(m, scans, num, maildir_threads());
 
-  if (m->type == MUTT_MH)
+  for (size_t i = 0; i < num; i++)
   {
-    if (mh_read_sequences(&mhs, mailbox_path(m)) < 0)
+    if (scans[i].error != 0)
+    {
+      rc = -1;
+      break;
+    }
+
+    md = NULL;
+    last = &md;
+    int count = 0;
+    maildir_parse_scan(m, &last, &scans[i], &count, &progress);
+    maildir_scan_free(&scans[i]);
+    if (SigInt == 1)
     {
+      SigInt = 0;
       maildir_free(&md);
-      return -1;
+      rc = -1;
+      break;
+    }
+
+    if (m->verbose)
+    {
+      char msg[PATH_MAX];
+      snprintf(msg, sizeof(msg), _("Reading %s..."), mailbox_path(m));
+      mutt_progress_init(&progress, msg, MUTT_PROGRESS_READ, count);
     }
-    mh_update_maildir(md, &mhs);
-    mhs_sequences_free(&mhs);
+    maildir_delayed_parsing(m, &md, &progress);
+
+    if (m->type == MUTT_MH)
+    {
+      if (mh_read_sequences(&mhs, mailbox_path(m)) < 0)
+      {
+        maildir_free(&md);
+        rc = -1;
+        break;
+      }
+      mh_update_maildir(md, &mhs);
+      mhs_sequences_free(&mhs);
+    }
+
+    maildir_move_to_mailbox(m, &md);
   }
 
-  maildir_move_to_mailbox(m, &md);
+  for (size_t i = 0; i < num; i++)
+    maildir_scan_free(&scans[i]);
+  FREE(&scans);
+
+  if (rc < 0)
+    return rc;
 
   if (!mdata->mh_umask)
     mdata->mh_umask = mh_umask(m);
@@ -877,6 +1088,140 @@ int mh_read_dir(struct Mailbox *m, const char *subdir)
   return 0;
 }
 
+/**
+ * mh_read_dir - Read a MH/maildir style mailbox
+ * @param m      Mailbox
+ * @param subdir NULL for MH mailboxes,
+ *               otherwise the subdir of the maildir mailbox to read from
+ * @retval  0 Success
+ * @retval -1 Failure
+ */
+int mh_read_dir(struct Mailbox *m, const char *subdir)
+{
+  return mh_read_dirs(m, &subdir, 1);
+}
+
+#ifdef USE_HCACHE
+/**
+ * maildir_gc_filter - Recognise the header cache keys of a Maildir folder - Implements ::hcache_gc_filter_t
+ *
+ * Maildir keys look like "/1234.host", without the flags.  The keys of
+ * subfolders, e.g. "/.sub/1234.host", contain another '/'.
+ */
+static bool maildir_gc_filter(const char *key, size_t keylen)
+{
+  return (keylen > 1) && (key[0] == '/') && !memchr(key + 1, '/', keylen - 1);
+}
+
+/**
+ * mh_gc_filter - Recognise the header cache keys of an MH folder - Implements ::hcache_gc_filter_t
+ *
+ * MH keys look like "/123", optionally followed by a compression suffix,
+ * e.g. "/123-zstd".
+ */
+static bool mh_gc_filter(const char *key, size_t keylen)
+{
+  if ((keylen < 2) || (key[0] != '/'))
+    return false;
+
+  size_t i = 1;
+  while ((i < keylen) && isdigit((unsigned char) key[i]))
+    i++;
+
+  if (i == 1)
+    return false;
+  if (i == keylen)
+    return true;
+  if ((key[i] != '-') || (++i == keylen))
+    return false;
+
+  for (; i < keylen; i++)
+    if (!isalnum((unsigned char) key[i]))
+      return false;
+
+  return true;
+}
+#endif
+
+/**
+ * maildir_mbox_gc - Remove stale records from the header cache - Implements MxOps::mbox_gc()
+ *
+ * The live keys are taken from the Mailbox, after mh_read_dir() has scanned
+ * the whole folder.  Each call looks at, or deletes, at most
+ * #MAILDIR_GC_BATCH records, unless @a compact is set, when the job is
+ * finished and the database is also compacted.
+ *
+ * The header cache is kept open until the job is done.
+ */
+int maildir_mbox_gc(struct Mailbox *m, bool compact)
+{
+#ifdef USE_HCACHE
+  struct MaildirMboxData *mdata = maildir_mdata_get(m);
+  if (!mdata || !C_HeaderCache)
+    return -1;
+
+  if (mdata->hcache_gc_done && !compact)
+    return 0;
+
+  if (!mdata->hcache)
+    mdata->hcache = mutt_hcache_open(C_HeaderCache, mailbox_path(m), NULL, NULL);
+  struct HeaderCache *hc = mdata->hcache;
+  if (!hc)
+    return -1;
+
+  if (!mdata->hcache_gc)
+  {
+    mdata->hcache_gc = mutt_hcache_gc_new((m->type == MUTT_MH) ? mh_gc_filter : maildir_gc_filter);
+    for (int i = 0; i < m->msg_count; i++)
+    {
+      struct Email *e = m->emails[i];
+      if (!e || !e->cold->path)
+        continue;
+
+      char buf[MH_KEY_LEN];
+      size_t keylen = 0;
+      const char *key = maildir_hcache_key(m, e, buf, sizeof(buf), &keylen);
+      mutt_hcache_gc_live(mdata->hcache_gc, key, keylen);
+    }
+  }
+
+  bool done;
+  do
+  {
+    done = mutt_hcache_gc_step(hc, mdata->hcache_gc, MAILDIR_GC_BATCH);
+  } while (!done && compact);
+
+  if (done)
+  {
+    size_t removed = mutt_hcache_gc_removed(mdata->hcache_gc);
+    mutt_hcache_gc_free(&mdata->hcache_gc);
+    mdata->hcache_gc_done = true;
+
+    if (compact)
+    {
+      long reclaimed = mutt_hcache_compact(hc);
+      if (reclaimed < 0)
+      {
+        /* L10N: %zu is the number of stale records deleted from the header cache */
+        mutt_message(_("Removed %zu stale records, the header cache can't be compacted"), removed);
+      }
+      else
+      {
+        /* L10N: %zu is the number of stale records deleted from the header cache,
+           %ld is the number of bytes freed */
+        mutt_message(_("Removed %zu stale records, reclaimed %ld bytes"), removed, reclaimed);
+      }
+    }
+
+    maildir_gc_stop(mdata);
+  }
+
+  return done ? 0 : 1;
+#else
+  return -1;
+#endif
+}
+
 /**
  * mh_commit_msg - Commit a message to an MH folder
  * @param m   Mailbox
@@ -941,7 +1286,7 @@ int mh_commit_msg(struct Mailbox *m, struct Message *msg, struct Email *e, bool
     if (mutt_file_safe_rename(msg->path, path) == 0)
     {
       if (e)
-        mutt_str_replace(&e->path, tmp);
+        mutt_str_replace(&e->cold->path, tmp);
       mutt_str_replace(&msg->committed_path, path);
       FREE(&msg->path);
       break;
@@ -1045,10 +1390,10 @@ int md_commit_message(struct Mailbox *m, struct Message *msg, struct Email *e)
 
 #ifdef USE_NOTMUCH
       if (m->type == MUTT_NOTMUCH)
-        nm_update_filename(m, e->path, mutt_b2s(full), e);
+        nm_update_filename(m, e->cold->path, mutt_b2s(full), e);
 #endif
       if (e)
-        mutt_str_replace(&e->path, mutt_b2s(path));
+        mutt_str_replace(&e->cold->path, mutt_b2s(path));
       mutt_str_replace(&msg->committed_path, mutt_b2s(full));
       FREE(&msg->path);
 
@@ -1102,8 +1447,8 @@ int mh_rewrite_message(struct Mailbox *m, int msgno)
   {
     char oldpath[PATH_MAX];
     char partpath[PATH_MAX];
-    snprintf(oldpath, sizeof(oldpath), "%s/%s", mailbox_path(m), e->path);
-    mutt_str_copy(partpath, e->path, sizeof(partpath));
+    snprintf(oldpath, sizeof(oldpath), "%s/%s", mailbox_path(m), e->cold->path);
+    mutt_str_copy(partpath, e->cold->path, sizeof(partpath));
 
     if (m->type == MUTT_MAILDIR)
       rc = md_commit_message(m, dest, e);
@@ -1134,10 +1479,10 @@ int mh_rewrite_message(struct Mailbox *m, int msgno)
     if ((m->type == MUTT_MH) && (rc == 0))
     {
       char newpath[PATH_MAX];
-      snprintf(newpath, sizeof(newpath), "%s/%s", mailbox_path(m), e->path);
+      snprintf(newpath, sizeof(newpath), "%s/%s", mailbox_path(m), e->cold->path);
       rc = mutt_file_safe_rename(newpath, oldpath);
       if (rc == 0)
-        mutt_str_replace(&e->path, partpath);
+        mutt_str_replace(&e->cold->path, partpath);
     }
   }
   else
@@ -1321,8 +1666,8 @@ struct Email *maildir_parse_stream(enum MailboxType type, FILE *fp,
   if (!e)
   {
     e = email_new();
-    e->edata = maildir_edata_new();
-    e->edata_free = maildir_edata_free;
+    e->cold->edata = maildir_edata_new();
+    e->cold->edata_free = maildir_edata_free;
   }
   e->env = mutt_rfc822_read_header(fp, e, false, false);
 
@@ -1391,24 +1736,15 @@ int mh_sync_mailbox_message(struct Mailbox *m, int msgno, struct HeaderCache *hc
   if (e->deleted && ((m->type != MUTT_MAILDIR) || !C_MaildirTrash))
   {
     char path[PATH_MAX];
-    snprintf(path, sizeof(path), "%s/%s", mailbox_path(m), e->path);
+    snprintf(path, sizeof(path), "%s/%s", mailbox_path(m), e->cold->path);
     if ((m->type == MUTT_MAILDIR) || (C_MhPurge && (m->type == MUTT_MH)))
     {
 #ifdef USE_HCACHE
       if (hc)
       {
-        const char *key = NULL;
-        size_t keylen;
-        if (m->type == MUTT_MH)
-        {
-          key = e->path;
-          keylen = strlen(key);
-        }
-        else
-        {
-          key = e->path + 3;
-          keylen = maildir_hcache_keylen(key);
-        }
+        char buf[MH_KEY_LEN];
+        size_t keylen = 0;
+        const char *key = maildir_hcache_key(m, e, buf, sizeof(buf), &keylen);
         mutt_hcache_delete_record(hc, key, keylen);
       }
 #endif
@@ -1417,10 +1753,10 @@ int mh_sync_mailbox_message(struct Mailbox *m, int msgno, struct HeaderCache *hc
     else if (m->type == MUTT_MH)
     {
       /* MH just moves files out of the way when you delete them */
-      if (*e->path != ',')
+      if (*e->cold->path != ',')
       {
         char tmp[PATH_MAX];
-        snprintf(tmp, sizeof(tmp), "%s/,%s", mailbox_path(m), e->path);
+        snprintf(tmp, sizeof(tmp), "%s/,%s", mailbox_path(m), e->cold->path);
         unlink(tmp);
         rename(path, tmp);
       }
@@ -1445,18 +1781,9 @@ int mh_sync_mailbox_message(struct Mailbox *m, int msgno, struct HeaderCache *hc
 #ifdef USE_HCACHE
   if (hc && e->changed)
   {
-    const char *key = NULL;
-    size_t keylen;
-    if (m->type == MUTT_MH)
-    {
-      key = e->path;
-      keylen = strlen(key);
-    }
-    else
-    {
-      key = e->path + 3;
-      keylen = maildir_hcache_keylen(key);
-    }
+    char buf[MH_KEY_LEN];
+    size_t keylen = 0;
+    const char *key = maildir_hcache_key(m, e, buf, sizeof(buf), &keylen);
     mutt_hcache_store(hc, key, keylen, e, 0);
   }
 #endif
@@ -1578,11 +1905,11 @@ int maildir_mh_open_message(struct Mailbox *m, struct Message *msg, int msgno, b
 
   char path[PATH_MAX];
 
-  snprintf(path, sizeof(path), "%s/%s", mailbox_path(m), e->path);
+  snprintf(path, sizeof(path), "%s/%s", mailbox_path(m), e->cold->path);
 
   msg->fp = fopen(path, "r");
   if (!msg->fp && (errno == ENOENT) && is_maildir)
-    msg->fp = maildir_open_find_message(mailbox_path(m), e->path, NULL);
+    msg->fp = maildir_open_find_message(mailbox_path(m), e->cold->path, NULL);
 
   if (!msg->fp)
   {
@@ -1761,7 +2088,7 @@ int mh_mbox_sync(struct Mailbox *m)
 
 #ifdef USE_HCACHE
   if ((m->type == MUTT_MAILDIR) || (m->type == MUTT_MH))
-    hc = mutt_hcache_open(C_HeaderCache, mailbox_path(m), NULL);
+    hc = mutt_hcache_open(C_HeaderCache, mailbox_path(m), NULL, NULL);
 #endif
 
   if (m->verbose)
@@ -1823,6 +2150,11 @@ err:
  */
 int mh_mbox_close(struct Mailbox *m)
 {
+#ifdef USE_HCACHE
+  struct MaildirMboxData *mdata = maildir_mdata_get(m);
+  if (mdata)
+    maildir_gc_stop(mdata);
+#endif
   return 0;
 }
 
@@ -1843,8 +2175,11 @@ int mh_msg_save_hcache(struct Mailbox *m, struct Email *e)
 {
   int rc = 0;
 #ifdef USE_HCACHE
-  struct HeaderCache *hc = mutt_hcache_open(C_HeaderCache, mailbox_path(m), NULL);
-  rc = mutt_hcache_store(hc, e->path, strlen(e->path), e, 0);
+  struct HeaderCache *hc = mutt_hcache_open(C_HeaderCache, mailbox_path(m), NULL, NULL);
+  char buf[MH_KEY_LEN];
+  size_t keylen = 0;
+  const char *key = maildir_hcache_key(m, e, buf, sizeof(buf), &keylen);
+  rc = mutt_hcache_store(hc, key, keylen, e, 0);
   mutt_hcache_close(hc);
 #endif
   return rc;
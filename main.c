@@ -90,6 +90,9 @@
 #ifdef USE_AUTOCRYPT
 #include "autocrypt/lib.h"
 #endif
+#ifdef USE_HCACHE
+#include "hcache/lib.h"
+#endif
 
 /* These Config Variables are only used in main.c */
 bool C_ResumeEditedDraftFiles; ///< Config: Resume editing previously saved draft files
@@ -961,7 +964,7 @@ int main(int argc, char *argv[], char *envp[])
         /* Set up a tmp Email with just enough information so that
          * mutt_prepare_template() can parse the message in fp_in.  */
         struct Email *e_tmp = email_new();
-        e_tmp->offset = 0;
+        e_tmp->cold->offset = 0;
         e_tmp->content = mutt_body_new();
         if (fstat(fileno(fp_in), &st) != 0)
         {
@@ -1268,6 +1271,9 @@ main_exit:
   mutt_browser_cleanup();
   mutt_commands_cleanup();
   crypt_cleanup();
+#ifdef USE_HCACHE
+  mutt_hcache_cleanup();
+#endif
   mutt_opts_free();
   mutt_keys_free();
   myvarlist_free(&MyVars);
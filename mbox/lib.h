@@ -30,6 +30,7 @@
  * | :------------ | :------------------- |
  * | mbox/config.c | @subpage mbox_config |
  * | mbox/mbox.c   | @subpage mbox_mbox   |
+ * | mbox/sync.c   | @subpage mbox_sync   |
  */
 
 #ifndef MUTT_MBOX_LIB_H
@@ -49,11 +50,14 @@ struct stat;
  */
 struct MboxAccountData
 {
-  FILE *fp;              ///< Mailbox file
-  struct timespec atime; ///< File's last-access time
+  FILE *fp;                     ///< Mailbox file
+  struct timespec atime;        ///< File's last-access time
+  LOFF_T eof_boundary;          ///< Offset of the last message
+  unsigned char eof_digest[16]; ///< MD5 of the last message
 
-  bool locked : 1; ///< is the mailbox locked?
-  bool append : 1; ///< mailbox is opened in append mode
+  bool locked : 1;    ///< is the mailbox locked?
+  bool append : 1;    ///< mailbox is opened in append mode
+  bool eof_valid : 1; ///< eof_digest is set
 };
 
 extern bool C_CheckMboxSize;
@@ -31,12 +31,15 @@
  */
 
 #include "config.h"
+#include <errno.h>
 #include <fcntl.h>
 #include <inttypes.h> // IWYU pragma: keep
 #include <limits.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <time.h>
 #include <unistd.h>
@@ -48,6 +51,7 @@
 #include "core/lib.h"
 #include "mutt.h"
 #include "lib.h"
+#include "sync.h"
 #include "copy.h"
 #include "mutt_globals.h"
 #include "mutt_header.h"
@@ -56,6 +60,9 @@
 #include "progress.h"
 #include "protos.h"
 #include "sort.h"
+#ifdef USE_HCACHE
+#include "hcache/lib.h"
+#endif
 
 /**
  * struct MUpdate - Store of new offsets, used by mutt_sync_mailbox()
@@ -69,6 +76,16 @@ struct MUpdate
   LOFF_T length;
 };
 
+/**
+ * struct MboxMap - A mailbox file mapped into memory
+ */
+struct MboxMap
+{
+  const char *data; ///< Contents of the file
+  size_t len;       ///< Length of the mapping
+  FILE *fp;         ///< Stream used to read the headers
+};
+
 /**
  * mbox_adata_free - Free the private Account data - Implements Account::adata_free()
  */
@@ -174,6 +191,413 @@ static void mbox_unlock_mailbox(struct Mailbox *m)
   }
 }
 
+/**
+ * mbox_map_open - Map a mailbox file into memory
+ * @param[in]  m   Mailbox
+ * @param[out] map Mapped file
+ * @retval true  Success
+ * @retval false The file can't be mapped, e.g. it's empty
+ *
+ * The headers are read from an in-memory stream if fmemopen() is available,
+ * otherwise from the Mailbox's own stream.
+ */
+static bool mbox_map_open(struct Mailbox *m, struct MboxMap *map)
+{
+  struct MboxAccountData *adata = mbox_adata_get(m);
+  if (!adata || !adata->fp || (m->size <= 0) || ((uintmax_t) m->size > SIZE_MAX))
+    return false;
+
+  void *data = mmap(NULL, m->size, PROT_READ, MAP_PRIVATE, fileno(adata->fp), 0);
+  if (data == MAP_FAILED)
+  {
+    mutt_debug(LL_DEBUG1, "mmap() failed: %s (errno %d)\n", strerror(errno), errno);
+    return false;
+  }
+#ifdef MADV_SEQUENTIAL
+  madvise(data, m->size, MADV_SEQUENTIAL);
+#endif
+
+  map->data = data;
+  map->len = m->size;
+  map->fp = adata->fp;
+#ifdef USE_FMEMOPEN
+  FILE *fp = fmemopen(data, map->len, "r");
+  if (fp)
+    map->fp = fp;
+#endif
+  return true;
+}
+
+/**
+ * mbox_map_close - Unmap a mailbox file
+ * @param m   Mailbox
+ * @param map Mapped file
+ *
+ * The Mailbox's stream is left at the end of the mapped data, where the
+ * stdio parsers would have left it.
+ */
+static void mbox_map_close(struct Mailbox *m, struct MboxMap *map)
+{
+  struct MboxAccountData *adata = mbox_adata_get(m);
+  if (map->fp != adata->fp)
+    mutt_file_fclose(&map->fp);
+  if (fseeko(adata->fp, map->len, SEEK_SET) != 0)
+    mutt_debug(LL_DEBUG1, "fseek() failed\n");
+  munmap((void *) map->data, map->len);
+  memset(map, 0, sizeof(*map));
+}
+
+/**
+ * mbox_map_count_lines - Count the lines in a block of memory
+ * @param p   Start of the block
+ * @param len Length of the block
+ * @retval num Number of newline characters
+ */
+static size_t mbox_map_count_lines(const char *p, size_t len)
+{
+  size_t lines = 0;
+  for (size_t i = 0; i < len; i++)
+    lines += (p[i] == '\n');
+  return lines;
+}
+
+/**
+ * mbox_map_eol - Find the end of a line in a mapped file
+ * @param map Mapped file
+ * @param pos Offset of the start of the line
+ * @retval num Offset of the start of the next line
+ */
+static size_t mbox_map_eol(const struct MboxMap *map, size_t pos)
+{
+  const char *nl = memchr(map->data + pos, '\n', map->len - pos);
+  return nl ? (nl - map->data + 1) : map->len;
+}
+
+/**
+ * mbox_map_line - Copy a line of a mapped file into a buffer
+ * @param map    Mapped file
+ * @param pos    Offset of the start of the line
+ * @param buf    Buffer for the line
+ * @param buflen Length of the buffer
+ *
+ * Like fgets(), the newline is kept and long lines are truncated.
+ */
+static void mbox_map_line(const struct MboxMap *map, size_t pos, char *buf, size_t buflen)
+{
+  size_t copy = MIN(mbox_map_eol(map, pos) - pos, buflen - 1);
+  memcpy(buf, map->data + pos, copy);
+  buf[copy] = '\0';
+}
+
+/**
+ * mbox_map_find_from - Find the next message separator in a mapped file
+ * @param[in]  map         Mapped file
+ * @param[in]  pos         Offset of the start of a line
+ * @param[out] return_path Buffer for the return path
+ * @param[in]  rplen       Length of the return path buffer
+ * @param[out] t           Time from the separator
+ * @retval num Offset of the separator, or the length of the file if there isn't one
+ *
+ * The line at @a pos is checked first, then memmem() jumps between the
+ * candidate "From " lines, skipping the message bodies without copying them.
+ */
+static size_t mbox_map_find_from(const struct MboxMap *map, size_t pos,
+                                 char *return_path, size_t rplen, time_t *t)
+{
+  char buf[8192];
+
+  while (pos < map->len)
+  {
+    if (((map->len - pos) > 5) && (memcmp(map->data + pos, "From ", 5) == 0))
+    {
+      mbox_map_line(map, pos, buf, sizeof(buf));
+      if (is_from(buf, return_path, rplen, t))
+        return pos;
+    }
+
+    const char *next = memmem(map->data + pos, map->len - pos, "\nFrom ", 6);
+    if (!next)
+      break;
+    pos = next - map->data + 1;
+  }
+
+  return map->len;
+}
+
+/**
+ * mbox_parse_map - Read the messages of a mapped mbox file
+ * @param m        Mailbox
+ * @param map      Mapped file
+ * @param pos      Offset of the first new message
+ * @param progress Progress bar, may be NULL
+ * @retval  0 Success
+ * @retval -2 Aborted
+ *
+ * This is the equivalent of the stdio loop in mbox_parse_mailbox(), but the
+ * message separators are found by scanning memory, rather than by reading
+ * every line of every message.
+ */
+static int mbox_parse_map(struct Mailbox *m, const struct MboxMap *map,
+                          size_t pos, struct Progress *progress)
+{
+  char return_path[256];
+  time_t t = 0;
+  int count = 0;
+  struct Email *e_prev = NULL;
+  LOFF_T body_prev = 0;
+
+  while ((SigInt != 1) &&
+         ((pos = mbox_map_find_from(map, pos, return_path, sizeof(return_path), &t)) < map->len))
+  {
+    /* Save the Content-Length of the previous message */
+    if (e_prev)
+    {
+      if (e_prev->content->length < 0)
+      {
+        e_prev->content->length = pos - e_prev->content->offset - 1;
+        if (e_prev->content->length < 0)
+          e_prev->content->length = 0;
+      }
+      if (!e_prev->lines)
+      {
+        size_t lines = mbox_map_count_lines(map->data + body_prev, pos - body_prev);
+        e_prev->lines = lines ? lines - 1 : 0;
+      }
+    }
+
+    count++;
+
+    if (progress)
+      mutt_progress_update(progress, count, (int) (pos / (map->len / 100 + 1)));
+
+    if (m->msg_count == m->email_max)
+      mx_alloc_memory(m, m->msg_count + 1);
+
+    struct Email *e = email_new();
+    m->emails[m->msg_count] = e;
+    e->received = t - mutt_date_local_tz(t);
+    e->cold->offset = pos;
+    e->index = m->msg_count;
+
+    /* Skip the separator */
+    pos = mbox_map_eol(map, pos);
+    if (fseeko(map->fp, pos, SEEK_SET) != 0)
+      mutt_debug(LL_DEBUG1, "#1 fseek() failed\n");
+    e->env = mutt_rfc822_read_header(map->fp, e, false, false);
+
+    LOFF_T body = ftello(map->fp);
+    if (body < 0)
+      body = pos;
+    pos = body;
+
+    /* if we know how long this message is, either just skip over the body,
+     * or if we don't know how many lines there are, count them now */
+    if (e->content->length > 0)
+    {
+      /* The test below avoids a potential integer overflow if the
+       * content-length is huge (thus necessarily invalid).  */
+      LOFF_T tmploc = (e->content->length < m->size) ?
+                          (body + e->content->length + 1) :
+                          -1;
+
+      if ((tmploc > 0) && (tmploc < map->len))
+      {
+        /* check to see if the content-length looks valid.  we expect to
+         * to see a valid message separator at this point in the stream */
+        if (((map->len - tmploc) < 5) || (memcmp(map->data + tmploc, "From ", 5) != 0))
+        {
+          mutt_debug(LL_DEBUG1, "bad content-length in message %d (cl=" OFF_T_FMT ")\n",
+                     e->index, e->content->length);
+          e->content->length = -1;
+        }
+      }
+      else if (tmploc != map->len)
+      {
+        /* content-length would put us past the end of the file, so it
+         * must be wrong */
+        e->content->length = -1;
+      }
+
+      if (e->content->length != -1)
+      {
+        /* good content-length.  check to see if we know how many lines
+         * are in this message.  */
+        if (e->lines == 0)
+          e->lines = mbox_map_count_lines(map->data + body, e->content->length);
+
+        /* continue at the offset of the next message separator */
+        pos = tmploc;
+      }
+    }
+
+    m->msg_count++;
+
+    if (TAILQ_EMPTY(&e->env->return_path) && return_path[0])
+      mutt_addrlist_parse(&e->env->return_path, return_path);
+
+    if (TAILQ_EMPTY(&e->env->from))
+      mutt_addrlist_copy(&e->env->from, &e->env->return_path, false);
+
+    e_prev = e;
+    body_prev = body;
+  }
+
+  /* Only set the content-length of the previous message if we have read more
+   * than one message during _this_ invocation.  */
+  if (e_prev)
+  {
+    if (e_prev->content->length < 0)
+    {
+      e_prev->content->length = map->len - e_prev->content->offset - 1;
+      if (e_prev->content->length < 0)
+        e_prev->content->length = 0;
+    }
+
+    if (!e_prev->lines)
+    {
+      size_t lines = mbox_map_count_lines(map->data + body_prev, map->len - body_prev);
+      e_prev->lines = lines ? lines - 1 : 0;
+    }
+  }
+
+  if (SigInt == 1)
+  {
+    SigInt = 0;
+    return -2; /* action aborted */
+  }
+
+  return 0;
+}
+
+/**
+ * mmdf_parse_map - Read the messages of a mapped MMDF file
+ * @param m        Mailbox
+ * @param map      Mapped file
+ * @param pos      Offset of the first new message
+ * @param progress Progress bar, may be NULL
+ * @retval  0 Success
+ * @retval -1 Failure
+ * @retval -2 Aborted
+ *
+ * This is the equivalent of the stdio loop in mmdf_parse_mailbox().
+ */
+static int mmdf_parse_map(struct Mailbox *m, const struct MboxMap *map,
+                          size_t pos, struct Progress *progress)
+{
+  const size_t seplen = sizeof(MMDF_SEP) - 1;
+  char buf[8192];
+  char return_path[1024];
+  int count = 0;
+  time_t t;
+
+  while ((pos < map->len) && (SigInt != 1))
+  {
+    if (((map->len - pos) < seplen) || (memcmp(map->data + pos, MMDF_SEP, seplen) != 0))
+    {
+      mutt_debug(LL_DEBUG1, "corrupt mailbox\n");
+      mutt_error(_("Mailbox is corrupt"));
+      return -1;
+    }
+
+    pos += seplen;
+    if (pos >= map->len)
+    {
+      mutt_debug(LL_DEBUG1, "unexpected EOF\n");
+      break;
+    }
+
+    count++;
+    if (progress)
+      mutt_progress_update(progress, count, (int) (pos / (map->len / 100 + 1)));
+
+    if (m->msg_count == m->email_max)
+      mx_alloc_memory(m, m->msg_count + 1);
+    struct Email *e = email_new();
+    m->emails[m->msg_count] = e;
+    e->cold->offset = pos;
+    e->index = m->msg_count;
+
+    return_path[0] = '\0';
+    mbox_map_line(map, pos, buf, sizeof(buf));
+    if (is_from(buf, return_path, sizeof(return_path), &t))
+    {
+      e->received = t - mutt_date_local_tz(t);
+      pos = mbox_map_eol(map, pos);
+    }
+
+    if (fseeko(map->fp, pos, SEEK_SET) != 0)
+    {
+      mutt_debug(LL_DEBUG1, "#1 fseek() failed\n");
+      mutt_error(_("Mailbox is corrupt"));
+      return -1;
+    }
+    e->env = mutt_rfc822_read_header(map->fp, e, false, false);
+
+    LOFF_T loc = ftello(map->fp);
+    if (loc < 0)
+      return -1;
+
+    pos = loc;
+    if ((e->content->length > 0) && (e->lines > 0))
+    {
+      LOFF_T tmploc = loc + e->content->length;
+      if ((tmploc > 0) && (tmploc < map->len) && ((map->len - tmploc) >= seplen) &&
+          (memcmp(map->data + tmploc, MMDF_SEP, seplen) == 0))
+      {
+        pos = tmploc + seplen;
+      }
+      else
+        e->content->length = -1;
+    }
+    else
+      e->content->length = -1;
+
+    if (e->content->length < 0)
+    {
+      /* Find the separator at the end of the message */
+      size_t end = map->len;
+      if (((map->len - loc) >= seplen) && (memcmp(map->data + loc, MMDF_SEP, seplen) == 0))
+      {
+        end = loc;
+      }
+      else
+      {
+        const char *sep = memmem(map->data + loc, map->len - loc, "\n" MMDF_SEP, seplen + 1);
+        if (sep)
+          end = sep - map->data + 1;
+      }
+
+      long lines = mbox_map_count_lines(map->data + loc, end - loc);
+      if (end == map->len)
+      {
+        lines--;
+        pos = end;
+      }
+      else
+        pos = end + seplen;
+
+      e->lines = lines;
+      e->content->length = end - e->content->offset;
+    }
+
+    if (TAILQ_EMPTY(&e->env->return_path) && return_path[0])
+      mutt_addrlist_parse(&e->env->return_path, return_path);
+
+    if (TAILQ_EMPTY(&e->env->from))
+      mutt_addrlist_copy(&e->env->from, &e->env->return_path, false);
+
+    m->msg_count++;
+  }
+
+  if (SigInt == 1)
+  {
+    SigInt = 0;
+    return -2; /* action aborted */
+  }
+
+  return 0;
+}
+
 /**
  * mmdf_parse_mailbox - Read a mailbox in MMDF format
  * @param m Mailbox
@@ -218,6 +642,15 @@ static int mmdf_parse_mailbox(struct Mailbox *m)
     mutt_progress_init(&progress, msg, MUTT_PROGRESS_READ, 0);
   }
 
+  struct MboxMap map = { 0 };
+  if (mbox_map_open(m, &map))
+  {
+    loc = ftello(adata->fp);
+    int rc = mmdf_parse_map(m, &map, MAX(loc, 0), m->verbose ? &progress : NULL);
+    mbox_map_close(m, &map);
+    return rc;
+  }
+
   while (true)
   {
     if (!fgets(buf, sizeof(buf) - 1, adata->fp))
@@ -237,10 +670,10 @@ static int mmdf_parse_mailbox(struct Mailbox *m)
         mutt_progress_update(&progress, count, (int) (loc / (m->size / 100 + 1)));
 
       if (m->msg_count == m->email_max)
-        mx_alloc_memory(m);
+        mx_alloc_memory(m, m->msg_count + 1);
       e = email_new();
       m->emails[m->msg_count] = e;
-      e->offset = loc;
+      e->cold->offset = loc;
       e->index = m->msg_count;
 
       if (!fgets(buf, sizeof(buf) - 1, adata->fp))
@@ -384,6 +817,15 @@ static int mbox_parse_mailbox(struct Mailbox *m)
   }
 
   loc = ftello(adata->fp);
+
+  struct MboxMap map = { 0 };
+  if (mbox_map_open(m, &map))
+  {
+    int rc = mbox_parse_map(m, &map, MAX(loc, 0), m->verbose ? &progress : NULL);
+    mbox_map_close(m, &map);
+    return rc;
+  }
+
   while ((fgets(buf, sizeof(buf), adata->fp)) && (SigInt != 1))
   {
     if (is_from(buf, return_path, sizeof(return_path), &t))
@@ -411,12 +853,12 @@ static int mbox_parse_mailbox(struct Mailbox *m)
       }
 
       if (m->msg_count == m->email_max)
-        mx_alloc_memory(m);
+        mx_alloc_memory(m, m->msg_count + 1);
 
       m->emails[m->msg_count] = email_new();
       e_cur = m->emails[m->msg_count];
       e_cur->received = t - mutt_date_local_tz(t);
-      e_cur->offset = loc;
+      e_cur->cold->offset = loc;
       e_cur->index = m->msg_count;
 
       e_cur->env = mutt_rfc822_read_header(adata->fp, e_cur, false, false);
@@ -530,6 +972,307 @@ static int mbox_parse_mailbox(struct Mailbox *m)
   return 0;
 }
 
+#define MBOX_DIGEST_WINDOW 4096 ///< Bytes at each end of a range covered by mbox_digest()
+
+/**
+ * mbox_digest - Checksum the start and end of a range of a mailbox file
+ * @param[in]  fp     File to read
+ * @param[in]  start  Start of the range
+ * @param[in]  end    End of the range
+ * @param[out] digest Buffer for the MD5 digest, 16 bytes
+ * @retval true Success
+ *
+ * Reading a window at each end of the range is enough to spot a file that's
+ * been rewritten, without reading the whole thing.
+ */
+static bool mbox_digest(FILE *fp, LOFF_T start, LOFF_T end, unsigned char *digest)
+{
+  char buf[MBOX_DIGEST_WINDOW];
+  struct Md5Ctx md5ctx;
+  mutt_md5_init_ctx(&md5ctx);
+
+  LOFF_T head = MIN(end - start, MBOX_DIGEST_WINDOW);
+  LOFF_T tail = MIN(end - start - head, MBOX_DIGEST_WINDOW);
+  if (head < 0)
+    return false;
+
+  if ((fseeko(fp, start, SEEK_SET) != 0) || (fread(buf, 1, head, fp) != (size_t) head))
+    return false;
+  mutt_md5_process_bytes(buf, head, &md5ctx);
+
+  if ((fseeko(fp, end - tail, SEEK_SET) != 0) || (fread(buf, 1, tail, fp) != (size_t) tail))
+    return false;
+  mutt_md5_process_bytes(buf, tail, &md5ctx);
+
+  mutt_md5_finish_ctx(&md5ctx, digest);
+  return true;
+}
+
+/**
+ * mbox_eof_update - Remember the end of a mailbox file
+ * @param m     Mailbox
+ * @param first First message that's new since the last update
+ *
+ * Checksum the data from the start of the last message to the end of the
+ * file, so that mbox_eof_check() can tell whether new mail was appended.
+ * Only the new messages are searched for the last one.
+ */
+static void mbox_eof_update(struct Mailbox *m, int first)
+{
+  struct MboxAccountData *adata = mbox_adata_get(m);
+  if (!adata || !adata->fp)
+    return;
+
+  LOFF_T boundary = (first > 0) ? adata->eof_boundary : 0;
+  for (int i = m->msg_count - 1; i >= first; i--)
+  {
+    struct Email *e = m->emails[i];
+    if (e && !e->deleted && (e->cold->offset > boundary))
+      boundary = e->cold->offset;
+  }
+
+  adata->eof_boundary = MIN(boundary, m->size);
+  adata->eof_valid = mbox_digest(adata->fp, adata->eof_boundary, m->size, adata->eof_digest);
+}
+
+/**
+ * mbox_eof_check - Is the end of the mailbox file unchanged?
+ * @param m Mailbox
+ * @retval true The data up to the old end of the file hasn't been changed
+ *
+ * This reads at most two windows of the file, whatever its size.
+ */
+static bool mbox_eof_check(struct Mailbox *m)
+{
+  struct MboxAccountData *adata = mbox_adata_get(m);
+  if (!adata->eof_valid)
+    return true;
+
+  unsigned char digest[16];
+  if (!mbox_digest(adata->fp, adata->eof_boundary, m->size, digest) ||
+      (memcmp(digest, adata->eof_digest, sizeof(digest)) != 0))
+  {
+    mutt_debug(LL_DEBUG1, "%s: the last message has changed\n", mailbox_path(m));
+    return false;
+  }
+
+  return true;
+}
+
+#ifdef USE_HCACHE
+#define MBOX_INDEX_VERSION 2    ///< Format of struct MboxIndex
+#define MBOX_INDEX_BATCH 256    ///< Number of messages to fetch from the header cache at once
+
+static const char MboxIndexKey[] = "/mbox.index";
+
+/**
+ * struct MboxIndex - Summary of an mbox file, stored in the header cache
+ *
+ * Each message is stored under its number, see mbox_index_key().
+ */
+struct MboxIndex
+{
+  uint32_t version;         ///< Format of the record, #MBOX_INDEX_VERSION
+  uint32_t type;            ///< Mailbox type, e.g. #MUTT_MBOX
+  int64_t size;             ///< Size of the indexed file
+  int64_t mtime;            ///< Modification time of the indexed file
+  int64_t mtime_nsec;       ///< Nanoseconds of the modification time
+  int32_t count;            ///< Number of indexed messages
+  unsigned char digest[16]; ///< MD5 of the start and end of the indexed file
+};
+
+/**
+ * mbox_index_key - Get the header cache key for a message
+ * @param buf    Buffer for the key
+ * @param buflen Length of the buffer
+ * @param msgno  Message number
+ * @retval num Length of the key
+ */
+static size_t mbox_index_key(char *buf, size_t buflen, int msgno)
+{
+  return snprintf(buf, buflen, "/%d", msgno);
+}
+
+/**
+ * mbox_index_valid - Does an index describe the start of a mailbox file?
+ * @param m   Mailbox
+ * @param idx Index
+ * @retval true The indexed messages are still in the file
+ *
+ * The file may have grown since it was indexed, as long as the new data
+ * starts with a message separator.  If the size is unchanged, so must be the
+ * modification time.
+ */
+static bool mbox_index_valid(struct Mailbox *m, const struct MboxIndex *idx)
+{
+  struct MboxAccountData *adata = mbox_adata_get(m);
+  struct stat sb = { 0 };
+
+  if ((idx->version != MBOX_INDEX_VERSION) || (idx->type != m->type) ||
+      (idx->count <= 0) || (fstat(fileno(adata->fp), &sb) != 0) || (idx->size > sb.st_size))
+  {
+    return false;
+  }
+
+  if (idx->size == sb.st_size)
+  {
+    struct timespec mtime = { idx->mtime, idx->mtime_nsec };
+    if (mutt_file_stat_timespec_compare(&sb, MUTT_STAT_MTIME, &mtime) != 0)
+      return false;
+  }
+  else
+  {
+    const char *sep = (m->type == MUTT_MMDF) ? MMDF_SEP : "From ";
+    char buf[8] = { 0 };
+    size_t len = strlen(sep);
+    if ((fseeko(adata->fp, idx->size, SEEK_SET) != 0) ||
+        (fread(buf, 1, len, adata->fp) != len) || (memcmp(buf, sep, len) != 0))
+    {
+      return false;
+    }
+  }
+
+  unsigned char digest[16];
+  return mbox_digest(adata->fp, 0, idx->size, digest) &&
+         (memcmp(digest, idx->digest, sizeof(digest)) == 0);
+}
+
+/**
+ * mbox_index_load - Restore the indexed messages of a mailbox
+ * @param[in]  m     Mailbox
+ * @param[out] count Number of messages in the stored index
+ * @retval ptr  Header cache to pass to mbox_index_save()
+ * @retval NULL The header cache isn't in use
+ *
+ * If the index is valid, the messages are added to the Mailbox and the file
+ * is positioned at the end of the indexed data, ready for the parser to read
+ * any new messages.
+ */
+static struct HeaderCache *mbox_index_load(struct Mailbox *m, int *count)
+{
+  *count = 0;
+  if (!C_HeaderCache)
+    return NULL;
+
+  struct HeaderCache *hc = mutt_hcache_open(C_HeaderCache, mailbox_path(m), NULL, NULL);
+  if (!hc)
+    return NULL;
+
+  struct MboxAccountData *adata = mbox_adata_get(m);
+  size_t dlen = 0;
+  struct MboxIndex *idx = mutt_hcache_fetch_raw(hc, MboxIndexKey, sizeof(MboxIndexKey) - 1, &dlen);
+  if (!idx)
+    return hc;
+
+  bool valid = (dlen == sizeof(*idx)) && mbox_index_valid(m, idx);
+  *count = (dlen == sizeof(*idx)) ? idx->count : 0;
+  LOFF_T size = idx->size;
+  mutt_hcache_free_raw(hc, (void **) &idx);
+
+  if (valid)
+  {
+    mx_alloc_memory(m, m->msg_count + *count);
+
+    struct HCacheItem items[MBOX_INDEX_BATCH];
+    char keys[MBOX_INDEX_BATCH][16];
+
+    for (int first = 0; valid && (first < *count); first += MBOX_INDEX_BATCH)
+    {
+      const int num = MIN(*count - first, MBOX_INDEX_BATCH);
+      memset(items, 0, num * sizeof(items[0]));
+      for (int i = 0; i < num; i++)
+      {
+        items[i].keylen = mbox_index_key(keys[i], sizeof(keys[i]), first + i);
+        items[i].key = keys[i];
+      }
+
+      if (mutt_hcache_fetch_many(hc, items, num, 0) != num)
+        valid = false;
+
+      for (int i = 0; i < num; i++)
+      {
+        struct Email *e = items[i].entry.email;
+        if (!e)
+          continue;
+        if (!valid)
+        {
+          email_free(&e);
+          continue;
+        }
+
+        if (m->msg_count == m->email_max)
+          mx_alloc_memory(m, m->msg_count + 1);
+        e->index = m->msg_count;
+        m->emails[m->msg_count++] = e;
+      }
+    }
+  }
+
+  if (valid)
+  {
+    mutt_debug(LL_DEBUG2, "%s: restored %d messages from the index\n",
+               mailbox_path(m), m->msg_count);
+  }
+  else
+  {
+    mutt_debug(LL_DEBUG2, "%s: the index is out of date\n", mailbox_path(m));
+    for (int i = 0; i < m->msg_count; i++)
+      email_free(&m->emails[i]);
+    m->msg_count = 0;
+    size = 0;
+  }
+
+  if (fseeko(adata->fp, size, SEEK_SET) != 0)
+    mutt_debug(LL_DEBUG1, "fseek() failed\n");
+
+  return hc;
+}
+
+/**
+ * mbox_index_save - Store the index of a mailbox
+ * @param m     Mailbox
+ * @param hc    Header cache from mbox_index_load()
+ * @param first First message that isn't in the stored index
+ * @param count Number of messages in the stored index
+ *
+ * Only the messages that were parsed are written.  Records of messages beyond
+ * the end of the Mailbox, from an older version of the file, are deleted.
+ */
+static void mbox_index_save(struct Mailbox *m, struct HeaderCache *hc, int first, int count)
+{
+  struct MboxAccountData *adata = mbox_adata_get(m);
+  struct MboxIndex idx = { 0 };
+  char key[16];
+
+  idx.version = MBOX_INDEX_VERSION;
+  idx.type = m->type;
+  idx.size = m->size;
+  idx.mtime = m->mtime.tv_sec;
+  idx.mtime_nsec = m->mtime.tv_nsec;
+  idx.count = m->msg_count;
+
+  bool ok = mbox_digest(adata->fp, 0, idx.size, idx.digest);
+  if (fseeko(adata->fp, idx.size, SEEK_SET) != 0)
+    mutt_debug(LL_DEBUG1, "fseek() failed\n");
+  if (!ok)
+    return;
+
+  for (int i = first; i < m->msg_count; i++)
+  {
+    size_t keylen = mbox_index_key(key, sizeof(key), i);
+    mutt_hcache_store_async(hc, key, keylen, m->emails[i], 0);
+  }
+
+  for (int i = m->msg_count; i < count; i++)
+  {
+    size_t keylen = mbox_index_key(key, sizeof(key), i);
+    mutt_hcache_delete_record(hc, key, keylen);
+  }
+
+  mutt_hcache_store_raw(hc, MboxIndexKey, sizeof(MboxIndexKey) - 1, &idx, sizeof(idx));
+}
+#endif
+
 /**
  * reopen_mailbox - Close and reopen a mailbox
  * @param m          Mailbox
@@ -545,7 +1288,7 @@ static int reopen_mailbox(struct Mailbox *m)
   if (!adata)
     return -1;
 
-  bool (*cmp_headers)(const struct Email *, const struct Email *) = NULL;
+  bool (*cmp_headers)(struct Email *, struct Email *) = NULL;
   struct Email **e_old = NULL;
   int old_msg_count;
   bool msg_mod = false;
@@ -611,6 +1354,8 @@ static int reopen_mailbox(struct Mailbox *m)
         rc = mbox_parse_mailbox(m);
       else
         rc = mmdf_parse_mailbox(m);
+      if (rc == 0)
+        mbox_eof_update(m, 0);
       break;
 
     default:
@@ -954,6 +1699,12 @@ static int mbox_mbox_open(struct Mailbox *m)
   }
 
   m->has_new = true;
+#ifdef USE_HCACHE
+  int count = 0;
+  struct HeaderCache *hc = mbox_index_load(m, &count);
+  const int indexed = m->msg_count;
+#endif
+
   int rc;
   if (m->type == MUTT_MBOX)
     rc = mbox_parse_mailbox(m);
@@ -962,6 +1713,18 @@ static int mbox_mbox_open(struct Mailbox *m)
   else
     rc = -1;
 
+  if (rc == 0)
+    mbox_eof_update(m, 0);
+
+#ifdef USE_HCACHE
+  if (hc)
+  {
+    if ((rc == 0) && ((m->msg_count != indexed) || (count != indexed)))
+      mbox_index_save(m, hc, indexed, count);
+    mutt_hcache_close(hc);
+  }
+#endif
+
   if (!mbox_has_new(m))
     m->has_new = false;
   clearerr(adata->fp); // Clear the EOF flag
@@ -1057,7 +1820,7 @@ static int mbox_mbox_check(struct Mailbox *m)
       return 0;
     }
 
-    if (st.st_size == m->size)
+    if ((st.st_size == m->size) && mbox_eof_check(m))
     {
       /* the file was touched, but it is still the same length, so just exit */
       mutt_file_get_stat_timespec(&m->mtime, &st, MUTT_STAT_MTIME);
@@ -1086,9 +1849,11 @@ static int mbox_mbox_check(struct Mailbox *m)
        * see the message separator at *exactly* what used to be the end of the
        * folder.  */
       char buf[1024];
-      if (fseeko(adata->fp, m->size, SEEK_SET) != 0)
+      if (!mbox_eof_check(m))
+        modified = true;
+      else if (fseeko(adata->fp, m->size, SEEK_SET) != 0)
         mutt_debug(LL_DEBUG1, "#1 fseek() failed\n");
-      if (fgets(buf, sizeof(buf), adata->fp))
+      if (!modified && fgets(buf, sizeof(buf), adata->fp))
       {
         if (((m->type == MUTT_MBOX) && mutt_str_startswith(buf, "From ")) ||
             ((m->type == MUTT_MMDF) && mutt_str_equal(buf, MMDF_SEP)))
@@ -1103,7 +1868,10 @@ static int mbox_mbox_check(struct Mailbox *m)
             mmdf_parse_mailbox(m);
 
           if (m->msg_count > old_msg_count)
+          {
+            mbox_eof_update(m, old_msg_count);
             mailbox_changed(m, NT_MAILBOX_INVALID);
+          }
 
           /* Only unlock the folder if it was locked inside of this routine.
            * It may have been locked elsewhere, like in
@@ -1119,7 +1887,7 @@ static int mbox_mbox_check(struct Mailbox *m)
         else
           modified = true;
       }
-      else
+      else if (!modified)
       {
         mutt_debug(LL_DEBUG1, "fgets returned NULL\n");
         modified = true;
@@ -1178,6 +1946,14 @@ static int mbox_mbox_sync(struct Mailbox *m)
   struct MUpdate *old_offset = NULL;
   FILE *fp = NULL;
   struct Progress progress;
+  struct MboxSyncPlan plan;
+  struct Buffer *bakfile = NULL; /* backup of the data the rewrite overwrites */
+  int fd_bak = -1;
+  LOFF_T saved = 0;
+  /* the offset stored in the header does not include the MMDF_SEP */
+  const LOFF_T seplen = (m->type == MUTT_MMDF) ? (sizeof(MMDF_SEP) - 1) : 0;
+
+  mbox_sync_plan_init(&plan, 0);
 
   /* sort message by their position in the mailbox on disk */
   if (C_Sort != SORT_ORDER)
@@ -1237,6 +2013,15 @@ static int mbox_mbox_sync(struct Mailbox *m)
   }
   unlink_tempfile = true;
 
+  bakfile = mutt_buffer_pool_get();
+  mutt_buffer_mktemp(bakfile);
+  fd_bak = open(mutt_b2s(bakfile), O_RDWR | O_EXCL | O_CREAT, 0600);
+  if (fd_bak == -1)
+  {
+    mutt_error(_("Could not create temporary file"));
+    goto bail;
+  }
+
   /* find the first deleted/changed message.  we save a lot of time by only
    * rewriting the mailbox from the point where it has actually changed.  */
   for (i = 0; (i < m->msg_count) && !m->emails[i]->deleted &&
@@ -1258,12 +2043,12 @@ static int mbox_mbox_sync(struct Mailbox *m)
   /* save the index of the first changed/deleted message */
   first = i;
   /* where to start overwriting */
-  offset = m->emails[i]->offset;
+  offset = m->emails[i]->cold->offset;
 
   /* the offset stored in the header does not include the MMDF_SEP, so make
    * sure we seek to the correct location */
-  if (m->type == MUTT_MMDF)
-    offset -= (sizeof(MMDF_SEP) - 1);
+  offset -= seplen;
+  mbox_sync_plan_init(&plan, offset);
 
   /* allocate space for the new offsets */
   new_offset = mutt_mem_calloc(m->msg_count - first, sizeof(struct MUpdate));
@@ -1284,61 +2069,82 @@ static int mbox_mbox_sync(struct Mailbox *m)
      * something fails.  */
 
     old_offset[i - first].valid = true;
-    old_offset[i - first].hdr = m->emails[i]->offset;
+    old_offset[i - first].hdr = m->emails[i]->cold->offset;
     old_offset[i - first].body = m->emails[i]->content->offset;
     old_offset[i - first].lines = m->emails[i]->lines;
     old_offset[i - first].length = m->emails[i]->content->length;
 
-    if (!m->emails[i]->deleted)
-    {
-      j++;
+    if (m->emails[i]->deleted)
+      continue;
 
-      if (m->type == MUTT_MMDF)
-      {
-        if (fputs(MMDF_SEP, fp) == EOF)
-        {
-          mutt_perror(mutt_b2s(tempfile));
-          goto bail;
-        }
-      }
+    j++;
 
-      /* save the new offset for this message.  we add 'offset' because the
-       * temporary file only contains saved message which are located after
-       * 'offset' in the real mailbox */
-      new_offset[i - first].hdr = ftello(fp) + offset;
+    struct Email *e = m->emails[i];
+    if (!e->changed && !e->attach_del)
+    {
+      /* An unchanged message is moved as it is, separators and all */
+      LOFF_T start = e->cold->offset - seplen;
+      LOFF_T end = (i + 1 < m->msg_count) ? (m->emails[i + 1]->cold->offset - seplen) : m->size;
+      LOFF_T delta = mbox_sync_plan_keep(&plan, start, end - start) - start;
+
+      new_offset[i - first].hdr = e->cold->offset + delta;
+      new_offset[i - first].body = e->content->offset + delta;
+      if (delta != 0)
+        mutt_body_free(&e->content->parts);
+      continue;
+    }
 
-      if (mutt_copy_message(fp, m, m->emails[i], MUTT_CM_UPDATE,
-                            CH_FROM | CH_UPDATE | CH_UPDATE_LEN, 0) != 0)
+    /* A changed message is written to the temporary file */
+    LOFF_T tmp_start = ftello(fp);
+
+    if (m->type == MUTT_MMDF)
+    {
+      if (fputs(MMDF_SEP, fp) == EOF)
       {
         mutt_perror(mutt_b2s(tempfile));
         goto bail;
       }
+    }
 
-      /* Since messages could have been deleted, the offsets stored in memory
-       * will be wrong, so update what we can, which is the offset of this
-       * message, and the offset of the body.  If this is a multipart message,
-       * we just flush the in memory cache so that the message will be reparsed
-       * if the user accesses it later.  */
-      new_offset[i - first].body = ftello(fp) - m->emails[i]->content->length + offset;
-      mutt_body_free(&m->emails[i]->content->parts);
+    /* save the offset of this message in the temporary file.  it's adjusted
+     * below, once the plan knows where the message will go in the mailbox */
+    new_offset[i - first].hdr = ftello(fp);
 
-      switch (m->type)
-      {
-        case MUTT_MMDF:
-          if (fputs(MMDF_SEP, fp) == EOF)
-          {
-            mutt_perror(mutt_b2s(tempfile));
-            goto bail;
-          }
-          break;
-        default:
-          if (fputs("\n", fp) == EOF)
-          {
-            mutt_perror(mutt_b2s(tempfile));
-            goto bail;
-          }
-      }
+    if (mutt_copy_message(fp, m, e, MUTT_CM_UPDATE,
+                          CH_FROM | CH_UPDATE | CH_UPDATE_LEN, 0) != 0)
+    {
+      mutt_perror(mutt_b2s(tempfile));
+      goto bail;
+    }
+
+    /* Since messages could have been deleted, the offsets stored in memory
+     * will be wrong, so update what we can, which is the offset of this
+     * message, and the offset of the body.  If this is a multipart message,
+     * we just flush the in memory cache so that the message will be reparsed
+     * if the user accesses it later.  */
+    new_offset[i - first].body = ftello(fp) - e->content->length;
+    mutt_body_free(&e->content->parts);
+
+    switch (m->type)
+    {
+      case MUTT_MMDF:
+        if (fputs(MMDF_SEP, fp) == EOF)
+        {
+          mutt_perror(mutt_b2s(tempfile));
+          goto bail;
+        }
+        break;
+      default:
+        if (fputs("\n", fp) == EOF)
+        {
+          mutt_perror(mutt_b2s(tempfile));
+          goto bail;
+        }
     }
+
+    LOFF_T delta = mbox_sync_plan_write(&plan, tmp_start, ftello(fp) - tmp_start) - tmp_start;
+    new_offset[i - first].hdr += delta;
+    new_offset[i - first].body += delta;
   }
 
   if (mutt_file_fclose(&fp) != 0)
@@ -1388,44 +2194,81 @@ static int mbox_mbox_sync(struct Mailbox *m)
     }
     else
     {
-      /* copy the temp mailbox back into place starting at the first
-       * change/deleted message */
+      /* move the unchanged messages into place and copy in the changed
+       * ones, starting at the first change/deleted message */
       if (m->verbose)
         mutt_message(_("Committing changes..."));
-      i = mutt_file_copy_stream(fp, adata->fp);
-
-      if (ferror(adata->fp))
-        i = -1;
-    }
-    if (i >= 0)
-    {
-      m->size = ftello(adata->fp); /* update the mailbox->size of the mailbox */
-      if ((m->size < 0) || (ftruncate(fileno(adata->fp), m->size) != 0))
-      {
-        i = -1;
-        mutt_debug(LL_DEBUG1, "ftruncate() failed\n");
-      }
+      mutt_debug(LL_DEBUG2, "moving %lld bytes and writing %lld, instead of copying %lld twice\n",
+                 (long long) plan.moved, (long long) plan.written,
+                 (long long) (plan.dst - offset));
+      i = mbox_sync_plan_apply(&plan, fileno(adata->fp), fileno(fp), fd_bak, m->size, &saved);
+      if (i == 0)
+        m->size = plan.dst; /* update the mailbox->size of the mailbox */
+      else
+        mutt_debug(LL_DEBUG1, "rewrite failed: %s (errno %d)\n", strerror(errno), errno);
     }
   }
 
   mutt_file_fclose(&fp);
   fp = NULL;
-  mbox_unlock_mailbox(m);
+  unlink(mutt_b2s(tempfile));
 
-  if ((mutt_file_fclose(&adata->fp) != 0) || (i == -1))
+  if (i == -1)
   {
-    /* error occurred while writing the mailbox back, so keep the temp copy around */
+    /* Nothing was written, or the original data has been put back */
+    mutt_error(_("Write failed!  The mailbox is unchanged"));
+    goto bail;
+  }
 
+  if (i == -2)
+  {
+    /* The mailbox is damaged, but the backup holds the overwritten data */
     struct Buffer *savefile = mutt_buffer_pool_get();
 
     mutt_buffer_printf(savefile, "%s/neomutt.%s-%s-%u", NONULL(C_Tmpdir), NONULL(Username),
                        NONULL(ShortHostname), (unsigned int) getpid());
-    rename(mutt_b2s(tempfile), mutt_b2s(savefile));
+    int fd_save = open(mutt_b2s(savefile), O_WRONLY | O_EXCL | O_CREAT, 0600);
+    if ((fd_save != -1) && (mbox_sync_plan_save(&plan, fileno(adata->fp), fd_bak,
+                                                saved, m->size, fd_save) == 0))
+    {
+      unlink(mutt_b2s(bakfile));
+      mutt_buffer_pretty_mailbox(savefile);
+      mutt_error(_("Write failed!  Saved the original mailbox to %s"), mutt_b2s(savefile));
+    }
+    else
+    {
+      if (fd_save != -1)
+        unlink(mutt_b2s(savefile));
+      mutt_error(_("Write failed!  Saved the overwritten part of the mailbox, from byte %lld, to %s"),
+                 (long long) plan.start, mutt_b2s(bakfile));
+    }
+    if (fd_save != -1)
+      close(fd_save);
+    mutt_buffer_pool_release(&savefile);
+
+    close(fd_bak);
+    fd_bak = -1;
+    mbox_unlock_mailbox(m);
+    mutt_file_fclose(&adata->fp);
+    mutt_sig_unblock();
+    mx_fastclose_mailbox(m);
+    FREE(&new_offset);
+    FREE(&old_offset);
+    goto fatal;
+  }
+
+  mbox_sync_plan_free(&plan);
+  close(fd_bak);
+  fd_bak = -1;
+  unlink(mutt_b2s(bakfile));
+  mbox_unlock_mailbox(m);
+
+  if (mutt_file_fclose(&adata->fp) != 0)
+  {
+    /* The data has been written, but it may not have reached the disk */
+    mutt_perror(mailbox_path(m));
     mutt_sig_unblock();
     mx_fastclose_mailbox(m);
-    mutt_buffer_pretty_mailbox(savefile);
-    mutt_error(_("Write failed!  Saved partial mailbox to %s"), mutt_b2s(savefile));
-    mutt_buffer_pool_release(&savefile);
     FREE(&new_offset);
     FREE(&old_offset);
     goto fatal;
@@ -1442,7 +2285,6 @@ static int mbox_mbox_sync(struct Mailbox *m)
   }
   if (!adata->fp)
   {
-    unlink(mutt_b2s(tempfile));
     mutt_sig_unblock();
     mx_fastclose_mailbox(m);
     mutt_error(_("Fatal error!  Could not reopen mailbox!"));
@@ -1456,7 +2298,7 @@ static int mbox_mbox_sync(struct Mailbox *m)
   {
     if (!m->emails[i]->deleted)
     {
-      m->emails[i]->offset = new_offset[i - first].hdr;
+      m->emails[i]->cold->offset = new_offset[i - first].hdr;
       m->emails[i]->content->hdr_offset = new_offset[i - first].hdr;
       m->emails[i]->content->offset = new_offset[i - first].body;
       m->emails[i]->index = j++;
@@ -1464,8 +2306,9 @@ static int mbox_mbox_sync(struct Mailbox *m)
   }
   FREE(&new_offset);
   FREE(&old_offset);
-  unlink(mutt_b2s(tempfile)); /* remove partial copy of the mailbox */
+  mbox_eof_update(m, 0);
   mutt_buffer_pool_release(&tempfile);
+  mutt_buffer_pool_release(&bakfile);
   mutt_sig_unblock();
 
   if (C_CheckMboxSize)
@@ -1489,7 +2332,7 @@ bail: /* Come here in case of disaster */
   {
     for (i = first; (i < m->msg_count) && old_offset[i - first].valid; i++)
     {
-      m->emails[i]->offset = old_offset[i - first].hdr;
+      m->emails[i]->cold->offset = old_offset[i - first].hdr;
       m->emails[i]->content->hdr_offset = old_offset[i - first].hdr;
       m->emails[i]->content->offset = old_offset[i - first].body;
       m->emails[i]->lines = old_offset[i - first].lines;
@@ -1521,7 +2364,14 @@ bail: /* Come here in case of disaster */
   }
 
 fatal:
+  if (fd_bak != -1)
+  {
+    close(fd_bak);
+    unlink(mutt_b2s(bakfile));
+  }
+  mbox_sync_plan_free(&plan);
   mutt_buffer_pool_release(&tempfile);
+  mutt_buffer_pool_release(&bakfile);
   return rc;
 }
 
@@ -1862,6 +2712,7 @@ struct MxOps MxMboxOps = {
   .msg_close        = mbox_msg_close,
   .msg_padding_size = mbox_msg_padding_size,
   .msg_save_hcache  = NULL,
+  .mbox_gc          = NULL,
   .tags_edit        = NULL,
   .tags_commit      = NULL,
   .path_probe       = mbox_path_probe,
@@ -1891,6 +2742,7 @@ struct MxOps MxMmdfOps = {
   .msg_close        = mbox_msg_close,
   .msg_padding_size = mmdf_msg_padding_size,
   .msg_save_hcache  = NULL,
+  .mbox_gc          = NULL,
   .tags_edit        = NULL,
   .tags_commit      = NULL,
   .path_probe       = mbox_path_probe,
@@ -0,0 +1,524 @@
+/**
+ * @file
+ * Plan the minimal rewrite of an mbox file
+ *
+ * @authors
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * @copyright
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @page mbox_sync Plan the minimal rewrite of an mbox file
+ *
+ * When a message changes size, every message after it has to move.  Rather
+ * than writing them all to a temporary file and copying them back, the plan
+ * moves them within the mailbox file:
+ *
+ * - Changed messages are written to a temporary file first, because they're
+ *   generated from the old data.
+ * - Unchanged messages are moved by the total change in size of the messages
+ *   before them.  Once that total is zero again, e.g. a deleted message has
+ *   absorbed the growth of a changed one, nothing more is written.
+ *
+ * The steps are ordered so that no data is overwritten before it's been read:
+ * data moving towards the start of the file is moved first, in file order,
+ * then data moving towards the end, in reverse order, then the changed
+ * messages are copied in.
+ *
+ * Before anything is moved, the part of the mailbox that the steps overwrite
+ * is copied to a backup file.  If a step fails, the backup is copied back.
+ * If that fails too, or NeoMutt dies part way through, the original mailbox
+ * is the part before the plan's start, the backup, then the rest of the file,
+ * which is never touched, see mbox_sync_plan_save().
+ */
+
+#include "config.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "mutt/lib.h"
+#include "sync.h"
+
+#define MBOX_SYNC_BUFSIZE (1024 * 1024) ///< Size of the chunks to copy
+
+/**
+ * mbox_sync_plan_init - Start a new plan
+ * @param plan  Plan to initialise
+ * @param start Offset of the first message that may change
+ */
+void mbox_sync_plan_init(struct MboxSyncPlan *plan, LOFF_T start)
+{
+  if (!plan)
+    return;
+
+  memset(plan, 0, sizeof(*plan));
+  plan->start = start;
+  plan->dst = start;
+}
+
+/**
+ * mbox_sync_plan_free - Free the steps of a plan
+ * @param plan Plan to free
+ */
+void mbox_sync_plan_free(struct MboxSyncPlan *plan)
+{
+  if (!plan)
+    return;
+
+  FREE(&plan->ops);
+  plan->num = 0;
+  plan->max = 0;
+}
+
+/**
+ * plan_add - Add a step to a plan
+ * @param plan     Plan
+ * @param src      Offset of the data
+ * @param len      Length of the data
+ * @param from_tmp The data is in the temporary file
+ */
+static void plan_add(struct MboxSyncPlan *plan, LOFF_T src, LOFF_T len, bool from_tmp)
+{
+  /* Merge neighbouring moves of the same distance */
+  if (!from_tmp && (plan->num > 0))
+  {
+    struct MboxSyncOp *prev = &plan->ops[plan->num - 1];
+    if (!prev->from_tmp && ((prev->src + prev->len) == src) &&
+        ((prev->dst + prev->len) == plan->dst))
+    {
+      prev->len += len;
+      return;
+    }
+  }
+
+  if (plan->num == plan->max)
+  {
+    plan->max += 64;
+    mutt_mem_realloc(&plan->ops, plan->max * sizeof(struct MboxSyncOp));
+  }
+
+  struct MboxSyncOp *op = &plan->ops[plan->num++];
+  op->src = src;
+  op->dst = plan->dst;
+  op->len = len;
+  op->from_tmp = from_tmp;
+}
+
+/**
+ * mbox_sync_plan_keep - Add an unchanged message to a plan
+ * @param plan Plan
+ * @param src  Offset of the message in the mailbox
+ * @param len  Length of the message, including its separators
+ * @retval num New offset of the message
+ */
+LOFF_T mbox_sync_plan_keep(struct MboxSyncPlan *plan, LOFF_T src, LOFF_T len)
+{
+  LOFF_T dst = plan->dst;
+  if ((src != dst) && (len > 0))
+  {
+    plan_add(plan, src, len, false);
+    plan->moved += len;
+  }
+  plan->dst += len;
+  return dst;
+}
+
+/**
+ * mbox_sync_plan_write - Add a changed message to a plan
+ * @param plan Plan
+ * @param src  Offset of the message in the temporary file
+ * @param len  Length of the message, including its separators
+ * @retval num New offset of the message
+ */
+LOFF_T mbox_sync_plan_write(struct MboxSyncPlan *plan, LOFF_T src, LOFF_T len)
+{
+  LOFF_T dst = plan->dst;
+  if (len > 0)
+  {
+    plan_add(plan, src, len, true);
+    plan->written += len;
+  }
+  plan->dst += len;
+  return dst;
+}
+
+/**
+ * write_all - Write a whole buffer to a file
+ * @param fd  File descriptor
+ * @param buf Data to write
+ * @param len Length of the data
+ * @param off Offset in the file
+ * @retval  0 Success
+ * @retval -1 Error
+ */
+static int write_all(int fd, const char *buf, size_t len, LOFF_T off)
+{
+  while (len > 0)
+  {
+    ssize_t rc = pwrite(fd, buf, len, off);
+    if (rc < 0)
+    {
+      if (errno == EINTR)
+        continue;
+      return -1;
+    }
+    buf += rc;
+    len -= rc;
+    off += rc;
+  }
+  return 0;
+}
+
+/**
+ * copy_chunk - Copy one chunk of data between files
+ * @param fd_in  File to read
+ * @param src    Offset to read from
+ * @param fd_out File to write
+ * @param dst    Offset to write to
+ * @param len    Length of the chunk, at most #MBOX_SYNC_BUFSIZE
+ * @param buf    Buffer of #MBOX_SYNC_BUFSIZE bytes
+ * @retval  0 Success
+ * @retval -1 Error
+ *
+ * If the source and destination don't overlap, the kernel is asked to do the
+ * copy, which may avoid copying the data at all.
+ */
+static int copy_chunk(int fd_in, LOFF_T src, int fd_out, LOFF_T dst, size_t len, char *buf)
+{
+#ifdef HAVE_COPY_FILE_RANGE
+  if ((fd_in != fd_out) || ((src + (LOFF_T) len) <= dst) || ((dst + (LOFF_T) len) <= src))
+  {
+    loff_t in = src;
+    loff_t out = dst;
+    size_t left = len;
+    while (left > 0)
+    {
+      ssize_t rc = copy_file_range(fd_in, &in, fd_out, &out, left, 0);
+      if (rc <= 0)
+        break;
+      left -= rc;
+    }
+    if (left == 0)
+      return 0;
+
+    /* Not supported here, e.g. across filesystems; copy the rest by hand */
+    src = in;
+    dst = out;
+    len = left;
+  }
+#endif
+
+  while (len > 0)
+  {
+    ssize_t rc = pread(fd_in, buf, len, src);
+    if (rc < 0)
+    {
+      if (errno == EINTR)
+        continue;
+      return -1;
+    }
+    if (rc == 0)
+    {
+      errno = EIO; /* the file is shorter than expected */
+      return -1;
+    }
+    if (write_all(fd_out, buf, rc, dst) != 0)
+      return -1;
+    src += rc;
+    dst += rc;
+    len -= rc;
+  }
+
+  return 0;
+}
+
+/**
+ * copy_range - Copy some data between files, in order
+ * @param fd_in  File to read
+ * @param src    Offset to read from
+ * @param fd_out File to write
+ * @param dst    Offset to write to
+ * @param len    Length of the data
+ * @param buf    Buffer of #MBOX_SYNC_BUFSIZE bytes
+ * @retval  0 Success
+ * @retval -1 Error
+ */
+static int copy_range(int fd_in, LOFF_T src, int fd_out, LOFF_T dst, LOFF_T len, char *buf)
+{
+  for (LOFF_T done = 0; done < len;)
+  {
+    size_t chunk = MIN(len - done, MBOX_SYNC_BUFSIZE);
+    if (copy_chunk(fd_in, src + done, fd_out, dst + done, chunk, buf) != 0)
+      return -1;
+    done += chunk;
+  }
+
+  return 0;
+}
+
+/**
+ * apply_op - Perform one step of a plan
+ * @param op     Step
+ * @param fd     Mailbox file
+ * @param fd_tmp Temporary file
+ * @param buf    Buffer of #MBOX_SYNC_BUFSIZE bytes
+ * @retval  0 Success
+ * @retval -1 Error
+ *
+ * Data moving towards the end of the file is copied from the end backwards,
+ * so that an overlapping destination doesn't overwrite it before it's read.
+ */
+static int apply_op(const struct MboxSyncOp *op, int fd, int fd_tmp, char *buf)
+{
+  const int fd_in = op->from_tmp ? fd_tmp : fd;
+  const bool backwards = !op->from_tmp && (op->dst > op->src);
+
+  for (LOFF_T done = 0; done < op->len;)
+  {
+    size_t chunk = MIN(op->len - done, MBOX_SYNC_BUFSIZE);
+    LOFF_T pos = backwards ? (op->len - done - chunk) : done;
+
+    if (copy_chunk(fd_in, op->src + pos, fd, op->dst + pos, chunk, buf) != 0)
+      return -1;
+    done += chunk;
+  }
+
+  return 0;
+}
+
+/**
+ * can_collapse - Can the last step be done with FALLOC_FL_COLLAPSE_RANGE?
+ * @param plan Plan
+ * @param fd   Mailbox file
+ * @param size Size of the mailbox file
+ * @retval true The last step moves the rest of the file by whole blocks
+ *
+ * If the plan ends by moving the rest of the file towards the start by a
+ * whole number of filesystem blocks, the filesystem can drop the gap without
+ * copying any data.  The gap may hold the data of other steps, so it has to
+ * be dropped last.
+ */
+static bool can_collapse(const struct MboxSyncPlan *plan, int fd, LOFF_T size)
+{
+#if defined(HAVE_FALLOCATE) && defined(FALLOC_FL_COLLAPSE_RANGE)
+  if (plan->num == 0)
+    return false;
+
+  const struct MboxSyncOp *op = &plan->ops[plan->num - 1];
+  struct stat st = { 0 };
+  if (op->from_tmp || (op->dst >= op->src) || ((op->src + op->len) != size) ||
+      (fstat(fd, &st) != 0) || (st.st_blksize <= 0))
+  {
+    return false;
+  }
+
+  return ((op->dst % st.st_blksize) == 0) && (((op->src - op->dst) % st.st_blksize) == 0);
+#else
+  return false;
+#endif
+}
+
+/**
+ * collapse - Drop the gap before the last step with FALLOC_FL_COLLAPSE_RANGE
+ * @param op Last step of the plan
+ * @param fd Mailbox file
+ * @retval true Success
+ */
+static bool collapse(const struct MboxSyncOp *op, int fd)
+{
+#if defined(HAVE_FALLOCATE) && defined(FALLOC_FL_COLLAPSE_RANGE)
+  if (fallocate(fd, FALLOC_FL_COLLAPSE_RANGE, op->dst, op->src - op->dst) == 0)
+    return true;
+
+  mutt_debug(LL_DEBUG2, "fallocate() failed: %s (errno %d)\n", strerror(errno), errno);
+#endif
+  return false;
+}
+
+/**
+ * backup - Copy part of the mailbox to the backup file
+ * @param plan   Plan
+ * @param fd     Mailbox file
+ * @param fd_bak Backup file
+ * @param from   Length of the backup so far
+ * @param to     Length of the backup needed
+ * @param buf    Buffer of #MBOX_SYNC_BUFSIZE bytes
+ * @retval  0 Success, the backup is on disk
+ * @retval -1 Error
+ */
+static int backup(const struct MboxSyncPlan *plan, int fd, int fd_bak,
+                  LOFF_T from, LOFF_T to, char *buf)
+{
+  if (copy_range(fd, plan->start + from, fd_bak, from, to - from, buf) != 0)
+    return -1;
+  return fsync(fd_bak);
+}
+
+/**
+ * mbox_sync_plan_apply - Rewrite a mailbox file
+ * @param[in]  plan   Plan
+ * @param[in]  fd     Mailbox file, open for reading and writing
+ * @param[in]  fd_tmp Temporary file holding the changed messages
+ * @param[in]  fd_bak Empty file for a backup of the overwritten data
+ * @param[in]  size   Current size of the mailbox file
+ * @param[out] saved  Length of the backup
+ * @retval  0 Success
+ * @retval -1 Error, see errno, the mailbox is unchanged
+ * @retval -2 Error, see errno, the mailbox is damaged, see mbox_sync_plan_save()
+ *
+ * The data the steps will overwrite, from the plan's start, is saved in the
+ * backup file first.  If the file will grow, the space is reserved before
+ * anything is changed.  Finally, the file is truncated to its new size.
+ */
+int mbox_sync_plan_apply(const struct MboxSyncPlan *plan, int fd, int fd_tmp,
+                         int fd_bak, LOFF_T size, LOFF_T *saved)
+{
+  if (!plan || (fd < 0) || (fd_bak < 0) || !saved)
+    return -1;
+
+  *saved = 0;
+
+#ifdef HAVE_POSIX_FALLOCATE
+  if (plan->dst > size)
+  {
+    int rc = posix_fallocate(fd, size, plan->dst - size);
+    if ((rc != 0) && (rc != EINVAL) && (rc != EOPNOTSUPP))
+    {
+      errno = rc;
+      return -1;
+    }
+  }
+#endif
+
+  char *buf = mutt_mem_malloc(MBOX_SYNC_BUFSIZE);
+  int rc = 0;
+  const bool collapsible = can_collapse(plan, fd, size);
+  const size_t num = collapsible ? (plan->num - 1) : plan->num;
+
+  /* Everything up to the end of the last write.  Collapsing the range before
+   * the last step only drops data that's already been moved. */
+  LOFF_T end = plan->start;
+  for (size_t i = 0; i < num; i++)
+    end = MAX(end, plan->ops[i].dst + plan->ops[i].len);
+  if (collapsible)
+    end = MAX(end, plan->ops[num].src);
+  end = MIN(end, size);
+
+  if (backup(plan, fd, fd_bak, 0, end - plan->start, buf) != 0)
+  {
+    FREE(&buf);
+    return -1;
+  }
+  *saved = end - plan->start;
+
+  /* Data moving towards the start, in file order */
+  for (size_t i = 0; (rc == 0) && (i < num); i++)
+  {
+    const struct MboxSyncOp *op = &plan->ops[i];
+    if (!op->from_tmp && (op->dst < op->src))
+      rc = apply_op(op, fd, fd_tmp, buf);
+  }
+
+  /* Data moving towards the end, in reverse order */
+  for (size_t i = num; (rc == 0) && (i > 0); i--)
+  {
+    const struct MboxSyncOp *op = &plan->ops[i - 1];
+    if (!op->from_tmp && (op->dst > op->src))
+      rc = apply_op(op, fd, fd_tmp, buf);
+  }
+
+  /* The changed messages */
+  for (size_t i = 0; (rc == 0) && (i < num); i++)
+  {
+    const struct MboxSyncOp *op = &plan->ops[i];
+    if (op->from_tmp)
+      rc = apply_op(op, fd, fd_tmp, buf);
+  }
+
+  bool collapsed = false;
+  if ((rc == 0) && collapsible)
+  {
+    collapsed = collapse(&plan->ops[num], fd);
+    if (!collapsed)
+    {
+      /* Moving the rest of the file by hand overwrites it, so save it first */
+      rc = backup(plan, fd, fd_bak, *saved, size - plan->start, buf);
+      if (rc == 0)
+      {
+        *saved = size - plan->start;
+        rc = apply_op(&plan->ops[num], fd, fd_tmp, buf);
+      }
+    }
+  }
+
+  /* Collapsing the range has already given the file its new size */
+  if ((rc == 0) && !collapsed && (ftruncate(fd, plan->dst) != 0))
+    rc = -1;
+
+  if (rc != 0)
+  {
+    /* Put the original data back */
+    const int err = errno;
+    if ((copy_range(fd_bak, 0, fd, plan->start, *saved, buf) == 0) &&
+        (ftruncate(fd, size) == 0))
+    {
+      rc = -1;
+    }
+    else
+    {
+      rc = -2;
+    }
+    errno = err;
+  }
+
+  FREE(&buf);
+  return rc;
+}
+
+/**
+ * mbox_sync_plan_save - Recreate the original mailbox after a failed rewrite
+ * @param plan   Plan
+ * @param fd     Mailbox file
+ * @param fd_bak Backup file, see mbox_sync_plan_apply()
+ * @param saved  Length of the backup
+ * @param size   Original size of the mailbox file
+ * @param fd_out Empty file for the original mailbox
+ * @retval  0 Success
+ * @retval -1 Error
+ */
+int mbox_sync_plan_save(const struct MboxSyncPlan *plan, int fd, int fd_bak,
+                        LOFF_T saved, LOFF_T size, int fd_out)
+{
+  if (!plan || (fd < 0) || (fd_bak < 0) || (fd_out < 0))
+    return -1;
+
+  char *buf = mutt_mem_malloc(MBOX_SYNC_BUFSIZE);
+  const LOFF_T end = plan->start + saved;
+
+  int rc = copy_range(fd, 0, fd_out, 0, plan->start, buf);
+  if (rc == 0)
+    rc = copy_range(fd_bak, 0, fd_out, plan->start, saved, buf);
+  if ((rc == 0) && (end < size))
+    rc = copy_range(fd, end, fd_out, end, size - end, buf);
+  if (rc == 0)
+    rc = fsync(fd_out);
+
+  FREE(&buf);
+  return rc;
+}
@@ -0,0 +1,67 @@
+/**
+ * @file
+ * Plan the minimal rewrite of an mbox file
+ *
+ * @authors
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * @copyright
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MUTT_MBOX_SYNC_H
+#define MUTT_MBOX_SYNC_H
+
+#include "config.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+/**
+ * struct MboxSyncOp - One step of an mbox sync
+ */
+struct MboxSyncOp
+{
+  LOFF_T src;    ///< Offset of the data, in the mailbox or the temporary file
+  LOFF_T dst;    ///< Offset in the mailbox to write the data
+  LOFF_T len;    ///< Length of the data
+  bool from_tmp; ///< The data is in the temporary file
+};
+
+/**
+ * struct MboxSyncPlan - How to turn the old mbox file into the new one
+ *
+ * The messages are added in file order.  Unchanged messages are moved within
+ * the mailbox, if they need to be; changed messages are copied from a
+ * temporary file; deleted messages are left out.
+ */
+struct MboxSyncPlan
+{
+  struct MboxSyncOp *ops; ///< Steps of the sync
+  size_t num;             ///< Number of steps
+  size_t max;             ///< Size of the array
+  LOFF_T start;           ///< Offset of the first message that may change
+  LOFF_T dst;             ///< Offset of the next message, i.e. the new size of the file
+  LOFF_T moved;           ///< Bytes of unchanged messages to move
+  LOFF_T written;         ///< Bytes of changed messages to write
+};
+
+void   mbox_sync_plan_init (struct MboxSyncPlan *plan, LOFF_T start);
+void   mbox_sync_plan_free (struct MboxSyncPlan *plan);
+LOFF_T mbox_sync_plan_keep (struct MboxSyncPlan *plan, LOFF_T src, LOFF_T len);
+LOFF_T mbox_sync_plan_write(struct MboxSyncPlan *plan, LOFF_T src, LOFF_T len);
+int    mbox_sync_plan_apply(const struct MboxSyncPlan *plan, int fd, int fd_tmp, int fd_bak, LOFF_T size, LOFF_T *saved);
+int    mbox_sync_plan_save (const struct MboxSyncPlan *plan, int fd, int fd_bak, LOFF_T saved, LOFF_T size, int fd_out);
+
+#endif /* MUTT_MBOX_SYNC_H */
@@ -24,6 +24,12 @@
  * @page monitor Monitor files for changes
  *
  * Monitor files for changes
+ *
+ * While a Maildir is open, the names of the files that appear in, or disappear
+ * from, its 'new' and 'cur' directories are also recorded.  The Maildir check
+ * can then look at just those files, rather than reading both directories.
+ * If any events are lost, e.g. the inotify queue overflows, the record is
+ * marked incomplete and the check falls back to a full scan.
  */
 
 #include "config.h"
@@ -60,6 +66,12 @@ static int MonitorContextDescriptor = -1;
 
 #define INOTIFY_MASK_DIR (IN_MOVED_TO | IN_ATTRIB | IN_CLOSE_WRITE | IN_ISDIR)
 #define INOTIFY_MASK_FILE IN_CLOSE_WRITE
+#define INOTIFY_MASK_DELTA_FILE (IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO)
+#define INOTIFY_MASK_DELTA_SELF (IN_DELETE_SELF | IN_MOVE_SELF | IN_UNMOUNT)
+#define INOTIFY_MASK_DELTA                                                     \
+  (INOTIFY_MASK_DELTA_FILE | INOTIFY_MASK_DELTA_SELF | IN_MASK_ADD | IN_ONLYDIR)
+
+#define MONITOR_DELTAS_MAX 10000 ///< Most changes to record before giving up
 
 #define EVENT_BUFLEN MAX(4096, sizeof(struct inotify_event) + NAME_MAX + 1)
 
@@ -88,6 +100,26 @@ struct Monitor
   int desc;
 };
 
+/**
+ * struct MonitorDeltas - Changes to the files of an open Maildir
+ */
+struct MonitorDeltas
+{
+  char *path;            ///< Path of the Maildir
+  int desc[2];           ///< Watch descriptors of 'new' and 'cur'
+  struct ListHead names; ///< Changed files, e.g. "new/1234.host"
+  size_t count;          ///< Number of names
+  bool complete;         ///< Every change since the last reset has been recorded
+};
+
+static struct MonitorDeltas Deltas = {
+  .desc = { -1, -1 },
+  .names = STAILQ_HEAD_INITIALIZER(Deltas.names),
+};
+
+/// Subdirectories of a Maildir, in the order of MonitorDeltas::desc
+static const char *const DeltaSubdirs[] = { "new", "cur" };
+
 /**
  * struct MonitorInfo - Information about a monitored file
  */
@@ -187,7 +219,7 @@ static int monitor_init(void)
  */
 static void monitor_check_free(void)
 {
-  if (!Monitor && (INotifyFd != -1))
+  if (!Monitor && (Deltas.desc[0] == -1) && (Deltas.desc[1] == -1) && (INotifyFd != -1))
   {
     mutt_poll_fd_remove(INotifyFd);
     close(INotifyFd);
@@ -314,6 +346,128 @@ static int monitor_handle_ignore(int desc)
   return new_desc;
 }
 
+/**
+ * monitor_desc_in_use - Is a watch descriptor used by a mailbox monitor?
+ * @param desc Watch descriptor
+ * @retval true The descriptor belongs to a Monitor
+ */
+static bool monitor_desc_in_use(int desc)
+{
+  for (struct Monitor *iter = Monitor; iter; iter = iter->next)
+    if (iter->desc == desc)
+      return true;
+  return false;
+}
+
+/**
+ * monitor_deltas_clear - Forget the recorded changes
+ */
+static void monitor_deltas_clear(void)
+{
+  mutt_list_free(&Deltas.names);
+  Deltas.count = 0;
+}
+
+/**
+ * monitor_deltas_event - Record a change to an open Maildir
+ * @param event inotify event
+ * @retval true The event belongs to the Maildir
+ */
+static bool monitor_deltas_event(const struct inotify_event *event)
+{
+  int i = 0;
+  for (; (i < mutt_array_size(Deltas.desc)) && (Deltas.desc[i] != event->wd); i++)
+    ; // do nothing
+
+  if ((event->wd == -1) || (i == mutt_array_size(Deltas.desc)))
+    return false;
+
+  if (event->mask & IN_IGNORED)
+  {
+    /* The watch has gone, so changes will be missed */
+    Deltas.desc[i] = -1;
+    Deltas.complete = false;
+  }
+  else if (event->mask & INOTIFY_MASK_DELTA_SELF)
+  {
+    Deltas.complete = false;
+  }
+  else if (Deltas.complete && (event->mask & INOTIFY_MASK_DELTA_FILE) && (event->len > 0))
+  {
+    if (Deltas.count == MONITOR_DELTAS_MAX)
+    {
+      mutt_debug(LL_DEBUG3, "too many changes to %s\n", Deltas.path);
+      Deltas.complete = false;
+    }
+    else
+    {
+      struct Buffer *buf = mutt_buffer_pool_get();
+      mutt_buffer_printf(buf, "%s/%s", DeltaSubdirs[i], event->name);
+      mutt_list_insert_tail(&Deltas.names, mutt_buffer_strdup(buf));
+      mutt_buffer_pool_release(&buf);
+      Deltas.count++;
+    }
+  }
+
+  if (!Deltas.complete)
+    monitor_deltas_clear();
+
+  return true;
+}
+
+/**
+ * monitor_read_events - Read and handle all the queued inotify events
+ * @retval true At least one event was read
+ */
+static bool monitor_read_events(void)
+{
+  char buf[EVENT_BUFLEN] __attribute__((aligned(__alignof__(struct inotify_event))));
+  bool found = false;
+
+  if (INotifyFd == -1)
+    return false;
+
+  while (true)
+  {
+    int len = read(INotifyFd, buf, sizeof(buf));
+    if (len == -1)
+    {
+      if (errno != EAGAIN)
+      {
+        mutt_debug(LL_DEBUG2, "read inotify events failed, errno=%d %s\n",
+                   errno, strerror(errno));
+      }
+      break;
+    }
+
+    found = true;
+    for (char *ptr = buf; ptr < (buf + len);)
+    {
+      const struct inotify_event *event = (const struct inotify_event *) ptr;
+      mutt_debug(LL_DEBUG3, "+ detail: descriptor=%d mask=0x%x\n", event->wd, event->mask);
+
+      if ((event->wd == -1) && (event->mask & IN_Q_OVERFLOW))
+      {
+        /* Events were lost, so nothing can be trusted */
+        Deltas.complete = false;
+        monitor_deltas_clear();
+        MonitorContextChanged = true;
+      }
+
+      if (monitor_deltas_event(event) && !(event->mask & IN_IGNORED))
+        MonitorContextChanged = true;
+
+      if (event->mask & IN_IGNORED)
+        monitor_handle_ignore(event->wd);
+      else if (event->wd == MonitorContextDescriptor)
+        MonitorContextChanged = true;
+      ptr += sizeof(struct inotify_event) + event->len;
+    }
+  }
+
+  return found;
+}
+
 /**
  * monitor_resolve - Get the monitor for a mailbox
  * @param[out] info Details of the mailbox's monitor
@@ -397,7 +551,6 @@ static enum ResolveResult monitor_resolve(struct MonitorInfo *info, struct Mailb
 int mutt_monitor_poll(void)
 {
   int rc = 0;
-  char buf[EVENT_BUFLEN] __attribute__((aligned(__alignof__(struct inotify_event))));
 
   MonitorFilesChanged = false;
 
@@ -429,34 +582,7 @@ int mutt_monitor_poll(void)
           {
             MonitorFilesChanged = true;
             mutt_debug(LL_DEBUG3, "file change(s) detected\n");
-            char *ptr = buf;
-            const struct inotify_event *event = NULL;
-
-            while (true)
-            {
-              int len = read(INotifyFd, buf, sizeof(buf));
-              if (len == -1)
-              {
-                if (errno != EAGAIN)
-                {
-                  mutt_debug(LL_DEBUG2, "read inotify events failed, errno=%d %s\n",
-                             errno, strerror(errno));
-                }
-                break;
-              }
-
-              while (ptr < (buf + len))
-              {
-                event = (const struct inotify_event *) ptr;
-                mutt_debug(LL_DEBUG3, "+ detail: descriptor=%d mask=0x%x\n",
-                           event->wd, event->mask);
-                if (event->mask & IN_IGNORED)
-                  monitor_handle_ignore(event->wd);
-                else if (event->wd == MonitorContextDescriptor)
-                  MonitorContextChanged = true;
-                ptr += sizeof(struct inotify_event) + event->len;
-              }
-            }
+            monitor_read_events();
           }
         }
       }
@@ -491,7 +617,8 @@ int mutt_monitor_add(struct Mailbox *m)
     goto cleanup;
   }
 
-  uint32_t mask = info.is_dir ? INOTIFY_MASK_DIR : INOTIFY_MASK_FILE;
+  /* Don't replace the events of a watch shared with the deltas */
+  uint32_t mask = (info.is_dir ? INOTIFY_MASK_DIR : INOTIFY_MASK_FILE) | IN_MASK_ADD;
   if (((INotifyFd == -1) && (monitor_init() == -1)) ||
       ((desc = inotify_add_watch(INotifyFd, info.path, mask)) == -1))
   {
@@ -574,3 +701,104 @@ cleanup:
   monitor_info_free(&info2);
   return rc;
 }
+
+/**
+ * mutt_monitor_deltas_stop - Stop recording the changes to a Maildir
+ * @param m Mailbox, NULL for any
+ */
+void mutt_monitor_deltas_stop(struct Mailbox *m)
+{
+  if (m && !mutt_str_equal(Deltas.path, mailbox_path(m)))
+    return;
+
+  for (size_t i = 0; i < mutt_array_size(Deltas.desc); i++)
+  {
+    /* The 'new' directory may also be watched for the mailbox list */
+    if ((Deltas.desc[i] != -1) && !monitor_desc_in_use(Deltas.desc[i]))
+      inotify_rm_watch(INotifyFd, Deltas.desc[i]);
+    Deltas.desc[i] = -1;
+  }
+
+  monitor_deltas_clear();
+  Deltas.complete = false;
+  FREE(&Deltas.path);
+  monitor_check_free();
+}
+
+/**
+ * mutt_monitor_deltas_reset - Start recording the changes to a Maildir
+ * @param m Mailbox
+ * @retval true Changes will be recorded from now on
+ *
+ * Only one Maildir is tracked at a time; resetting another one stops
+ * recording the changes to the first.  The caller should read the directories
+ * after calling this, so that no change is missed.
+ */
+bool mutt_monitor_deltas_reset(struct Mailbox *m)
+{
+  if (!m || (m->type != MUTT_MAILDIR))
+    return false;
+
+  if (!mutt_str_equal(Deltas.path, mailbox_path(m)))
+  {
+    mutt_monitor_deltas_stop(NULL);
+    Deltas.path = mutt_str_dup(mailbox_path(m));
+  }
+
+  if ((INotifyFd == -1) && (monitor_init() == -1))
+    return false;
+
+  struct Buffer *buf = mutt_buffer_pool_get();
+  for (size_t i = 0; i < mutt_array_size(Deltas.desc); i++)
+  {
+    if (Deltas.desc[i] != -1)
+      continue;
+
+    mutt_buffer_printf(buf, "%s/%s", mailbox_path(m), DeltaSubdirs[i]);
+    Deltas.desc[i] = inotify_add_watch(INotifyFd, mutt_b2s(buf), INOTIFY_MASK_DELTA);
+    if (Deltas.desc[i] == -1)
+    {
+      mutt_debug(LL_DEBUG2, "inotify_add_watch failed for '%s', errno=%d %s\n",
+                 mutt_b2s(buf), errno, strerror(errno));
+      mutt_buffer_pool_release(&buf);
+      mutt_monitor_deltas_stop(NULL);
+      return false;
+    }
+    mutt_debug(LL_DEBUG3, "inotify_add_watch descriptor=%d for '%s'\n",
+               Deltas.desc[i], mutt_b2s(buf));
+  }
+  mutt_buffer_pool_release(&buf);
+
+  /* Anything already queued happened before the reset */
+  monitor_read_events();
+  monitor_deltas_clear();
+  Deltas.complete = true;
+  return true;
+}
+
+/**
+ * mutt_monitor_deltas_get - Get the changes to a Maildir
+ * @param[in]  m     Mailbox
+ * @param[out] names List for the changed files, e.g. "new/1234.host"
+ * @retval true  Every change since the last call, or reset, is in the list
+ * @retval false The changes are unknown; the Maildir needs to be reset and read
+ *
+ * The names are moved to the list, which the caller must free.  The files may
+ * have been added or removed, possibly more than once.  A name may be listed
+ * more than once.
+ */
+bool mutt_monitor_deltas_get(struct Mailbox *m, struct ListHead *names)
+{
+  if (!m || !names || !mutt_str_equal(Deltas.path, mailbox_path(m)))
+    return false;
+
+  /* Collect any events that haven't been read yet */
+  monitor_read_events();
+
+  if (!Deltas.complete)
+    return false;
+
+  STAILQ_CONCAT(names, &Deltas.names);
+  Deltas.count = 0;
+  return true;
+}
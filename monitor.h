@@ -25,6 +25,7 @@
 
 #include <stdbool.h>
 
+struct ListHead;
 struct Mailbox;
 
 extern bool MonitorFilesChanged;   ///< true after a monitored file has changed
@@ -34,4 +35,8 @@ int mutt_monitor_add(struct Mailbox *m);
 int mutt_monitor_remove(struct Mailbox *m);
 int mutt_monitor_poll(void);
 
+bool mutt_monitor_deltas_get  (struct Mailbox *m, struct ListHead *names);
+bool mutt_monitor_deltas_reset(struct Mailbox *m);
+void mutt_monitor_deltas_stop (struct Mailbox *m);
+
 #endif /* MUTT_MONITOR_H */
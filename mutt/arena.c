@@ -0,0 +1,174 @@
+/**
+ * @file
+ * Memory that's freed all at once
+ *
+ * @authors
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * @copyright
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @page arena Memory that's freed all at once
+ *
+ * An Arena hands out memory from large blocks.  The pieces can't be freed on
+ * their own; they're all freed together when the Arena is freed.  This suits
+ * lots of small objects that live exactly as long as something else, e.g. the
+ * Emails of a Mailbox.
+ *
+ * If NeoMutt was built with threads, the Arena is protected by a mutex, so it
+ * may be used by worker threads, e.g. when parsing Maildir messages.
+ */
+
+#include "config.h"
+#include <stddef.h>
+#include <string.h>
+#ifdef USE_PTHREADS
+#include <pthread.h>
+#endif
+#include "arena.h"
+#include "memory.h"
+
+#define ARENA_ALIGN (2 * sizeof(void *)) ///< Alignment of every allocation
+#define ARENA_MIN_BLOCK (64 * 1024)      ///< Size of the first block
+#define ARENA_MAX_BLOCK (1024 * 1024)    ///< Size the blocks grow to
+
+/**
+ * struct ArenaBlock - A block of memory in an Arena
+ */
+struct ArenaBlock
+{
+  struct ArenaBlock *next; ///< Previous block
+  size_t used;             ///< Bytes used in data
+  size_t size;             ///< Size of data
+  char *data;              ///< Memory to hand out
+};
+
+/**
+ * struct Arena - Memory that's freed all at once
+ */
+struct Arena
+{
+  struct ArenaBlock *head; ///< Current block
+  size_t size;             ///< Bytes handed out
+#ifdef USE_PTHREADS
+  pthread_mutex_t lock;    ///< Lock for worker threads
+#endif
+};
+
+/**
+ * mutt_arena_new - Create an Arena
+ * @retval ptr New Arena
+ */
+struct Arena *mutt_arena_new(void)
+{
+  struct Arena *a = mutt_mem_calloc(1, sizeof(struct Arena));
+#ifdef USE_PTHREADS
+  pthread_mutex_init(&a->lock, NULL);
+#endif
+  return a;
+}
+
+/**
+ * mutt_arena_free - Free an Arena and everything allocated from it
+ * @param[out] ptr Arena to free
+ */
+void mutt_arena_free(struct Arena **ptr)
+{
+  if (!ptr || !*ptr)
+    return;
+
+  struct Arena *a = *ptr;
+  struct ArenaBlock *block = a->head;
+  while (block)
+  {
+    struct ArenaBlock *next = block->next;
+    FREE(&block);
+    block = next;
+  }
+
+#ifdef USE_PTHREADS
+  pthread_mutex_destroy(&a->lock);
+#endif
+  FREE(ptr);
+}
+
+/**
+ * block_new - Add a block to an Arena
+ * @param a    Arena
+ * @param size Bytes needed
+ * @retval ptr New block
+ *
+ * Each block is twice the size of the previous one, up to #ARENA_MAX_BLOCK.
+ */
+static struct ArenaBlock *block_new(struct Arena *a, size_t size)
+{
+  size_t len = a->head ? MIN(a->head->size * 2, ARENA_MAX_BLOCK) : ARENA_MIN_BLOCK;
+  len = MAX(len, size);
+
+  const size_t hdr = (sizeof(struct ArenaBlock) + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+  struct ArenaBlock *block = mutt_mem_malloc(hdr + len);
+  block->data = (char *) block + hdr;
+  block->used = 0;
+  block->size = len;
+  block->next = a->head;
+  a->head = block;
+  return block;
+}
+
+/**
+ * mutt_arena_calloc - Allocate zeroed memory from an Arena
+ * @param a    Arena
+ * @param size Bytes needed
+ * @retval ptr Memory, freed with the Arena
+ *
+ * If the Arena is NULL, the memory is allocated with mutt_mem_calloc().
+ */
+void *mutt_arena_calloc(struct Arena *a, size_t size)
+{
+  if (!a)
+    return mutt_mem_calloc(1, size);
+
+  if (size == 0)
+    size = 1;
+  size = (size + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+
+#ifdef USE_PTHREADS
+  pthread_mutex_lock(&a->lock);
+#endif
+  struct ArenaBlock *block = a->head;
+  if (!block || ((block->size - block->used) < size))
+    block = block_new(a, size);
+
+  void *p = block->data + block->used;
+  block->used += size;
+  a->size += size;
+#ifdef USE_PTHREADS
+  pthread_mutex_unlock(&a->lock);
+#endif
+
+  memset(p, 0, size);
+  return p;
+}
+
+/**
+ * mutt_arena_size - How much memory has been handed out
+ * @param a Arena
+ * @retval num Bytes allocated from the Arena
+ */
+size_t mutt_arena_size(const struct Arena *a)
+{
+  return a ? a->size : 0;
+}
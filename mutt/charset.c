@@ -335,7 +335,8 @@ int mutt_ch_convert_nonmime_string(char **ps)
       return 0;
     }
   }
-  mutt_ch_convert_string(ps, (const char *) mutt_ch_get_default_charset(),
+  char cs[128];
+  mutt_ch_convert_string(ps, mutt_ch_get_default_charset(cs, sizeof(cs)),
                          C_Charset, MUTT_ICONV_HOOK_FROM);
   return -1;
 }
@@ -433,23 +434,28 @@ bool mutt_ch_chscmp(const char *cs1, const char *cs2)
 
 /**
  * mutt_ch_get_default_charset - Get the default character set
- * @retval ptr Name of the default character set
+ * @param buf    Buffer for the result
+ * @param buflen Length of the buffer
+ * @retval ptr Name of the default character set, i.e. buf
  *
- * @warning This returns a pointer to a static buffer.  Do not free it.
+ * This is the first of the $assumed_charset, or "us-ascii".
  */
-char *mutt_ch_get_default_charset(void)
+char *mutt_ch_get_default_charset(char *buf, size_t buflen)
 {
-  static char fcharset[128];
+  if (!buf || (buflen == 0))
+    return NULL;
+
   const char *c = C_AssumedCharset;
   const char *c1 = NULL;
 
   if (c)
   {
     c1 = strchr(c, ':');
-    mutt_str_copy(fcharset, c, c1 ? (c1 - c + 1) : sizeof(fcharset));
-    return fcharset;
+    mutt_str_copy(buf, c, c1 ? MIN(c1 - c + 1, buflen) : buflen);
+    return buf;
   }
-  return strcpy(fcharset, "us-ascii");
+  mutt_str_copy(buf, "us-ascii", buflen);
+  return buf;
 }
 
 /**
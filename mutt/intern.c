@@ -0,0 +1,166 @@
+/**
+ * @file
+ * Shared copies of strings
+ *
+ * @authors
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * @copyright
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @page intern Shared copies of strings
+ *
+ * Some header values repeat across a whole mailbox, e.g. the List-Post of a
+ * mailing list.  Rather than each Email having its own copy, they share one,
+ * which is counted and freed when the last user releases it.
+ *
+ * An interned string must not be changed, or freed with FREE().  Two interned
+ * strings are equal if, and only if, their pointers are equal.
+ *
+ * If NeoMutt was built with threads, the table is protected by a mutex, so it
+ * may be used by worker threads, e.g. when parsing Maildir messages.
+ */
+
+#include "config.h"
+#include <assert.h>
+#include <stddef.h>
+#include <string.h>
+#ifdef USE_PTHREADS
+#include <pthread.h>
+#endif
+#include "intern.h"
+#include "hash.h"
+#include "logging.h"
+#include "memory.h"
+
+/**
+ * struct InternString - A shared string
+ */
+struct InternString
+{
+  size_t refs; ///< Number of users
+  char str[];  ///< The string
+};
+
+static struct HashTable *InternTable = NULL; ///< Shared strings, keyed by themselves
+static size_t InternCount = 0;               ///< Number of shared strings
+#ifdef USE_PTHREADS
+static pthread_mutex_t InternLock = PTHREAD_MUTEX_INITIALIZER;
+#define intern_lock() pthread_mutex_lock(&InternLock)
+#define intern_unlock() pthread_mutex_unlock(&InternLock)
+#else
+#define intern_lock()
+#define intern_unlock()
+#endif
+
+/**
+ * mutt_intern_get - Get a shared copy of a string
+ * @param str String to copy
+ * @retval ptr  Shared string, release with mutt_intern_release()
+ * @retval NULL The string was NULL or empty, like mutt_str_dup()
+ */
+char *mutt_intern_get(const char *str)
+{
+  if (!str || (*str == '\0'))
+    return NULL;
+
+  intern_lock();
+
+  if (!InternTable)
+    InternTable = mutt_hash_new(1024, MUTT_HASH_NO_FLAGS);
+
+  struct InternString *is = mutt_hash_find(InternTable, str);
+  if (is)
+  {
+    is->refs++;
+  }
+  else
+  {
+    const size_t len = strlen(str) + 1;
+    is = mutt_mem_malloc(sizeof(struct InternString) + len);
+    is->refs = 1;
+    memcpy(is->str, str, len);
+    mutt_hash_insert(InternTable, is->str, is);
+    InternCount++;
+  }
+
+  intern_unlock();
+  return is->str;
+}
+
+/**
+ * mutt_intern_release - Release a shared string
+ * @param[out] ptr Shared string to release
+ *
+ * When the last user has released the string, it's freed.
+ *
+ * The string must have come from mutt_intern_get().  It's looked up in the
+ * table before its count is touched, so a string from mutt_str_dup() is
+ * caught, rather than corrupting the heap.
+ */
+void mutt_intern_release(char **ptr)
+{
+  if (!ptr || !*ptr)
+    return;
+
+  char *str = *ptr;
+  *ptr = NULL;
+
+  intern_lock();
+
+  struct InternString *is = InternTable ? mutt_hash_find(InternTable, str) : NULL;
+  if (!is || (is->str != str))
+  {
+    intern_unlock();
+    mutt_debug(LL_DEBUG1, "Not a shared string: %s\n", str);
+    assert(!"String wasn't shared with mutt_intern_get()");
+    return;
+  }
+
+  if (--is->refs == 0)
+  {
+    mutt_hash_delete(InternTable, is->str, is);
+    FREE(&is);
+    if (--InternCount == 0)
+      mutt_hash_free(&InternTable);
+  }
+
+  intern_unlock();
+}
+
+/**
+ * mutt_intern_replace - Replace a shared string
+ * @param[out] ptr Shared string to replace
+ * @param[in]  str String to copy
+ */
+void mutt_intern_replace(char **ptr, const char *str)
+{
+  if (!ptr)
+    return;
+
+  char *old = *ptr;
+  *ptr = mutt_intern_get(str);
+  mutt_intern_release(&old);
+}
+
+/**
+ * mutt_intern_count - How many strings are shared
+ * @retval num Number of distinct shared strings
+ */
+size_t mutt_intern_count(void)
+{
+  return InternCount;
+}
@@ -27,6 +27,7 @@
  *
  * | File             | Description        |
  * | :--------------- | :----------------- |
+ * | mutt/arena.c     | @subpage arena     |
  * | mutt/base64.c    | @subpage base64    |
  * | mutt/buffer.c    | @subpage buffer    |
  * | mutt/charset.c   | @subpage charset   |
@@ -36,6 +37,7 @@
  * | mutt/file.c      | @subpage file      |
  * | mutt/filter.c    | @subpage filter    |
  * | mutt/hash.c      | @subpage hash      |
+ * | mutt/intern.c    | @subpage intern    |
  * | mutt/list.c      | @subpage list      |
  * | mutt/logging.c   | @subpage logging   |
  * | mutt/mapping.c   | @subpage mapping   |
@@ -44,6 +46,7 @@
  * | mutt/memory.c    | @subpage memory    |
  * | mutt/notify.c    | @subpage notify    |
  * | mutt/observer.h  | @subpage observer  |
+ * | mutt/parallel.c  | @subpage parallel  |
  * | mutt/path.c      | @subpage path      |
  * | mutt/pool.c      | @subpage pool      |
  * | mutt/prex.c      | @subpage prex      |
@@ -61,6 +64,7 @@
 #define MUTT_MUTT_LIB_H
 
 // IWYU pragma: begin_exports
+#include "arena.h"
 #include "base64.h"
 #include "buffer.h"
 #include "charset.h"
@@ -70,6 +74,7 @@
 #include "file.h"
 #include "filter.h"
 #include "hash.h"
+#include "intern.h"
 #include "list.h"
 #include "logging.h"
 #include "mapping.h"
@@ -80,6 +85,7 @@
 #include "notify.h"
 #include "notify_type.h"
 #include "observer.h"
+#include "parallel.h"
 #include "path.h"
 #include "pool.h"
 #include "prex.h"
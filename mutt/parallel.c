@@ -0,0 +1,273 @@
+/**
+ * @file
+ * Process items using several threads
+ *
+ * @authors
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * @copyright
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @page parallel Process items using several threads
+ *
+ * Some jobs are made of many independent items, e.g. reading the headers of
+ * the messages in a Maildir, or searching the bodies of the emails in a
+ * Mailbox.  mutt_parallel_run() spreads the items across a small pool of
+ * threads.
+ *
+ * Each worker takes the next item and stores the result in place, so the
+ * caller sees the results in the same order as the items.
+ *
+ * While the workers are running, the logging is serialised, see
+ * log_disp_locked().  The calling thread waits for the workers to finish.
+ * Meanwhile, it can show the progress and stop the job.
+ *
+ * If NeoMutt was built without threads, the calling thread does the work.
+ */
+
+#include "config.h"
+#include <stdbool.h>
+#include <stddef.h>
+#ifdef USE_PTHREADS
+#include <errno.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <time.h>
+#endif
+#include "parallel.h"
+#include "logging.h"
+
+#define PARALLEL_MAX_THREADS 64 ///< Upper limit for the number of threads
+
+/**
+ * parallel_serial - Process the items using the calling thread
+ * @param work Function to process one item
+ * @param wait Function to watch the job, may be NULL
+ * @param data Private data passed to the functions
+ * @param num  Number of items
+ * @retval true  All the items were processed
+ * @retval false The job was stopped
+ */
+static bool parallel_serial(parallel_work_t work, parallel_wait_t wait, void *data, size_t num)
+{
+  for (size_t i = 0; i < num; i++)
+  {
+    if (wait && !wait(data, i))
+      return false;
+    work(data, i);
+  }
+
+  return true;
+}
+
+#ifdef USE_PTHREADS
+/**
+ * struct ParallelJob - Shared state of the worker threads
+ */
+struct ParallelJob
+{
+  parallel_work_t work; ///< Function to process one item
+  void *data;           ///< Private data passed to the function
+  size_t num;           ///< Number of items
+  size_t next;          ///< Next item to be processed
+  size_t done;          ///< Number of items processed
+  bool stop;            ///< Don't start any more items
+  pthread_mutex_t lock; ///< Protects 'next', 'done' and 'stop'
+  pthread_cond_t cond;  ///< Signalled when the last item is done
+};
+
+static pthread_mutex_t LogLock = PTHREAD_MUTEX_INITIALIZER;
+static log_dispatcher_t LogUnlocked = NULL; ///< Logger to use while the threads are running
+
+/**
+ * log_disp_locked - Serialise the logging of the worker threads - Implements ::log_dispatcher_t
+ */
+static int log_disp_locked(time_t stamp, const char *file, int line,
+                           const char *function, enum LogLevel level, ...)
+{
+  char buf[1024];
+
+  va_list ap;
+  va_start(ap, level);
+  const char *fmt = va_arg(ap, const char *);
+  vsnprintf(buf, sizeof(buf), fmt, ap);
+  va_end(ap);
+
+  pthread_mutex_lock(&LogLock);
+  int rc = LogUnlocked(stamp, file, line, function, level, "%s", buf);
+  pthread_mutex_unlock(&LogLock);
+
+  return rc;
+}
+
+/**
+ * parallel_worker - Process items until there are none left
+ * @param arg Shared ParallelJob
+ * @retval NULL Always
+ */
+static void *parallel_worker(void *arg)
+{
+  struct ParallelJob *job = arg;
+
+  while (true)
+  {
+    pthread_mutex_lock(&job->lock);
+    const size_t i = job->next++;
+    const bool stop = job->stop;
+    pthread_mutex_unlock(&job->lock);
+
+    if (stop || (i >= job->num))
+      break;
+
+    job->work(job->data, i);
+
+    pthread_mutex_lock(&job->lock);
+    if (++job->done == job->num)
+      pthread_cond_signal(&job->cond);
+    pthread_mutex_unlock(&job->lock);
+  }
+
+  return NULL;
+}
+
+/**
+ * parallel_wait - Watch the workers until they've finished
+ * @param job  Shared ParallelJob
+ * @param wait Function to watch the job
+ * @retval true  All the items were processed
+ * @retval false The job was stopped
+ *
+ * The watch function is called about ten times a second.
+ */
+static bool parallel_wait(struct ParallelJob *job, parallel_wait_t wait)
+{
+  pthread_mutex_lock(&job->lock);
+  while (job->done < job->num)
+  {
+    const size_t done = job->done;
+    pthread_mutex_unlock(&job->lock);
+    const bool carry_on = wait(job->data, done);
+    pthread_mutex_lock(&job->lock);
+
+    if (!carry_on)
+    {
+      job->stop = true;
+      break;
+    }
+
+    struct timespec ts = { 0 };
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_nsec += 100000000;
+    if (ts.tv_nsec >= 1000000000)
+    {
+      ts.tv_sec++;
+      ts.tv_nsec -= 1000000000;
+    }
+
+    int rc = 0;
+    while ((job->done < job->num) && (rc != ETIMEDOUT))
+      rc = pthread_cond_timedwait(&job->cond, &job->lock, &ts);
+  }
+  const bool stopped = job->stop;
+  pthread_mutex_unlock(&job->lock);
+
+  return !stopped;
+}
+#endif
+
+/**
+ * mutt_parallel_run - Process a set of items using several threads
+ * @param work    Function to process one item
+ * @param wait    Function to watch the job, may be NULL
+ * @param data    Private data passed to the functions
+ * @param num     Number of items
+ * @param threads Number of threads to use
+ * @retval true  All the items were processed
+ * @retval false The job was stopped by the watch function
+ *
+ * Each item is processed exactly once, in no particular order.  The function
+ * returns when all the items have been processed, or when the job has been
+ * stopped and the workers have finished their current items.
+ */
+bool mutt_parallel_run(parallel_work_t work, parallel_wait_t wait, void *data,
+                       size_t num, int threads)
+{
+  if (!work || (num == 0))
+    return true;
+
+#ifdef USE_PTHREADS
+  if (threads > PARALLEL_MAX_THREADS)
+    threads = PARALLEL_MAX_THREADS;
+  if ((size_t) threads > num)
+    threads = num;
+
+  if (threads < 2)
+    return parallel_serial(work, wait, data, num);
+
+  struct ParallelJob job = {
+    .work = work,
+    .data = data,
+    .num = num,
+    .next = 0,
+    .done = 0,
+    .stop = false,
+  };
+  pthread_mutex_init(&job.lock, NULL);
+  pthread_cond_init(&job.cond, NULL);
+
+  pthread_t tids[PARALLEL_MAX_THREADS];
+  int started = 0;
+  bool rc = true;
+
+  LogUnlocked = MuttLogger;
+  MuttLogger = log_disp_locked;
+
+  for (; started < threads; started++)
+  {
+    if (pthread_create(&tids[started], NULL, parallel_worker, &job) != 0)
+    {
+      mutt_debug(LL_DEBUG1, "only started %d of %d threads\n", started, threads);
+      break;
+    }
+  }
+
+  if (started == 0)
+  {
+    /* If no threads could be started, do the work here */
+    MuttLogger = LogUnlocked;
+    LogUnlocked = NULL;
+    rc = parallel_serial(work, wait, data, num);
+  }
+  else
+  {
+    if (wait)
+      rc = parallel_wait(&job, wait);
+
+    for (int i = 0; i < started; i++)
+      pthread_join(tids[i], NULL);
+
+    MuttLogger = LogUnlocked;
+    LogUnlocked = NULL;
+  }
+
+  pthread_cond_destroy(&job.cond);
+  pthread_mutex_destroy(&job.lock);
+  return rc;
+#else
+  return parallel_serial(work, wait, data, num);
+#endif
+}
@@ -0,0 +1,51 @@
+/**
+ * @file
+ * Process items using several threads
+ *
+ * @authors
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * @copyright
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MUTT_LIB_PARALLEL_H
+#define MUTT_LIB_PARALLEL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * typedef parallel_work_t - Prototype for a function to process one item of a parallel job
+ * @param data Private data
+ * @param i    Index of the item
+ *
+ * This is called by the worker threads.
+ */
+typedef void (*parallel_work_t)(void *data, size_t i);
+
+/**
+ * typedef parallel_wait_t - Prototype for a function to watch a parallel job
+ * @param data Private data
+ * @param done Number of items processed so far
+ * @retval true  Carry on
+ * @retval false Stop the job
+ *
+ * This is called by the calling thread, while it waits for the workers.
+ */
+typedef bool (*parallel_wait_t)(void *data, size_t done);
+
+bool mutt_parallel_run(parallel_work_t work, parallel_wait_t wait, void *data, size_t num, int threads);
+
+#endif /* MUTT_LIB_PARALLEL_H */
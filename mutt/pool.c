@@ -24,10 +24,16 @@
  * @page pool A global pool of Buffers
  *
  * A shared pool of Buffers to save lots of allocs/frees.
+ *
+ * If NeoMutt was built with threads, the pool is protected by a mutex, so it
+ * may be used by worker threads, e.g. when parsing Maildir messages.
  */
 
 #include "config.h"
 #include <stdio.h>
+#ifdef USE_PTHREADS
+#include <pthread.h>
+#endif
 #include "pool.h"
 #include "buffer.h"
 #include "logging.h"
@@ -38,6 +44,14 @@ static size_t BufferPoolLen = 0;
 static size_t BufferPoolIncrement = 20;
 static size_t BufferPoolInitialBufferSize = 1024;
 static struct Buffer **BufferPool = NULL;
+#ifdef USE_PTHREADS
+static pthread_mutex_t BufferPoolLock = PTHREAD_MUTEX_INITIALIZER;
+#define pool_lock() pthread_mutex_lock(&BufferPoolLock)
+#define pool_unlock() pthread_mutex_unlock(&BufferPoolLock)
+#else
+#define pool_lock()
+#define pool_unlock()
+#endif
 
 /**
  * buffer_new - Allocate a new Buffer on the heap
@@ -100,9 +114,12 @@ void mutt_buffer_pool_free(void)
  */
 struct Buffer *mutt_buffer_pool_get(void)
 {
+  pool_lock();
   if (BufferPoolCount == 0)
     increase_buffer_pool();
-  return BufferPool[--BufferPoolCount];
+  struct Buffer *buf = BufferPool[--BufferPoolCount];
+  pool_unlock();
+  return buf;
 }
 
 /**
@@ -114,13 +131,6 @@ void mutt_buffer_pool_release(struct Buffer **pbuf)
   if (!pbuf || !*pbuf)
     return;
 
-  if (BufferPoolCount >= BufferPoolLen)
-  {
-    mutt_debug(LL_DEBUG1, "Internal buffer pool error\n");
-    buffer_free(pbuf);
-    return;
-  }
-
   struct Buffer *buf = *pbuf;
   if ((buf->dsize > (2 * BufferPoolInitialBufferSize)) ||
       (buf->dsize < BufferPoolInitialBufferSize))
@@ -129,7 +139,17 @@ void mutt_buffer_pool_release(struct Buffer **pbuf)
     mutt_mem_realloc(&buf->data, buf->dsize);
   }
   mutt_buffer_reset(buf);
+
+  pool_lock();
+  if (BufferPoolCount >= BufferPoolLen)
+  {
+    pool_unlock();
+    mutt_debug(LL_DEBUG1, "Internal buffer pool error\n");
+    buffer_free(pbuf);
+    return;
+  }
   BufferPool[BufferPoolCount++] = buf;
+  pool_unlock();
 
   *pbuf = NULL;
 }
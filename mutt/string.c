@@ -571,6 +571,8 @@ char *mutt_strn_dup(const char *begin, size_t len)
  */
 int mutt_str_cmp(const char *a, const char *b)
 {
+  if (a == b) /* e.g. shared strings, see mutt_intern_get() */
+    return 0;
   return strcmp(NONULL(a), NONULL(b));
 }
 
@@ -584,6 +586,8 @@ int mutt_str_cmp(const char *a, const char *b)
  */
 int mutt_istr_cmp(const char *a, const char *b)
 {
+  if (a == b)
+    return 0;
   return strcasecmp(NONULL(a), NONULL(b));
 }
 
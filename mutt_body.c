@@ -74,7 +74,9 @@ int mutt_body_copy(FILE *fp, struct Body **tgt, struct Body *src)
   *tgt = mutt_body_new();
   b = *tgt;
 
+  const bool arena = b->arena;
   memcpy(b, src, sizeof(struct Body));
+  b->arena = arena;
   TAILQ_INIT(&b->parameter);
   b->parts = NULL;
   b->next = NULL;
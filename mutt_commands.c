@@ -74,6 +74,9 @@ const struct Command Commands[] = {
   { "finish",              parse_finish,           0 },
   { "folder-hook",         mutt_parse_hook,        MUTT_FOLDER_HOOK },
   { "group",               parse_group,            MUTT_GROUP },
+#ifdef USE_HCACHE
+  { "hcache-compact",      parse_hcache_compact,   0 },
+#endif
   { "hdr_order",           parse_stailq,           IP &HeaderOrderList },
   { "iconv-hook",          mutt_parse_hook,        MUTT_ICONV_HOOK },
   { "ifdef",               parse_ifdef,            0 },
@@ -131,6 +131,7 @@ static void linearize_tree(struct Context *ctx)
   struct MuttThread *tree = ctx->tree;
   struct Email **array = m->emails + ((C_Sort & SORT_REVERSE) ? m->msg_count - 1 : 0);
 
+  ctx->msg_threaded = 0;
   while (tree)
   {
     while (!tree->message)
@@ -138,6 +139,7 @@ static void linearize_tree(struct Context *ctx)
 
     *array = tree->message;
     array += (C_Sort & SORT_REVERSE) ? -1 : 1;
+    ctx->msg_threaded++;
 
     if (tree->child)
       tree = tree->child;
@@ -160,6 +162,7 @@ static void linearize_tree(struct Context *ctx)
 /**
  * calculate_visibility - Are tree nodes visible
  * @param ctx       Mailbox
+ * @param top       First thread to check
  * @param max_depth Maximum depth to check
  *
  * this calculates whether a node is the root of a subtree that has visible
@@ -169,10 +172,10 @@ static void linearize_tree(struct Context *ctx)
  * skip parts of the tree in mutt_draw_tree() if we've decided here that we
  * don't care about them any more.
  */
-static void calculate_visibility(struct Context *ctx, int *max_depth)
+static void calculate_visibility(struct Context *ctx, struct MuttThread *top, int *max_depth)
 {
   struct MuttThread *tmp = NULL;
-  struct MuttThread *tree = ctx->tree;
+  struct MuttThread *tree = top;
   int hide_top_missing = C_HideTopMissing && !C_HideMissing;
   int hide_top_limited = C_HideTopLimited && !C_HideLimited;
   int depth = 0;
@@ -190,7 +193,7 @@ static void calculate_visibility(struct Context *ctx, int *max_depth)
     tree->subtree_visible = 0;
     if (tree->message)
     {
-      FREE(&tree->message->tree);
+      FREE(&tree->message->cold->tree);
       if (is_visible(tree->message, ctx))
       {
         tree->deep = true;
@@ -246,7 +249,7 @@ static void calculate_visibility(struct Context *ctx, int *max_depth)
   /* now fix up for the OPTHIDETOP* options if necessary */
   if (hide_top_limited || hide_top_missing)
   {
-    tree = ctx->tree;
+    tree = top;
     while (true)
     {
       if (!tree->visible && tree->deep && (tree->subtree_visible < 2) &&
@@ -271,8 +274,9 @@ static void calculate_visibility(struct Context *ctx, int *max_depth)
 }
 
 /**
- * mutt_draw_tree - Draw a tree of threaded emails
+ * draw_tree - Draw a tree of threaded emails
  * @param ctx Mailbox
+ * @param top First thread to draw
  *
  * Since the graphics characters have a value >255, I have to resort to using
  * escape sequences to pass the information to print_enriched_string().  These
@@ -282,18 +286,18 @@ static void calculate_visibility(struct Context *ctx, int *max_depth)
  * graphics chars on terminals which don't support them (see the man page for
  * curs_addch).
  */
-void mutt_draw_tree(struct Context *ctx)
+static void draw_tree(struct Context *ctx, struct MuttThread *top)
 {
   char *pfx = NULL, *mypfx = NULL, *arrow = NULL, *myarrow = NULL, *new_tree = NULL;
   enum TreeChar corner = (C_Sort & SORT_REVERSE) ? MUTT_TREE_ULCORNER : MUTT_TREE_LLCORNER;
   enum TreeChar vtee = (C_Sort & SORT_REVERSE) ? MUTT_TREE_BTEE : MUTT_TREE_TTEE;
   int depth = 0, start_depth = 0, max_depth = 0, width = C_NarrowTree ? 1 : 2;
   struct MuttThread *nextdisp = NULL, *pseudo = NULL, *parent = NULL;
-  struct MuttThread *tree = ctx->tree;
+  struct MuttThread *tree = top;
 
   /* Do the visibility calculations and free the old thread chars.
    * From now on we can simply ignore invisible subtrees */
-  calculate_visibility(ctx, &max_depth);
+  calculate_visibility(ctx, top, &max_depth);
   pfx = mutt_mem_malloc((width * max_depth) + 2);
   arrow = mutt_mem_malloc((width * max_depth) + 2);
   while (tree)
@@ -327,7 +331,7 @@ void mutt_draw_tree(struct Context *ctx)
         }
         else
           mutt_str_copy(new_tree, arrow, ((size_t) depth * width) + 2);
-        tree->message->tree = new_tree;
+        tree->message->cold->tree = new_tree;
       }
     }
     if (tree->child && (depth != 0))
@@ -395,6 +399,35 @@ void mutt_draw_tree(struct Context *ctx)
   FREE(&arrow);
 }
 
+/**
+ * draw_thread - Draw the tree of a single thread
+ * @param ctx    Mailbox
+ * @param thread Top of the thread
+ *
+ * The tree characters of a thread don't depend on its siblings, so the thread
+ * is drawn as if it were the only one.
+ */
+static void draw_thread(struct Context *ctx, struct MuttThread *thread)
+{
+  struct MuttThread *prev = thread->prev;
+  struct MuttThread *next = thread->next;
+
+  thread->prev = NULL;
+  thread->next = NULL;
+  draw_tree(ctx, thread);
+  thread->prev = prev;
+  thread->next = next;
+}
+
+/**
+ * mutt_draw_tree - Draw a tree of threaded emails
+ * @param ctx Mailbox
+ */
+void mutt_draw_tree(struct Context *ctx)
+{
+  draw_tree(ctx, ctx->tree);
+}
+
 /**
  * make_subject_list - Create a sorted list of all subjects in a thread
  * @param[out] subjects String List of subjects
@@ -521,6 +554,62 @@ static struct HashTable *make_subj_hash(struct Mailbox *m)
   return hash;
 }
 
+/**
+ * pseudo_thread - Thread a message by subject
+ * @param m   Mailbox
+ * @param top Top of the list of threads containing cur
+ * @param cur Thread that didn't get threaded by message-id
+ */
+static void pseudo_thread(struct Mailbox *m, struct MuttThread **top, struct MuttThread *cur)
+{
+  struct MuttThread *tmp = NULL, *parent = NULL, *curchild = NULL, *nextchild = NULL;
+
+  parent = find_subject(m, cur);
+  if (!parent)
+    return;
+
+  cur->fake_thread = true;
+  unlink_message(top, cur);
+  insert_message(&parent->child, parent, cur);
+  parent->sort_children = true;
+  tmp = cur;
+  while (true)
+  {
+    while (!tmp->message)
+      tmp = tmp->child;
+
+    /* if the message we're attaching has pseudo-children, they
+     * need to be attached to its parent, so move them up a level.
+     * but only do this if they have the same real subject as the
+     * parent, since otherwise they rightly belong to the message
+     * we're attaching. */
+    if ((tmp == cur) ||
+        mutt_str_equal(tmp->message->env->real_subj, parent->message->env->real_subj))
+    {
+      tmp->message->subject_changed = false;
+
+      for (curchild = tmp->child; curchild;)
+      {
+        nextchild = curchild->next;
+        if (curchild->fake_thread)
+        {
+          unlink_message(&tmp->child, curchild);
+          insert_message(&parent->child, parent, curchild);
+        }
+        curchild = nextchild;
+      }
+    }
+
+    while (!tmp->next && (tmp != cur))
+    {
+      tmp = tmp->parent;
+    }
+    if (tmp == cur)
+      break;
+    tmp = tmp->next;
+  }
+}
+
 /**
  * pseudo_threads - Thread messages by subject
  * @param ctx Mailbox
@@ -536,8 +625,7 @@ static void pseudo_threads(struct Context *ctx)
 
   struct MuttThread *tree = ctx->tree;
   struct MuttThread *top = tree;
-  struct MuttThread *tmp = NULL, *cur = NULL, *parent = NULL, *curchild = NULL,
-                    *nextchild = NULL;
+  struct MuttThread *cur = NULL;
 
   if (!m->subj_hash)
     m->subj_hash = make_subj_hash(ctx->mailbox);
@@ -546,50 +634,7 @@ static void pseudo_threads(struct Context *ctx)
   {
     cur = tree;
     tree = tree->next;
-    parent = find_subject(ctx->mailbox, cur);
-    if (parent)
-    {
-      cur->fake_thread = true;
-      unlink_message(&top, cur);
-      insert_message(&parent->child, parent, cur);
-      parent->sort_children = true;
-      tmp = cur;
-      while (true)
-      {
-        while (!tmp->message)
-          tmp = tmp->child;
-
-        /* if the message we're attaching has pseudo-children, they
-         * need to be attached to its parent, so move them up a level.
-         * but only do this if they have the same real subject as the
-         * parent, since otherwise they rightly belong to the message
-         * we're attaching. */
-        if ((tmp == cur) || mutt_str_equal(tmp->message->env->real_subj,
-                                           parent->message->env->real_subj))
-        {
-          tmp->message->subject_changed = false;
-
-          for (curchild = tmp->child; curchild;)
-          {
-            nextchild = curchild->next;
-            if (curchild->fake_thread)
-            {
-              unlink_message(&tmp->child, curchild);
-              insert_message(&parent->child, parent, curchild);
-            }
-            curchild = nextchild;
-          }
-        }
-
-        while (!tmp->next && (tmp != cur))
-        {
-          tmp = tmp->parent;
-        }
-        if (tmp == cur)
-          break;
-        tmp = tmp->next;
-      }
-    }
+    pseudo_thread(m, &top, cur);
   }
   ctx->tree = top;
 }
@@ -616,6 +661,7 @@ void mutt_clear_threads(struct Context *ctx)
     e->threaded = false;
   }
   ctx->tree = NULL;
+  ctx->msg_threaded = 0;
 
   mutt_hash_free(&ctx->thread_hash);
 }
@@ -786,17 +832,18 @@ struct MuttThread *mutt_sort_subthreads(struct MuttThread *thread, bool init)
 
 /**
  * check_subjects - Find out which emails' subjects differ from their parent's
- * @param m    Mailbox
- * @param init If true, rebuild the thread
+ * @param emails Emails to check
+ * @param num    Number of emails
+ * @param init   If true, rebuild the thread
  */
-static void check_subjects(struct Mailbox *m, bool init)
+static void check_subjects(struct Email **emails, int num, bool init)
 {
-  if (!m)
+  if (!emails)
     return;
 
-  for (int i = 0; i < m->msg_count; i++)
+  for (int i = 0; i < num; i++)
   {
-    struct Email *e = m->emails[i];
+    struct Email *e = emails[i];
     if (!e || !e->thread)
       continue;
 
@@ -825,6 +872,352 @@ static void check_subjects(struct Mailbox *m, bool init)
   }
 }
 
+/**
+ * next_reference - Get the next message-id to thread an email by
+ * @param[in]     env        Envelope of the email
+ * @param[in]     ref        Previous reference, NULL for the first
+ * @param[in,out] using_refs State of the search, 0 for the first
+ * @retval ptr Next reference
+ * @retval NULL No more references
+ */
+static struct ListNode *next_reference(struct Envelope *env, struct ListNode *ref, int *using_refs)
+{
+  if (*using_refs == 0)
+  {
+    /* look at the beginning of in-reply-to: */
+    ref = STAILQ_FIRST(&env->in_reply_to);
+    if (ref)
+      *using_refs = 1;
+    else
+    {
+      ref = STAILQ_FIRST(&env->references);
+      *using_refs = 2;
+    }
+  }
+  else if (*using_refs == 1)
+  {
+    /* if there's no references header, use all the in-reply-to:
+     * data that we have.  otherwise, use the first reference
+     * if it's different than the first in-reply-to, otherwise use
+     * the second reference (since at least eudora puts the most
+     * recent reference in in-reply-to and the rest in references) */
+    if (STAILQ_EMPTY(&env->references))
+      ref = STAILQ_NEXT(ref, entries);
+    else
+    {
+      if (!mutt_str_equal(ref->data, STAILQ_FIRST(&env->references)->data))
+        ref = STAILQ_FIRST(&env->references);
+      else
+        ref = STAILQ_NEXT(STAILQ_FIRST(&env->references), entries);
+
+      *using_refs = 2;
+    }
+  }
+  else
+    ref = STAILQ_NEXT(ref, entries); /* go on with references */
+
+  return ref;
+}
+
+/**
+ * thread_by_references - Attach an email to the thread of its references
+ * @param ctx Mailbox
+ * @param e   Email
+ * @param top Temporary top node of the threads
+ */
+static void thread_by_references(struct Context *ctx, struct Email *e, struct MuttThread *top)
+{
+  struct MuttThread *thread = e->thread;
+  struct MuttThread *tnew = NULL;
+  struct ListNode *ref = NULL;
+  int using_refs = 0;
+
+  while (true)
+  {
+    ref = next_reference(e->env, ref, &using_refs);
+    if (!ref)
+      break;
+
+    tnew = mutt_hash_find(ctx->thread_hash, ref->data);
+    if (tnew)
+    {
+      if (tnew->duplicate_thread)
+        tnew = tnew->parent;
+      if (is_descendant(tnew, thread)) /* no loops! */
+        continue;
+    }
+    else
+    {
+      tnew = mutt_mem_calloc(1, sizeof(struct MuttThread));
+      mutt_hash_insert(ctx->thread_hash, ref->data, tnew);
+    }
+
+    if (thread->parent)
+      unlink_message(&top->child, thread);
+    insert_message(&tnew->child, tnew, thread);
+    thread = tnew;
+    if (thread->message || (thread->parent && (thread->parent != top)))
+      break;
+  }
+
+  if (!thread->parent)
+    insert_message(&top->child, top, thread);
+}
+
+/**
+ * add_thread - Create the thread of a new email
+ * @param ctx    Mailbox
+ * @param e      Email
+ * @param thread Thread of an email with the same message-id, or NULL
+ */
+static void add_thread(struct Context *ctx, struct Email *e, struct MuttThread *thread)
+{
+  struct MuttThread *tnew = (C_DuplicateThreads ? thread : NULL);
+
+  thread = mutt_mem_calloc(1, sizeof(struct MuttThread));
+  thread->message = e;
+  thread->check_subject = true;
+  e->thread = thread;
+  mutt_hash_insert(ctx->thread_hash, e->env->message_id ? e->env->message_id : "", thread);
+
+  if (tnew)
+  {
+    if (tnew->duplicate_thread)
+      tnew = tnew->parent;
+
+    thread = e->thread;
+
+    insert_message(&tnew->child, tnew, thread);
+    thread->duplicate_thread = true;
+    thread->message->threaded = true;
+  }
+}
+
+/**
+ * can_thread_new_emails - Can new emails be added without rebuilding the tree?
+ * @param ctx    Mailbox
+ * @param emails New emails
+ * @param num    Number of new emails
+ * @retval true The existing threads won't change shape
+ *
+ * The new emails may only become descendants of existing messages, or start
+ * threads of their own.  They mustn't fill in a missing message, and, if we
+ * also thread by subject, they mustn't be an earlier match for the subject of
+ * an existing thread.
+ */
+static bool can_thread_new_emails(struct Context *ctx, struct Email **emails, int num)
+{
+  struct Mailbox *m = ctx->mailbox;
+  struct MuttThread *thread = NULL;
+  struct HashElem *ptr = NULL;
+
+  if (!C_StrictThreads && !m->subj_hash)
+    return false;
+
+  for (int i = 0; i < num; i++)
+  {
+    struct Email *e = emails[i];
+
+    if (e->env->message_id)
+    {
+      thread = mutt_hash_find(ctx->thread_hash, e->env->message_id);
+      if (thread && !thread->message)
+        return false;
+    }
+
+    struct ListNode *ref = NULL;
+    int using_refs = 0;
+    while ((ref = next_reference(e->env, ref, &using_refs)))
+    {
+      thread = mutt_hash_find(ctx->thread_hash, ref->data);
+      if (!thread)
+        continue;
+      if (thread->duplicate_thread)
+        thread = thread->parent;
+      if (!thread->message)
+        return false;
+      break;
+    }
+
+    if (C_StrictThreads || !e->env->real_subj)
+      continue;
+
+    const time_t date = C_ThreadReceived ? e->received : e->date_sent;
+    for (ptr = mutt_hash_find_bucket(m->subj_hash, e->env->real_subj); ptr; ptr = ptr->next)
+    {
+      struct Email *e2 = ptr->data;
+      if (e2->thread && mutt_str_equal(e2->env->real_subj, e->env->real_subj) &&
+          ((C_ThreadReceived ? e2->received : e2->date_sent) >= date))
+      {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+/**
+ * compare_thread_ptrs - Compare the addresses of two threads - Implements ::sort_t
+ */
+static int compare_thread_ptrs(const void *a, const void *b)
+{
+  struct MuttThread const *const *ta = (struct MuttThread const *const *) a;
+  struct MuttThread const *const *tb = (struct MuttThread const *const *) b;
+  return (*ta < *tb) ? -1 : (*ta > *tb);
+}
+
+/**
+ * thread_new_emails - Add new emails to the existing threads
+ * @param[in]  ctx   Mailbox
+ * @param[out] roots Threads that have changed
+ * @retval num Number of threads that have changed
+ * @retval  0  There's no new mail, nothing has been changed
+ * @retval -1  The tree must be rebuilt, nothing has been changed
+ *
+ * Only the threads that gain an email are re-sorted, and then merged back into
+ * the sorted list of threads.  The caller must free roots.
+ */
+static int thread_new_emails(struct Context *ctx, struct MuttThread ***roots)
+{
+  struct Mailbox *m = ctx->mailbox;
+  struct MuttThread top = { 0 };
+  struct MuttThread newtop = { 0 };
+  struct MuttThread *thread = NULL, *tree = NULL, *prev = NULL;
+  int i, num = 0, num_roots = 0;
+
+  if (!ctx->tree)
+    return 0;
+
+  for (i = 0; i < m->msg_count; i++)
+  {
+    struct Email *e = m->emails[i];
+    if (!e)
+      continue;
+    if (!e->thread)
+      num++;
+    else if (!e->threaded)
+      return 0;
+  }
+  if (num == 0)
+    return 0;
+
+  /* the threads must already be in order, every top-level thread has a key */
+  if (compare_threads(NULL, NULL) == 0)
+    return -1;
+  for (tree = ctx->tree; tree; tree = tree->next)
+  {
+    if (!tree->sort_key || (tree->prev && (compare_threads(&tree->prev, &tree) > 0)))
+      return -1;
+  }
+
+  struct Email **emails = mutt_mem_calloc(num, sizeof(struct Email *));
+  num = 0;
+  for (i = 0; i < m->msg_count; i++)
+  {
+    struct Email *e = m->emails[i];
+    if (e && !e->thread)
+      emails[num++] = e;
+  }
+
+  if (!can_thread_new_emails(ctx, emails, num))
+  {
+    FREE(&emails);
+    return -1;
+  }
+
+  /* existing threads are attached to one top node, new ones to another */
+  top.child = ctx->tree;
+  for (thread = ctx->tree; thread; thread = thread->next)
+    thread->parent = &top;
+
+  for (i = 0; i < num; i++)
+  {
+    struct Email *e = emails[i];
+    thread = e->env->message_id ? mutt_hash_find(ctx->thread_hash, e->env->message_id) : NULL;
+    add_thread(ctx, e, thread);
+  }
+
+  for (i = 0; i < num; i++)
+  {
+    struct Email *e = emails[i];
+    if (e->threaded)
+      continue;
+    e->threaded = true;
+    thread_by_references(ctx, e, &newtop);
+  }
+
+  for (thread = ctx->tree; thread; thread = thread->next)
+    thread->parent = NULL;
+  for (thread = newtop.child; thread; thread = thread->next)
+    thread->parent = NULL;
+
+  check_subjects(emails, num, false);
+
+  if (!C_StrictThreads)
+  {
+    tree = newtop.child;
+    while (tree)
+    {
+      thread = tree;
+      tree = tree->next;
+      pseudo_thread(m, &newtop.child, thread);
+    }
+  }
+
+  /* find the threads containing the new emails and take them out of the tree */
+  *roots = mutt_mem_calloc(num, sizeof(struct MuttThread *));
+  for (i = 0; i < num; i++)
+  {
+    for (thread = emails[i]->thread; thread->parent;)
+      thread = thread->parent;
+    (*roots)[i] = thread;
+  }
+  FREE(&emails);
+
+  qsort(*roots, num, sizeof(struct MuttThread *), compare_thread_ptrs);
+  for (i = 0; i < num; i++)
+  {
+    if ((num_roots > 0) && ((*roots)[i] == (*roots)[num_roots - 1]))
+      continue;
+    thread = (*roots)[i];
+    (*roots)[num_roots++] = thread;
+    unlink_message((ctx->tree == thread) ? &ctx->tree : &newtop.child, thread);
+    thread->next = NULL;
+    thread->prev = NULL;
+  }
+
+  for (i = 0; i < num_roots; i++)
+    (*roots)[i] = mutt_sort_subthreads((*roots)[i], false);
+
+  /* merge them back into the sorted list of threads */
+  compare_threads(NULL, NULL);
+  qsort(*roots, num_roots, sizeof(struct MuttThread *), compare_threads);
+  tree = ctx->tree;
+  prev = NULL;
+  for (i = 0; i < num_roots; i++)
+  {
+    thread = (*roots)[i];
+    while (tree && (compare_threads(&tree, &thread) < 0))
+    {
+      prev = tree;
+      tree = tree->next;
+    }
+
+    thread->prev = prev;
+    thread->next = tree;
+    if (prev)
+      prev->next = thread;
+    else
+      ctx->tree = thread;
+    if (tree)
+      tree->prev = thread;
+    prev = thread;
+  }
+
+  return num_roots;
+}
+
 /**
  * mutt_sort_threads - Sort email threads
  * @param ctx  Mailbox
@@ -838,16 +1231,33 @@ void mutt_sort_threads(struct Context *ctx, bool init)
   struct Mailbox *m = ctx->mailbox;
 
   struct Email *e = NULL;
-  int i, oldsort, using_refs = 0;
+  int i, oldsort;
   struct MuttThread *thread = NULL, *tnew = NULL, *tmp = NULL;
   struct MuttThread top = { 0 };
-  struct ListNode *ref = NULL;
 
   /* Set C_Sort to the secondary method to support the set sort_aux=reverse-*
    * settings.  The sorting functions just look at the value of SORT_REVERSE */
   oldsort = C_Sort;
   C_Sort = C_SortAux;
 
+  if (!init && ctx->thread_hash)
+  {
+    /* try to add new mail to the threads, without rebuilding them */
+    struct MuttThread **roots = NULL;
+    const int num_roots = thread_new_emails(ctx, &roots);
+    if (num_roots > 0)
+    {
+      C_Sort = oldsort;
+      linearize_tree(ctx);
+      for (i = 0; i < num_roots; i++)
+        draw_thread(ctx, roots[i]);
+      FREE(&roots);
+      return;
+    }
+    if (num_roots < 0)
+      mutt_clear_threads(ctx);
+  }
+
   if (!ctx->thread_hash)
     init = true;
 
@@ -923,28 +1333,7 @@ void mutt_sort_threads(struct Context *ctx, bool init)
         }
       }
       else
-      {
-        tnew = (C_DuplicateThreads ? thread : NULL);
-
-        thread = mutt_mem_calloc(1, sizeof(struct MuttThread));
-        thread->message = e;
-        thread->check_subject = true;
-        e->thread = thread;
-        mutt_hash_insert(ctx->thread_hash,
-                         e->env->message_id ? e->env->message_id : "", thread);
-
-        if (tnew)
-        {
-          if (tnew->duplicate_thread)
-            tnew = tnew->parent;
-
-          thread = e->thread;
-
-          insert_message(&tnew->child, tnew, thread);
-          thread->duplicate_thread = true;
-          thread->message->threaded = true;
-        }
-      }
+        add_thread(ctx, e, thread);
     }
     else
     {
@@ -976,74 +1365,8 @@ void mutt_sort_threads(struct Context *ctx, bool init)
       continue;
     e->threaded = true;
 
-    thread = e->thread;
-    if (!thread)
-      continue;
-    using_refs = 0;
-
-    while (true)
-    {
-      if (using_refs == 0)
-      {
-        /* look at the beginning of in-reply-to: */
-        ref = STAILQ_FIRST(&e->env->in_reply_to);
-        if (ref)
-          using_refs = 1;
-        else
-        {
-          ref = STAILQ_FIRST(&e->env->references);
-          using_refs = 2;
-        }
-      }
-      else if (using_refs == 1)
-      {
-        /* if there's no references header, use all the in-reply-to:
-         * data that we have.  otherwise, use the first reference
-         * if it's different than the first in-reply-to, otherwise use
-         * the second reference (since at least eudora puts the most
-         * recent reference in in-reply-to and the rest in references) */
-        if (STAILQ_EMPTY(&e->env->references))
-          ref = STAILQ_NEXT(ref, entries);
-        else
-        {
-          if (!mutt_str_equal(ref->data, STAILQ_FIRST(&e->env->references)->data))
-            ref = STAILQ_FIRST(&e->env->references);
-          else
-            ref = STAILQ_NEXT(STAILQ_FIRST(&e->env->references), entries);
-
-          using_refs = 2;
-        }
-      }
-      else
-        ref = STAILQ_NEXT(ref, entries); /* go on with references */
-
-      if (!ref)
-        break;
-
-      tnew = mutt_hash_find(ctx->thread_hash, ref->data);
-      if (tnew)
-      {
-        if (tnew->duplicate_thread)
-          tnew = tnew->parent;
-        if (is_descendant(tnew, thread)) /* no loops! */
-          continue;
-      }
-      else
-      {
-        tnew = mutt_mem_calloc(1, sizeof(struct MuttThread));
-        mutt_hash_insert(ctx->thread_hash, ref->data, tnew);
-      }
-
-      if (thread->parent)
-        unlink_message(&top.child, thread);
-      insert_message(&tnew->child, tnew, thread);
-      thread = tnew;
-      if (thread->message || (thread->parent && (thread->parent != &top)))
-        break;
-    }
-
-    if (!thread->parent)
-      insert_message(&top.child, &top, thread);
+    if (e->thread)
+      thread_by_references(ctx, e, &top);
   }
 
   /* detach everything from the temporary top node */
@@ -1053,7 +1376,7 @@ void mutt_sort_threads(struct Context *ctx, bool init)
   }
   ctx->tree = top.child;
 
-  check_subjects(ctx->mailbox, init);
+  check_subjects(m->emails, m->msg_count, init);
 
   if (!C_StrictThreads)
     pseudo_threads(ctx);
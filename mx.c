@@ -34,6 +34,7 @@
 #include <limits.h>
 #include <locale.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <string.h>
 #include <sys/stat.h>
 #include <unistd.h>
@@ -398,7 +399,19 @@ struct Context *mx_mbox_open(struct Mailbox *m, OpenMailboxFlags flags)
   m->msg_tagged = 0;
   m->vcount = 0;
 
+  /* The Emails live as long as the Mailbox is open, so allocate them together.
+   * Their Envelopes and Bodies go elsewhere, keeping the Emails dense. */
+  if (!m->arena)
+    m->arena = mutt_arena_new();
+  if (!m->arena_parts)
+    m->arena_parts = mutt_arena_new();
+  struct Arena *arena_prev = EmailArena;
+  struct Arena *parts_prev = EnvelopeArena;
+  EmailArena = m->arena;
+  EnvelopeArena = m->arena_parts;
   int rc = m->mx_ops->mbox_open(ctx->mailbox);
+  EmailArena = arena_prev;
+  EnvelopeArena = parts_prev;
   m->opened++;
   if (rc == 0)
     ctx_update(ctx);
@@ -473,6 +486,17 @@ void mx_fastclose_mailbox(struct Mailbox *m)
       email_free(&m->emails[i]);
     }
   }
+
+  if (m->arena)
+  {
+    /* Nothing may outlive the arena */
+    for (int i = 0; m->emails && (i < m->email_max); i++)
+      email_free(&m->emails[i]);
+    mutt_debug(LL_DEBUG2, "freeing %zu bytes of emails\n",
+               mutt_arena_size(m->arena) + mutt_arena_size(m->arena_parts));
+    mutt_arena_free(&m->arena);
+    mutt_arena_free(&m->arena_parts);
+  }
 }
 
 /**
@@ -1108,6 +1132,7 @@ struct Message *mx_msg_open_new(struct Mailbox *m, struct Email *e, MsgOpenFlags
     {
       if (e)
       {
+        mutt_env_lazy_restore(e->env);
         p = TAILQ_FIRST(&e->env->return_path);
         if (!p)
           p = TAILQ_FIRST(&e->env->sender);
@@ -1169,6 +1194,9 @@ struct Message *mx_msg_open(struct Mailbox *m, int msgno)
     return NULL;
   }
 
+  if ((msgno >= 0) && (msgno < m->msg_count) && m->emails[msgno])
+    mutt_env_lazy_restore(m->emails[msgno]->env);
+
   msg = mutt_mem_calloc(1, sizeof(struct Message));
   if (m->mx_ops->msg_open(m, msg, msgno) < 0)
     FREE(&msg);
@@ -1228,30 +1256,35 @@ int mx_msg_close(struct Mailbox *m, struct Message **msg)
 
 /**
  * mx_alloc_memory - Create storage for the emails
- * @param m Mailbox
+ * @param m        Mailbox
+ * @param req_size Number of emails the Mailbox needs room for
+ *
+ * The storage grows by half of its size each time, so adding emails one at a
+ * time doesn't copy the arrays over and over.  If the backend knows how many
+ * emails there are, e.g. from the server, it can ask for them all at once.
  */
-void mx_alloc_memory(struct Mailbox *m)
+void mx_alloc_memory(struct Mailbox *m, int req_size)
 {
-  size_t s = MAX(sizeof(struct Email *), sizeof(int));
+  if (!m || (req_size <= m->email_max))
+    return;
+
+  const size_t s = MAX(sizeof(struct Email *), sizeof(int));
+  size_t new_max = (size_t) m->email_max + (m->email_max / 2);
+  new_max = MAX(new_max, (size_t) req_size);
+  new_max = MAX(new_max, 25);
+  new_max = MIN(new_max, INT_MAX);
 
-  if ((m->email_max + 25) * s < m->email_max * s)
+  if (new_max > (SIZE_MAX / s))
   {
     mutt_error(_("Out of memory"));
     mutt_exit(1);
   }
 
-  m->email_max += 25;
-  if (m->emails)
-  {
-    mutt_mem_realloc(&m->emails, sizeof(struct Email *) * m->email_max);
-    mutt_mem_realloc(&m->v2r, sizeof(int) * m->email_max);
-  }
-  else
-  {
-    m->emails = mutt_mem_calloc(m->email_max, sizeof(struct Email *));
-    m->v2r = mutt_mem_calloc(m->email_max, sizeof(int));
-  }
-  for (int i = m->email_max - 25; i < m->email_max; i++)
+  const int old_max = m->emails ? m->email_max : 0;
+  m->email_max = new_max;
+  mutt_mem_realloc(&m->emails, sizeof(struct Email *) * m->email_max);
+  mutt_mem_realloc(&m->v2r, sizeof(int) * m->email_max);
+  for (int i = old_max; i < m->email_max; i++)
   {
     m->emails[i] = NULL;
     m->v2r[i] = -1;
@@ -1839,3 +1872,19 @@ int mx_save_hcache(struct Mailbox *m, struct Email *e)
 
   return m->mx_ops->msg_save_hcache(m, e);
 }
+
+/**
+ * mx_mbox_gc - Remove stale records from the header cache - Wrapper for MxOps::mbox_gc()
+ * @param m       Mailbox
+ * @param compact If true, finish the job, then compact the header cache
+ * @retval  0 Success, there's nothing more to do
+ * @retval  1 Success, call again to continue
+ * @retval -1 Failure, or not supported by the Mailbox
+ */
+int mx_mbox_gc(struct Mailbox *m, bool compact)
+{
+  if (!m || !m->mx_ops || !m->mx_ops->mbox_gc)
+    return -1;
+
+  return m->mx_ops->mbox_gc(m, compact);
+}
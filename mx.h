@@ -232,6 +232,16 @@ struct MxOps
    */
   int (*msg_save_hcache) (struct Mailbox *m, struct Email *e);
 
+  /**
+   * mbox_gc - Remove stale records from the header cache
+   * @param m       Mailbox
+   * @param compact If true, finish the job, then compact the header cache
+   * @retval  0 Success, there's nothing more to do
+   * @retval  1 Success, call again to continue
+   * @retval -1 Failure
+   */
+  int (*mbox_gc)         (struct Mailbox *m, bool compact);
+
   /**
    * tags_edit - Prompt and validate new messages tags
    * @param m      Mailbox
@@ -303,6 +313,7 @@ struct Message *mx_msg_open_new    (struct Mailbox *m, struct Email *e, MsgOpenF
 struct Message *mx_msg_open        (struct Mailbox *m, int msgno);
 int             mx_msg_padding_size(struct Mailbox *m);
 int             mx_save_hcache     (struct Mailbox *m, struct Email *e);
+int             mx_mbox_gc         (struct Mailbox *m, bool compact);
 int             mx_path_canon      (char *buf, size_t buflen, const char *folder, enum MailboxType *type);
 int             mx_path_canon2     (struct Mailbox *m, const char *folder);
 int             mx_path_parent     (char *buf, size_t buflen);
@@ -321,7 +332,7 @@ int             mx_ac_add      (struct Account *a, struct Mailbox *m);
 int             mx_ac_remove   (struct Mailbox *m);
 
 int                 mx_access           (const char *path, int flags);
-void                mx_alloc_memory     (struct Mailbox *m);
+void                mx_alloc_memory     (struct Mailbox *m, int req_size);
 int                 mx_check_empty      (const char *path);
 void                mx_fastclose_mailbox(struct Mailbox *m);
 const struct MxOps *mx_get_ops          (enum MailboxType type);
@@ -718,7 +718,8 @@ struct HeaderCache *nntp_hcache_open(struct NntpMboxData *mdata)
   mutt_account_tourl(&mdata->adata->conn->account, &url);
   url.path = mdata->group;
   url_tostring(&url, file, sizeof(file), U_PATH);
-  return mutt_hcache_open(C_NewsCacheDir, file, nntp_hcache_namer);
+  return mutt_hcache_open(C_NewsCacheDir, file, nntp_hcache_namer,
+                          &mdata->adata->conn->account);
 }
 
 /**
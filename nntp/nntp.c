@@ -98,6 +98,23 @@ struct FetchCtx
   struct HeaderCache *hc;
 };
 
+#ifdef USE_HCACHE
+#define NNTP_HCACHE_BATCH 256 ///< Number of articles to fetch from the header cache at once
+
+/**
+ * struct HcachePrefetch - A window of articles read from the header cache
+ */
+struct HcachePrefetch
+{
+  struct HCacheItem items[NNTP_HCACHE_BATCH]; ///< Cache entries
+  anum_t anums[NNTP_HCACHE_BATCH];            ///< Article numbers of the entries
+  char keys[NNTP_HCACHE_BATCH][16];           ///< Cache keys of the entries
+  size_t num;                                 ///< Number of entries in the window
+  size_t next;                                ///< Next entry to be used
+  anum_t last;                                ///< Last article covered by the window
+};
+#endif
+
 /**
  * struct ChildCtx - Keep track of the children of an article
  */
@@ -218,7 +235,7 @@ struct NntpEmailData *nntp_edata_get(struct Email *e)
 {
   if (!e)
     return NULL;
-  return e->edata;
+  return e->cold->edata;
 }
 
 /**
@@ -1160,7 +1177,7 @@ static int parse_overview_line(char *line, void *data)
 
   /* allocate memory for headers */
   if (m->msg_count >= m->email_max)
-    mx_alloc_memory(m);
+    mx_alloc_memory(m, m->msg_count + 1);
 
   /* parse header */
   m->emails[m->msg_count] = email_new();
@@ -1184,7 +1201,7 @@ static int parse_overview_line(char *line, void *data)
       email_free(&e);
       e = hce.email;
       m->emails[m->msg_count] = e;
-      e->edata = NULL;
+      e->cold->edata = NULL;
       e->read = false;
       e->old = false;
 
@@ -1215,8 +1232,8 @@ static int parse_overview_line(char *line, void *data)
     e->read = false;
     e->old = false;
     e->deleted = false;
-    e->edata = nntp_edata_new();
-    e->edata_free = nntp_edata_free;
+    e->cold->edata = nntp_edata_new();
+    e->cold->edata_free = nntp_edata_free;
     nntp_edata_get(e)->article_num = anum;
     if (fc->restore)
       e->changed = true;
@@ -1238,6 +1255,72 @@ static int parse_overview_line(char *line, void *data)
   return 0;
 }
 
+#ifdef USE_HCACHE
+/**
+ * hcache_prefetch_free - Free any unused Emails in the prefetch window
+ * @param hp Prefetch window
+ */
+static void hcache_prefetch_free(struct HcachePrefetch *hp)
+{
+  for (size_t i = hp->next; i < hp->num; i++)
+    email_free(&hp->items[i].entry.email);
+  hp->num = 0;
+  hp->next = 0;
+}
+
+/**
+ * hcache_prefetch_get - Get an article from the header cache, reading ahead
+ * @param fc      Fetch context
+ * @param hp      Prefetch window
+ * @param current Article number
+ * @retval obj HCacheEntry containing an Email, empty on failure
+ *
+ * Articles are requested in ascending order.  When the request falls outside
+ * the window, the next #NNTP_HCACHE_BATCH articles are fetched in one go.
+ */
+static struct HCacheEntry hcache_prefetch_get(struct FetchCtx *fc,
+                                              struct HcachePrefetch *hp, anum_t current)
+{
+  struct HCacheEntry hce = { 0 };
+
+  if ((hp->num == 0) || (current > hp->last))
+  {
+    hcache_prefetch_free(hp);
+
+    anum_t anum;
+    for (anum = current; (anum <= fc->last) && (hp->num < NNTP_HCACHE_BATCH); anum++)
+    {
+      if (!fc->messages[anum - fc->first])
+        continue;
+
+      size_t i = hp->num++;
+      snprintf(hp->keys[i], sizeof(hp->keys[i]), "%u", anum);
+      hp->items[i].key = hp->keys[i];
+      hp->items[i].keylen = strlen(hp->keys[i]);
+      hp->anums[i] = anum;
+    }
+    hp->last = anum - 1;
+
+    mutt_hcache_fetch_many(fc->hc, hp->items, hp->num, 0);
+  }
+
+  while ((hp->next < hp->num) && (hp->anums[hp->next] < current))
+  {
+    email_free(&hp->items[hp->next].entry.email);
+    hp->next++;
+  }
+
+  if ((hp->next < hp->num) && (hp->anums[hp->next] == current))
+  {
+    hce = hp->items[hp->next].entry;
+    hp->items[hp->next].entry.email = NULL;
+    hp->next++;
+  }
+
+  return hce;
+}
+#endif
+
 /**
  * nntp_fetch_headers - Fetch headers
  * @param m       Mailbox
@@ -1260,6 +1343,9 @@ static int nntp_fetch_headers(struct Mailbox *m, void *hc, anum_t first, anum_t
   int rc = 0;
   anum_t current;
   anum_t first_over = first;
+#ifdef USE_HCACHE
+  struct HcachePrefetch *hp = NULL;
+#endif
 
   /* if empty group or nothing to do */
   if (!last || (first > last))
@@ -1325,6 +1411,10 @@ static int nntp_fetch_headers(struct Mailbox *m, void *hc, anum_t first, anum_t
     mutt_progress_init(&fc.progress, _("Fetching message headers..."),
                        MUTT_PROGRESS_READ, last - first + 1);
   }
+#ifdef USE_HCACHE
+  if (fc.hc)
+    hp = mutt_mem_calloc(1, sizeof(struct HcachePrefetch));
+#endif
   for (current = first; (current <= last) && (rc == 0); current++)
   {
     if (m->verbose)
@@ -1340,17 +1430,19 @@ static int nntp_fetch_headers(struct Mailbox *m, void *hc, anum_t first, anum_t
 
     /* allocate memory for headers */
     if (m->msg_count >= m->email_max)
-      mx_alloc_memory(m);
+      mx_alloc_memory(m, m->msg_count + 1);
 
 #ifdef USE_HCACHE
     /* try to fetch header from cache */
-    struct HCacheEntry hce = mutt_hcache_fetch(fc.hc, buf, strlen(buf), 0);
+    struct HCacheEntry hce = { 0 };
+    if (hp)
+      hce = hcache_prefetch_get(&fc, hp, current);
     if (hce.email)
     {
       mutt_debug(LL_DEBUG2, "mutt_hcache_fetch %s\n", buf);
       e = hce.email;
       m->emails[m->msg_count] = e;
-      e->edata = NULL;
+      e->cold->edata = NULL;
 
       /* skip header marked as deleted in cache */
       if (e->deleted && !restore)
@@ -1434,8 +1526,8 @@ static int nntp_fetch_headers(struct Mailbox *m, void *hc, anum_t first, anum_t
     e->read = false;
     e->old = false;
     e->deleted = false;
-    e->edata = nntp_edata_new();
-    e->edata_free = nntp_edata_free;
+    e->cold->edata = nntp_edata_new();
+    e->cold->edata_free = nntp_edata_free;
     nntp_edata_get(e)->article_num = current;
     if (restore)
       e->changed = true;
@@ -1450,6 +1542,14 @@ static int nntp_fetch_headers(struct Mailbox *m, void *hc, anum_t first, anum_t
     first_over = current + 1;
   }
 
+#ifdef USE_HCACHE
+  if (hp)
+  {
+    hcache_prefetch_free(hp);
+    FREE(&hp);
+  }
+#endif
+
   if (!C_NntpListgroup || !mdata->adata->hasLISTGROUP)
     current = first_over;
 
@@ -1613,7 +1713,7 @@ static int check_mailbox(struct Mailbox *m)
 
           mutt_debug(LL_DEBUG2, "#1 mutt_hcache_fetch %s\n", buf);
           e = hce.email;
-          e->edata = NULL;
+          e->cold->edata = NULL;
           deleted = e->deleted;
           flagged = e->flagged;
           email_free(&e);
@@ -1656,11 +1756,11 @@ static int check_mailbox(struct Mailbox *m)
       {
         mutt_debug(LL_DEBUG2, "#2 mutt_hcache_fetch %s\n", buf);
         if (m->msg_count >= m->email_max)
-          mx_alloc_memory(m);
+          mx_alloc_memory(m, m->msg_count + 1);
 
         e = hce.email;
         m->emails[m->msg_count] = e;
-        e->edata = NULL;
+        e->cold->edata = NULL;
         if (e->deleted)
         {
           email_free(&e);
@@ -1675,8 +1775,8 @@ static int check_mailbox(struct Mailbox *m)
         m->msg_count++;
         e->read = false;
         e->old = false;
-        e->edata = nntp_edata_new();
-        e->edata_free = nntp_edata_free;
+        e->cold->edata = nntp_edata_new();
+        e->cold->edata_free = nntp_edata_free;
         nntp_edata_get(e)->article_num = anum;
         nntp_article_status(m, e, NULL, anum);
         if (!e->read)
@@ -2249,11 +2349,11 @@ int nntp_check_msgid(struct Mailbox *m, const char *msgid)
 
   /* parse header */
   if (m->msg_count == m->email_max)
-    mx_alloc_memory(m);
+    mx_alloc_memory(m, m->msg_count + 1);
   m->emails[m->msg_count] = email_new();
   struct Email *e = m->emails[m->msg_count];
-  e->edata = nntp_edata_new();
-  e->edata_free = nntp_edata_free;
+  e->cold->edata = nntp_edata_new();
+  e->cold->edata_free = nntp_edata_free;
   e->env = mutt_rfc822_read_header(fp, e, false, false);
   mutt_file_fclose(&fp);
 
@@ -2890,6 +2990,7 @@ struct MxOps MxNntpOps = {
   .msg_close        = nntp_msg_close,
   .msg_padding_size = NULL,
   .msg_save_hcache  = NULL,
+  .mbox_gc          = NULL,
   .tags_edit        = NULL,
   .tags_commit      = NULL,
   .path_probe       = nntp_path_probe,
@@ -81,7 +81,7 @@ const int NmUrlProtocolLen = sizeof(NmUrlProtocol) - 1;
 static struct HeaderCache *nm_hcache_open(struct Mailbox *m)
 {
 #ifdef USE_HCACHE
-  return mutt_hcache_open(C_HeaderCache, mailbox_path(m), NULL);
+  return mutt_hcache_open(C_HeaderCache, mailbox_path(m), NULL, NULL);
 #else
   return NULL;
 #endif
@@ -266,7 +266,7 @@ struct NmEmailData *nm_edata_get(struct Email *e)
   if (!e)
     return NULL;
 
-  return e->nm_edata;
+  return e->cold->nm_edata;
 }
 
 /**
@@ -341,7 +341,7 @@ static char *email_get_id(struct Email *e)
  */
 static char *email_get_fullpath(struct Email *e, char *buf, size_t buflen)
 {
-  snprintf(buf, buflen, "%s/%s", nm_email_get_folder(e), e->path);
+  snprintf(buf, buflen, "%s/%s", nm_email_get_folder(e), e->cold->path);
   return buf;
 }
 
@@ -651,7 +651,7 @@ static int update_email_tags(struct Email *e, notmuch_message_t *msg)
     mutt_str_append_item(&new_tags, t, ' ');
   }
 
-  old_tags = driver_tags_get(&e->tags);
+  old_tags = driver_tags_get(&e->cold->tags);
 
   if (new_tags && old_tags && (strcmp(old_tags, new_tags) == 0))
   {
@@ -662,14 +662,14 @@ static int update_email_tags(struct Email *e, notmuch_message_t *msg)
   }
 
   /* new version */
-  driver_tags_replace(&e->tags, new_tags);
+  driver_tags_replace(&e->cold->tags, new_tags);
   FREE(&new_tags);
 
-  new_tags = driver_tags_get_transformed(&e->tags);
+  new_tags = driver_tags_get_transformed(&e->cold->tags);
   mutt_debug(LL_DEBUG2, "nm: new tags: '%s'\n", new_tags);
   FREE(&new_tags);
 
-  new_tags = driver_tags_get(&e->tags);
+  new_tags = driver_tags_get(&e->cold->tags);
   mutt_debug(LL_DEBUG2, "nm: new tag transforms: '%s'\n", new_tags);
   FREE(&new_tags);
 
@@ -696,18 +696,18 @@ static int update_message_path(struct Email *e, const char *path)
   {
     edata->type = MUTT_MAILDIR;
 
-    FREE(&e->path);
+    FREE(&e->cold->path);
     FREE(&edata->folder);
 
     p -= 3; /* skip subfolder (e.g. "new") */
-    e->path = mutt_str_dup(p);
+    e->cold->path = mutt_str_dup(p);
 
     for (; (p > path) && (*(p - 1) == '/'); p--)
       ; // do nothing
 
     edata->folder = mutt_strn_dup(path, p - path);
 
-    mutt_debug(LL_DEBUG2, "nm: folder='%s', file='%s'\n", edata->folder, e->path);
+    mutt_debug(LL_DEBUG2, "nm: folder='%s', file='%s'\n", edata->folder, e->cold->path);
     return 0;
   }
 
@@ -773,7 +773,7 @@ static int init_email(struct Email *e, const char *path, notmuch_message_t *msg)
     return 0;
 
   struct NmEmailData *edata = nm_edata_new();
-  e->nm_edata = edata;
+  e->cold->nm_edata = edata;
 
   /* Notmuch ensures that message Id exists (if not notmuch Notmuch will
    * generate an ID), so it's more safe than use neomutt Email->env->id */
@@ -942,7 +942,7 @@ static void append_message(struct HeaderCache *h, struct Mailbox *m,
   if (m->msg_count >= m->email_max)
   {
     mutt_debug(LL_DEBUG2, "nm: allocate mx memory\n");
-    mx_alloc_memory(m);
+    mx_alloc_memory(m, m->msg_count + 1);
   }
 
 #ifdef USE_HCACHE
@@ -1092,6 +1092,28 @@ static notmuch_messages_t *get_messages(notmuch_query_t *query)
   return msgs;
 }
 
+/**
+ * count_messages - Count the messages matching a query
+ * @param q Notmuch query
+ * @retval num Number of messages
+ */
+static unsigned int count_messages(notmuch_query_t *q)
+{
+  unsigned int res = 0;
+
+#if LIBNOTMUCH_CHECK_VERSION(5, 0, 0)
+  if (notmuch_query_count_messages(q, &res) != NOTMUCH_STATUS_SUCCESS)
+    res = 0; /* may not be defined on error */
+#elif LIBNOTMUCH_CHECK_VERSION(4, 3, 0)
+  if (notmuch_query_count_messages_st(q, &res) != NOTMUCH_STATUS_SUCCESS)
+    res = 0; /* may not be defined on error */
+#else
+  res = notmuch_query_count_messages(q);
+#endif
+
+  return res;
+}
+
 /**
  * read_mesgs_query - Search for matching messages
  * @param m     Mailbox
@@ -1108,6 +1130,13 @@ static bool read_mesgs_query(struct Mailbox *m, notmuch_query_t *q, bool dedup)
 
   int limit = get_limit(mdata);
 
+  /* Make room for all the results at once */
+  unsigned int count = count_messages(q);
+  if ((limit > 0) && (count > limit))
+    count = limit;
+  if (count < (INT_MAX - m->msg_count))
+    mx_alloc_memory(m, m->msg_count + count);
+
   notmuch_messages_t *msgs = get_messages(q);
 
   if (!msgs)
@@ -1580,7 +1609,7 @@ static int rename_filename(struct Mailbox *m, const char *old_file,
     notmuch_message_maildir_flags_to_tags(msg);
     update_email_tags(e, msg);
 
-    char *tags = driver_tags_get(&e->tags);
+    char *tags = driver_tags_get(&e->cold->tags);
     update_tags(msg, tags);
     FREE(&tags);
   }
@@ -1607,18 +1636,8 @@ static unsigned int count_query(notmuch_database_t *db, const char *qstr, int li
   if (!q)
     return 0;
 
-  unsigned int res = 0;
-
   apply_exclude_tags(q);
-#if LIBNOTMUCH_CHECK_VERSION(5, 0, 0)
-  if (notmuch_query_count_messages(q, &res) != NOTMUCH_STATUS_SUCCESS)
-    res = 0; /* may not be defined on error */
-#elif LIBNOTMUCH_CHECK_VERSION(4, 3, 0)
-  if (notmuch_query_count_messages_st(q, &res) != NOTMUCH_STATUS_SUCCESS)
-    res = 0; /* may not be defined on error */
-#else
-  res = notmuch_query_count_messages(q);
-#endif
+  unsigned int res = count_messages(q);
   notmuch_query_destroy(q);
   mutt_debug(LL_DEBUG1, "nm: count '%s', result=%d\n", qstr, res);
 
@@ -1981,8 +2000,7 @@ static int nm_mbox_check_stats(struct Mailbox *m, int flags)
 
   /* all emails */
   m->msg_count = count_query(db, db_query, limit);
-  while (m->email_max < m->msg_count)
-    mx_alloc_memory(m);
+  mx_alloc_memory(m, m->msg_count);
 
   // holder variable for extending query to unread/flagged
   char *qstr = NULL;
@@ -2054,7 +2072,7 @@ int nm_record_message(struct Mailbox *m, char *path, struct Email *e)
     notmuch_message_maildir_flags_to_tags(msg);
     if (e)
     {
-      char *tags = driver_tags_get(&e->tags);
+      char *tags = driver_tags_get(&e->cold->tags);
       update_tags(msg, tags);
       FREE(&tags);
     }
@@ -2293,11 +2311,12 @@ static int nm_mbox_check(struct Mailbox *m)
     {
       /* if the user hasn't modified the flags on this message, update the
        * flags we just detected.  */
-      struct Email e_tmp = { 0 };
-      e_tmp.edata = maildir_edata_new();
-      maildir_parse_flags(&e_tmp, new_file);
-      maildir_update_flags(m, e, &e_tmp);
-      maildir_edata_free(&e_tmp.edata);
+      struct Email *e_tmp = email_new();
+      e_tmp->cold->edata = maildir_edata_new();
+      e_tmp->cold->edata_free = maildir_edata_free;
+      maildir_parse_flags(e_tmp, new_file);
+      maildir_update_flags(m, e, e_tmp);
+      email_free(&e_tmp);
     }
 
     if (update_email_tags(e, msg) == 0)
@@ -2459,12 +2478,12 @@ static int nm_msg_open(struct Mailbox *m, struct Message *msg, int msgno)
   char path[PATH_MAX];
   char *folder = nm_email_get_folder(e);
 
-  snprintf(path, sizeof(path), "%s/%s", folder, e->path);
+  snprintf(path, sizeof(path), "%s/%s", folder, e->cold->path);
 
   msg->fp = fopen(path, "r");
   if (!msg->fp && (errno == ENOENT) && ((m->type == MUTT_MAILDIR) || (m->type == MUTT_NOTMUCH)))
   {
-    msg->fp = maildir_open_find_message(folder, e->path, NULL);
+    msg->fp = maildir_open_find_message(folder, e->cold->path, NULL);
   }
 
   if (!msg->fp)
@@ -2606,6 +2625,7 @@ struct MxOps MxNotmuchOps = {
   .msg_close        = nm_msg_close,
   .msg_padding_size = NULL,
   .msg_save_hcache  = NULL,
+  .mbox_gc          = NULL,
   .tags_edit        = nm_tags_edit,
   .tags_commit      = nm_tags_commit,
   .path_probe       = nm_path_probe,
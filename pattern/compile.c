@@ -70,6 +70,22 @@ enum EatRangeError
   RANGE_E_CTX,    ///< Range requires Context, but none available
 };
 
+/**
+ * enum PatternCost - Estimated cost of matching a Pattern against an Email
+ *
+ * The operands of an AND or OR are reordered so that the cheap tests are done
+ * first, see pattern_sort_children().
+ */
+enum PatternCost
+{
+  COST_FLAG,    ///< Test a flag or a number in the Email
+  COST_HEADER,  ///< Compare a header field with a string
+  COST_ADDRESS, ///< Compare an Address list with a string
+  COST_REGEX,   ///< Match a header field or Address list with a regex
+  COST_THREAD,  ///< Match the other Emails in the thread
+  COST_MESSAGE, ///< Open the message and read it
+};
+
 #define KILO 1024
 #define MEGA 1048576
 
@@ -1046,6 +1062,114 @@ static struct PatternList *mutt_pattern_node_new(void)
   return h;
 }
 
+/**
+ * pattern_cost - Estimate the cost of matching a Pattern
+ * @param pat Pattern
+ * @retval enum #PatternCost, e.g. #COST_FLAG
+ *
+ * A logical operation costs as much as its most expensive operand.
+ */
+static enum PatternCost pattern_cost(const struct Pattern *pat)
+{
+  const bool regex = !pat->string_match && !pat->group_match && !pat->is_multi;
+  enum PatternCost cost = COST_FLAG;
+  const struct Pattern *np = NULL;
+
+  switch (pat->op)
+  {
+    case MUTT_PAT_AND:
+    case MUTT_PAT_OR:
+      SLIST_FOREACH(np, pat->child, entries)
+      {
+        cost = MAX(cost, pattern_cost(np));
+      }
+      return cost;
+
+    case MUTT_PAT_THREAD:
+    case MUTT_PAT_PARENT:
+    case MUTT_PAT_CHILDREN:
+      SLIST_FOREACH(np, pat->child, entries)
+      {
+        cost = MAX(cost, pattern_cost(np));
+      }
+      return MAX(cost, COST_THREAD);
+
+    case MUTT_PAT_SUBJECT:
+    case MUTT_PAT_ID:
+    case MUTT_PAT_ID_EXTERNAL:
+    case MUTT_PAT_REFERENCE:
+    case MUTT_PAT_XLABEL:
+    case MUTT_PAT_DRIVER_TAGS:
+    case MUTT_PAT_HORMEL:
+#ifdef USE_NNTP
+    case MUTT_PAT_NEWSGROUPS:
+#endif
+      return regex ? COST_REGEX : COST_HEADER;
+
+    case MUTT_PAT_SENDER:
+    case MUTT_PAT_FROM:
+    case MUTT_PAT_TO:
+    case MUTT_PAT_CC:
+    case MUTT_PAT_ADDRESS:
+    case MUTT_PAT_RECIPIENT:
+      return regex ? COST_REGEX : COST_ADDRESS;
+
+    case MUTT_PAT_LIST:
+    case MUTT_PAT_SUBSCRIBED_LIST:
+    case MUTT_PAT_PERSONAL_RECIP:
+    case MUTT_PAT_PERSONAL_FROM:
+      return COST_ADDRESS;
+
+    case MUTT_PAT_BODY:
+    case MUTT_PAT_HEADER:
+    case MUTT_PAT_WHOLE_MSG:
+    case MUTT_PAT_MIMEATTACH:
+    case MUTT_PAT_MIMETYPE:
+      return COST_MESSAGE;
+
+    default:
+      return COST_FLAG;
+  }
+}
+
+/**
+ * pattern_sort_children - Put the cheapest operands of a logical operation first
+ * @param pat AND or OR Pattern
+ *
+ * Matching stops at the first operand that decides the result, so testing the
+ * cheap operands first avoids most of the expensive ones, e.g. `~b foo ~F` only
+ * reads the bodies of the flagged emails.  The sort is stable, so operands of
+ * equal cost keep the order they were written in.
+ */
+static void pattern_sort_children(struct Pattern *pat)
+{
+  struct PatternList sorted = SLIST_HEAD_INITIALIZER(sorted);
+
+  while (!SLIST_EMPTY(pat->child))
+  {
+    struct Pattern *np = SLIST_FIRST(pat->child);
+    SLIST_REMOVE_HEAD(pat->child, entries);
+    const enum PatternCost cost = pattern_cost(np);
+
+    /* Insert after the last operand that's no more expensive */
+    struct Pattern *prev = NULL;
+    struct Pattern *tp = NULL;
+    SLIST_FOREACH(tp, &sorted, entries)
+    {
+      if (pattern_cost(tp) > cost)
+        break;
+      prev = tp;
+    }
+
+    if (prev)
+      SLIST_INSERT_AFTER(prev, np, entries);
+    else
+      SLIST_INSERT_HEAD(&sorted, np, entries);
+  }
+
+  *pat->child = sorted;
+}
+
 /**
  * mutt_pattern_comp - Create a Pattern
  * @param s     Pattern string
@@ -1116,6 +1240,7 @@ struct PatternList *mutt_pattern_comp(const char *s, PatternCompFlags flags, str
             pat = SLIST_FIRST(tmp);
             pat->op = MUTT_PAT_AND;
             pat->child = curlist;
+            pattern_sort_children(pat);
 
             curlist = tmp;
             last = curlist;
@@ -1191,6 +1316,7 @@ struct PatternList *mutt_pattern_comp(const char *s, PatternCompFlags flags, str
           pat = SLIST_FIRST(tmp);
           pat->op = MUTT_PAT_OR;
           pat->child = curlist;
+          pattern_sort_children(pat);
           curlist = tmp;
           last = tmp;
           pat_or = false;
@@ -1321,6 +1447,7 @@ struct PatternList *mutt_pattern_comp(const char *s, PatternCompFlags flags, str
     struct Pattern *pat = SLIST_FIRST(tmp);
     pat->op = pat_or ? MUTT_PAT_OR : MUTT_PAT_AND;
     pat->child = curlist;
+    pattern_sort_children(pat);
     curlist = tmp;
   }
 
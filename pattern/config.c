@@ -34,6 +34,9 @@
 // clang-format off
 char *C_ExternalSearchCommand = NULL; ///< Config: External search command
 char *C_PatternFormat = NULL;         ///< Config: printf-like format string for the pattern completion menu
+#ifdef USE_PTHREADS
+short C_SearchThreads;                ///< Config: Number of threads used to match patterns
+#endif
 bool  C_ThoroughSearch;               ///< Config: Decode headers and messages before searching them
 // clang-format on
 
@@ -45,6 +48,11 @@ struct ConfigDef PatternVars[] = {
   { "pattern_format", DT_STRING, &C_PatternFormat, IP "%2n %-15e  %d", 0, NULL,
     "printf-like format string for the pattern completion menu"
   },
+#ifdef USE_PTHREADS
+  { "search_threads", DT_NUMBER|DT_NOT_NEGATIVE, &C_SearchThreads, 0, 0, NULL,
+    "Number of threads used to match patterns"
+  },
+#endif
   { "thorough_search", DT_BOOL, &C_ThoroughSearch, true, 0, NULL,
     "Decode headers and messages before searching them"
   },
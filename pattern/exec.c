@@ -94,159 +94,419 @@ static void print_crypt_pattern_op_error(int op)
 }
 
 /**
- * msg_search - Search an email
+ * struct SearchStream - Match a Pattern against a stream of text
+ *
+ * The text arrives in chunks of any size.  It's matched a line at a time, so
+ * a line that's split between two chunks is kept until it's complete.
+ */
+struct SearchStream
+{
+  struct Pattern *pat; ///< Pattern to find
+  struct Buffer line;  ///< Incomplete line from the previous chunk
+  struct Buffer field; ///< Unfolded header field, for #MUTT_PAT_HEADER
+  bool eoh;            ///< End of the header, for #MUTT_PAT_HEADER
+  bool match;          ///< Pattern found
+};
+
+/**
+ * search_stream_field - Match a complete header field
+ * @param ss Search stream
+ */
+static void search_stream_field(struct SearchStream *ss)
+{
+  if (mutt_buffer_is_empty(&ss->field))
+    return;
+
+  ss->match = patmatch(ss->pat, mutt_b2s(&ss->field));
+  mutt_buffer_reset(&ss->field);
+}
+
+/**
+ * search_stream_line - Match a complete line
+ * @param ss Search stream
+ *
+ * Header fields are unfolded first, like mutt_rfc822_read_line().
+ */
+static void search_stream_line(struct SearchStream *ss)
+{
+  char *line = ss->line.data;
+
+  if (ss->pat->op != MUTT_PAT_HEADER)
+  {
+    ss->match = patmatch(ss->pat, line);
+    return;
+  }
+
+  if (((*line == ' ') || (*line == '\t')) && !mutt_buffer_is_empty(&ss->field))
+  {
+    /* continuation line */
+    mutt_buffer_addch(&ss->field, ' ');
+    mutt_buffer_addstr(&ss->field, line + strspn(line, " \t"));
+  }
+  else
+  {
+    search_stream_field(ss);
+    if (IS_SPACE(*line))
+    {
+      ss->eoh = true;
+      return;
+    }
+    mutt_buffer_strcpy(&ss->field, line);
+  }
+
+  mutt_str_remove_trailing_ws(ss->field.data);
+  mutt_buffer_fix_dptr(&ss->field);
+}
+
+/**
+ * search_stream_add - Match the next chunk of text
+ * @param ss  Search stream
+ * @param buf Text
+ * @param len Length of the text
+ * @retval true  Finished, the Pattern has matched or the header has ended
+ * @retval false More text is needed
+ */
+static bool search_stream_add(struct SearchStream *ss, const char *buf, size_t len)
+{
+  const char *end = buf + len;
+
+  while (!ss->match && !ss->eoh && (buf < end))
+  {
+    const char *nl = memchr(buf, '\n', end - buf);
+    if (!nl)
+    {
+      mutt_buffer_addstr_n(&ss->line, buf, end - buf);
+      break;
+    }
+
+    mutt_buffer_addstr_n(&ss->line, buf, nl + 1 - buf);
+    search_stream_line(ss);
+    mutt_buffer_reset(&ss->line);
+    buf = nl + 1;
+  }
+
+  return ss->match || ss->eoh;
+}
+
+/**
+ * search_stream_finish - Match the end of the text
+ * @param ss Search stream
+ * @retval true Pattern found
+ *
+ * The Buffers are freed.
+ */
+static bool search_stream_finish(struct SearchStream *ss)
+{
+  if (!ss->match && !ss->eoh && !mutt_buffer_is_empty(&ss->line))
+    search_stream_line(ss);
+  if (!ss->match && !ss->eoh)
+    search_stream_field(ss);
+
+  mutt_buffer_dealloc(&ss->line);
+  mutt_buffer_dealloc(&ss->field);
+  return ss->match;
+}
+
+/**
+ * search_lines - Search the lines of a file
+ * @param pat Pattern to find
+ * @param fp  File to search, at the start of the text
+ * @param len Length of the text
+ * @retval true Pattern found
+ */
+static bool search_lines(struct Pattern *pat, FILE *fp, long len)
+{
+  struct SearchStream ss = { .pat = pat };
+  char chunk[4096];
+
+  /* search the file "fp" */
+  while (len > 0)
+  {
+    const size_t bytes = fread(chunk, 1, MIN((long) sizeof(chunk), len), fp);
+    if (bytes == 0)
+      break; /* don't loop forever */
+    if (search_stream_add(&ss, chunk, bytes))
+      break;
+    len -= bytes;
+  }
+
+  return search_stream_finish(&ss);
+}
+
+/**
+ * seek_raw - Find the raw header / body of an email
+ * @param pat Pattern to find
+ * @param fp  File containing the email
+ * @param e   Email
+ * @retval num Length of the text to search
+ */
+static long seek_raw(struct Pattern *pat, FILE *fp, struct Email *e)
+{
+  long len = 0;
+
+  if (pat->op != MUTT_PAT_BODY)
+  {
+    fseeko(fp, e->cold->offset, SEEK_SET);
+    len = e->content->offset - e->cold->offset;
+  }
+  if (pat->op != MUTT_PAT_HEADER)
+  {
+    if (pat->op == MUTT_PAT_BODY)
+      fseeko(fp, e->content->offset, SEEK_SET);
+    len += e->content->length;
+  }
+
+  return len;
+}
+
+/**
+ * msg_search_worker - Search an email from a worker thread
  * @param m   Mailbox
+ * @param pat Pattern to find
+ * @param e   Email
+ * @retval  1 Pattern found
+ * @retval  0 Pattern not found
+ * @retval -1 The email couldn't be opened
+ *
+ * The workers share the Mailbox, so the email is read using its own file
+ * handle.  It isn't decoded, see pattern_thread_safe().
+ *
+ * If the file can't be opened, e.g. another client has renamed it, the main
+ * thread must match the email, because it knows how to find it again.
+ */
+static int msg_search_worker(struct Mailbox *m, struct Pattern *pat, struct Email *e)
+{
+  struct Buffer *path = mutt_buffer_pool_get();
+  if ((m->type == MUTT_MAILDIR) || (m->type == MUTT_MH))
+    mutt_buffer_printf(path, "%s/%s", mailbox_path(m), e->cold->path);
+  else
+    mutt_buffer_strcpy(path, mailbox_path(m));
+
+  int match = -1;
+  FILE *fp = fopen(mutt_b2s(path), "r");
+  if (fp)
+  {
+    match = search_lines(pat, fp, seek_raw(pat, fp, e));
+    fclose(fp);
+  }
+  else
+  {
+    mutt_debug(LL_DEBUG1, "Can't open %s\n", mutt_b2s(path));
+  }
+
+  mutt_buffer_pool_release(&path);
+  return match;
+}
+
+/**
+ * decode_message - Decode the header / body of an email
+ * @param m      Mailbox
+ * @param pat    Pattern to find
+ * @param e      Email
+ * @param fp_in  File containing the email
+ * @param fp_out File for the decoded text
+ * @retval true  Success
+ * @retval false The email couldn't be decrypted
+ */
+static bool decode_message(struct Mailbox *m, struct Pattern *pat,
+                           struct Email *e, FILE *fp_in, FILE *fp_out)
+{
+  struct State s = { 0 };
+  s.fp_in = fp_in;
+  s.fp_out = fp_out;
+  s.flags = MUTT_CHARCONV;
+
+  if (pat->op != MUTT_PAT_BODY)
+    mutt_copy_header(fp_in, e, fp_out, CH_FROM | CH_DECODE, NULL, 0);
+
+  if (pat->op != MUTT_PAT_HEADER)
+  {
+    mutt_parse_mime_message(m, e);
+
+    if ((WithCrypto != 0) && (e->security & SEC_ENCRYPT) &&
+        !crypt_valid_passphrase(e->security))
+    {
+      return false;
+    }
+
+    fseeko(fp_in, e->cold->offset, SEEK_SET);
+    mutt_body_handler(e->content, &s);
+  }
+
+  return true;
+}
+
+#if defined(HAVE_FOPENCOOKIE) || defined(HAVE_FUNOPEN)
+/**
+ * search_stream_write - Match the text written to a stream
+ * @param cookie Search stream
+ * @param buf    Text
+ * @param size   Length of the text
+ * @retval num Number of bytes consumed, always all of them
+ *
+ * Once the Pattern has matched, the rest of the text is thrown away.
+ */
+#ifdef HAVE_FOPENCOOKIE
+static ssize_t search_stream_write(void *cookie, const char *buf, size_t size)
+#else
+static int search_stream_write(void *cookie, const char *buf, int size)
+#endif
+{
+  search_stream_add(cookie, buf, size);
+  return size;
+}
+
+/**
+ * search_decoded - Search the decoded text of an email
+ * @param m     Mailbox
  * @param pat   Pattern to find
- * @param msgno Message to search
+ * @param e     Email
+ * @param fp_in File containing the email
  * @retval true Pattern found
- * @retval false Error or pattern not found
+ *
+ * The decoded text is matched as it's written, so it's never stored.
  */
-static bool msg_search(struct Mailbox *m, struct Pattern *pat, int msgno)
+static bool search_decoded(struct Mailbox *m, struct Pattern *pat,
+                           struct Email *e, FILE *fp_in)
 {
-  bool match = false;
-  struct Message *msg = mx_msg_open(m, msgno);
-  if (!msg)
+  struct SearchStream ss = { .pat = pat };
+
+#ifdef HAVE_FOPENCOOKIE
+  cookie_io_functions_t io = { .write = search_stream_write };
+  FILE *fp_out = fopencookie(&ss, "w", io);
+#else
+  FILE *fp_out = funopen(&ss, NULL, search_stream_write, NULL, NULL);
+#endif
+  if (!fp_out)
   {
-    return match;
+    mutt_perror(_("Error opening 'memory stream'"));
+    return false;
   }
 
+  const bool decoded = decode_message(m, pat, e, fp_in, fp_out);
+  mutt_file_fclose(&fp_out);
+  const bool match = search_stream_finish(&ss);
+  return decoded && match;
+}
+#else
+/**
+ * search_decoded - Search the decoded text of an email
+ * @param m     Mailbox
+ * @param pat   Pattern to find
+ * @param e     Email
+ * @param fp_in File containing the email
+ * @retval true Pattern found
+ *
+ * The decoded text is written to a temporary file, then searched.
+ */
+static bool search_decoded(struct Mailbox *m, struct Pattern *pat,
+                           struct Email *e, FILE *fp_in)
+{
+  bool match = false;
   FILE *fp = NULL;
   long len = 0;
-  struct Email *e = m->emails[msgno];
 #ifdef USE_FMEMOPEN
   char *temp = NULL;
   size_t tempsize = 0;
+
+  FILE *fp_out = open_memstream(&temp, &tempsize);
+  if (!fp_out)
+  {
+    mutt_perror(_("Error opening 'memory stream'"));
+    return false;
+  }
 #else
   struct stat st;
+
+  FILE *fp_out = mutt_file_mkstemp();
+  if (!fp_out)
+  {
+    mutt_perror(_("Can't create temporary file"));
+    return false;
+  }
 #endif
 
-  if (C_ThoroughSearch)
+  if (!decode_message(m, pat, e, fp_in, fp_out))
   {
-    /* decode the header / body */
-    struct State s = { 0 };
-    s.fp_in = msg->fp;
-    s.flags = MUTT_CHARCONV;
+    mutt_file_fclose(&fp_out);
+#ifdef USE_FMEMOPEN
+    FREE(&temp);
+#endif
+    return false;
+  }
+
 #ifdef USE_FMEMOPEN
-    s.fp_out = open_memstream(&temp, &tempsize);
-    if (!s.fp_out)
+  mutt_file_fclose(&fp_out);
+  len = tempsize;
+
+  if (tempsize != 0)
+  {
+    fp = fmemopen(temp, tempsize, "r");
+    if (!fp)
     {
-      mutt_perror(_("Error opening 'memory stream'"));
+      mutt_perror(_("Error re-opening 'memory stream'"));
+      FREE(&temp);
       return false;
     }
-#else
-    s.fp_out = mutt_file_mkstemp();
-    if (!s.fp_out)
+  }
+  else
+  { /* fmemopen can't handle empty buffers */
+    fp = mutt_file_fopen("/dev/null", "r");
+    if (!fp)
     {
-      mutt_perror(_("Can't create temporary file"));
+      mutt_perror(_("Error opening /dev/null"));
       return false;
     }
+  }
+#else
+  fp = fp_out;
+  fflush(fp);
+  fseek(fp, 0, SEEK_SET);
+  fstat(fileno(fp), &st);
+  len = (long) st.st_size;
 #endif
 
-    if (pat->op != MUTT_PAT_BODY)
-      mutt_copy_header(msg->fp, e, s.fp_out, CH_FROM | CH_DECODE, NULL, 0);
-
-    if (pat->op != MUTT_PAT_HEADER)
-    {
-      mutt_parse_mime_message(m, e);
+  match = search_lines(pat, fp, len);
+  mutt_file_fclose(&fp);
 
-      if ((WithCrypto != 0) && (e->security & SEC_ENCRYPT) &&
-          !crypt_valid_passphrase(e->security))
-      {
-        mx_msg_close(m, &msg);
-        if (s.fp_out)
-        {
-          mutt_file_fclose(&s.fp_out);
 #ifdef USE_FMEMOPEN
-          FREE(&temp);
+  FREE(&temp);
+#endif
+  return match;
+}
 #endif
-        }
-        return false;
-      }
 
-      fseeko(msg->fp, e->offset, SEEK_SET);
-      mutt_body_handler(e->content, &s);
-    }
+/**
+ * msg_search - Search an email
+ * @param m   Mailbox
+ * @param pat   Pattern to find
+ * @param msgno Message to search
+ * @retval true Pattern found
+ * @retval false Error or pattern not found
+ */
+static bool msg_search(struct Mailbox *m, struct Pattern *pat, int msgno)
+{
+  bool match = false;
+  struct Message *msg = mx_msg_open(m, msgno);
+  if (!msg)
+  {
+    return match;
+  }
 
-#ifdef USE_FMEMOPEN
-    mutt_file_fclose(&s.fp_out);
-    len = tempsize;
+  struct Email *e = m->emails[msgno];
 
-    if (tempsize != 0)
-    {
-      fp = fmemopen(temp, tempsize, "r");
-      if (!fp)
-      {
-        mutt_perror(_("Error re-opening 'memory stream'"));
-        FREE(&temp);
-        return false;
-      }
-    }
-    else
-    { /* fmemopen can't handle empty buffers */
-      fp = mutt_file_fopen("/dev/null", "r");
-      if (!fp)
-      {
-        mutt_perror(_("Error opening /dev/null"));
-        return false;
-      }
-    }
-#else
-    fp = s.fp_out;
-    fflush(fp);
-    fseek(fp, 0, SEEK_SET);
-    fstat(fileno(fp), &st);
-    len = (long) st.st_size;
-#endif
+  if (C_ThoroughSearch)
+  {
+    /* decoded header / body */
+    match = search_decoded(m, pat, e, msg->fp);
   }
   else
   {
     /* raw header / body */
-    fp = msg->fp;
-    if (pat->op != MUTT_PAT_BODY)
-    {
-      fseeko(fp, e->offset, SEEK_SET);
-      len = e->content->offset - e->offset;
-    }
-    if (pat->op != MUTT_PAT_HEADER)
-    {
-      if (pat->op == MUTT_PAT_BODY)
-        fseeko(fp, e->content->offset, SEEK_SET);
-      len += e->content->length;
-    }
-  }
-
-  size_t blen = 256;
-  char *buf = mutt_mem_malloc(blen);
-
-  /* search the file "fp" */
-  while (len > 0)
-  {
-    if (pat->op == MUTT_PAT_HEADER)
-    {
-      buf = mutt_rfc822_read_line(fp, buf, &blen);
-      if (*buf == '\0')
-        break;
-    }
-    else if (!fgets(buf, blen - 1, fp))
-      break; /* don't loop forever */
-    if (patmatch(pat, buf))
-    {
-      match = true;
-      break;
-    }
-    len -= mutt_str_len(buf);
+    match = search_lines(pat, msg->fp, seek_raw(pat, msg->fp, e));
   }
 
-  FREE(&buf);
-
   mx_msg_close(m, &msg);
-
-  if (C_ThoroughSearch)
-    mutt_file_fclose(&fp);
-
-#ifdef USE_FMEMOPEN
-  FREE(&temp);
-#endif
   return match;
 }
 
@@ -257,19 +517,25 @@ static bool msg_search(struct Mailbox *m, struct Pattern *pat, int msgno)
  * @param m   Mailbox
  * @param e   Email
  * @param cache Cached Patterns
- * @retval true If ALL of the Patterns evaluates to true
+ * @retval  1 If ALL of the Patterns evaluates to true
+ * @retval  0 If ONE (or more) of the Patterns evaluates to false
+ * @retval -1 A worker couldn't match a Pattern, see #MUTT_MATCH_WORKER
  */
-static bool perform_and(struct PatternList *pat, PatternExecFlags flags,
-                        struct Mailbox *m, struct Email *e, struct PatternCache *cache)
+static int perform_and(struct PatternList *pat, PatternExecFlags flags,
+                       struct Mailbox *m, struct Email *e, struct PatternCache *cache)
 {
   struct Pattern *p = NULL;
+  bool unknown = false;
 
   SLIST_FOREACH(p, pat, entries)
   {
-    if (mutt_pattern_exec(p, flags, m, e, cache) <= 0)
+    int rc = mutt_pattern_exec(p, flags, m, e, cache);
+    if ((rc < 0) && (flags & MUTT_MATCH_WORKER))
+      unknown = true;
+    else if (rc <= 0)
       return false;
   }
-  return true;
+  return unknown ? -1 : true;
 }
 
 /**
@@ -279,19 +545,25 @@ static bool perform_and(struct PatternList *pat, PatternExecFlags flags,
  * @param m   Mailbox
  * @param e   Email
  * @param cache Cached Patterns
- * @retval true If ONE (or more) of the Patterns evaluates to true
+ * @retval  1 If ONE (or more) of the Patterns evaluates to true
+ * @retval  0 If ALL of the Patterns evaluates to false
+ * @retval -1 A worker couldn't match a Pattern, see #MUTT_MATCH_WORKER
  */
 static int perform_or(struct PatternList *pat, PatternExecFlags flags,
                       struct Mailbox *m, struct Email *e, struct PatternCache *cache)
 {
   struct Pattern *p = NULL;
+  bool unknown = false;
 
   SLIST_FOREACH(p, pat, entries)
   {
-    if (mutt_pattern_exec(p, flags, m, e, cache) > 0)
+    int rc = mutt_pattern_exec(p, flags, m, e, cache);
+    if (rc > 0)
       return true;
+    if ((rc < 0) && (flags & MUTT_MATCH_WORKER))
+      unknown = true;
   }
-  return false;
+  return unknown ? -1 : false;
 }
 
 /**
@@ -676,6 +948,72 @@ static int msg_search_sendmode(struct Email *e, struct Pattern *pat)
   return match;
 }
 
+/**
+ * pattern_thread_safe - Can a Pattern be matched by a worker thread?
+ * @param[in]  pat  Pattern to check
+ * @param[out] body Set to true if the Pattern searches the body of an email
+ * @retval true The Pattern may be matched using #MUTT_MATCH_WORKER
+ *
+ * Worker threads may only read the Email they're matching.  Patterns that
+ * look at other Emails, change the Pattern or the Email's structure, or may
+ * report an error, must be matched by the main thread.
+ *
+ * A worker doesn't decode the email it's searching.  If $thorough_search is
+ * set, headers can't be searched, and bodies may only be searched if they
+ * don't need decoding, see mutt_body_is_verbatim().
+ */
+bool pattern_thread_safe(const struct PatternList *pat, bool *body)
+{
+  const struct Pattern *np = NULL;
+  SLIST_FOREACH(np, pat, entries)
+  {
+    switch (np->op)
+    {
+      case MUTT_PAT_AND:
+      case MUTT_PAT_OR:
+        if (!pattern_thread_safe(np->child, body))
+          return false;
+        break;
+      case MUTT_PAT_BODY:
+        if (np->sendmode)
+          return false;
+        *body = true;
+        break;
+      case MUTT_PAT_HEADER:
+      case MUTT_PAT_WHOLE_MSG:
+        if (np->sendmode || C_ThoroughSearch)
+          return false;
+        break;
+      case MUTT_PAT_DATE:
+      case MUTT_PAT_DATE_RECEIVED:
+        if (np->dynamic)
+          return false;
+        break;
+      case MUTT_PAT_CRYPT_SIGN:
+      case MUTT_PAT_CRYPT_VERIFIED:
+      case MUTT_PAT_CRYPT_ENCRYPT:
+        if (!WithCrypto)
+          return false;
+        break;
+      case MUTT_PAT_PGP_KEY:
+        if (!(WithCrypto & APPLICATION_PGP))
+          return false;
+        break;
+      case MUTT_PAT_THREAD:
+      case MUTT_PAT_PARENT:
+      case MUTT_PAT_CHILDREN:
+      case MUTT_PAT_SERVERSEARCH:
+      case MUTT_PAT_MIMEATTACH:
+      case MUTT_PAT_MIMETYPE:
+        return false;
+      default:
+        break;
+    }
+  }
+
+  return true;
+}
+
 /**
  * mutt_pattern_exec - Match a pattern against an email header
  * @param pat   Pattern to match
@@ -685,7 +1023,7 @@ static int msg_search_sendmode(struct Email *e, struct Pattern *pat)
  * @param cache Cache for common Patterns
  * @retval  1 Success, pattern matched
  * @retval  0 Pattern did not match
- * @retval -1 Error
+ * @retval -1 Error, or a worker couldn't decide, see #MUTT_MATCH_WORKER
  *
  * flags: MUTT_MATCH_FULL_ADDRESS - match both personal and machine address
  * cache: For repeated matches against the same Header, passing in non-NULL will
@@ -694,12 +1032,20 @@ static int msg_search_sendmode(struct Email *e, struct Pattern *pat)
 int mutt_pattern_exec(struct Pattern *pat, PatternExecFlags flags,
                       struct Mailbox *m, struct Email *e, struct PatternCache *cache)
 {
+  int rc;
+
   switch (pat->op)
   {
     case MUTT_PAT_AND:
-      return pat->pat_not ^ (perform_and(pat->child, flags, m, e, cache) > 0);
+      rc = perform_and(pat->child, flags, m, e, cache);
+      if (rc < 0)
+        return -1;
+      return pat->pat_not ^ (rc > 0);
     case MUTT_PAT_OR:
-      return pat->pat_not ^ (perform_or(pat->child, flags, m, e, cache) > 0);
+      rc = perform_or(pat->child, flags, m, e, cache);
+      if (rc < 0)
+        return -1;
+      return pat->pat_not ^ (rc > 0);
     case MUTT_PAT_THREAD:
       return pat->pat_not ^
              match_threadcomplete(pat->child, flags, m, e->thread, 1, 1, 1, 1);
@@ -753,6 +1099,13 @@ int mutt_pattern_exec(struct Pattern *pat, PatternExecFlags flags,
        * This is also the case when message scoring.  */
       if (!m)
         return 0;
+      if (flags & MUTT_MATCH_WORKER)
+      {
+        rc = msg_search_worker(m, pat, e);
+        if (rc < 0)
+          return -1;
+        return pat->pat_not ^ rc;
+      }
 #ifdef USE_IMAP
       /* IMAP search sets e->matched at search compile time */
       if ((m->type == MUTT_IMAP) && pat->string_match)
@@ -778,6 +1131,7 @@ int mutt_pattern_exec(struct Pattern *pat, PatternExecFlags flags,
     case MUTT_PAT_SENDER:
       if (!e->env)
         return 0;
+      mutt_env_lazy_restore(e->env);
       return pat->pat_not ^ match_addrlist(pat, (flags & MUTT_MATCH_FULL_ADDRESS),
                                            1, &e->env->sender);
     case MUTT_PAT_FROM:
@@ -819,6 +1173,7 @@ int mutt_pattern_exec(struct Pattern *pat, PatternExecFlags flags,
     case MUTT_PAT_ADDRESS:
       if (!e->env)
         return 0;
+      mutt_env_lazy_restore(e->env);
       return pat->pat_not ^ match_addrlist(pat, (flags & MUTT_MATCH_FULL_ADDRESS),
                                            4, &e->env->from, &e->env->sender,
                                            &e->env->to, &e->env->cc);
@@ -943,7 +1298,7 @@ int mutt_pattern_exec(struct Pattern *pat, PatternExecFlags flags,
       return pat->pat_not ^ (e->env->x_label && patmatch(pat, e->env->x_label));
     case MUTT_PAT_DRIVER_TAGS:
     {
-      char *tags = driver_tags_get(&e->tags);
+      char *tags = driver_tags_get(&e->cold->tags);
       bool rc = (pat->pat_not ^ (tags && patmatch(pat, tags)));
       FREE(&tags);
       return rc;
@@ -90,6 +90,7 @@ SLIST_HEAD(PatternList, Pattern);
 typedef uint8_t PatternExecFlags;         ///< Flags for mutt_pattern_exec(), e.g. #MUTT_MATCH_FULL_ADDRESS
 #define MUTT_PAT_EXEC_NO_FLAGS         0  ///< No flags are set
 #define MUTT_MATCH_FULL_ADDRESS  (1 << 0) ///< Match the full address
+#define MUTT_MATCH_WORKER        (1 << 1) ///< Match in a worker thread, see pattern_thread_safe()
 
 /**
  * struct PatternCache - Cache commonly-used patterns
@@ -30,6 +30,7 @@
 #include "config.h"
 #include <stddef.h>
 #include <stdbool.h>
+#include <string.h>
 #include "private.h"
 #include "mutt/lib.h"
 #include "email/lib.h"
@@ -38,6 +39,7 @@
 #include "mutt.h"
 #include "lib.h"
 #include "context.h"
+#include "handler.h"
 #include "mutt_globals.h"
 #include "mutt_logging.h"
 #include "mx.h"
@@ -221,6 +223,116 @@ bool mutt_limit_current_thread(struct Email *e)
   return true;
 }
 
+#ifdef USE_PTHREADS
+/**
+ * struct MatchJob - Emails to match against a Pattern using several threads
+ */
+struct MatchJob
+{
+  struct Pattern *pat;       ///< Pattern to match
+  struct Mailbox *mailbox;   ///< Mailbox containing the Emails
+  struct Email **emails;     ///< Emails, NULL if a worker can't match it
+  signed char *results;      ///< Results: 1 match, 0 no match, -1 not matched
+  struct Progress *progress; ///< Progress bar
+};
+
+/**
+ * match_one - Match the Pattern against one Email - Implements ::parallel_work_t
+ */
+static void match_one(void *data, size_t i)
+{
+  struct MatchJob *job = data;
+
+  struct Email *e = job->emails[i];
+  if (!e)
+    return;
+
+  /* If the worker can't decide, the result stays -1 for the main thread */
+  int rc = mutt_pattern_exec(job->pat, MUTT_MATCH_FULL_ADDRESS | MUTT_MATCH_WORKER,
+                             job->mailbox, e, NULL);
+  if (rc >= 0)
+    job->results[i] = (rc != 0);
+}
+
+/**
+ * match_wait - Show the progress of the workers - Implements ::parallel_wait_t
+ */
+static bool match_wait(void *data, size_t done)
+{
+  struct MatchJob *job = data;
+
+  mutt_progress_update(job->progress, done, -1);
+  return !SigInt;
+}
+
+/**
+ * match_parallel - Match a Pattern against the Emails using several threads
+ * @param[in]  pat      Pattern to match
+ * @param[in]  m        Mailbox
+ * @param[in]  all      If true, match all the Emails, otherwise only the visible ones
+ * @param[in]  progress Progress bar
+ * @param[out] results  Results: 1 match, 0 no match, -1 not matched
+ * @retval  1 Success, the caller must match the Emails marked -1
+ * @retval  0 The Pattern can't be matched by worker threads
+ * @retval -1 The user interrupted the search
+ *
+ * If $search_threads is set, Patterns that only read the Emails of a local
+ * Mailbox are matched in parallel.  The results are indexed like the Emails,
+ * i.e. by message number, or by virtual number if only the visible Emails
+ * are matched.
+ */
+static int match_parallel(struct PatternList *pat, struct Mailbox *m, bool all,
+                          struct Progress *progress, signed char **results)
+{
+  if ((C_SearchThreads < 2) ||
+      ((m->type != MUTT_MBOX) && (m->type != MUTT_MMDF) &&
+       (m->type != MUTT_MAILDIR) && (m->type != MUTT_MH)))
+  {
+    return 0;
+  }
+
+  bool body = false;
+  if (!pattern_thread_safe(pat, &body))
+    return 0;
+
+  /* Decoding isn't thread-safe, so only plain bodies can be searched */
+  const bool verbatim = body && C_ThoroughSearch;
+
+  const int num = all ? m->msg_count : m->vcount;
+  if (num < 1)
+    return 0;
+
+  struct MatchJob job = {
+    .pat = SLIST_FIRST(pat),
+    .mailbox = m,
+    .emails = mutt_mem_calloc(num, sizeof(struct Email *)),
+    .results = mutt_mem_malloc(num),
+    .progress = progress,
+  };
+  memset(job.results, -1, num);
+
+  for (int i = 0; i < num; i++)
+  {
+    struct Email *e = all ? m->emails[i] : mutt_get_virt_email(m, i);
+    if (!e || (verbatim && !mutt_body_is_verbatim(e->content)))
+      continue;
+    job.emails[i] = e;
+  }
+
+  const bool done = mutt_parallel_run(match_one, match_wait, &job, num, C_SearchThreads);
+  FREE(&job.emails);
+
+  if (!done)
+  {
+    FREE(&job.results);
+    return -1;
+  }
+
+  *results = job.results;
+  return 1;
+}
+#endif
+
 /**
  * mutt_pattern_func - Perform some Pattern matching
  * @param op     Operation to perform, e.g. #MUTT_LIMIT
@@ -238,6 +350,7 @@ int mutt_pattern_func(int op, char *prompt)
   struct Progress progress;
   struct Buffer *buf = mutt_buffer_pool_get();
   struct Mailbox *m = Context->mailbox;
+  signed char *results = NULL; /* from the worker threads, see match_parallel() */
 
   mutt_buffer_strcpy(buf, NONULL(Context->pattern));
   if (prompt || (op != MUTT_LIMIT))
@@ -273,6 +386,15 @@ int mutt_pattern_func(int op, char *prompt)
   mutt_progress_init(&progress, _("Executing command on matching messages..."),
                      MUTT_PROGRESS_READ, (op == MUTT_LIMIT) ? m->msg_count : m->vcount);
 
+#ifdef USE_PTHREADS
+  if (match_parallel(pat, m, (op == MUTT_LIMIT), &progress, &results) < 0)
+  {
+    mutt_error(_("Search interrupted"));
+    SigInt = 0;
+    goto bail;
+  }
+#endif
+
   if (op == MUTT_LIMIT)
   {
     m->vcount = 0;
@@ -292,7 +414,9 @@ int mutt_pattern_func(int op, char *prompt)
       e->limited = false;
       e->collapsed = false;
       e->num_hidden = 0;
-      if (mutt_pattern_exec(SLIST_FIRST(pat), MUTT_MATCH_FULL_ADDRESS, m, e, NULL))
+      if ((results && (results[i] >= 0)) ?
+              results[i] :
+              mutt_pattern_exec(SLIST_FIRST(pat), MUTT_MATCH_FULL_ADDRESS, m, e, NULL))
       {
         e->vnum = m->vcount;
         e->limited = true;
@@ -311,7 +435,9 @@ int mutt_pattern_func(int op, char *prompt)
       if (!e)
         continue;
       mutt_progress_update(&progress, i, -1);
-      if (mutt_pattern_exec(SLIST_FIRST(pat), MUTT_MATCH_FULL_ADDRESS, m, e, NULL))
+      if ((results && (results[i] >= 0)) ?
+              results[i] :
+              mutt_pattern_exec(SLIST_FIRST(pat), MUTT_MATCH_FULL_ADDRESS, m, e, NULL))
       {
         switch (op)
         {
@@ -356,6 +482,7 @@ int mutt_pattern_func(int op, char *prompt)
   rc = 0;
 
 bail:
+  FREE(&results);
   mutt_buffer_pool_release(&buf);
   FREE(&simple);
   mutt_pattern_free(&pat);
@@ -29,6 +29,7 @@
 
 struct Buffer;
 struct Pattern;
+struct PatternList;
 
 /**
  * enum PatternEat - Function to process pattern arguments
@@ -125,10 +126,14 @@ extern const struct PatternFlags Flags[];
 
 extern char *C_ExternalSearchCommand;
 extern char *C_PatternFormat;
+#ifdef USE_PTHREADS
+extern short C_SearchThreads;
+#endif
 extern bool  C_ThoroughSearch;
 
 const struct PatternFlags *lookup_op(int op);
 const struct PatternFlags *lookup_tag(char tag);
 bool eval_date_minmax(struct Pattern *pat, const char *s, struct Buffer *err);
+bool pattern_thread_safe(const struct PatternList *pat, bool *body);
 
 #endif /* MUTT_PATTERN_PRIVATE_H */
@@ -270,7 +270,7 @@ struct PopEmailData *pop_edata_get(struct Email *e)
 {
   if (!e)
     return NULL;
-  return e->edata;
+  return e->cold->edata;
 }
 
 /**
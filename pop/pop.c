@@ -280,13 +280,13 @@ static int fetch_uidl(const char *line, void *data)
     mutt_debug(LL_DEBUG1, "new header %d %s\n", index, line);
 
     if (i >= m->email_max)
-      mx_alloc_memory(m);
+      mx_alloc_memory(m, i + 1);
 
     m->msg_count++;
     m->emails[i] = email_new();
 
-    m->emails[i]->edata = pop_edata_new(line);
-    m->emails[i]->edata_free = pop_edata_free;
+    m->emails[i]->cold->edata = pop_edata_new(line);
+    m->emails[i]->cold->edata_free = pop_edata_free;
   }
   else if (m->emails[i]->index != index - 1)
     adata->clear_cache = true;
@@ -349,7 +349,7 @@ static void pop_hcache_namer(const char *path, struct Buffer *dest)
 static struct HeaderCache *pop_hcache_open(struct PopAccountData *adata, const char *path)
 {
   if (!adata || !adata->conn)
-    return mutt_hcache_open(C_HeaderCache, path, NULL);
+    return mutt_hcache_open(C_HeaderCache, path, NULL, NULL);
 
   struct Url url = { 0 };
   char p[1024];
@@ -357,7 +357,7 @@ static struct HeaderCache *pop_hcache_open(struct PopAccountData *adata, const c
   mutt_account_tourl(&adata->conn->account, &url);
   url.path = HC_FNAME;
   url_tostring(&url, p, sizeof(p), U_PATH);
-  return mutt_hcache_open(C_HeaderCache, p, pop_hcache_namer);
+  return mutt_hcache_open(C_HeaderCache, p, pop_hcache_namer, &adata->conn->account);
 }
 #endif
 
@@ -451,7 +451,7 @@ static int pop_fetch_headers(struct Mailbox *m)
       if (hce.email)
       {
         /* Detach the private data */
-        m->emails[i]->edata = NULL;
+        m->emails[i]->cold->edata = NULL;
 
         int index = m->emails[i]->index;
         /* - POP dynamically numbers headers and relies on e->refno
@@ -466,8 +466,8 @@ static int pop_fetch_headers(struct Mailbox *m)
         m->emails[i]->index = index;
 
         /* Reattach the private data */
-        m->emails[i]->edata = edata;
-        m->emails[i]->edata_free = pop_edata_free;
+        m->emails[i]->cold->edata = edata;
+        m->emails[i]->cold->edata_free = pop_edata_free;
         rc = 0;
         hcached = true;
       }
@@ -478,7 +478,7 @@ static int pop_fetch_headers(struct Mailbox *m)
 #ifdef USE_HCACHE
       else
       {
-        mutt_hcache_store(hc, edata->uid, strlen(edata->uid), m->emails[i], 0);
+        mutt_hcache_store_async(hc, edata->uid, strlen(edata->uid), m->emails[i], 0);
       }
 #endif
 
@@ -1149,7 +1149,7 @@ static int pop_msg_open(struct Mailbox *m, struct Message *msg, int msgno)
   rewind(msg->fp);
 
   /* Detach the private data */
-  e->edata = NULL;
+  e->cold->edata = NULL;
 
   /* we replace envelope, key in subj_hash has to be updated as well */
   if (m->subj_hash && e->env->real_subj)
@@ -1162,8 +1162,8 @@ static int pop_msg_open(struct Mailbox *m, struct Message *msg, int msgno)
   mutt_label_hash_add(m, e);
 
   /* Reattach the private data */
-  e->edata = edata;
-  e->edata_free = pop_edata_free;
+  e->cold->edata = edata;
+  e->cold->edata_free = pop_edata_free;
 
   e->lines = 0;
   fgets(buf, sizeof(buf), msg->fp);
@@ -1207,7 +1207,7 @@ static int pop_msg_save_hcache(struct Mailbox *m, struct Email *e)
   int rc = 0;
 #ifdef USE_HCACHE
   struct PopAccountData *adata = pop_adata_get(m);
-  struct PopEmailData *edata = e->edata;
+  struct PopEmailData *edata = e->cold->edata;
   struct HeaderCache *hc = pop_hcache_open(adata, mailbox_path(m));
   rc = mutt_hcache_store(hc, edata->uid, strlen(edata->uid), e, 0);
   mutt_hcache_close(hc);
@@ -1284,6 +1284,7 @@ struct MxOps MxPopOps = {
   .msg_close        = pop_msg_close,
   .msg_padding_size = NULL,
   .msg_save_hcache  = pop_msg_save_hcache,
+  .mbox_gc          = NULL,
   .tags_edit        = NULL,
   .tags_commit      = NULL,
   .path_probe       = pop_path_probe,
@@ -461,12 +461,12 @@ int mutt_get_postponed(struct Context *ctx, struct Email *hdr,
 #ifdef MIXMASTER
     else if (mutt_str_startswith(np->data, "X-Mutt-Mix:"))
     {
-      mutt_list_free(&hdr->chain);
+      mutt_list_free(&hdr->cold->chain);
 
       char *t = strtok(np->data + 11, " \t\n");
       while (t)
       {
-        mutt_list_insert_tail(&hdr->chain, mutt_str_dup(t));
+        mutt_list_insert_tail(&hdr->cold->chain, mutt_str_dup(t));
         t = strtok(NULL, " \t\n");
       }
     }
@@ -673,8 +673,8 @@ int mutt_prepare_template(FILE *fp, struct Mailbox *m, struct Email *e_new,
 
   /* parse the message header and MIME structure */
 
-  fseeko(fp, e->offset, SEEK_SET);
-  e_new->offset = e->offset;
+  fseeko(fp, e->cold->offset, SEEK_SET);
+  e_new->cold->offset = e->cold->offset;
   /* enable header weeding for resent messages */
   e_new->env = mutt_rfc822_read_header(fp, e_new, true, resend);
   e_new->content->length = e->content->length;
@@ -786,6 +786,7 @@ int mutt_fetch_recips(struct Envelope *out, struct Envelope *in,
                       SendFlags flags, struct ConfigSubset *sub)
 {
   enum QuadOption hmfupto = MUTT_ABORT;
+  mutt_env_lazy_restore(in);
   const struct Address *followup_to = TAILQ_FIRST(&in->mail_followup_to);
 
   if ((flags & (SEND_LIST_REPLY | SEND_GROUP_REPLY | SEND_GROUP_CHAT_REPLY)) && followup_to)
@@ -1376,7 +1377,7 @@ static int invoke_mta(struct Email *e, struct ConfigSubset *sub)
 #endif
 #ifdef MIXMASTER
   mutt_rfc822_write_header(fp_tmp, e->env, e->content, MUTT_WRITE_HEADER_NORMAL,
-                           !STAILQ_EMPTY(&e->chain),
+                           !STAILQ_EMPTY(&e->cold->chain),
                            mutt_should_hide_protected_subject(e), sub);
 #endif
 #ifndef MIXMASTER
@@ -1401,9 +1402,9 @@ static int invoke_mta(struct Email *e, struct ConfigSubset *sub)
   }
 
 #ifdef MIXMASTER
-  if (!STAILQ_EMPTY(&e->chain))
+  if (!STAILQ_EMPTY(&e->cold->chain))
   {
-    rc = mix_send_message(&e->chain, mutt_b2s(tempfile));
+    rc = mix_send_message(&e->cold->chain, mutt_b2s(tempfile));
     goto cleanup;
   }
 #endif
@@ -2010,7 +2011,14 @@ int mutt_send_message(SendFlags flags, struct Email *e_templ, const char *tempfi
   struct Email *e_cur = NULL;
 
   if (el)
+  {
+    /* Replies and forwards may need any of the headers */
+    STAILQ_FOREACH(en, el, entries)
+    {
+      mutt_env_lazy_restore(en->email->env);
+    }
     en = STAILQ_FIRST(el);
+  }
   if (en)
     e_cur = STAILQ_NEXT(en, entries) ? NULL : en->email;
 
@@ -1017,7 +1017,7 @@ struct Body *mutt_make_message_attach(struct Mailbox *m, struct Email *e,
   rewind(fp);
 
   body->email = email_new();
-  body->email->offset = 0;
+  body->email->cold->offset = 0;
   /* we don't need the user headers here */
   body->email->env = mutt_rfc822_read_header(fp, body->email, false, false);
   if (WithCrypto)
@@ -1318,7 +1318,7 @@ static int bounce_message(FILE *fp, struct Email *e, struct AddressList *to,
     if (!c_bounce_delivered)
       chflags |= CH_WEED_DELIVERED;
 
-    fseeko(fp, e->offset, SEEK_SET);
+    fseeko(fp, e->cold->offset, SEEK_SET);
     fprintf(fp_tmp, "Resent-From: %s\n", resent_from);
 
     struct Buffer *date = mutt_buffer_pool_get();
@@ -1646,11 +1646,11 @@ int mutt_write_fcc(const char *path, struct Email *e, const char *msgid, bool po
   /* (postponement) if the mail is to be sent through a mixmaster
    * chain, save that information */
 
-  if (post && !STAILQ_EMPTY(&e->chain))
+  if (post && !STAILQ_EMPTY(&e->cold->chain))
   {
     fputs("X-Mutt-Mix:", msg->fp);
     struct ListNode *p = NULL;
-    STAILQ_FOREACH(p, &e->chain, entries)
+    STAILQ_FOREACH(p, &e->cold->chain, entries)
     {
       fprintf(msg->fp, " %s", (char *) p->data);
     }
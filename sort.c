@@ -28,7 +28,9 @@
  */
 
 #include "config.h"
+#include <ctype.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include "mutt/lib.h"
@@ -356,6 +358,230 @@ sort_t mutt_get_sort_func(enum SortType method)
   /* not reached */
 }
 
+/**
+ * struct EmailSortKey - An Email and its precomputed sort keys
+ */
+struct EmailSortKey
+{
+  struct Email *email; ///< Email to sort
+  const char *str[2];  ///< Case-folded strings for $sort and $sort_aux, if they use one
+};
+
+/* Sort methods used by compare_sort_keys(): $sort and $sort_aux */
+static short SortKeyOrder[2];
+
+/**
+ * sort_key_fold - Make a case-folded copy of a string
+ * @param arena Arena to allocate from
+ * @param str   String to copy
+ * @param max   Maximum number of characters to copy
+ * @retval ptr Folded string
+ *
+ * Comparing the copies with strcmp() gives the same order as comparing the
+ * originals with mutt_istr_cmp().
+ */
+static const char *sort_key_fold(struct Arena *arena, const char *str, size_t max)
+{
+  const size_t len = strnlen(NONULL(str), max);
+  char *key = mutt_arena_calloc(arena, len + 1);
+  for (size_t i = 0; i < len; i++)
+    key[i] = tolower((unsigned char) str[i]);
+  return key;
+}
+
+/**
+ * sort_key_string - Get the string that an Email is sorted by
+ * @param arena  Arena to allocate from
+ * @param e      Email
+ * @param method Sort method, e.g. #SORT_SUBJECT
+ * @retval ptr  Case-folded string
+ * @retval NULL The method doesn't use a string, or the Email doesn't have one
+ */
+static const char *sort_key_string(struct Arena *arena, const struct Email *e, short method)
+{
+  switch (method & SORT_MASK)
+  {
+    case SORT_FROM:
+      /* compare_from() only looks at the first 127 characters */
+      return sort_key_fold(arena, mutt_get_name(TAILQ_FIRST(&e->env->from)), 127);
+    case SORT_TO:
+      return sort_key_fold(arena, mutt_get_name(TAILQ_FIRST(&e->env->to)), 127);
+    case SORT_LABEL:
+      if (!e->env->x_label || (e->env->x_label[0] == '\0'))
+        return NULL;
+      return sort_key_fold(arena, e->env->x_label, SIZE_MAX);
+    case SORT_SUBJECT:
+      if (!e->env->real_subj)
+        return NULL;
+      return sort_key_fold(arena, e->env->real_subj, SIZE_MAX);
+    default:
+      return NULL;
+  }
+}
+
+/**
+ * compare_key - Compare two Emails using one of their keys
+ * @param a   First Email
+ * @param b   Second Email
+ * @param col Key to use: 0 ($sort) or 1 ($sort_aux)
+ * @retval <0 a precedes b
+ * @retval  0 a and b are identical
+ * @retval >0 b precedes a
+ *
+ * This matches the comparison functions above, but ignores SORT_REVERSE.
+ */
+static int compare_key(const struct EmailSortKey *a, const struct EmailSortKey *b, int col)
+{
+  const struct Email *ea = a->email;
+  const struct Email *eb = b->email;
+  const char *sa = a->str[col];
+  const char *sb = b->str[col];
+
+  switch (SortKeyOrder[col] & SORT_MASK)
+  {
+    case SORT_DATE:
+      return (ea->date_sent > eb->date_sent) - (ea->date_sent < eb->date_sent);
+    case SORT_RECEIVED:
+      return (ea->received > eb->received) - (ea->received < eb->received);
+    case SORT_SCORE: /* note that this is reverse */
+      return (eb->score > ea->score) - (eb->score < ea->score);
+    case SORT_SIZE:
+      return (ea->content->length > eb->content->length) -
+             (ea->content->length < eb->content->length);
+    case SORT_ORDER:
+      return ea->index - eb->index;
+    case SORT_FROM:
+    case SORT_TO:
+      return strcmp(sa, sb);
+    case SORT_LABEL:
+      /* Emails with a label come first */
+      if (sa && sb)
+        return strcmp(sa, sb);
+      return (sb != NULL) - (sa != NULL);
+    case SORT_SUBJECT:
+      /* Emails without a subject come first, in date order */
+      if (sa && sb)
+        return strcmp(sa, sb);
+      if (!sa && !sb)
+        return (ea->date_sent > eb->date_sent) - (ea->date_sent < eb->date_sent);
+      return (sa != NULL) - (sb != NULL);
+    default:
+      return 0;
+  }
+}
+
+/**
+ * compare_sort_keys - Compare two Emails using their precomputed keys - Implements ::sort_t
+ *
+ * Emails are compared by $sort, then $sort_aux, then their original order.
+ */
+static int compare_sort_keys(const void *a, const void *b)
+{
+  const struct EmailSortKey *ka = a;
+  const struct EmailSortKey *kb = b;
+
+  int rc = compare_key(ka, kb, 0);
+  if (rc == 0)
+  {
+    rc = compare_key(ka, kb, 1);
+    if (rc == 0)
+      rc = ka->email->index - kb->email->index;
+    if (SortKeyOrder[1] & SORT_REVERSE)
+      rc = -rc;
+  }
+  if (SortKeyOrder[0] & SORT_REVERSE)
+    rc = -rc;
+  return rc;
+}
+
+/**
+ * sort_key_supported - Can the Emails be sorted using precomputed keys?
+ * @param m      Mailbox
+ * @param method Sort method, e.g. #SORT_FROM
+ * @retval true compare_key() supports the method
+ */
+static bool sort_key_supported(const struct Mailbox *m, short method)
+{
+  switch (method & SORT_MASK)
+  {
+    case SORT_DATE:
+    case SORT_FROM:
+    case SORT_LABEL:
+    case SORT_RECEIVED:
+    case SORT_SCORE:
+    case SORT_SIZE:
+    case SORT_SUBJECT:
+    case SORT_TO:
+      return true;
+    case SORT_ORDER:
+      /* nntp_compare_order() sorts by article number */
+      return (m->type != MUTT_NNTP);
+    default:
+      return false;
+  }
+}
+
+/**
+ * sort_key_uses_string - Does a sort method compare strings?
+ * @param method Sort method, e.g. #SORT_FROM
+ * @retval true sort_key_string() creates a key for the method
+ */
+static bool sort_key_uses_string(short method)
+{
+  switch (method & SORT_MASK)
+  {
+    case SORT_FROM:
+    case SORT_LABEL:
+    case SORT_SUBJECT:
+    case SORT_TO:
+      return true;
+    default:
+      return false;
+  }
+}
+
+/**
+ * sort_emails_by_key - Sort the Emails using precomputed keys
+ * @param m Mailbox
+ * @retval true  Emails sorted
+ * @retval false Use the comparison functions instead
+ *
+ * The comparison functions look up aliases and fold case every time they're
+ * called.  Doing that once per Email makes re-sorting a large Mailbox by
+ * sender or subject much quicker.
+ */
+static bool sort_emails_by_key(struct Mailbox *m)
+{
+  if (!sort_key_supported(m, C_Sort) || !sort_key_supported(m, C_SortAux))
+    return false;
+
+  /* Numeric fields are just as quick to read from the Emails */
+  if (!sort_key_uses_string(C_Sort) && !sort_key_uses_string(C_SortAux))
+    return false;
+
+  struct Arena *arena = mutt_arena_new();
+  struct EmailSortKey *keys = mutt_mem_calloc(m->msg_count, sizeof(struct EmailSortKey));
+
+  for (int i = 0; i < m->msg_count; i++)
+  {
+    struct Email *e = m->emails[i];
+    keys[i].email = e;
+    keys[i].str[0] = sort_key_string(arena, e, C_Sort);
+    keys[i].str[1] = sort_key_string(arena, e, C_SortAux);
+  }
+
+  SortKeyOrder[0] = C_Sort;
+  SortKeyOrder[1] = C_SortAux;
+  qsort(keys, m->msg_count, sizeof(struct EmailSortKey), compare_sort_keys);
+
+  for (int i = 0; i < m->msg_count; i++)
+    m->emails[i] = keys[i].email;
+
+  FREE(&keys);
+  mutt_arena_free(&arena);
+  return true;
+}
+
 /**
  * mutt_sort_headers - Sort emails by their headers
  * @param ctx  Mailbox
@@ -429,7 +655,7 @@ void mutt_sort_headers(struct Context *ctx, bool init)
     mutt_error(_("Could not find sorting function [report this bug]"));
     return;
   }
-  else
+  else if (!sort_emails_by_key(m))
   {
     qsort((void *) m->emails, m->msg_count, sizeof(struct Email *), sortfunc);
   }
@@ -137,6 +137,56 @@ static void store_gdbm_close(void **ptr)
   *ptr = NULL;
 }
 
+/**
+ * store_gdbm_walk - Implements StoreOps::walk()
+ */
+static int store_gdbm_walk(void *store, const char *start, size_t slen,
+                           store_walk_t cb, void *data)
+{
+  if (!store || !cb)
+    return -1;
+
+  GDBM_FILE db = store;
+
+  datum dkey;
+  if (start)
+  {
+    datum skey = { (char *) start, slen };
+    dkey = gdbm_nextkey(db, skey);
+  }
+  else
+  {
+    dkey = gdbm_firstkey(db);
+  }
+
+  while (dkey.dptr)
+  {
+    if (!cb(dkey.dptr, dkey.dsize, data))
+    {
+      FREE(&dkey.dptr);
+      break;
+    }
+
+    datum next = gdbm_nextkey(db, dkey);
+    FREE(&dkey.dptr);
+    dkey = next;
+  }
+
+  return 0;
+}
+
+/**
+ * store_gdbm_compact - Implements StoreOps::compact()
+ */
+static int store_gdbm_compact(void *store)
+{
+  if (!store)
+    return -1;
+
+  GDBM_FILE db = store;
+  return gdbm_reorganize(db);
+}
+
 /**
  * store_gdbm_version - Implements StoreOps::version()
  */
@@ -145,4 +195,4 @@ static const char *store_gdbm_version(void)
   return gdbm_version;
 }
 
-STORE_BACKEND_OPS(gdbm)
+STORE_BACKEND_OPS_WALK(gdbm)
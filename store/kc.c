@@ -32,7 +32,11 @@
 
 #include "config.h"
 #include <kclangc.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include "mutt/lib.h"
 #include "lib.h"
 #include "mutt_globals.h"
@@ -51,7 +55,8 @@ static void *store_kyotocabinet_open(const char *path)
 
   struct Buffer kcdbpath = mutt_buffer_make(1024);
 
-  mutt_buffer_printf(&kcdbpath, "%s#type=kct#opts=l#rcomp=lex", path);
+  /* dfunit - Defragment the file after this many fragments are created */
+  mutt_buffer_printf(&kcdbpath, "%s#type=kct#opts=l#rcomp=lex#dfunit=8", path);
 
   if (!kcdbopen(db, mutt_b2s(&kcdbpath), KCOWRITER | KCOCREATE))
   {
@@ -143,6 +148,189 @@ static void store_kyotocabinet_close(void **ptr)
   *ptr = NULL;
 }
 
+/**
+ * kv_cmp - Compare the Keys of two StoreKvs - Implements ::sort_t
+ */
+static int kv_cmp(const void *a, const void *b)
+{
+  const struct StoreKv *kva = *(struct StoreKv const *const *) a;
+  const struct StoreKv *kvb = *(struct StoreKv const *const *) b;
+
+  int rc = memcmp(kva->key, kvb->key, MIN(kva->klen, kvb->klen));
+  if (rc == 0)
+    rc = (kva->klen > kvb->klen) - (kva->klen < kvb->klen);
+  return rc;
+}
+
+/**
+ * kv_find - Find the StoreKv waiting for a record
+ * @param sorted StoreKvs, sorted by kv_cmp()
+ * @param num    Number of StoreKvs
+ * @param key    Key of the record
+ * @retval ptr StoreKv to fill in
+ * @retval NULL The Key wasn't asked for
+ */
+static struct StoreKv *kv_find(struct StoreKv **sorted, size_t num, const KCSTR *key)
+{
+  struct StoreKv want = { .key = key->buf, .klen = key->size };
+  struct StoreKv *pwant = &want;
+
+  struct StoreKv **found = bsearch(&pwant, sorted, num, sizeof(*sorted), kv_cmp);
+  if (!found)
+    return NULL;
+
+  /* The same Key may have been asked for more than once */
+  while ((found > sorted) && (kv_cmp(found - 1, &pwant) == 0))
+    found--;
+  for (; (found < (sorted + num)) && (kv_cmp(found, &pwant) == 0); found++)
+  {
+    if (!(*found)->value)
+      return *found;
+  }
+
+  return NULL;
+}
+
+/**
+ * store_kyotocabinet_fetch_many - Implements StoreOps::fetch_many()
+ */
+static size_t store_kyotocabinet_fetch_many(void *store, struct StoreKv *kvs, size_t num)
+{
+  if (!store || !kvs || (num == 0))
+    return 0;
+
+  KCDB *db = store;
+  KCSTR *keys = mutt_mem_calloc(num, sizeof(KCSTR));
+  KCREC *recs = mutt_mem_calloc(num, sizeof(KCREC));
+  struct StoreKv **sorted = mutt_mem_calloc(num, sizeof(struct StoreKv *));
+
+  for (size_t i = 0; i < num; i++)
+  {
+    keys[i].buf = (char *) kvs[i].key;
+    keys[i].size = kvs[i].klen;
+    kvs[i].value = NULL;
+    kvs[i].vlen = 0;
+    sorted[i] = &kvs[i];
+  }
+
+  int64_t count = kcdbgetbulk(db, keys, num, recs, false);
+  if (count < 0)
+  {
+    int ecode = kcdbecode(db);
+    mutt_debug(LL_DEBUG2, "kcdbgetbulk failed: %s (ecode %d)\n", kcdbemsg(db), ecode);
+    count = 0;
+  }
+
+  /* The records aren't returned in the order they were asked for, and
+   * missing keys are skipped, so look up each one */
+  qsort(sorted, num, sizeof(*sorted), kv_cmp);
+
+  size_t found = 0;
+  for (int64_t j = 0; j < count; j++)
+  {
+    struct StoreKv *kv = kv_find(sorted, num, &recs[j].key);
+    if (kv)
+    {
+      kv->value = recs[j].value.buf;
+      kv->vlen = recs[j].value.size;
+      found++;
+    }
+    else
+    {
+      kcfree(recs[j].value.buf);
+    }
+    kcfree(recs[j].key.buf);
+  }
+
+  FREE(&sorted);
+  FREE(&recs);
+  FREE(&keys);
+  return found;
+}
+
+/**
+ * store_kyotocabinet_store_many - Implements StoreOps::store_many()
+ *
+ * All the Values are written in a single atomic transaction.
+ */
+static int store_kyotocabinet_store_many(void *store, struct StoreKv *kvs, size_t num)
+{
+  if (!store || !kvs)
+    return -1;
+
+  KCDB *db = store;
+  KCREC *recs = mutt_mem_calloc(MAX(num, 1), sizeof(KCREC));
+
+  for (size_t i = 0; i < num; i++)
+  {
+    recs[i].key.buf = (char *) kvs[i].key;
+    recs[i].key.size = kvs[i].klen;
+    recs[i].value.buf = kvs[i].value;
+    recs[i].value.size = kvs[i].vlen;
+  }
+
+  int rc = 0;
+  if (kcdbsetbulk(db, recs, num, true) < 0)
+  {
+    int ecode = kcdbecode(db);
+    rc = ecode ? ecode : -1;
+  }
+
+  FREE(&recs);
+  return rc;
+}
+
+/**
+ * store_kyotocabinet_walk - Implements StoreOps::walk()
+ */
+static int store_kyotocabinet_walk(void *store, const char *start, size_t slen,
+                                   store_walk_t cb, void *data)
+{
+  if (!store || !cb)
+    return -1;
+
+  KCDB *db = store;
+  KCCUR *cur = kcdbcursor(db);
+  if (!cur)
+    return -1;
+
+  bool found;
+  if (start)
+    found = kccurjumpkey(cur, start, slen) && kccurstep(cur);
+  else
+    found = kccurjump(cur);
+
+  if (found)
+  {
+    size_t klen = 0;
+    char *key = NULL;
+    while ((key = kccurgetkey(cur, &klen, true)))
+    {
+      bool more = cb(key, klen, data);
+      kcfree(key);
+      if (!more)
+        break;
+    }
+  }
+
+  kccurdel(cur);
+  return 0;
+}
+
+/**
+ * store_kyotocabinet_compact - Implements StoreOps::compact()
+ *
+ * The database is opened with automatic defragmentation, so there's nothing
+ * more to do.
+ */
+static int store_kyotocabinet_compact(void *store)
+{
+  if (!store)
+    return -1;
+
+  return 0;
+}
+
 /**
  * store_kyotocabinet_version - Implements StoreOps::version()
  */
@@ -155,4 +343,4 @@ static const char *store_kyotocabinet_version(void)
   return version_cache;
 }
 
-STORE_BACKEND_OPS(kyotocabinet)
+STORE_BACKEND_OPS_FULL(kyotocabinet)
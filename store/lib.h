@@ -33,10 +33,24 @@
  *
  * Each Store backend implements the StoreOps API.
  *
+ * Backends may also implement the optional batch functions,
+ * StoreOps::fetch_many() and StoreOps::store_many(), which operate on many
+ * records inside a single transaction.  If they don't, store_fetch_many() and
+ * store_store_many() fall back to calling fetch() and store() for each record.
+ *
+ * The optional StoreOps::walk() and StoreOps::compact() functions are used by
+ * the \ref hcache to remove stale records and to shrink the database.
+ *
+ * Any Store can be wrapped in an in-memory LRU cache, using store_lru_wrap().
+ * The cache is shared by all the wrapped Stores and outlives them.  A database's
+ * records are discarded when its file is found to have changed.
+ *
  * ## Source
  *
  * @subpage store_store
  *
+ * @subpage store_lru
+ *
  * | Name                   | File            | Home Page                                 |
  * | :--------------------- | :-------------- | :---------------------------------------- |
  * | @subpage store_bdb     | store/bdb.c     | https://en.wikipedia.org/wiki/Berkeley_DB |
@@ -55,6 +69,27 @@
 #include <stdbool.h>
 #include <stdlib.h>
 
+/**
+ * struct StoreKv - A Key/Value pair for the batch operations
+ */
+struct StoreKv
+{
+  const char *key; ///< Key identifying the record
+  size_t klen;     ///< Length of the Key string
+  void *value;     ///< Value (fetch_many() sets it to NULL if the Key isn't found)
+  size_t vlen;     ///< Length of the Value
+};
+
+/**
+ * typedef store_walk_t - Prototype for a function called for each Key in a Store
+ * @param key  Key identifying the record
+ * @param klen Length of the Key string
+ * @param data Private data passed to StoreOps::walk()
+ * @retval true  Continue the walk
+ * @retval false Stop the walk
+ */
+typedef bool (*store_walk_t)(const char *key, size_t klen, void *data);
+
 /**
  * struct StoreOps - Key Value Store API
  */
@@ -120,6 +155,54 @@ struct StoreOps
    */
   void (*close)(void **ptr);
 
+  /**
+   * fetch_many - Fetch many Values from the Store (optional)
+   * @param[in]     store Store retrieved via open()
+   * @param[in,out] kvs   Array of Keys, Values will be filled in
+   * @param[in]     num   Number of entries in the array
+   * @retval num Number of Values found
+   *
+   * The Values must be freed using free().
+   */
+  size_t (*fetch_many)(void *store, struct StoreKv *kvs, size_t num);
+
+  /**
+   * store_many - Write many Values to the Store in one transaction (optional)
+   * @param[in] store Store retrieved via open()
+   * @param[in] kvs   Array of Key/Value pairs to save
+   * @param[in] num   Number of entries in the array
+   * @retval 0   Success
+   * @retval num Error, a backend-specific error code
+   */
+  int (*store_many)(void *store, struct StoreKv *kvs, size_t num);
+
+  /**
+   * walk - Call a function for each Key in the Store (optional)
+   * @param[in] store Store retrieved via open()
+   * @param[in] start Resume the walk after this Key, or NULL to start at the beginning
+   * @param[in] slen  Length of the start Key
+   * @param[in] cb    Function to call for each Key
+   * @param[in] data  Private data passed to the function
+   * @retval 0   Success
+   * @retval num Error, a backend-specific error code
+   *
+   * The function mustn't modify the Store.
+   *
+   * A large Store can be walked a piece at a time: stop the walk by
+   * returning false from the function, then walk again, starting after the
+   * last Key seen.  If the Store is changed in between, some Keys may be
+   * missed.  If the start Key has been deleted, some backends end the walk.
+   */
+  int (*walk)(void *store, const char *start, size_t slen, store_walk_t cb, void *data);
+
+  /**
+   * compact - Release the space used by deleted records (optional)
+   * @param[in] store Store retrieved via open()
+   * @retval 0   Success
+   * @retval num Error, a backend-specific error code
+   */
+  int (*compact)(void *store);
+
   /**
    * version - Get a Store version string
    * @retval ptr String describing the currently used Store
@@ -130,6 +213,12 @@ struct StoreOps
 const char *           store_backend_list(void);
 const struct StoreOps *store_get_backend_ops(const char *str);
 bool                   store_is_valid_backend(const char *str);
+size_t                 store_fetch_many(const struct StoreOps *ops, void *store, struct StoreKv *kvs, size_t num);
+int                    store_store_many(const struct StoreOps *ops, void *store, struct StoreKv *kvs, size_t num);
+
+extern const struct StoreOps store_lru_ops;
+void *store_lru_wrap(const struct StoreOps *ops, void *store, const char *path, size_t limit);
+void  store_lru_cleanup(void);
 
 #define STORE_BACKEND_OPS(_name)                                               \
   const struct StoreOps store_##_name##_ops = {                                \
@@ -143,4 +232,34 @@ bool                   store_is_valid_backend(const char *str);
     .version        = store_##_name##_version,                                 \
   };
 
+#define STORE_BACKEND_OPS_WALK(_name)                                          \
+  const struct StoreOps store_##_name##_ops = {                                \
+    .name           = #_name,                                                  \
+    .open           = store_##_name##_open,                                    \
+    .fetch          = store_##_name##_fetch,                                   \
+    .free           = store_##_name##_free,                                    \
+    .store          = store_##_name##_store,                                   \
+    .delete_record  = store_##_name##_delete_record,                           \
+    .close          = store_##_name##_close,                                   \
+    .walk           = store_##_name##_walk,                                    \
+    .compact        = store_##_name##_compact,                                 \
+    .version        = store_##_name##_version,                                 \
+  };
+
+#define STORE_BACKEND_OPS_FULL(_name)                                          \
+  const struct StoreOps store_##_name##_ops = {                                \
+    .name           = #_name,                                                  \
+    .open           = store_##_name##_open,                                    \
+    .fetch          = store_##_name##_fetch,                                   \
+    .free           = store_##_name##_free,                                    \
+    .store          = store_##_name##_store,                                   \
+    .delete_record  = store_##_name##_delete_record,                           \
+    .close          = store_##_name##_close,                                   \
+    .fetch_many     = store_##_name##_fetch_many,                              \
+    .store_many     = store_##_name##_store_many,                              \
+    .walk           = store_##_name##_walk,                                    \
+    .compact        = store_##_name##_compact,                                 \
+    .version        = store_##_name##_version,                                 \
+  };
+
 #endif /* MUTT_STORE_LIB_H */
@@ -32,7 +32,11 @@
 
 #include "config.h"
 #include <stddef.h>
+#include <errno.h>
 #include <lmdb.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
 #include "mutt/lib.h"
 #include "lib.h"
 
@@ -59,6 +63,7 @@ struct StoreLmdbCtx
   MDB_txn *txn;
   MDB_dbi db;
   enum MdbTxnMode txn_mode;
+  char *path;
 };
 
 /**
@@ -70,6 +75,9 @@ static int mdb_get_r_txn(struct StoreLmdbCtx *ctx)
 {
   int rc;
 
+  if (!ctx->env)
+    return EINVAL;
+
   if (ctx->txn && ((ctx->txn_mode == TXN_READ) || (ctx->txn_mode == TXN_WRITE)))
     return MDB_SUCCESS;
 
@@ -98,6 +106,9 @@ static int mdb_get_w_txn(struct StoreLmdbCtx *ctx)
 {
   int rc;
 
+  if (!ctx->env)
+    return EINVAL;
+
   if (ctx->txn)
   {
     if (ctx->txn_mode == TXN_WRITE)
@@ -116,6 +127,26 @@ static int mdb_get_w_txn(struct StoreLmdbCtx *ctx)
   return rc;
 }
 
+/**
+ * mdb_end_txn - Finish the current LMDB transaction
+ * @param ctx LMDB context
+ *
+ * A write transaction is committed, a read transaction is aborted.
+ */
+static void mdb_end_txn(struct StoreLmdbCtx *ctx)
+{
+  if (!ctx->txn)
+    return;
+
+  if (ctx->txn_mode == TXN_WRITE)
+    mdb_txn_commit(ctx->txn);
+  else
+    mdb_txn_abort(ctx->txn);
+
+  ctx->txn_mode = TXN_UNINITIALIZED;
+  ctx->txn = NULL;
+}
+
 /**
  * store_lmdb_open - Implements StoreOps::open()
  */
@@ -161,6 +192,7 @@ static void *store_lmdb_open(const char *path)
 
   mdb_txn_reset(ctx->txn);
   ctx->txn_mode = TXN_UNINITIALIZED;
+  ctx->path = mutt_str_dup(path);
   return ctx;
 
 fail_dbi:
@@ -297,19 +329,213 @@ static void store_lmdb_close(void **ptr)
 
   struct StoreLmdbCtx *db = *ptr;
 
-  if (db->txn)
+  mdb_end_txn(db);
+  if (db->env)
+    mdb_env_close(db->env);
+  FREE(&db->path);
+  FREE(ptr);
+}
+
+/**
+ * store_lmdb_fetch_many - Implements StoreOps::fetch_many()
+ *
+ * All the Keys are looked up in a single read transaction.
+ */
+static size_t store_lmdb_fetch_many(void *store, struct StoreKv *kvs, size_t num)
+{
+  if (!store || !kvs)
+    return 0;
+
+  struct StoreLmdbCtx *ctx = store;
+
+  for (size_t i = 0; i < num; i++)
+  {
+    kvs[i].value = NULL;
+    kvs[i].vlen = 0;
+  }
+
+  int rc = mdb_get_r_txn(ctx);
+  if (rc != MDB_SUCCESS)
   {
-    if (db->txn_mode == TXN_WRITE)
-      mdb_txn_commit(db->txn);
-    else
-      mdb_txn_abort(db->txn);
+    ctx->txn = NULL;
+    mutt_debug(LL_DEBUG2, "txn_renew: %s\n", mdb_strerror(rc));
+    return 0;
+  }
 
-    db->txn_mode = TXN_UNINITIALIZED;
-    db->txn = NULL;
+  size_t found = 0;
+  MDB_val dkey;
+  MDB_val data;
+  for (size_t i = 0; i < num; i++)
+  {
+    dkey.mv_data = (void *) kvs[i].key;
+    dkey.mv_size = kvs[i].klen;
+    data.mv_data = NULL;
+    data.mv_size = 0;
+
+    rc = mdb_get(ctx->txn, ctx->db, &dkey, &data);
+    if (rc == MDB_NOTFOUND)
+      continue;
+    if (rc != MDB_SUCCESS)
+    {
+      mutt_debug(LL_DEBUG2, "mdb_get: %s\n", mdb_strerror(rc));
+      continue;
+    }
+
+    kvs[i].value = data.mv_data;
+    kvs[i].vlen = data.mv_size;
+    found++;
   }
 
-  mdb_env_close(db->env);
-  FREE(ptr);
+  return found;
+}
+
+/**
+ * store_lmdb_store_many - Implements StoreOps::store_many()
+ *
+ * All the Values are written in a single write transaction.
+ */
+static int store_lmdb_store_many(void *store, struct StoreKv *kvs, size_t num)
+{
+  if (!store || !kvs)
+    return -1;
+
+  struct StoreLmdbCtx *ctx = store;
+
+  int rc = mdb_get_w_txn(ctx);
+  if (rc != MDB_SUCCESS)
+  {
+    mutt_debug(LL_DEBUG2, "mdb_get_w_txn: %s\n", mdb_strerror(rc));
+    return rc;
+  }
+
+  MDB_val dkey;
+  MDB_val databuf;
+  for (size_t i = 0; i < num; i++)
+  {
+    dkey.mv_data = (void *) kvs[i].key;
+    dkey.mv_size = kvs[i].klen;
+    databuf.mv_data = kvs[i].value;
+    databuf.mv_size = kvs[i].vlen;
+
+    rc = mdb_put(ctx->txn, ctx->db, &dkey, &databuf, 0);
+    if (rc != MDB_SUCCESS)
+    {
+      mutt_debug(LL_DEBUG2, "mdb_put: %s\n", mdb_strerror(rc));
+      mdb_txn_abort(ctx->txn);
+      ctx->txn_mode = TXN_UNINITIALIZED;
+      ctx->txn = NULL;
+      return rc;
+    }
+  }
+
+  return MDB_SUCCESS;
+}
+
+/**
+ * store_lmdb_walk - Implements StoreOps::walk()
+ */
+static int store_lmdb_walk(void *store, const char *start, size_t slen,
+                           store_walk_t cb, void *data)
+{
+  if (!store || !cb)
+    return -1;
+
+  struct StoreLmdbCtx *ctx = store;
+
+  int rc = mdb_get_r_txn(ctx);
+  if (rc != MDB_SUCCESS)
+  {
+    ctx->txn = NULL;
+    mutt_debug(LL_DEBUG2, "txn_renew: %s\n", mdb_strerror(rc));
+    return rc;
+  }
+
+  MDB_cursor *cursor = NULL;
+  rc = mdb_cursor_open(ctx->txn, ctx->db, &cursor);
+  if (rc != MDB_SUCCESS)
+  {
+    mutt_debug(LL_DEBUG2, "mdb_cursor_open: %s\n", mdb_strerror(rc));
+    return rc;
+  }
+
+  MDB_val dkey = { 0 };
+  MDB_val value = { 0 };
+  MDB_cursor_op op = MDB_FIRST;
+  if (start)
+  {
+    /* Find the first Key >= start */
+    dkey.mv_data = (void *) start;
+    dkey.mv_size = slen;
+    op = MDB_SET_RANGE;
+  }
+
+  while ((rc = mdb_cursor_get(cursor, &dkey, &value, op)) == MDB_SUCCESS)
+  {
+    const bool skip = (op == MDB_SET_RANGE) && (dkey.mv_size == slen) &&
+                      (memcmp(dkey.mv_data, start, slen) == 0);
+    op = MDB_NEXT;
+    if (skip)
+      continue;
+    if (!cb(dkey.mv_data, dkey.mv_size, data))
+      break;
+  }
+  mdb_cursor_close(cursor);
+
+  return ((rc == MDB_SUCCESS) || (rc == MDB_NOTFOUND)) ? MDB_SUCCESS : rc;
+}
+
+/**
+ * store_lmdb_compact - Implements StoreOps::compact()
+ *
+ * LMDB reuses the pages of deleted records, but never shrinks the file.
+ * Make a compacted copy of the database, then replace the original with it.
+ */
+static int store_lmdb_compact(void *store)
+{
+  if (!store)
+    return -1;
+
+  struct StoreLmdbCtx *ctx = store;
+  if (!ctx->env || !ctx->path)
+    return -1;
+
+  mdb_end_txn(ctx);
+
+  struct Buffer *tmp = mutt_buffer_pool_get();
+  mutt_buffer_printf(tmp, "%s.compact", ctx->path);
+
+  int rc = mdb_env_copy2(ctx->env, mutt_b2s(tmp), MDB_CP_COMPACT);
+  if (rc != MDB_SUCCESS)
+  {
+    mutt_debug(LL_DEBUG2, "mdb_env_copy2: %s\n", mdb_strerror(rc));
+    unlink(mutt_b2s(tmp));
+    mutt_buffer_pool_release(&tmp);
+    return rc;
+  }
+
+  mdb_env_close(ctx->env);
+  ctx->env = NULL;
+
+  if (rename(mutt_b2s(tmp), ctx->path) != 0)
+  {
+    rc = errno;
+    unlink(mutt_b2s(tmp));
+  }
+  mutt_buffer_pool_release(&tmp);
+
+  /* Reopen the database, whether the copy replaced it, or not */
+  struct StoreLmdbCtx *fresh = store_lmdb_open(ctx->path);
+  if (!fresh)
+    return -1;
+
+  ctx->env = fresh->env;
+  ctx->db = fresh->db;
+  ctx->txn = fresh->txn;
+  ctx->txn_mode = fresh->txn_mode;
+  FREE(&fresh->path);
+  FREE(&fresh);
+
+  return rc;
 }
 
 /**
@@ -320,4 +546,4 @@ static const char *store_lmdb_version(void)
   return "lmdb " MDB_VERSION_STRING;
 }
 
-STORE_BACKEND_OPS(lmdb)
+STORE_BACKEND_OPS_FULL(lmdb)
@@ -0,0 +1,562 @@
+/**
+ * @file
+ * In-memory LRU cache in front of a Store
+ *
+ * @authors
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * @copyright
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @page store_lru In-memory LRU cache in front of a Store
+ *
+ * Keep recently used records in memory, so that reading them again, e.g. when
+ * switching back to a folder, doesn't touch the disk.
+ *
+ * One cache is shared by all the Stores opened with store_lru_wrap(), and its
+ * memory limit applies to all of them.  A database's records are kept after
+ * it's closed.  When it's opened again, its file is checked: if it has been
+ * recreated, or rewritten by another process, its records are discarded.
+ * When the cache grows beyond its limit, the least-recently used entries are
+ * discarded.
+ *
+ * Writes and deletes are passed straight through to the backend.
+ */
+
+#include "config.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include "mutt/lib.h"
+#include "lib.h"
+
+/**
+ * struct LruDb - The cached records of one database
+ */
+struct LruDb
+{
+  char *path;                    ///< Path to the database file
+  struct HashTable *hash;        ///< Entries, indexed by LruEntry::key
+  size_t num;                    ///< Number of entries
+  int refs;                      ///< Number of open Stores using the database
+  dev_t dev;                     ///< Device of the file, when last closed
+  ino_t ino;                     ///< Inode of the file, when last closed
+  off_t size;                    ///< Size of the file, when last closed
+  struct timespec ctime;         ///< Change time of the file, when last closed
+  size_t hits;                   ///< Records found in memory
+  size_t misses;                 ///< Records read from the backend
+  STAILQ_ENTRY(LruDb) entries;   ///< Linked list
+};
+STAILQ_HEAD(LruDbList, LruDb);
+
+/**
+ * struct LruEntry - A cached record
+ */
+struct LruEntry
+{
+  struct LruDb *db;               ///< Database the record came from
+  char *key;                      ///< Key
+  void *value;                    ///< Copy of the Value
+  size_t vlen;                    ///< Length of the Value
+  size_t size;                    ///< Memory used by the entry
+  TAILQ_ENTRY(LruEntry) entries;  ///< Linked list, most-recently used first
+};
+TAILQ_HEAD(LruList, LruEntry);
+
+/**
+ * struct StoreLruCtx - An LRU cache wrapped around a Store
+ */
+struct StoreLruCtx
+{
+  const struct StoreOps *ops; ///< Backend
+  void *store;                ///< Backend's Store
+  struct LruDb *db;           ///< Cached records of the database
+};
+
+static struct LruDbList LruDbs = STAILQ_HEAD_INITIALIZER(LruDbs); ///< Databases with cached records
+static struct LruList LruEntries = TAILQ_HEAD_INITIALIZER(LruEntries); ///< Entries, most-recently used first
+static size_t LruUsed = 0;  ///< Memory used by all the entries
+static size_t LruLimit = 0; ///< Maximum memory to use
+
+/**
+ * lru_db_free - Forget a database
+ * @param db Database, with no entries
+ */
+static void lru_db_free(struct LruDb *db)
+{
+  STAILQ_REMOVE(&LruDbs, db, LruDb, entries);
+  mutt_hash_free(&db->hash);
+  FREE(&db->path);
+  FREE(&db);
+}
+
+/**
+ * lru_entry_free - Remove an entry from the cache and free it
+ * @param le Entry to free
+ *
+ * If it was the last entry of a closed database, the database is forgotten.
+ */
+static void lru_entry_free(struct LruEntry *le)
+{
+  struct LruDb *db = le->db;
+  mutt_hash_delete(db->hash, le->key, le);
+  db->num--;
+  TAILQ_REMOVE(&LruEntries, le, entries);
+  LruUsed -= le->size;
+  FREE(&le->key);
+  FREE(&le->value);
+  FREE(&le);
+
+  if ((db->num == 0) && (db->refs == 0))
+    lru_db_free(db);
+}
+
+/**
+ * lru_shrink - Discard the least-recently used entries
+ * @param limit Maximum memory to use
+ */
+static void lru_shrink(size_t limit)
+{
+  while ((LruUsed > limit) && !TAILQ_EMPTY(&LruEntries))
+    lru_entry_free(TAILQ_LAST(&LruEntries, LruList));
+}
+
+/**
+ * lru_db_purge - Discard all the entries of a database
+ * @param db Database
+ */
+static void lru_db_purge(struct LruDb *db)
+{
+  /* Keep the database while its entries are freed */
+  db->refs++;
+
+  struct LruEntry *le = NULL;
+  struct LruEntry *tmp = NULL;
+  TAILQ_FOREACH_SAFE(le, &LruEntries, entries, tmp)
+  {
+    if (le->db == db)
+      lru_entry_free(le);
+  }
+
+  db->refs--;
+}
+
+/**
+ * lru_find - Find a record in the cache
+ * @param ctx  LRU Store
+ * @param key  Key identifying the record
+ * @param klen Length of the Key string
+ * @retval ptr Cached entry, marked as most-recently used
+ */
+static struct LruEntry *lru_find(struct StoreLruCtx *ctx, const char *key, size_t klen)
+{
+  struct Buffer *buf = mutt_buffer_pool_get();
+  mutt_buffer_strcpy_n(buf, key, klen);
+  struct LruEntry *le = mutt_hash_find(ctx->db->hash, mutt_b2s(buf));
+  mutt_buffer_pool_release(&buf);
+
+  if (le && (le != TAILQ_FIRST(&LruEntries)))
+  {
+    TAILQ_REMOVE(&LruEntries, le, entries);
+    TAILQ_INSERT_HEAD(&LruEntries, le, entries);
+  }
+
+  return le;
+}
+
+/**
+ * lru_remove - Remove a record from the cache
+ * @param ctx  LRU Store
+ * @param key  Key identifying the record
+ * @param klen Length of the Key string
+ */
+static void lru_remove(struct StoreLruCtx *ctx, const char *key, size_t klen)
+{
+  struct LruEntry *le = lru_find(ctx, key, klen);
+  if (le)
+    lru_entry_free(le);
+}
+
+/**
+ * lru_add - Add a copy of a record to the cache
+ * @param ctx   LRU Store
+ * @param key   Key identifying the record
+ * @param klen  Length of the Key string
+ * @param value Value to save
+ * @param vlen  Length of the Value
+ */
+static void lru_add(struct StoreLruCtx *ctx, const char *key, size_t klen,
+                    const void *value, size_t vlen)
+{
+  lru_remove(ctx, key, klen);
+
+  size_t size = sizeof(struct LruEntry) + klen + 1 + vlen;
+  if (size > LruLimit)
+    return;
+
+  lru_shrink(LruLimit - size);
+
+  struct LruEntry *le = mutt_mem_calloc(1, sizeof(struct LruEntry));
+  le->db = ctx->db;
+  le->key = mutt_strn_dup(key, klen);
+  le->value = mutt_mem_malloc(MAX(vlen, 1));
+  memcpy(le->value, value, vlen);
+  le->vlen = vlen;
+  le->size = size;
+
+  mutt_hash_insert(ctx->db->hash, le->key, le);
+  ctx->db->num++;
+  TAILQ_INSERT_HEAD(&LruEntries, le, entries);
+  LruUsed += size;
+}
+
+/**
+ * lru_copy - Make a copy of a Value for the caller
+ * @param value Value to copy
+ * @param vlen  Length of the Value
+ * @retval ptr Copy of the Value
+ */
+static void *lru_copy(const void *value, size_t vlen)
+{
+  void *copy = mutt_mem_malloc(MAX(vlen, 1));
+  memcpy(copy, value, vlen);
+  return copy;
+}
+
+/**
+ * store_lru_open - Implements StoreOps::open()
+ *
+ * An LRU Store can only be created by wrapping a backend.
+ * @sa store_lru_wrap()
+ */
+static void *store_lru_open(const char *path)
+{
+  return NULL;
+}
+
+/**
+ * store_lru_fetch - Implements StoreOps::fetch()
+ */
+static void *store_lru_fetch(void *store, const char *key, size_t klen, size_t *vlen)
+{
+  if (!store)
+    return NULL;
+
+  struct StoreLruCtx *ctx = store;
+
+  struct LruEntry *le = lru_find(ctx, key, klen);
+  if (le)
+  {
+    ctx->db->hits++;
+    *vlen = le->vlen;
+    return lru_copy(le->value, le->vlen);
+  }
+
+  ctx->db->misses++;
+  void *value = ctx->ops->fetch(ctx->store, key, klen, vlen);
+  if (!value)
+    return NULL;
+
+  lru_add(ctx, key, klen, value, *vlen);
+  void *copy = lru_copy(value, *vlen);
+  ctx->ops->free(ctx->store, &value);
+  return copy;
+}
+
+/**
+ * store_lru_free - Implements StoreOps::free()
+ */
+static void store_lru_free(void *store, void **ptr)
+{
+  FREE(ptr);
+}
+
+/**
+ * store_lru_store - Implements StoreOps::store()
+ */
+static int store_lru_store(void *store, const char *key, size_t klen, void *value, size_t vlen)
+{
+  if (!store)
+    return -1;
+
+  struct StoreLruCtx *ctx = store;
+
+  int rc = ctx->ops->store(ctx->store, key, klen, value, vlen);
+  if (rc == 0)
+    lru_add(ctx, key, klen, value, vlen);
+  else
+    lru_remove(ctx, key, klen);
+
+  return rc;
+}
+
+/**
+ * store_lru_delete_record - Implements StoreOps::delete_record()
+ */
+static int store_lru_delete_record(void *store, const char *key, size_t klen)
+{
+  if (!store)
+    return -1;
+
+  struct StoreLruCtx *ctx = store;
+
+  lru_remove(ctx, key, klen);
+  return ctx->ops->delete_record(ctx->store, key, klen);
+}
+
+/**
+ * store_lru_close - Implements StoreOps::close()
+ *
+ * The cached records are kept, with the state of the database file, so they
+ * can be used if it's opened again unchanged.
+ */
+static void store_lru_close(void **ptr)
+{
+  if (!ptr || !*ptr)
+    return;
+
+  struct StoreLruCtx *ctx = *ptr;
+  struct LruDb *db = ctx->db;
+
+  ctx->ops->close(&ctx->store);
+
+  mutt_debug(LL_DEBUG1, "%s: %zu hits, %zu misses, %zu records cached\n",
+             db->path, db->hits, db->misses, db->num);
+
+  struct stat st = { 0 };
+  if (stat(db->path, &st) == 0)
+  {
+    db->dev = st.st_dev;
+    db->ino = st.st_ino;
+    db->size = st.st_size;
+    mutt_file_get_stat_timespec(&db->ctime, &st, MUTT_STAT_CTIME);
+  }
+  else
+  {
+    lru_db_purge(db);
+  }
+
+  db->refs--;
+  if ((db->refs == 0) && (db->num == 0))
+    lru_db_free(db);
+
+  FREE(ptr);
+}
+
+/**
+ * store_lru_fetch_many - Implements StoreOps::fetch_many()
+ *
+ * Only the Keys that aren't in the cache are fetched from the backend.
+ */
+static size_t store_lru_fetch_many(void *store, struct StoreKv *kvs, size_t num)
+{
+  if (!store)
+    return 0;
+
+  struct StoreLruCtx *ctx = store;
+
+  size_t found = 0;
+  size_t num_misses = 0;
+  struct StoreKv *misses = mutt_mem_calloc(MAX(num, 1), sizeof(struct StoreKv));
+  size_t *idx = mutt_mem_calloc(MAX(num, 1), sizeof(size_t));
+
+  for (size_t i = 0; i < num; i++)
+  {
+    struct LruEntry *le = lru_find(ctx, kvs[i].key, kvs[i].klen);
+    if (le)
+    {
+      ctx->db->hits++;
+      kvs[i].value = lru_copy(le->value, le->vlen);
+      kvs[i].vlen = le->vlen;
+      found++;
+      continue;
+    }
+
+    ctx->db->misses++;
+    kvs[i].value = NULL;
+    kvs[i].vlen = 0;
+    misses[num_misses].key = kvs[i].key;
+    misses[num_misses].klen = kvs[i].klen;
+    idx[num_misses] = i;
+    num_misses++;
+  }
+
+  if (num_misses > 0)
+  {
+    store_fetch_many(ctx->ops, ctx->store, misses, num_misses);
+    for (size_t i = 0; i < num_misses; i++)
+    {
+      if (!misses[i].value)
+        continue;
+
+      struct StoreKv *kv = &kvs[idx[i]];
+      lru_add(ctx, kv->key, kv->klen, misses[i].value, misses[i].vlen);
+      kv->value = lru_copy(misses[i].value, misses[i].vlen);
+      kv->vlen = misses[i].vlen;
+      ctx->ops->free(ctx->store, &misses[i].value);
+      found++;
+    }
+  }
+
+  FREE(&misses);
+  FREE(&idx);
+  return found;
+}
+
+/**
+ * store_lru_store_many - Implements StoreOps::store_many()
+ */
+static int store_lru_store_many(void *store, struct StoreKv *kvs, size_t num)
+{
+  if (!store)
+    return -1;
+
+  struct StoreLruCtx *ctx = store;
+
+  int rc = store_store_many(ctx->ops, ctx->store, kvs, num);
+  for (size_t i = 0; i < num; i++)
+  {
+    if (rc == 0)
+      lru_add(ctx, kvs[i].key, kvs[i].klen, kvs[i].value, kvs[i].vlen);
+    else
+      lru_remove(ctx, kvs[i].key, kvs[i].klen);
+  }
+
+  return rc;
+}
+
+/**
+ * store_lru_walk - Implements StoreOps::walk()
+ *
+ * The backend holds every record, so it's walked directly.
+ */
+static int store_lru_walk(void *store, const char *start, size_t slen,
+                          store_walk_t cb, void *data)
+{
+  if (!store)
+    return -1;
+
+  struct StoreLruCtx *ctx = store;
+  if (!ctx->ops->walk)
+    return -1;
+
+  return ctx->ops->walk(ctx->store, start, slen, cb, data);
+}
+
+/**
+ * store_lru_compact - Implements StoreOps::compact()
+ */
+static int store_lru_compact(void *store)
+{
+  if (!store)
+    return -1;
+
+  struct StoreLruCtx *ctx = store;
+  if (!ctx->ops->compact)
+    return -1;
+
+  return ctx->ops->compact(ctx->store);
+}
+
+/**
+ * store_lru_version - Implements StoreOps::version()
+ */
+static const char *store_lru_version(void)
+{
+  return "lru";
+}
+
+STORE_BACKEND_OPS_FULL(lru)
+
+/**
+ * lru_db_changed - Has a database file changed since it was closed?
+ * @param db Database
+ * @retval true The file has been recreated or modified, or it can't be read
+ */
+static bool lru_db_changed(struct LruDb *db)
+{
+  struct stat st = { 0 };
+  if (stat(db->path, &st) != 0)
+    return true;
+
+  return (st.st_dev != db->dev) || (st.st_ino != db->ino) ||
+         (st.st_size != db->size) ||
+         (mutt_file_stat_timespec_compare(&st, MUTT_STAT_CTIME, &db->ctime) != 0);
+}
+
+/**
+ * store_lru_wrap - Put an in-memory LRU cache in front of a Store
+ * @param ops   Backend
+ * @param store Store retrieved via StoreOps::open()
+ * @param path  Path to the database file
+ * @param limit Maximum memory to use for all the cached records
+ * @retval ptr LRU Store, to be used with #store_lru_ops
+ *
+ * The LRU Store takes ownership of the backend's Store.
+ *
+ * If the database's records are still cached from an earlier Store, they're
+ * reused, unless the file has changed since that Store was closed.
+ */
+void *store_lru_wrap(const struct StoreOps *ops, void *store, const char *path, size_t limit)
+{
+  if (!ops || !store || !path)
+    return NULL;
+
+  LruLimit = limit;
+  lru_shrink(LruLimit);
+
+  struct LruDb *db = NULL;
+  STAILQ_FOREACH(db, &LruDbs, entries)
+  {
+    if (mutt_str_equal(db->path, path))
+      break;
+  }
+
+  if (db)
+  {
+    if ((db->refs == 0) && lru_db_changed(db))
+    {
+      mutt_debug(LL_DEBUG1, "%s has changed, discarding %zu records\n", path, db->num);
+      lru_db_purge(db);
+    }
+  }
+  else
+  {
+    db = mutt_mem_calloc(1, sizeof(struct LruDb));
+    db->path = mutt_str_dup(path);
+    db->hash = mutt_hash_new(1024, MUTT_HASH_NO_FLAGS);
+    STAILQ_INSERT_TAIL(&LruDbs, db, entries);
+  }
+  db->refs++;
+
+  struct StoreLruCtx *ctx = mutt_mem_calloc(1, sizeof(struct StoreLruCtx));
+  ctx->ops = ops;
+  ctx->store = store;
+  ctx->db = db;
+  return ctx;
+}
+
+/**
+ * store_lru_cleanup - Free the LRU cache
+ *
+ * All the Stores using it must have been closed.
+ */
+void store_lru_cleanup(void)
+{
+  lru_shrink(0);
+}
@@ -181,6 +181,135 @@ static void store_rocksdb_close(void **ptr)
   *ptr = NULL;
 }
 
+/**
+ * store_rocksdb_fetch_many - Implements StoreOps::fetch_many()
+ */
+static size_t store_rocksdb_fetch_many(void *store, struct StoreKv *kvs, size_t num)
+{
+  if (!store || !kvs || (num == 0))
+    return 0;
+
+  struct RocksDB_Ctx *ctx = store;
+
+  const char **keys = mutt_mem_calloc(num, sizeof(char *));
+  size_t *klens = mutt_mem_calloc(num, sizeof(size_t));
+  char **values = mutt_mem_calloc(num, sizeof(char *));
+  size_t *vlens = mutt_mem_calloc(num, sizeof(size_t));
+  char **errs = mutt_mem_calloc(num, sizeof(char *));
+
+  for (size_t i = 0; i < num; i++)
+  {
+    keys[i] = kvs[i].key;
+    klens[i] = kvs[i].klen;
+  }
+
+  rocksdb_multi_get(ctx->db, ctx->read_options, num, keys, klens, values, vlens, errs);
+
+  size_t found = 0;
+  for (size_t i = 0; i < num; i++)
+  {
+    if (errs[i])
+    {
+      rocksdb_free(errs[i]);
+      rocksdb_free(values[i]);
+      values[i] = NULL;
+    }
+
+    kvs[i].value = values[i];
+    kvs[i].vlen = values[i] ? vlens[i] : 0;
+    if (values[i])
+      found++;
+  }
+
+  FREE(&errs);
+  FREE(&vlens);
+  FREE(&values);
+  FREE(&klens);
+  FREE(&keys);
+  return found;
+}
+
+/**
+ * store_rocksdb_store_many - Implements StoreOps::store_many()
+ *
+ * All the Values are written in a single WriteBatch.
+ */
+static int store_rocksdb_store_many(void *store, struct StoreKv *kvs, size_t num)
+{
+  if (!store || !kvs)
+    return -1;
+
+  struct RocksDB_Ctx *ctx = store;
+
+  rocksdb_writebatch_t *batch = rocksdb_writebatch_create();
+  for (size_t i = 0; i < num; i++)
+    rocksdb_writebatch_put(batch, kvs[i].key, kvs[i].klen, kvs[i].value, kvs[i].vlen);
+
+  rocksdb_write(ctx->db, ctx->write_options, batch, &ctx->err);
+  rocksdb_writebatch_destroy(batch);
+  if (ctx->err)
+  {
+    rocksdb_free(ctx->err);
+    ctx->err = NULL;
+    return -1;
+  }
+
+  return 0;
+}
+
+/**
+ * store_rocksdb_walk - Implements StoreOps::walk()
+ */
+static int store_rocksdb_walk(void *store, const char *start, size_t slen,
+                              store_walk_t cb, void *data)
+{
+  if (!store || !cb)
+    return -1;
+
+  struct RocksDB_Ctx *ctx = store;
+
+  rocksdb_iterator_t *it = rocksdb_create_iterator(ctx->db, ctx->read_options);
+  if (start)
+  {
+    /* Find the first Key >= start */
+    rocksdb_iter_seek(it, start, slen);
+    size_t klen = 0;
+    const char *key = rocksdb_iter_valid(it) ? rocksdb_iter_key(it, &klen) : NULL;
+    if (key && (klen == slen) && (memcmp(key, start, slen) == 0))
+      rocksdb_iter_next(it);
+  }
+  else
+  {
+    rocksdb_iter_seek_to_first(it);
+  }
+
+  for (; rocksdb_iter_valid(it); rocksdb_iter_next(it))
+  {
+    size_t klen = 0;
+    const char *key = rocksdb_iter_key(it, &klen);
+    if (!cb(key, klen, data))
+      break;
+  }
+  rocksdb_iter_destroy(it);
+
+  return 0;
+}
+
+/**
+ * store_rocksdb_compact - Implements StoreOps::compact()
+ */
+static int store_rocksdb_compact(void *store)
+{
+  if (!store)
+    return -1;
+
+  struct RocksDB_Ctx *ctx = store;
+
+  /* NULL keys mean the whole database */
+  rocksdb_compact_range(ctx->db, NULL, 0, NULL, 0);
+  return 0;
+}
+
 /**
  * store_rocksdb_version - Implements StoreOps::version()
  */
@@ -191,4 +320,4 @@ static const char *store_rocksdb_version(void)
   return "RocksDB " RDBVER(ROCKSDB_MAJOR, ROCKSDB_MINOR, ROCKSDB_PATCH);
 }
 
-STORE_BACKEND_OPS(rocksdb)
+STORE_BACKEND_OPS_FULL(rocksdb)
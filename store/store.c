@@ -130,3 +130,65 @@ bool store_is_valid_backend(const char *str)
 {
   return store_get_backend_ops(str);
 }
+
+/**
+ * store_fetch_many - Fetch many Values from a Store
+ * @param ops   Store backend
+ * @param store Store retrieved via StoreOps::open()
+ * @param kvs   Array of Keys, Values will be filled in
+ * @param num   Number of entries in the array
+ * @retval num Number of Values found
+ *
+ * If the backend doesn't support batch fetches, each Key is fetched in turn.
+ * The Values must be freed using StoreOps::free().
+ */
+size_t store_fetch_many(const struct StoreOps *ops, void *store, struct StoreKv *kvs, size_t num)
+{
+  if (!ops || !store || !kvs)
+    return 0;
+
+  if (ops->fetch_many)
+    return ops->fetch_many(store, kvs, num);
+
+  size_t found = 0;
+  for (size_t i = 0; i < num; i++)
+  {
+    kvs[i].vlen = 0;
+    kvs[i].value = ops->fetch(store, kvs[i].key, kvs[i].klen, &kvs[i].vlen);
+    if (kvs[i].value)
+      found++;
+  }
+
+  return found;
+}
+
+/**
+ * store_store_many - Write many Values to a Store
+ * @param ops   Store backend
+ * @param store Store retrieved via StoreOps::open()
+ * @param kvs   Array of Key/Value pairs to save
+ * @param num   Number of entries in the array
+ * @retval 0   Success
+ * @retval num Error, a backend-specific error code
+ *
+ * If the backend doesn't support batch writes, each Value is stored in turn.
+ * The first error is returned, but the remaining Values are still stored.
+ */
+int store_store_many(const struct StoreOps *ops, void *store, struct StoreKv *kvs, size_t num)
+{
+  if (!ops || !store || !kvs)
+    return -1;
+
+  if (ops->store_many)
+    return ops->store_many(store, kvs, num);
+
+  int rc = 0;
+  for (size_t i = 0; i < num; i++)
+  {
+    int rc2 = ops->store(store, kvs[i].key, kvs[i].klen, kvs[i].value, kvs[i].vlen);
+    if (rc == 0)
+      rc = rc2;
+  }
+
+  return rc;
+}
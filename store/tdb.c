@@ -30,6 +30,7 @@
 #include "config.h"
 #include <stddef.h>
 #include <fcntl.h>
+#include <stdbool.h>
 #include <tdb.h>
 #include "mutt/lib.h"
 #include "lib.h"
@@ -97,7 +98,7 @@ static int store_tdb_store(void *store, const char *key, size_t klen, void *valu
   databuf.dsize = vlen;
   databuf.dptr = value;
 
-  return tdb_store(db, dkey, databuf, TDB_INSERT);
+  return tdb_store(db, dkey, databuf, TDB_REPLACE);
 }
 
 /**
@@ -130,6 +131,143 @@ static void store_tdb_close(void **ptr)
   *ptr = NULL;
 }
 
+/**
+ * store_tdb_fetch_many - Implements StoreOps::fetch_many()
+ *
+ * The database is read-locked once for all the Keys.
+ */
+static size_t store_tdb_fetch_many(void *store, struct StoreKv *kvs, size_t num)
+{
+  if (!store || !kvs)
+    return 0;
+
+  TDB_CONTEXT *db = store;
+  TDB_DATA dkey;
+  TDB_DATA data;
+  size_t found = 0;
+
+  const bool locked = (tdb_lockall_read(db) == 0);
+  for (size_t i = 0; i < num; i++)
+  {
+    dkey.dptr = (unsigned char *) kvs[i].key;
+    dkey.dsize = kvs[i].klen;
+    data = tdb_fetch(db, dkey);
+
+    kvs[i].value = data.dptr;
+    kvs[i].vlen = data.dsize;
+    if (data.dptr)
+      found++;
+  }
+  if (locked)
+    tdb_unlockall_read(db);
+
+  return found;
+}
+
+/**
+ * store_tdb_store_many - Implements StoreOps::store_many()
+ *
+ * All the Values are written in a single transaction.  If any write fails,
+ * none of them are saved.
+ */
+static int store_tdb_store_many(void *store, struct StoreKv *kvs, size_t num)
+{
+  if (!store || !kvs)
+    return -1;
+
+  TDB_CONTEXT *db = store;
+  TDB_DATA dkey;
+  TDB_DATA databuf;
+
+  int rc = tdb_transaction_start(db);
+  if (rc != 0)
+    return rc;
+
+  for (size_t i = 0; i < num; i++)
+  {
+    dkey.dptr = (unsigned char *) kvs[i].key;
+    dkey.dsize = kvs[i].klen;
+    databuf.dptr = kvs[i].value;
+    databuf.dsize = kvs[i].vlen;
+
+    /* A failed write spoils the transaction, so the whole batch is abandoned */
+    rc = tdb_store(db, dkey, databuf, TDB_REPLACE);
+    if (rc != 0)
+    {
+      tdb_transaction_cancel(db);
+      return rc;
+    }
+  }
+
+  return tdb_transaction_commit(db);
+}
+
+/**
+ * struct TdbWalk - Private data for tdb_walk_cb()
+ */
+struct TdbWalk
+{
+  store_walk_t cb; ///< Caller's function
+  void *data;      ///< Caller's private data
+};
+
+/**
+ * tdb_walk_cb - Pass a Key to the caller - Implements ::tdb_traverse_func
+ */
+static int tdb_walk_cb(TDB_CONTEXT *db, TDB_DATA key, TDB_DATA value, void *data)
+{
+  struct TdbWalk *tw = data;
+  return tw->cb((const char *) key.dptr, key.dsize, tw->data) ? 0 : 1;
+}
+
+/**
+ * store_tdb_walk - Implements StoreOps::walk()
+ */
+static int store_tdb_walk(void *store, const char *start, size_t slen,
+                          store_walk_t cb, void *data)
+{
+  if (!store || !cb)
+    return -1;
+
+  TDB_CONTEXT *db = store;
+
+  if (!start)
+  {
+    struct TdbWalk tw = { cb, data };
+    return (tdb_traverse(db, tdb_walk_cb, &tw) < 0) ? -1 : 0;
+  }
+
+  /* Resume the walk by hand */
+  TDB_DATA skey = { (unsigned char *) start, slen };
+  TDB_DATA dkey = tdb_nextkey(db, skey);
+  while (dkey.dptr)
+  {
+    if (!cb((const char *) dkey.dptr, dkey.dsize, data))
+    {
+      FREE(&dkey.dptr);
+      break;
+    }
+
+    TDB_DATA next = tdb_nextkey(db, dkey);
+    FREE(&dkey.dptr);
+    dkey = next;
+  }
+
+  return 0;
+}
+
+/**
+ * store_tdb_compact - Implements StoreOps::compact()
+ */
+static int store_tdb_compact(void *store)
+{
+  if (!store)
+    return -1;
+
+  TDB_CONTEXT *db = store;
+  return tdb_repack(db);
+}
+
 /**
  * store_tdb_version - Implements StoreOps::version()
  */
@@ -139,4 +277,4 @@ static const char *store_tdb_version(void)
   return "tdb";
 }
 
-STORE_BACKEND_OPS(tdb)
+STORE_BACKEND_OPS_FULL(tdb)
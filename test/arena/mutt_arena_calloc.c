@@ -0,0 +1,80 @@
+/**
+ * @file
+ * Test code for mutt_arena_calloc()
+ *
+ * @authors
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * @copyright
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define TEST_NO_MAIN
+#include "config.h"
+#include <stdint.h>
+#include <string.h>
+#include "acutest.h"
+#include "mutt/lib.h"
+
+void test_mutt_arena_calloc(void)
+{
+  // void *mutt_arena_calloc(struct Arena *a, size_t size);
+
+  {
+    void *p = mutt_arena_calloc(NULL, 16);
+    TEST_CHECK(p != NULL);
+    FREE(&p);
+  }
+
+  {
+    struct Arena *a = mutt_arena_new();
+    char *p1 = mutt_arena_calloc(a, 0);
+    char *p2 = mutt_arena_calloc(a, 0);
+    TEST_CHECK(p1 != NULL);
+    TEST_CHECK(p1 != p2);
+    mutt_arena_free(&a);
+  }
+
+  {
+    struct Arena *a = mutt_arena_new();
+    char *prev = NULL;
+    for (size_t i = 1; i < 1000; i++)
+    {
+      char *p = mutt_arena_calloc(a, i);
+      if (!TEST_CHECK(p != NULL))
+        break;
+      TEST_CHECK(((uintptr_t) p % sizeof(void *)) == 0);
+      for (size_t j = 0; j < i; j++)
+      {
+        if (!TEST_CHECK(p[j] == '\0'))
+          break;
+      }
+      memset(p, 'x', i);
+      if (prev)
+        TEST_CHECK(prev[0] == 'x');
+      prev = p;
+    }
+    mutt_arena_free(&a);
+  }
+
+  {
+    struct Arena *a = mutt_arena_new();
+    const size_t big = 4 * 1024 * 1024;
+    char *p = mutt_arena_calloc(a, big);
+    TEST_CHECK(p != NULL);
+    TEST_CHECK((p[0] == '\0') && (p[big - 1] == '\0'));
+    TEST_CHECK(mutt_arena_size(a) >= big);
+    mutt_arena_free(&a);
+  }
+}
@@ -0,0 +1,314 @@
+/**
+ * @file
+ * Email layout benchmark
+ *
+ * @authors
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * @copyright
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * Time the passes over a large Mailbox that only read the "hot" fields of
+ * each Email, using synthetic Emails allocated from an Arena, like a real
+ * Mailbox:
+ *
+ * - sort-date:  sort by date sent, like compare_date_sent()
+ * - sort-score: sort by score, like compare_score()
+ * - limit:      rebuild the tables, like ctx_update_tables()
+ * - vnum:       renumber the visible Emails, like mutt_set_vnum()
+ *
+ * Each pass is run several times and the fastest is reported as a single line
+ * of JSON, e.g.
+ *
+ * `{"op":"sort-date","emails":1000000,"email_size":96,"ms":306.9}`
+ *
+ * Usage: email-bench [-n emails] [-r repeats]
+ */
+
+#include "config.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "mutt/lib.h"
+#include "email/lib.h"
+
+/**
+ * now_ns - Get a monotonic timestamp
+ * @retval num Time in nanoseconds
+ */
+static uint64_t now_ns(void)
+{
+  struct timespec ts = { 0 };
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((uint64_t) ts.tv_sec * 1000000000) + ts.tv_nsec;
+}
+
+/**
+ * compare_date - Compare the sent date of two emails - Implements ::sort_t
+ */
+static int compare_date(const void *a, const void *b)
+{
+  struct Email const *const *pa = (struct Email const *const *) a;
+  struct Email const *const *pb = (struct Email const *const *) b;
+  int result = (*pa)->date_sent - (*pb)->date_sent;
+  if (result == 0)
+    result = (*pa)->index - (*pb)->index;
+  return result;
+}
+
+/**
+ * compare_score - Compare the score of two emails - Implements ::sort_t
+ */
+static int compare_score(const void *a, const void *b)
+{
+  struct Email const *const *pa = (struct Email const *const *) a;
+  struct Email const *const *pb = (struct Email const *const *) b;
+  int result = (*pb)->score - (*pa)->score;
+  if (result == 0)
+    result = (*pa)->index - (*pb)->index;
+  return result;
+}
+
+/**
+ * emails_generate - Create some Emails
+ * @param arena Arena for the Emails
+ * @param parts Arena for the Envelopes and Bodies
+ * @param num   Number of Emails
+ * @retval ptr Array of Emails
+ *
+ * Each Email gets an Envelope and a Body, allocated in the same order as the
+ * mbox parser does.  The dates, scores and flags are pseudo-random.
+ */
+static struct Email **emails_generate(struct Arena *arena, struct Arena *parts, size_t num)
+{
+  struct Email **emails = mutt_mem_calloc(num, sizeof(struct Email *));
+  uint32_t seed = 2463534242;
+
+  EmailArena = arena;
+  EnvelopeArena = parts;
+  for (size_t i = 0; i < num; i++)
+  {
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+
+    struct Email *e = email_new();
+    e->env = mutt_env_new();
+    e->content = mutt_body_new();
+    e->content->length = 1024 + (seed % 4096);
+    e->date_sent = 1577836800 + (seed % (365 * 86400));
+    e->received = e->date_sent + (seed % 600);
+    e->score = seed % 100;
+    e->index = i;
+    e->msgno = i;
+    e->vnum = ((seed % 10) == 0) ? -1 : 0;
+    e->read = (seed % 3) != 0;
+    e->old = (seed % 7) == 0;
+    e->flagged = (seed % 50) == 0;
+    e->deleted = (seed % 200) == 0;
+    e->active = true;
+    emails[i] = e;
+  }
+  EmailArena = NULL;
+  EnvelopeArena = NULL;
+
+  return emails;
+}
+
+/**
+ * pass_limit - Rebuild the tables of visible Emails
+ * @param emails Emails
+ * @param v2r    Virtual to real message numbers
+ * @param num    Number of Emails
+ * @retval num Sum of the counters, so that the pass isn't optimised away
+ */
+static size_t pass_limit(struct Email **emails, int *v2r, size_t num)
+{
+  size_t vcount = 0;
+  size_t vsize = 0;
+  size_t deleted = 0;
+  size_t unread = 0;
+  size_t flagged = 0;
+
+  for (size_t i = 0; i < num; i++)
+  {
+    struct Email *e = emails[i];
+    if (e->quasi_deleted || !e->active)
+      continue;
+
+    e->msgno = i;
+    if (e->vnum != -1)
+    {
+      v2r[vcount] = i;
+      e->vnum = vcount++;
+      vsize += e->content->length + e->content->offset - e->content->hdr_offset;
+    }
+
+    if (e->deleted)
+      deleted++;
+    if (e->flagged)
+      flagged++;
+    if (!e->read)
+      unread++;
+  }
+
+  return unread + deleted + flagged + vsize;
+}
+
+/**
+ * pass_vnum - Renumber the visible Emails
+ * @param emails Emails
+ * @param v2r    Virtual to real message numbers
+ * @param num    Number of Emails
+ * @retval num Sum of the counters, so that the pass isn't optimised away
+ */
+static size_t pass_vnum(struct Email **emails, int *v2r, size_t num)
+{
+  size_t vcount = 0;
+  size_t vsize = 0;
+
+  for (size_t i = 0; i < num; i++)
+  {
+    struct Email *e = emails[i];
+    if (e->vnum >= 0)
+    {
+      e->vnum = vcount;
+      v2r[vcount++] = i;
+      vsize += e->content->length + e->content->offset - e->content->hdr_offset;
+    }
+  }
+
+  return vcount + vsize;
+}
+
+/**
+ * bench_print - Print a result as JSON
+ * @param op  Operation
+ * @param num Number of Emails
+ * @param ns  Fastest time (ns)
+ */
+static void bench_print(const char *op, size_t num, uint64_t ns)
+{
+  printf("{\"op\":\"%s\",\"emails\":%zu,\"email_size\":%zu,\"ms\":%.1f}\n", op,
+         num, sizeof(struct Email), ns / 1e6);
+  fflush(stdout);
+}
+
+/**
+ * bench_sort - Time a sort of the Emails
+ * @param op      Operation
+ * @param emails  Emails, in mailbox order
+ * @param num     Number of Emails
+ * @param repeats Number of runs
+ * @param cmp     Comparison function
+ */
+static void bench_sort(const char *op, struct Email **emails, size_t num,
+                       int repeats, int (*cmp)(const void *, const void *))
+{
+  struct Email **sorted = mutt_mem_calloc(num, sizeof(struct Email *));
+  uint64_t best = UINT64_MAX;
+
+  for (int r = 0; r < repeats; r++)
+  {
+    memcpy(sorted, emails, num * sizeof(struct Email *));
+    const uint64_t start = now_ns();
+    qsort(sorted, num, sizeof(struct Email *), cmp);
+    best = MIN(best, now_ns() - start);
+  }
+
+  bench_print(op, num, best);
+  FREE(&sorted);
+}
+
+/**
+ * bench_pass - Time a pass over the Emails
+ * @param op      Operation
+ * @param emails  Emails
+ * @param num     Number of Emails
+ * @param repeats Number of runs
+ * @param limit   true for pass_limit(), false for pass_vnum()
+ */
+static void bench_pass(const char *op, struct Email **emails, size_t num,
+                       int repeats, bool limit)
+{
+  int *v2r = mutt_mem_calloc(num, sizeof(int));
+  uint64_t best = UINT64_MAX;
+  volatile size_t sink = 0;
+
+  for (int r = 0; r < repeats; r++)
+  {
+    const uint64_t start = now_ns();
+    sink += limit ? pass_limit(emails, v2r, num) : pass_vnum(emails, v2r, num);
+    best = MIN(best, now_ns() - start);
+  }
+
+  bench_print(op, num, best);
+  FREE(&v2r);
+}
+
+/**
+ * main - Run the benchmarks
+ * @param argc Number of arguments
+ * @param argv Arguments
+ * @retval 0 Success
+ */
+int main(int argc, char *argv[])
+{
+  size_t num = 100000;
+  int repeats = 5;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "n:r:")) != -1)
+  {
+    switch (opt)
+    {
+      case 'n':
+        num = strtoul(optarg, NULL, 10);
+        break;
+      case 'r':
+        repeats = atoi(optarg);
+        break;
+      default:
+        fprintf(stderr, "Usage: %s [-n emails] [-r repeats]\n", argv[0]);
+        return 1;
+    }
+  }
+
+  if ((num == 0) || (repeats < 1))
+    return 1;
+
+  MuttLogger = log_disp_null;
+
+  struct Arena *arena = mutt_arena_new();
+  struct Arena *parts = mutt_arena_new();
+  struct Email **emails = emails_generate(arena, parts, num);
+
+  bench_sort("sort-date", emails, num, repeats, compare_date);
+  bench_sort("sort-score", emails, num, repeats, compare_score);
+  bench_pass("limit", emails, num, repeats, true);
+  bench_pass("vnum", emails, num, repeats, false);
+
+  for (size_t i = 0; i < num; i++)
+    email_free(&emails[i]);
+  FREE(&emails);
+  mutt_arena_free(&arena);
+  mutt_arena_free(&parts);
+  return 0;
+}
@@ -0,0 +1,513 @@
+/**
+ * @file
+ * Header cache benchmark
+ *
+ * @authors
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * @copyright
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * Measure the parts of the header cache separately, using synthetic Emails:
+ *
+ * - serialize:   serial_dump_email() and serial_restore_email()
+ * - compress:    each ComprOps backend, with a dictionary if it's supported
+ * - store:       each StoreOps backend
+ *
+ * Each result is printed as a single line of JSON, e.g.
+ *
+ * `{"group":"compress","name":"zstd","op":"compress","records":10000,"ops_per_sec":512345,"bytes_per_record":212.4,"p99_ns":3100}`
+ *
+ * Usage: hcache-bench [-n records] [-d directory]
+ */
+
+#include "config.h"
+#include <limits.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "mutt/lib.h"
+#include "address/lib.h"
+#include "email/lib.h"
+#include "compress/lib.h"
+#include "hcache/serialize.h"
+#include "store/lib.h"
+
+/**
+ * struct BenchResult - Timings for one operation
+ */
+struct BenchResult
+{
+  const char *group;  ///< Part of the cache, e.g. "store"
+  const char *name;   ///< Backend name, e.g. "lmdb"
+  const char *op;     ///< Operation, e.g. "fetch"
+  size_t records;     ///< Number of records processed
+  uint64_t *times;    ///< Time taken by each operation (ns)
+  uint64_t total;     ///< Total time (ns)
+  size_t bytes;       ///< Total size of the records
+};
+
+/**
+ * struct BenchRecord - A serialised Email
+ */
+struct BenchRecord
+{
+  char key[32];  ///< Store key
+  void *data;    ///< Record
+  size_t len;    ///< Length of the record
+};
+
+/**
+ * now_ns - Get a monotonic timestamp
+ * @retval num Time in nanoseconds
+ */
+static uint64_t now_ns(void)
+{
+  struct timespec ts = { 0 };
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((uint64_t) ts.tv_sec * 1000000000) + ts.tv_nsec;
+}
+
+/**
+ * cmp_u64 - Compare two timings - Implements ::sort_t
+ */
+static int cmp_u64(const void *a, const void *b)
+{
+  const uint64_t x = *(const uint64_t *) a;
+  const uint64_t y = *(const uint64_t *) b;
+  return (x > y) - (x < y);
+}
+
+/**
+ * result_init - Prepare to time an operation
+ * @param r       Result to initialise
+ * @param group   Part of the cache
+ * @param name    Backend name
+ * @param op      Operation
+ * @param records Number of records
+ */
+static void result_init(struct BenchResult *r, const char *group,
+                        const char *name, const char *op, size_t records)
+{
+  memset(r, 0, sizeof(*r));
+  r->group = group;
+  r->name = name;
+  r->op = op;
+  r->records = records;
+  r->times = mutt_mem_calloc(records, sizeof(uint64_t));
+}
+
+/**
+ * result_add - Record the timing of one operation
+ * @param r     Result
+ * @param i     Index of the record
+ * @param start Start time, see now_ns()
+ * @param bytes Size of the record
+ */
+static void result_add(struct BenchResult *r, size_t i, uint64_t start, size_t bytes)
+{
+  const uint64_t t = now_ns() - start;
+  r->times[i] = t;
+  r->total += t;
+  r->bytes += bytes;
+}
+
+/**
+ * result_print - Print a result as JSON and free it
+ * @param r Result
+ */
+static void result_print(struct BenchResult *r)
+{
+  double ops = 0;
+  double bytes = 0;
+  uint64_t p99 = 0;
+
+  if (r->records > 0)
+  {
+    qsort(r->times, r->records, sizeof(uint64_t), cmp_u64);
+    p99 = r->times[((r->records * 99) - 1) / 100];
+    bytes = (double) r->bytes / r->records;
+    if (r->total > 0)
+      ops = (double) r->records * 1000000000 / r->total;
+  }
+
+  printf("{\"group\":\"%s\",\"name\":\"%s\",\"op\":\"%s\",\"records\":%zu,"
+         "\"ops_per_sec\":%.0f,\"bytes_per_record\":%.1f,\"p99_ns\":%llu}\n",
+         r->group, r->name, r->op, r->records, ops, bytes, (unsigned long long) p99);
+  fflush(stdout);
+
+  FREE(&r->times);
+}
+
+/**
+ * email_generate - Create a realistic-looking Email
+ * @param n Sequence number
+ * @retval ptr New Email
+ */
+static struct Email *email_generate(size_t n)
+{
+  char buf[256];
+  struct Email *e = email_new();
+  struct Envelope *env = mutt_env_new();
+  e->env = env;
+
+  snprintf(buf, sizeof(buf), "\"User %zu\" <user%zu@example.com>", n % 97, n % 97);
+  mutt_addrlist_parse(&env->from, buf);
+  snprintf(buf, sizeof(buf), "list%zu@lists.example.org", n % 7);
+  mutt_addrlist_parse(&env->to, buf);
+  if ((n % 3) == 0)
+  {
+    snprintf(buf, sizeof(buf), "Someone <someone%zu@example.net>, other%zu@example.net",
+             n % 13, n % 11);
+    mutt_addrlist_parse(&env->cc, buf);
+  }
+
+  snprintf(buf, sizeof(buf), "Re: [list%zu] Discussion of topic number %zu", n % 7, n / 5);
+  env->subject = mutt_str_dup(buf);
+  env->real_subj = env->subject + 4;
+  snprintf(buf, sizeof(buf), "<%zu.%zu@mail%zu.example.com>", n * 7919, n, n % 5);
+  env->message_id = mutt_str_dup(buf);
+  env->x_label = ((n % 10) == 0) ? mutt_intern_get("work") : NULL;
+  env->organization = ((n % 4) == 0) ? mutt_intern_get("Example Organisation") : NULL;
+
+  for (size_t i = 1; (i <= 3) && (i <= n); i++)
+  {
+    snprintf(buf, sizeof(buf), "<%zu.%zu@mail%zu.example.com>", (n - i) * 7919,
+             n - i, (n - i) % 5);
+    mutt_list_insert_tail(&env->references, mutt_str_dup(buf));
+  }
+  if (n > 0)
+  {
+    snprintf(buf, sizeof(buf), "<%zu.%zu@mail%zu.example.com>", (n - 1) * 7919,
+             n - 1, (n - 1) % 5);
+    mutt_list_insert_tail(&env->in_reply_to, mutt_str_dup(buf));
+  }
+
+  struct Body *b = mutt_body_new();
+  b->type = TYPE_TEXT;
+  b->subtype = mutt_str_dup("plain");
+  b->encoding = ENC_QUOTED_PRINTABLE;
+  b->length = 1000 + (n % 5000);
+  b->offset = 500;
+  b->hdr_offset = 0;
+  mutt_param_set(&b->parameter, "charset", "utf-8");
+  e->content = b;
+
+  e->date_sent = 1577836800 + (n * 3600);
+  e->received = e->date_sent + 60;
+  e->lines = 20 + (n % 100);
+  e->read = (n % 2);
+  e->flagged = ((n % 20) == 0);
+  e->index = n;
+  e->msgno = n;
+
+  return e;
+}
+
+/**
+ * bench_serialize - Time serial_dump_email() and serial_restore_email()
+ * @param emails Emails to serialise
+ * @param recs   Records to fill in
+ * @param num    Number of Emails
+ */
+static void bench_serialize(struct Email **emails, struct BenchRecord *recs, size_t num)
+{
+  struct BenchResult r = { 0 };
+
+  result_init(&r, "serialize", "record", "dump", num);
+  for (size_t i = 0; i < num; i++)
+  {
+    int off = 0;
+    const uint64_t start = now_ns();
+    unsigned char *d = mutt_mem_malloc(4096);
+    d = serial_dump_email(emails[i], d, &off, false);
+    result_add(&r, i, start, off);
+
+    snprintf(recs[i].key, sizeof(recs[i].key), "/%zu", i);
+    recs[i].data = d;
+    recs[i].len = off;
+  }
+  result_print(&r);
+
+  result_init(&r, "serialize", "record", "restore", num);
+  for (size_t i = 0; i < num; i++)
+  {
+    const uint64_t start = now_ns();
+    struct Email *e = serial_restore_email(recs[i].data, recs[i].len, false, false);
+    result_add(&r, i, start, recs[i].len);
+    email_free(&e);
+  }
+  result_print(&r);
+
+  result_init(&r, "serialize", "record", "restore_lazy", num);
+  for (size_t i = 0; i < num; i++)
+  {
+    const uint64_t start = now_ns();
+    struct Email *e = serial_restore_email(recs[i].data, recs[i].len, true, false);
+    result_add(&r, i, start, recs[i].len);
+    email_free(&e);
+  }
+  result_print(&r);
+}
+
+/**
+ * bench_compress - Time a compression backend
+ * @param cops Compression backend
+ * @param name Name for the results
+ * @param dict Dictionary to use, may be NULL
+ * @param dlen Length of the dictionary
+ * @param recs Records to compress
+ * @param num  Number of records
+ */
+static void bench_compress(const struct ComprOps *cops, const char *name, void *dict,
+                           size_t dlen, struct BenchRecord *recs, size_t num)
+{
+  struct BenchResult r = { 0 };
+  void **cdata = mutt_mem_calloc(num, sizeof(void *));
+  size_t *clen = mutt_mem_calloc(num, sizeof(size_t));
+
+  void *cctx = cops->open(MAX(cops->min_level, 1));
+  if (!cctx)
+    goto done;
+
+  if (dict && !cops->set_dict(cctx, dict, dlen))
+  {
+    cops->close(&cctx);
+    goto done;
+  }
+
+  result_init(&r, "compress", name, "compress", num);
+  for (size_t i = 0; i < num; i++)
+  {
+    const uint64_t start = now_ns();
+    void *c = cops->compress(cctx, recs[i].data, recs[i].len, &clen[i]);
+    result_add(&r, i, start, c ? clen[i] : 0);
+
+    /* The compressed data belongs to the context, keep a copy */
+    if (c)
+    {
+      cdata[i] = mutt_mem_malloc(clen[i]);
+      memcpy(cdata[i], c, clen[i]);
+    }
+  }
+  result_print(&r);
+
+  result_init(&r, "compress", name, "decompress", num);
+  for (size_t i = 0; i < num; i++)
+  {
+    if (!cdata[i])
+      continue;
+    const uint64_t start = now_ns();
+    cops->decompress(cctx, cdata[i], clen[i]);
+    result_add(&r, i, start, recs[i].len);
+  }
+  result_print(&r);
+
+  cops->close(&cctx);
+
+done:
+  for (size_t i = 0; i < num; i++)
+    FREE(&cdata[i]);
+  FREE(&cdata);
+  FREE(&clen);
+}
+
+/**
+ * bench_compress_dict - Time a compression backend using a trained dictionary
+ * @param cops Compression backend
+ * @param recs Records to compress
+ * @param num  Number of records
+ *
+ * The dictionary is trained from the first 1000 records, like the header cache.
+ */
+static void bench_compress_dict(const struct ComprOps *cops, struct BenchRecord *recs, size_t num)
+{
+  const size_t num_samples = MIN(num, 1000);
+  size_t *sizes = mutt_mem_calloc(num_samples, sizeof(size_t));
+  struct Buffer samples = mutt_buffer_make(0);
+
+  for (size_t i = 0; i < num_samples; i++)
+  {
+    mutt_buffer_addstr_n(&samples, recs[i].data, recs[i].len);
+    sizes[i] = recs[i].len;
+  }
+
+  size_t dlen = 0;
+  void *dict = cops->train(samples.data, sizes, num_samples, &dlen);
+  if (dict)
+  {
+    char name[64];
+    snprintf(name, sizeof(name), "%s+dict", cops->name);
+    bench_compress(cops, name, dict, dlen, recs, num);
+  }
+
+  FREE(&dict);
+  mutt_buffer_dealloc(&samples);
+  FREE(&sizes);
+}
+
+/**
+ * bench_store - Time a storage backend
+ * @param sops Storage backend
+ * @param dir  Directory for the database
+ * @param recs Records to store
+ * @param num  Number of records
+ */
+static void bench_store(const struct StoreOps *sops, const char *dir,
+                        struct BenchRecord *recs, size_t num)
+{
+  struct BenchResult r = { 0 };
+  char path[PATH_MAX];
+  snprintf(path, sizeof(path), "%s/bench.%s", dir, sops->name);
+
+  void *db = sops->open(path);
+  if (!db)
+  {
+    fprintf(stderr, "Can't open %s database: %s\n", sops->name, path);
+    return;
+  }
+
+  result_init(&r, "store", sops->name, "store", num);
+  for (size_t i = 0; i < num; i++)
+  {
+    const uint64_t start = now_ns();
+    sops->store(db, recs[i].key, strlen(recs[i].key), recs[i].data, recs[i].len);
+    result_add(&r, i, start, recs[i].len);
+  }
+  result_print(&r);
+
+  result_init(&r, "store", sops->name, "fetch", num);
+  for (size_t i = 0; i < num; i++)
+  {
+    size_t vlen = 0;
+    const uint64_t start = now_ns();
+    void *data = sops->fetch(db, recs[i].key, strlen(recs[i].key), &vlen);
+    sops->free(db, &data);
+    result_add(&r, i, start, vlen);
+  }
+  result_print(&r);
+
+  sops->close(&db);
+}
+
+/**
+ * bench_backends - Run a benchmark for each backend in a list
+ * @param list  Comma-space-separated list of names
+ * @param store true for Store backends, false for compression
+ * @param dir   Directory for the databases
+ * @param recs  Records to use
+ * @param num   Number of records
+ */
+static void bench_backends(const char *list, bool store, const char *dir,
+                           struct BenchRecord *recs, size_t num)
+{
+  struct ListHead names = STAILQ_HEAD_INITIALIZER(names);
+  mutt_list_str_split(&names, list, ',');
+  struct ListNode *np = NULL;
+  STAILQ_FOREACH(np, &names, entries)
+  {
+    const char *name = mutt_str_skip_whitespace(np->data);
+    if (store)
+    {
+      const struct StoreOps *sops = store_get_backend_ops(name);
+      if (sops)
+        bench_store(sops, dir, recs, num);
+    }
+    else
+    {
+      const struct ComprOps *cops = compress_get_ops(name);
+      if (!cops)
+        continue;
+      bench_compress(cops, cops->name, NULL, 0, recs, num);
+      if (cops->train)
+        bench_compress_dict(cops, recs, num);
+    }
+  }
+  mutt_list_free(&names);
+}
+
+/**
+ * main - Run the header cache benchmarks
+ * @param argc Number of command line arguments
+ * @param argv Command line arguments
+ * @retval 0 Success
+ * @retval 1 Error
+ */
+int main(int argc, char *argv[])
+{
+  size_t num = 10000;
+  const char *tmp = mutt_str_getenv("TMPDIR");
+  char dir[PATH_MAX];
+  snprintf(dir, sizeof(dir), "%s/hcache-bench-XXXXXX", tmp ? tmp : "/tmp");
+
+  int opt;
+  while ((opt = getopt(argc, argv, "n:d:")) != -1)
+  {
+    switch (opt)
+    {
+      case 'n':
+        num = strtoul(optarg, NULL, 10);
+        break;
+      case 'd':
+        snprintf(dir, sizeof(dir), "%s/hcache-bench-XXXXXX", optarg);
+        break;
+      default:
+        fprintf(stderr, "Usage: %s [-n records] [-d directory]\n", argv[0]);
+        return 1;
+    }
+  }
+
+  if (num == 0)
+    return 1;
+
+  MuttLogger = log_disp_null;
+
+  if (!mkdtemp(dir))
+  {
+    fprintf(stderr, "Can't create directory %s\n", dir);
+    return 1;
+  }
+
+  struct Email **emails = mutt_mem_calloc(num, sizeof(struct Email *));
+  struct BenchRecord *recs = mutt_mem_calloc(num, sizeof(struct BenchRecord));
+  for (size_t i = 0; i < num; i++)
+    emails[i] = email_generate(i);
+
+  bench_serialize(emails, recs, num);
+
+  char *list = (char *) compress_list();
+  bench_backends(list, false, dir, recs, num);
+  FREE(&list);
+
+  list = (char *) store_backend_list();
+  bench_backends(list, true, dir, recs, num);
+  FREE(&list);
+
+  for (size_t i = 0; i < num; i++)
+  {
+    email_free(&emails[i]);
+    FREE(&recs[i].data);
+  }
+  FREE(&emails);
+  FREE(&recs);
+
+  mutt_file_rmtree(dir);
+  return 0;
+}
@@ -0,0 +1,491 @@
+/**
+ * @file
+ * Mbox sync benchmark
+ *
+ * @authors
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * @copyright
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * Compare two ways of saving changes to an mbox file, using a synthetic
+ * mailbox:
+ *
+ * - rewrite: copy everything after the first change to a temporary file, then
+ *   copy it back (the old mbox_mbox_sync())
+ * - plan:    back up the data that will be overwritten, then move the unchanged
+ *   messages in place and copy in only the changed ones, see
+ *   mbox_sync_plan_apply()
+ *
+ * Each scenario changes or deletes a few messages.  Both methods are applied to
+ * a copy of the mailbox and the results are compared.  Each result is printed
+ * as a single line of JSON, e.g.
+ *
+ * `{"scenario":"flag-first","method":"plan","messages":10000,"size":31457280,"bytes_written":31457292,"ms":14.2,"match":true}`
+ *
+ * Usage: mbox-bench [-n messages] [-d directory]
+ */
+
+#include "config.h"
+#include <fcntl.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include "mutt/lib.h"
+#include "mbox/sync.h"
+
+#define FLAG_HEADER "Status: RO\n" ///< Header added or removed by a change
+
+/**
+ * enum BenchAction - What happens to a message
+ */
+enum BenchAction
+{
+  BENCH_KEEP,   ///< Message is unchanged
+  BENCH_CHANGE, ///< Message is flagged, or unflagged
+  BENCH_DELETE, ///< Message is deleted
+};
+
+/**
+ * struct BenchMessage - A message in the synthetic mailbox
+ */
+struct BenchMessage
+{
+  LOFF_T offset;           ///< Offset of the From_ line
+  LOFF_T len;              ///< Length, including the blank line after it
+  bool flagged;            ///< Message has a #FLAG_HEADER
+  enum BenchAction action; ///< What the scenario does to the message
+};
+
+/**
+ * struct BenchScenario - A set of changes to the mailbox
+ */
+struct BenchScenario
+{
+  const char *name; ///< Name of the scenario
+  void (*setup)(struct BenchMessage *msgs, size_t num); ///< Choose the actions
+};
+
+/**
+ * now_ns - Get a monotonic timestamp
+ * @retval num Time in nanoseconds
+ */
+static uint64_t now_ns(void)
+{
+  struct timespec ts = { 0 };
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((uint64_t) ts.tv_sec * 1000000000) + ts.tv_nsec;
+}
+
+/**
+ * setup_flag_first - Flag the first message
+ */
+static void setup_flag_first(struct BenchMessage *msgs, size_t num)
+{
+  msgs[0].action = BENCH_CHANGE;
+}
+
+/**
+ * setup_delete_first - Delete the first message
+ */
+static void setup_delete_first(struct BenchMessage *msgs, size_t num)
+{
+  msgs[0].action = BENCH_DELETE;
+}
+
+/**
+ * setup_absorbed - Flag one message and unflag the next
+ *
+ * The second change undoes the growth of the first, so nothing after them
+ * needs to move.
+ */
+static void setup_absorbed(struct BenchMessage *msgs, size_t num)
+{
+  msgs[0].action = BENCH_CHANGE;
+  if (num > 1)
+    msgs[1].action = BENCH_CHANGE;
+}
+
+/**
+ * setup_delete_scattered - Delete every hundredth message
+ */
+static void setup_delete_scattered(struct BenchMessage *msgs, size_t num)
+{
+  for (size_t i = 0; i < num; i += 100)
+    msgs[i].action = BENCH_DELETE;
+}
+
+/**
+ * setup_flag_last - Flag the last message
+ */
+static void setup_flag_last(struct BenchMessage *msgs, size_t num)
+{
+  msgs[num - 1].action = BENCH_CHANGE;
+}
+
+static const struct BenchScenario Scenarios[] = {
+  // clang-format off
+  { "flag-first",       setup_flag_first       },
+  { "delete-first",     setup_delete_first     },
+  { "absorbed",         setup_absorbed         },
+  { "delete-scattered", setup_delete_scattered },
+  { "flag-last",        setup_flag_last        },
+  { NULL, NULL },
+  // clang-format on
+};
+
+/**
+ * mailbox_generate - Write a synthetic mailbox
+ * @param path File to create
+ * @param msgs Array for the layout of the messages
+ * @param num  Number of messages
+ * @retval num Size of the mailbox, or -1 on error
+ *
+ * Every other message is flagged.  The bodies vary in length, between about
+ * 1KiB and 5KiB.
+ */
+static LOFF_T mailbox_generate(const char *path, struct BenchMessage *msgs, size_t num)
+{
+  FILE *fp = fopen(path, "w");
+  if (!fp)
+    return -1;
+
+  for (size_t i = 0; i < num; i++)
+  {
+    msgs[i].offset = ftello(fp);
+    msgs[i].flagged = (i % 2) == 1;
+
+    fprintf(fp, "From user%zu@example.com Mon Jan  1 00:00:00 2020\n", i % 97);
+    if (msgs[i].flagged)
+      fputs(FLAG_HEADER, fp);
+    fprintf(fp, "From: user%zu@example.com\nTo: me@example.com\n"
+                "Subject: Message %zu\nMessage-ID: <%zu@bench.example.com>\n\n",
+            i % 97, i, i);
+
+    const size_t lines = 16 + ((i * 7919) % 64);
+    for (size_t j = 0; j < lines; j++)
+      fprintf(fp, "Line %zu of message %zu, padded out to a typical width.....\n", j, i);
+    fputs("\n", fp);
+
+    msgs[i].len = ftello(fp) - msgs[i].offset;
+  }
+
+  LOFF_T size = ftello(fp);
+  if (mutt_file_fclose(&fp) != 0)
+    return -1;
+  return size;
+}
+
+/**
+ * message_copy - Copy a message, applying the change to it
+ * @param fd  Mailbox file
+ * @param msg Message
+ * @param fp  File to write to
+ * @retval num Bytes written
+ */
+static LOFF_T message_copy(int fd, const struct BenchMessage *msg, FILE *fp)
+{
+  char *buf = mutt_mem_malloc(msg->len);
+  if (pread(fd, buf, msg->len, msg->offset) != msg->len)
+  {
+    FREE(&buf);
+    return 0;
+  }
+
+  LOFF_T written = msg->len;
+  if (msg->action != BENCH_CHANGE)
+  {
+    fwrite(buf, 1, msg->len, fp);
+  }
+  else
+  {
+    /* Toggle the flag header, straight after the From_ line */
+    const char *eol = memchr(buf, '\n', msg->len);
+    const size_t first = (eol - buf) + 1;
+    fwrite(buf, 1, first, fp);
+    if (msg->flagged)
+    {
+      const size_t skip = sizeof(FLAG_HEADER) - 1;
+      fwrite(buf + first + skip, 1, msg->len - first - skip, fp);
+      written -= skip;
+    }
+    else
+    {
+      fputs(FLAG_HEADER, fp);
+      fwrite(buf + first, 1, msg->len - first, fp);
+      written += sizeof(FLAG_HEADER) - 1;
+    }
+  }
+
+  FREE(&buf);
+  return written;
+}
+
+/**
+ * file_copy - Make a working copy of the mailbox
+ * @param src  Original mailbox
+ * @param dst  Copy
+ * @retval true Success
+ */
+static bool file_copy(const char *src, const char *dst)
+{
+  FILE *fp_in = fopen(src, "r");
+  FILE *fp_out = fopen(dst, "w");
+  bool rc = fp_in && fp_out && (mutt_file_copy_stream(fp_in, fp_out) >= 0);
+  mutt_file_fclose(&fp_in);
+  if (mutt_file_fclose(&fp_out) != 0)
+    rc = false;
+  return rc;
+}
+
+/**
+ * files_equal - Compare two files
+ * @param a First file
+ * @param b Second file
+ * @retval true The files are identical
+ */
+static bool files_equal(const char *a, const char *b)
+{
+  FILE *fp_a = fopen(a, "r");
+  FILE *fp_b = fopen(b, "r");
+  bool rc = fp_a && fp_b;
+  while (rc)
+  {
+    int ca = fgetc(fp_a);
+    int cb = fgetc(fp_b);
+    if (ca != cb)
+      rc = false;
+    if (ca == EOF)
+      break;
+  }
+  mutt_file_fclose(&fp_a);
+  mutt_file_fclose(&fp_b);
+  return rc;
+}
+
+/**
+ * sync_rewrite - Save the changes by rewriting the end of the mailbox
+ * @param path Mailbox file
+ * @param msgs Layout of the messages
+ * @param num  Number of messages
+ * @retval num Bytes written, or -1 on error
+ */
+static LOFF_T sync_rewrite(const char *path, struct BenchMessage *msgs, size_t num)
+{
+  size_t first = 0;
+  while ((first < num) && (msgs[first].action == BENCH_KEEP))
+    first++;
+  if (first == num)
+    return 0;
+
+  FILE *fp = fopen(path, "r+");
+  FILE *fp_tmp = tmpfile();
+  if (!fp || !fp_tmp)
+  {
+    mutt_file_fclose(&fp);
+    mutt_file_fclose(&fp_tmp);
+    return -1;
+  }
+
+  LOFF_T tail = 0;
+  for (size_t i = first; i < num; i++)
+    if (msgs[i].action != BENCH_DELETE)
+      tail += message_copy(fileno(fp), &msgs[i], fp_tmp);
+
+  fflush(fp_tmp);
+  rewind(fp_tmp);
+  fseeko(fp, msgs[first].offset, SEEK_SET);
+  int rc = mutt_file_copy_stream(fp_tmp, fp);
+  fflush(fp);
+  if ((rc >= 0) && (ftruncate(fileno(fp), msgs[first].offset + tail) != 0))
+    rc = -1;
+
+  mutt_file_fclose(&fp_tmp);
+  if ((mutt_file_fclose(&fp) != 0) || (rc < 0))
+    return -1;
+  /* The end of the mailbox is written twice: to the temporary file, then back */
+  return 2 * tail;
+}
+
+/**
+ * sync_plan - Save the changes by moving only what's needed
+ * @param path Mailbox file
+ * @param msgs Layout of the messages
+ * @param num  Number of messages
+ * @param size Size of the mailbox
+ * @retval num Bytes written, or -1 on error
+ */
+static LOFF_T sync_plan(const char *path, struct BenchMessage *msgs, size_t num, LOFF_T size)
+{
+  size_t first = 0;
+  while ((first < num) && (msgs[first].action == BENCH_KEEP))
+    first++;
+  if (first == num)
+    return 0;
+
+  FILE *fp = fopen(path, "r+");
+  FILE *fp_tmp = tmpfile();
+  FILE *fp_bak = tmpfile();
+  if (!fp || !fp_tmp || !fp_bak)
+  {
+    mutt_file_fclose(&fp);
+    mutt_file_fclose(&fp_tmp);
+    mutt_file_fclose(&fp_bak);
+    return -1;
+  }
+
+  struct MboxSyncPlan plan;
+  mbox_sync_plan_init(&plan, msgs[first].offset);
+  for (size_t i = first; i < num; i++)
+  {
+    if (msgs[i].action == BENCH_KEEP)
+    {
+      mbox_sync_plan_keep(&plan, msgs[i].offset, msgs[i].len);
+    }
+    else if (msgs[i].action == BENCH_CHANGE)
+    {
+      LOFF_T start = ftello(fp_tmp);
+      LOFF_T len = message_copy(fileno(fp), &msgs[i], fp_tmp);
+      mbox_sync_plan_write(&plan, start, len);
+    }
+  }
+  fflush(fp_tmp);
+
+  LOFF_T saved = 0;
+  int rc = mbox_sync_plan_apply(&plan, fileno(fp), fileno(fp_tmp), fileno(fp_bak), size, &saved);
+  /* Changed messages are written twice: to the temporary file, then into place.
+   * The overwritten data is written once more, to the backup file. */
+  LOFF_T written = plan.moved + (2 * plan.written) + saved;
+  mbox_sync_plan_free(&plan);
+
+  mutt_file_fclose(&fp_tmp);
+  mutt_file_fclose(&fp_bak);
+  if ((mutt_file_fclose(&fp) != 0) || (rc != 0))
+    return -1;
+  return written;
+}
+
+/**
+ * bench_scenario - Run one scenario with both methods
+ * @param sc   Scenario
+ * @param dir  Working directory
+ * @param orig Original mailbox
+ * @param msgs Layout of the messages
+ * @param num  Number of messages
+ * @param size Size of the mailbox
+ */
+static void bench_scenario(const struct BenchScenario *sc, const char *dir, const char *orig,
+                           struct BenchMessage *msgs, size_t num, LOFF_T size)
+{
+  char path_rewrite[PATH_MAX + 16];
+  char path_plan[PATH_MAX + 16];
+  snprintf(path_rewrite, sizeof(path_rewrite), "%s/rewrite", dir);
+  snprintf(path_plan, sizeof(path_plan), "%s/plan", dir);
+
+  for (size_t i = 0; i < num; i++)
+    msgs[i].action = BENCH_KEEP;
+  sc->setup(msgs, num);
+
+  if (!file_copy(orig, path_rewrite) || !file_copy(orig, path_plan))
+  {
+    fprintf(stderr, "Can't copy %s\n", orig);
+    return;
+  }
+
+  uint64_t start = now_ns();
+  LOFF_T bytes_rewrite = sync_rewrite(path_rewrite, msgs, num);
+  uint64_t time_rewrite = now_ns() - start;
+
+  start = now_ns();
+  LOFF_T bytes_plan = sync_plan(path_plan, msgs, num, size);
+  uint64_t time_plan = now_ns() - start;
+
+  const bool match = (bytes_rewrite >= 0) && (bytes_plan >= 0) &&
+                     files_equal(path_rewrite, path_plan);
+
+  printf("{\"scenario\":\"%s\",\"method\":\"rewrite\",\"messages\":%zu,\"size\":%lld,"
+         "\"bytes_written\":%lld,\"ms\":%.1f,\"match\":%s}\n",
+         sc->name, num, (long long) size, (long long) bytes_rewrite,
+         time_rewrite / 1e6, match ? "true" : "false");
+  printf("{\"scenario\":\"%s\",\"method\":\"plan\",\"messages\":%zu,\"size\":%lld,"
+         "\"bytes_written\":%lld,\"ms\":%.1f,\"match\":%s}\n",
+         sc->name, num, (long long) size, (long long) bytes_plan,
+         time_plan / 1e6, match ? "true" : "false");
+
+  unlink(path_rewrite);
+  unlink(path_plan);
+}
+
+int main(int argc, char *argv[])
+{
+  size_t num = 10000;
+  const char *tmp = mutt_str_getenv("TMPDIR");
+  char dir[PATH_MAX];
+  snprintf(dir, sizeof(dir), "%s/mbox-bench-XXXXXX", tmp ? tmp : "/tmp");
+
+  int opt;
+  while ((opt = getopt(argc, argv, "n:d:")) != -1)
+  {
+    switch (opt)
+    {
+      case 'n':
+        num = strtoul(optarg, NULL, 10);
+        break;
+      case 'd':
+        snprintf(dir, sizeof(dir), "%s/mbox-bench-XXXXXX", optarg);
+        break;
+      default:
+        fprintf(stderr, "Usage: %s [-n messages] [-d directory]\n", argv[0]);
+        return 1;
+    }
+  }
+
+  if (num == 0)
+    return 1;
+
+  MuttLogger = log_disp_null;
+
+  if (!mkdtemp(dir))
+  {
+    fprintf(stderr, "Can't create directory %s\n", dir);
+    return 1;
+  }
+
+  char orig[PATH_MAX + 16];
+  snprintf(orig, sizeof(orig), "%s/orig", dir);
+
+  struct BenchMessage *msgs = mutt_mem_calloc(num, sizeof(struct BenchMessage));
+  LOFF_T size = mailbox_generate(orig, msgs, num);
+  if (size < 0)
+  {
+    fprintf(stderr, "Can't create %s\n", orig);
+  }
+  else
+  {
+    for (const struct BenchScenario *sc = Scenarios; sc->name; sc++)
+      bench_scenario(sc, dir, orig, msgs, num, size);
+  }
+
+  FREE(&msgs);
+  mutt_file_rmtree(dir);
+  return (size < 0);
+}
@@ -27,10 +27,21 @@
 
 void test_mutt_ch_get_default_charset(void)
 {
-  // char *mutt_ch_get_default_charset(void);
+  // char *mutt_ch_get_default_charset(char *buf, size_t buflen);
 
   {
-    char *cs = mutt_ch_get_default_charset();
+    TEST_CHECK(mutt_ch_get_default_charset(NULL, 10) == NULL);
+  }
+
+  {
+    char buf[32];
+    TEST_CHECK(mutt_ch_get_default_charset(buf, 0) == NULL);
+  }
+
+  {
+    char buf[32];
+    char *cs = mutt_ch_get_default_charset(buf, sizeof(buf));
+    TEST_CHECK(cs == buf);
     TEST_CHECK(strlen(cs) != 0);
   }
 }
@@ -23,6 +23,7 @@
 #define TEST_NO_MAIN
 #include "config.h"
 #include "acutest.h"
+#include <string.h>
 #include "mutt/lib.h"
 #include "common.h"
 #include "compress/lib.h"
@@ -82,4 +83,72 @@ void test_compress_zstd(void)
   }
 
   compress_data_tests(cops, MIN_COMP_LEVEL, MAX_COMP_LEVEL);
+
+  {
+    // Dictionary
+    // void *train(const void *samples, const size_t *sizes, size_t num, size_t *dlen);
+    // bool  set_dict(void *cctx, const void *dict, size_t dlen);
+    TEST_CHECK(cops->train(NULL, NULL, 0, NULL) == NULL);
+    TEST_CHECK(!cops->set_dict(NULL, NULL, 0));
+
+    struct Buffer samples = mutt_buffer_make(0);
+    size_t sizes[500];
+    size_t num = mutt_array_size(sizes);
+    for (size_t i = 0; i < num; i++)
+    {
+      size_t before = mutt_buffer_len(&samples);
+      mutt_buffer_add_printf(&samples,
+                             "From: user%zu@example.com\nTo: list%zu@lists.example.org\n"
+                             "Subject: Re: [list] weekly report %zu\n"
+                             "Message-ID: <%zu.%zu@mail.example.com>\n",
+                             i % 17, i % 5, i, i * 7919, i * 104729);
+      sizes[i] = mutt_buffer_len(&samples) - before;
+    }
+
+    size_t dlen = 0;
+    void *dict = cops->train(samples.data, sizes, num, &dlen);
+    TEST_CHECK(dict != NULL);
+    TEST_CHECK(dlen > 0);
+
+    const char *record = "From: user3@example.com\nTo: list1@lists.example.org\n"
+                         "Subject: Re: [list] weekly report 1234\n"
+                         "Message-ID: <1234.5678@mail.example.com>\n";
+    const size_t rlen = strlen(record);
+
+    void *cctx = cops->open(MIN_COMP_LEVEL);
+    TEST_CHECK(cctx != NULL);
+
+    // Compress without the dictionary
+    size_t plain_len = 0;
+    void *cdata = cops->compress(cctx, record, rlen, &plain_len);
+    TEST_CHECK(cdata != NULL);
+    char *plain = mutt_mem_malloc(plain_len);
+    memcpy(plain, cdata, plain_len);
+
+    TEST_CHECK(cops->set_dict(cctx, dict, dlen));
+
+    size_t dict_len = 0;
+    cdata = cops->compress(cctx, record, rlen, &dict_len);
+    TEST_CHECK(cdata != NULL);
+    TEST_CHECK_(dict_len < plain_len, "%zu < %zu", dict_len, plain_len);
+    char *with_dict = mutt_mem_malloc(dict_len);
+    memcpy(with_dict, cdata, dict_len);
+
+    // Both records can be read with the dictionary
+    char *result = cops->decompress(cctx, with_dict, dict_len);
+    TEST_CHECK((result != NULL) && (memcmp(result, record, rlen) == 0));
+    result = cops->decompress(cctx, plain, plain_len);
+    TEST_CHECK((result != NULL) && (memcmp(result, record, rlen) == 0));
+    cops->close(&cctx);
+
+    // The dictionary is needed to read the record
+    cctx = cops->open(MIN_COMP_LEVEL);
+    TEST_CHECK(cops->decompress(cctx, with_dict, dict_len) == NULL);
+    cops->close(&cctx);
+
+    FREE(&with_dict);
+    FREE(&plain);
+    FREE(&dict);
+    mutt_buffer_dealloc(&samples);
+  }
 }
@@ -29,7 +29,7 @@
 
 void test_email_cmp_strict(void)
 {
-  // bool email_cmp_strict(const struct Email *e1, const struct Email *e2);
+  // bool email_cmp_strict(struct Email *e1, struct Email *e2);
 
   {
     struct Email e = { 0 };
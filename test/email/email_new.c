@@ -34,7 +34,42 @@ void test_email_new(void)
   {
     struct Email *e = email_new();
     TEST_CHECK(e != NULL);
+    TEST_CHECK((e->cold != NULL) && !e->cold_arena);
     email_free(&e);
     TEST_CHECK(e == NULL);
   }
+
+  {
+    struct Arena *a = mutt_arena_new();
+    EmailArena = a;
+    struct Email *e = email_new();
+    e->env = mutt_env_new();
+    e->content = mutt_body_new();
+    EmailArena = NULL;
+    TEST_CHECK(e->arena && !e->cold_arena && !e->env->arena && !e->content->arena);
+    TEST_CHECK(mutt_arena_size(a) >= sizeof(struct Email));
+    TEST_CHECK(mutt_arena_size(a) < sizeof(struct Email) + sizeof(struct EmailCold));
+    email_free(&e);
+    TEST_CHECK(e == NULL);
+    mutt_arena_free(&a);
+  }
+
+  {
+    struct Arena *a = mutt_arena_new();
+    struct Arena *parts = mutt_arena_new();
+    EmailArena = a;
+    EnvelopeArena = parts;
+    struct Email *e = email_new();
+    e->env = mutt_env_new();
+    e->content = mutt_body_new();
+    EmailArena = NULL;
+    EnvelopeArena = NULL;
+    TEST_CHECK(e->arena && e->cold_arena && e->env->arena && e->content->arena);
+    TEST_CHECK(mutt_arena_size(a) >= sizeof(struct Email));
+    TEST_CHECK(mutt_arena_size(parts) >= sizeof(struct EmailCold));
+    email_free(&e);
+    TEST_CHECK(e == NULL);
+    mutt_arena_free(&a);
+    mutt_arena_free(&parts);
+  }
 }
@@ -28,9 +28,15 @@
 #include "address/lib.h"
 #include "email/lib.h"
 
+static void test_restore(struct Envelope *env)
+{
+  mutt_addrlist_parse(&env->return_path, env->lazy);
+  FREE(&env->lazy);
+}
+
 void test_mutt_env_cmp_strict(void)
 {
-  // bool mutt_env_cmp_strict(const struct Envelope *e1, const struct Envelope *e2);
+  // bool mutt_env_cmp_strict(struct Envelope *e1, struct Envelope *e2);
 
   {
     struct Envelope envelope;
@@ -43,4 +49,22 @@ void test_mutt_env_cmp_strict(void)
     memset(&envelope, 0, sizeof(struct Envelope));
     TEST_CHECK(!mutt_env_cmp_strict(&envelope, NULL));
   }
+
+  {
+    // Deferred fields are restored before they're compared
+    struct Envelope *e1 = mutt_env_new();
+    mutt_str_replace(&e1->message_id, "<1@example.com>");
+    e1->lazy = mutt_str_dup("alice@example.com");
+    e1->lazy_restore = test_restore;
+
+    struct Envelope *e2 = mutt_env_new();
+    mutt_str_replace(&e2->message_id, "<1@example.com>");
+    mutt_addrlist_parse(&e2->return_path, "alice@example.com");
+
+    TEST_CHECK(mutt_env_cmp_strict(e1, e2));
+    TEST_CHECK(e1->lazy == NULL);
+
+    mutt_env_free(&e1);
+    mutt_env_free(&e2);
+  }
 }
@@ -0,0 +1,79 @@
+/**
+ * @file
+ * Test code for mutt_env_lazy_restore()
+ *
+ * @authors
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * @copyright
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define TEST_NO_MAIN
+#include "config.h"
+#include "acutest.h"
+#include "mutt/lib.h"
+#include "address/lib.h"
+#include "email/lib.h"
+
+static int restore_count = 0;
+
+static void test_restore(struct Envelope *env)
+{
+  restore_count++;
+  env->organization = mutt_intern_get(env->lazy);
+  FREE(&env->lazy);
+}
+
+void test_mutt_env_lazy_restore(void)
+{
+  // void mutt_env_lazy_restore(struct Envelope *env);
+
+  {
+    mutt_env_lazy_restore(NULL);
+    TEST_CHECK_(1, "mutt_env_lazy_restore(NULL)");
+  }
+
+  {
+    struct Envelope *env = mutt_env_new();
+    mutt_env_lazy_restore(env);
+    TEST_CHECK(env->organization == NULL);
+    mutt_env_free(&env);
+  }
+
+  {
+    restore_count = 0;
+    struct Envelope *env = mutt_env_new();
+    env->lazy = mutt_str_dup("apple");
+    env->lazy_restore = test_restore;
+
+    mutt_env_lazy_restore(env);
+    TEST_CHECK(restore_count == 1);
+    TEST_CHECK(mutt_str_equal(env->organization, "apple"));
+    TEST_CHECK(env->lazy == NULL);
+
+    mutt_env_lazy_restore(env);
+    TEST_CHECK(restore_count == 1);
+    mutt_env_free(&env);
+  }
+
+  {
+    // Free an Envelope that was never restored
+    struct Envelope *env = mutt_env_new();
+    env->lazy = mutt_str_dup("banana");
+    env->lazy_restore = test_restore;
+    mutt_env_free(&env);
+    TEST_CHECK(env == NULL);
+  }
+}
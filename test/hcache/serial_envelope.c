@@ -0,0 +1,100 @@
+/**
+ * @file
+ * Test code for the hcache Envelope records
+ *
+ * @authors
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * @copyright
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define TEST_NO_MAIN
+#include "config.h"
+#include "acutest.h"
+#include <stddef.h>
+#include "mutt/lib.h"
+#include "address/lib.h"
+#include "email/lib.h"
+#include "hcache/serialize.h"
+
+void test_hcache_serial_envelope(void)
+{
+  // unsigned char *serial_dump_envelope(struct Envelope *e, unsigned char *d, int *off, bool convert);
+  // bool serial_restore_envelope(struct Envelope *e, const unsigned char *d, size_t dlen, bool convert);
+
+  {
+    struct Envelope *env = mutt_env_new();
+    mutt_addrlist_parse(&env->from, "Alice <alice@example.com>");
+    mutt_addrlist_parse(&env->bcc, "bob@example.com");
+    env->subject = mutt_str_dup("Re: hello");
+    env->real_subj = env->subject + 4;
+    env->message_id = mutt_str_dup("<1@example.com>");
+    env->organization = mutt_intern_get("Example");
+    mutt_list_insert_tail(&env->references, mutt_str_dup("<0@example.com>"));
+
+    unsigned char *d = mutt_mem_malloc(4096);
+    int off = 0;
+    d = serial_dump_envelope(env, d, &off, false);
+    const int hot_len = off;
+    d = serial_dump_envelope_cold(env, d, &off, false);
+
+    struct Envelope *copy = mutt_env_new();
+    TEST_CHECK(serial_restore_envelope(copy, d, hot_len, false));
+    TEST_CHECK(TAILQ_EMPTY(&copy->bcc));
+    TEST_CHECK(serial_restore_envelope_cold(copy, d + hot_len, off - hot_len, false));
+
+    TEST_CHECK(mutt_addrlist_equal(&copy->from, &env->from));
+    TEST_CHECK(mutt_addrlist_equal(&copy->bcc, &env->bcc));
+    TEST_CHECK(TAILQ_EMPTY(&copy->to));
+    TEST_CHECK(mutt_str_equal(copy->subject, "Re: hello"));
+    TEST_CHECK(mutt_str_equal(copy->real_subj, "hello"));
+    TEST_CHECK(mutt_str_equal(copy->message_id, "<1@example.com>"));
+    TEST_CHECK(mutt_str_equal(copy->organization, "Example"));
+    TEST_CHECK(copy->supersedes == NULL);
+    TEST_CHECK(mutt_list_compare(&copy->references, &env->references));
+    TEST_CHECK(STAILQ_EMPTY(&copy->in_reply_to));
+
+    mutt_env_free(&copy);
+    mutt_env_free(&env);
+    FREE(&d);
+  }
+
+  {
+    // Fields the reader doesn't know about are ignored
+    struct SerialRecordWriter w = { 0 };
+    unsigned char *d = mutt_mem_malloc(4096);
+    int off = 0;
+    d = serial_record_begin(&w, 2, d, &off);
+    serial_record_field_begin(&w, &off);
+    d = serial_dump_char("apple", d, &off, false);
+    serial_record_field_end(&w, HC_ENV_TAG_SUBJECT, d, &off);
+    serial_record_field_begin(&w, &off);
+    d = serial_dump_char("banana", d, &off, false);
+    serial_record_field_end(&w, 999, d, &off);
+    serial_record_end(&w, d, &off);
+
+    struct Envelope *env = mutt_env_new();
+    TEST_CHECK(serial_restore_envelope(env, d, off, false));
+    TEST_CHECK(mutt_str_equal(env->subject, "apple"));
+    TEST_CHECK(env->real_subj == NULL);
+    TEST_CHECK(TAILQ_EMPTY(&env->from));
+
+    // A truncated record is rejected
+    TEST_CHECK(!serial_restore_envelope(env, d, off - 1, false));
+
+    mutt_env_free(&env);
+    FREE(&d);
+  }
+}
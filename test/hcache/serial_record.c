@@ -0,0 +1,89 @@
+/**
+ * @file
+ * Test code for the tagged hcache records
+ *
+ * @authors
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * @copyright
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define TEST_NO_MAIN
+#include "config.h"
+#include "acutest.h"
+#include <stdint.h>
+#include <string.h>
+#include "mutt/lib.h"
+#include "hcache/serialize.h"
+
+void test_hcache_serial_record(void)
+{
+  // bool serial_record_open(struct SerialRecord *rec, const unsigned char *d, size_t dlen);
+  // const unsigned char *serial_record_field(const struct SerialRecord *rec, uint16_t tag, size_t *len);
+  // int64_t serial_record_get_int(const struct SerialRecord *rec, uint16_t tag, int64_t def);
+
+  {
+    struct SerialRecord rec = { 0 };
+    TEST_CHECK(!serial_record_open(NULL, NULL, 0));
+    TEST_CHECK(!serial_record_open(&rec, NULL, 0));
+    TEST_CHECK(serial_record_field(NULL, 1, NULL) == NULL);
+    TEST_CHECK(serial_record_get_int(NULL, 1, 42) == 42);
+  }
+
+  {
+    struct SerialRecordWriter w = { 0 };
+    int off = 0;
+    unsigned char *d = mutt_mem_malloc(4096);
+
+    // Leave some space before the record
+    d = serial_dump_int(0xdeadbeef, d, &off);
+
+    const int start = off;
+    d = serial_record_begin(&w, 4, d, &off);
+    d = serial_record_int(&w, 7, 1234567890123LL, d, &off);
+    serial_record_field_begin(&w, &off);
+    d = serial_dump_char("apple", d, &off, false);
+    serial_record_field_end(&w, 99, d, &off); // unknown to the reader
+    d = serial_record_int(&w, 3, -5, d, &off);
+    serial_record_end(&w, d, &off); // one field unused
+
+    struct SerialRecord rec = { 0 };
+    TEST_CHECK(serial_record_open(&rec, d + start, off - start));
+    TEST_CHECK(rec.num == 3);
+    TEST_CHECK(serial_record_get_int(&rec, 7, 0) == 1234567890123LL);
+    TEST_CHECK(serial_record_get_int(&rec, 3, 0) == -5);
+    TEST_CHECK(serial_record_get_int(&rec, 5, 42) == 42);
+
+    size_t len = 0;
+    const unsigned char *field = serial_record_field(&rec, 99, &len);
+    TEST_CHECK(field != NULL);
+    char *str = NULL;
+    int foff = 0;
+    serial_restore_char(&str, field, &foff, false);
+    TEST_CHECK(mutt_str_equal(str, "apple"));
+    TEST_CHECK((size_t) foff == len);
+    FREE(&str);
+
+    // Truncated
+    TEST_CHECK(!serial_record_open(&rec, d + start, off - start - 1));
+    TEST_CHECK(!serial_record_open(&rec, d + start, 4));
+
+    // Unknown version
+    d[start] = 0xff;
+    TEST_CHECK(!serial_record_open(&rec, d + start, off - start));
+
+    FREE(&d);
+  }
+}
@@ -0,0 +1,53 @@
+/**
+ * @file
+ * Test code for mutt_intern_get()
+ *
+ * @authors
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * @copyright
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define TEST_NO_MAIN
+#include "config.h"
+#include "acutest.h"
+#include "mutt/lib.h"
+
+void test_mutt_intern_get(void)
+{
+  // char *mutt_intern_get(const char *str);
+
+  {
+    TEST_CHECK(mutt_intern_get(NULL) == NULL);
+    TEST_CHECK(mutt_intern_get("") == NULL);
+  }
+
+  {
+    const size_t count = mutt_intern_count();
+    char buf[32] = "apple";
+    char *s1 = mutt_intern_get(buf);
+    char *s2 = mutt_intern_get("apple");
+    char *s3 = mutt_intern_get("banana");
+    TEST_CHECK(s1 != buf);
+    TEST_CHECK(mutt_str_equal(s1, "apple"));
+    TEST_CHECK(s1 == s2);
+    TEST_CHECK(s1 != s3);
+    TEST_CHECK(mutt_intern_count() == (count + 2));
+    mutt_intern_release(&s1);
+    mutt_intern_release(&s2);
+    mutt_intern_release(&s3);
+    TEST_CHECK(mutt_intern_count() == count);
+  }
+}
@@ -0,0 +1,54 @@
+/**
+ * @file
+ * Test code for mutt_intern_release()
+ *
+ * @authors
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * @copyright
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define TEST_NO_MAIN
+#include "config.h"
+#include "acutest.h"
+#include "mutt/lib.h"
+
+void test_mutt_intern_release(void)
+{
+  // void mutt_intern_release(char **ptr);
+
+  {
+    mutt_intern_release(NULL);
+    TEST_CHECK_(1, "mutt_intern_release(NULL)");
+  }
+
+  {
+    char *s = NULL;
+    mutt_intern_release(&s);
+    TEST_CHECK_(1, "mutt_intern_release(&s)");
+  }
+
+  {
+    const size_t count = mutt_intern_count();
+    char *s1 = mutt_intern_get("cherry");
+    char *s2 = mutt_intern_get("cherry");
+    mutt_intern_release(&s1);
+    TEST_CHECK(s1 == NULL);
+    TEST_CHECK(mutt_str_equal(s2, "cherry"));
+    TEST_CHECK(mutt_intern_count() == (count + 1));
+    mutt_intern_release(&s2);
+    TEST_CHECK(mutt_intern_count() == count);
+  }
+}
@@ -66,6 +66,12 @@
   NEOMUTT_TEST_ITEM(test_mutt_addrlist_write)                                  \
   NEOMUTT_TEST_ITEM(test_mutt_addrlist_write_list)                             \
                                                                                \
+  /* arena */                                                                  \
+  NEOMUTT_TEST_ITEM(test_mutt_arena_calloc)                                    \
+  NEOMUTT_TEST_ITEM(test_mutt_arena_free)                                      \
+  NEOMUTT_TEST_ITEM(test_mutt_arena_new)                                       \
+  NEOMUTT_TEST_ITEM(test_mutt_arena_size)                                      \
+                                                                               \
   /* attach */                                                                 \
   NEOMUTT_TEST_ITEM(test_mutt_actx_add_attach)                                 \
   NEOMUTT_TEST_ITEM(test_mutt_actx_add_body)                                   \
@@ -184,6 +190,7 @@
   /* envelope */                                                               \
   NEOMUTT_TEST_ITEM(test_mutt_env_cmp_strict)                                  \
   NEOMUTT_TEST_ITEM(test_mutt_env_free)                                        \
+  NEOMUTT_TEST_ITEM(test_mutt_env_lazy_restore)                                \
   NEOMUTT_TEST_ITEM(test_mutt_env_merge)                                       \
   NEOMUTT_TEST_ITEM(test_mutt_env_new)                                         \
   NEOMUTT_TEST_ITEM(test_mutt_env_to_intl)                                     \
@@ -298,6 +305,12 @@
   NEOMUTT_TEST_ITEM(test_mutt_idna_print_version)                              \
   NEOMUTT_TEST_ITEM(test_mutt_idna_to_ascii_lz)                                \
                                                                                \
+  /* intern */                                                                 \
+  NEOMUTT_TEST_ITEM(test_mutt_intern_count)                                    \
+  NEOMUTT_TEST_ITEM(test_mutt_intern_get)                                      \
+  NEOMUTT_TEST_ITEM(test_mutt_intern_release)                                  \
+  NEOMUTT_TEST_ITEM(test_mutt_intern_replace)                                  \
+                                                                               \
   /* list */                                                                   \
   NEOMUTT_TEST_ITEM(test_mutt_list_clear)                                      \
   NEOMUTT_TEST_ITEM(test_mutt_list_compare)                                    \
@@ -388,6 +401,9 @@
   NEOMUTT_TEST_ITEM(test_notify_send)                                          \
   NEOMUTT_TEST_ITEM(test_notify_set_parent)                                    \
                                                                                \
+  /* parallel */                                                               \
+  NEOMUTT_TEST_ITEM(test_mutt_parallel_run)                                    \
+                                                                               \
   /* parameter */                                                              \
   NEOMUTT_TEST_ITEM(test_mutt_param_cmp_strict)                                \
   NEOMUTT_TEST_ITEM(test_mutt_param_delete)                                    \
@@ -564,6 +580,10 @@
 // clang-format off
 #define NEOMUTT_TEST_ITEM(x) void x(void);
 NEOMUTT_TEST_LIST
+#ifdef USE_HCACHE
+  NEOMUTT_TEST_ITEM(test_hcache_serial_envelope)
+  NEOMUTT_TEST_ITEM(test_hcache_serial_record)
+#endif
 #if defined(USE_LZ4) || defined(USE_ZLIB) || defined(USE_ZSTD)
   NEOMUTT_TEST_ITEM(test_compress_common)
 #endif
@@ -577,6 +597,7 @@ NEOMUTT_TEST_LIST
   NEOMUTT_TEST_ITEM(test_compress_zstd)
 #endif
 #if defined(HAVE_BDB) || defined(HAVE_GDBM) || defined(HAVE_KC) || defined(HAVE_LMDB) || defined(HAVE_QDBM) || defined(HAVE_ROCKSDB) || defined(HAVE_TC) || defined(HAVE_TDB)
+  NEOMUTT_TEST_ITEM(test_store_lru)
   NEOMUTT_TEST_ITEM(test_store_store)
 #endif
 #ifdef HAVE_BDB
@@ -608,6 +629,10 @@ NEOMUTT_TEST_LIST
 TEST_LIST = {
 #define NEOMUTT_TEST_ITEM(x) { #x, x },
   NEOMUTT_TEST_LIST
+#ifdef USE_HCACHE
+  NEOMUTT_TEST_ITEM(test_hcache_serial_envelope)
+  NEOMUTT_TEST_ITEM(test_hcache_serial_record)
+#endif
 #if defined(USE_LZ4) || defined(USE_ZLIB) || defined(USE_ZSTD)
 NEOMUTT_TEST_ITEM(test_compress_common)
 #endif
@@ -621,6 +646,7 @@ NEOMUTT_TEST_ITEM(test_compress_common)
   NEOMUTT_TEST_ITEM(test_compress_zstd)
 #endif
 #if defined(HAVE_BDB) || defined(HAVE_GDBM) || defined(HAVE_KC) || defined(HAVE_LMDB) || defined(HAVE_QDBM) || defined(HAVE_ROCKSDB) || defined(HAVE_TC) || defined(HAVE_TDB)
+  NEOMUTT_TEST_ITEM(test_store_lru)
   NEOMUTT_TEST_ITEM(test_store_store)
 #endif
 #ifdef HAVE_BDB
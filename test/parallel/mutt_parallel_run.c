@@ -0,0 +1,113 @@
+/**
+ * @file
+ * Test code for mutt_parallel_run()
+ *
+ * @authors
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * @copyright
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define TEST_NO_MAIN
+#include "config.h"
+#include "acutest.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include "mutt/lib.h"
+
+#define NUM_ITEMS 200
+
+/**
+ * count_one - Count the visits to an item - Implements ::parallel_work_t
+ */
+static void count_one(void *data, size_t i)
+{
+  int *counts = data;
+  counts[i]++;
+}
+
+/**
+ * slow_one - Count the visits to an item, slowly - Implements ::parallel_work_t
+ */
+static void slow_one(void *data, size_t i)
+{
+  mutt_date_sleep_ms(1);
+  count_one(data, i);
+}
+
+/**
+ * stop_now - Stop the job - Implements ::parallel_wait_t
+ */
+static bool stop_now(void *data, size_t done)
+{
+  return false;
+}
+
+/**
+ * carry_on - Let the job run - Implements ::parallel_wait_t
+ */
+static bool carry_on(void *data, size_t done)
+{
+  return done <= NUM_ITEMS;
+}
+
+void test_mutt_parallel_run(void)
+{
+  // bool mutt_parallel_run(parallel_work_t work, parallel_wait_t wait, void *data, size_t num, int threads);
+
+  {
+    TEST_CHECK(mutt_parallel_run(NULL, NULL, NULL, 10, 4));
+  }
+
+  {
+    TEST_CHECK(mutt_parallel_run(count_one, NULL, NULL, 0, 4));
+  }
+
+  static const int threads[] = { 0, 1, 4, 1000 };
+  for (size_t t = 0; t < mutt_array_size(threads); t++)
+  {
+    TEST_CASE_("%d threads", threads[t]);
+    int counts[NUM_ITEMS] = { 0 };
+    TEST_CHECK(mutt_parallel_run(count_one, carry_on, counts, NUM_ITEMS, threads[t]));
+
+    for (size_t i = 0; i < NUM_ITEMS; i++)
+    {
+      if (!TEST_CHECK(counts[i] == 1))
+        TEST_MSG("Item %zu processed %d times", i, counts[i]);
+    }
+  }
+
+  {
+    TEST_CASE("stopped, serial");
+    int counts[NUM_ITEMS] = { 0 };
+    TEST_CHECK(!mutt_parallel_run(count_one, stop_now, counts, NUM_ITEMS, 1));
+    for (size_t i = 0; i < NUM_ITEMS; i++)
+      TEST_CHECK(counts[i] == 0);
+  }
+
+  {
+    TEST_CASE("stopped, threaded");
+    int counts[NUM_ITEMS] = { 0 };
+    bool rc = mutt_parallel_run(slow_one, stop_now, counts, NUM_ITEMS, 4);
+    size_t done = 0;
+    for (size_t i = 0; i < NUM_ITEMS; i++)
+    {
+      TEST_CHECK(counts[i] <= 1);
+      done += counts[i];
+    }
+    // The workers may have finished before the job could be stopped
+    TEST_CHECK(rc == (done == NUM_ITEMS));
+  }
+}
@@ -94,6 +94,11 @@ int mutt_body_handler(struct Body *b, struct State *s)
   return -1;
 }
 
+bool mutt_body_is_verbatim(struct Body *b)
+{
+  return false;
+}
+
 void mutt_clear_error(void)
 {
 }
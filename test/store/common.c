@@ -24,6 +24,7 @@
 #include "config.h"
 #include "acutest.h"
 #include <stdbool.h>
+#include <string.h>
 #include "mutt/lib.h"
 #include "test_common.h"
 #include "store/lib.h"
@@ -79,6 +80,35 @@ bool test_store_degenerate(const struct StoreOps *sops, const char *name)
   return true;
 }
 
+static bool test_store_walk_cb(const char *key, size_t klen, void *data)
+{
+  size_t *count = data;
+  if (((klen == 3) && (memcmp(key, "two", 3) == 0)) ||
+      ((klen == 5) && (memcmp(key, "three", 5) == 0)))
+  {
+    (*count)++;
+  }
+  return true;
+}
+
+struct TestStoreWalk
+{
+  char key[32];
+  size_t klen;
+  bool counted;
+};
+
+static bool test_store_walk_first_cb(const char *key, size_t klen, void *data)
+{
+  struct TestStoreWalk *tw = data;
+  size_t count = 0;
+  test_store_walk_cb(key, klen, &count);
+  tw->counted = (count == 1);
+  tw->klen = MIN(klen, sizeof(tw->key));
+  memcpy(tw->key, key, tw->klen);
+  return false;
+}
+
 bool test_store_db(const struct StoreOps *sops, void *db)
 {
   if (!sops || !db)
@@ -107,5 +137,64 @@ bool test_store_db(const struct StoreOps *sops, void *db)
   if (!TEST_CHECK(rc == 0))
     return false;
 
+  struct StoreKv kvs[3] = {
+    { "two", 3, "zyxwvutsrq", 10 },
+    { "three", 5, "0123456789", 10 },
+    { "four", 4, "", 0 },
+  };
+
+  rc = store_store_many(sops, db, kvs, 2);
+  if (!TEST_CHECK(rc == 0))
+    return false;
+
+  if (!TEST_CHECK(store_fetch_many(sops, db, kvs, 3) == 2))
+    return false;
+
+  if (!TEST_CHECK((kvs[0].vlen == 10) && (memcmp(kvs[0].value, "zyxwvutsrq", 10) == 0)))
+    return false;
+
+  if (!TEST_CHECK((kvs[1].vlen == 10) && (memcmp(kvs[1].value, "0123456789", 10) == 0)))
+    return false;
+
+  if (!TEST_CHECK(kvs[2].value == NULL))
+    return false;
+
+  for (size_t i = 0; i < 3; i++)
+    sops->free(db, &kvs[i].value);
+
+  if (sops->walk)
+  {
+    size_t count = 0;
+    if (!TEST_CHECK(sops->walk(db, NULL, 0, test_store_walk_cb, &count) == 0))
+      return false;
+
+    if (!TEST_CHECK(count == 2))
+      return false;
+
+    // Resume the walk after the first key
+    struct TestStoreWalk tw = { 0 };
+    if (!TEST_CHECK(sops->walk(db, NULL, 0, test_store_walk_first_cb, &tw) == 0))
+      return false;
+
+    count = 0;
+    if (!TEST_CHECK(sops->walk(db, tw.key, tw.klen, test_store_walk_cb, &count) == 0))
+      return false;
+
+    if (!TEST_CHECK(count == (tw.counted ? 1 : 2)))
+      return false;
+  }
+
+  if (sops->compact)
+  {
+    if (!TEST_CHECK(sops->compact(db) == 0))
+      return false;
+
+    vlen = 0;
+    data = sops->fetch(db, "three", 5, &vlen);
+    if (!TEST_CHECK((data != NULL) && (vlen == 10)))
+      return false;
+    sops->free(db, &data);
+  }
+
   return true;
 }
@@ -0,0 +1,119 @@
+/**
+ * @file
+ * Test code for the in-memory LRU Store
+ *
+ * @authors
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * @copyright
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define TEST_NO_MAIN
+#include "config.h"
+#include "acutest.h"
+#include <limits.h>
+#include <string.h>
+#include "mutt/lib.h"
+#include "common.h"
+#include "store/lib.h"
+
+#define DB_NAME "lru"
+
+void test_store_lru(void)
+{
+  char path[PATH_MAX];
+
+  const struct StoreOps *sops = store_get_backend_ops(NULL);
+  TEST_CHECK(sops != NULL);
+
+  TEST_CHECK(test_store_degenerate(&store_lru_ops, DB_NAME) == true);
+  TEST_CHECK(store_lru_wrap(sops, NULL, "x", 1024) == NULL);
+
+  TEST_CHECK(test_store_setup(path, sizeof(path)) == true);
+
+  mutt_str_cat(path, sizeof(path), "/");
+  mutt_str_cat(path, sizeof(path), sops->name);
+
+  void *db = sops->open(path);
+  TEST_CHECK(db != NULL);
+
+  void *lru = store_lru_wrap(sops, db, path, 4096);
+  TEST_CHECK(lru != NULL);
+
+  TEST_CHECK(test_store_db(&store_lru_ops, lru) == true);
+
+  // A cached record survives the backend losing it
+  const char *key = "cached";
+  const char *value = "0123456789";
+  TEST_CHECK(store_lru_ops.store(lru, key, strlen(key), (void *) value, 10) == 0);
+  TEST_CHECK(sops->delete_record(db, key, strlen(key)) == 0);
+
+  size_t vlen = 0;
+  void *data = store_lru_ops.fetch(lru, key, strlen(key), &vlen);
+  TEST_CHECK((data != NULL) && (vlen == 10) && (memcmp(data, value, 10) == 0));
+  store_lru_ops.free(lru, &data);
+
+  // Fill the cache until the record is discarded
+  char big[512] = { 0 };
+  char bkey[32];
+  for (int i = 0; i < 16; i++)
+  {
+    snprintf(bkey, sizeof(bkey), "big%d", i);
+    TEST_CHECK(store_lru_ops.store(lru, bkey, strlen(bkey), big, sizeof(big)) == 0);
+  }
+
+  data = store_lru_ops.fetch(lru, key, strlen(key), &vlen);
+  TEST_CHECK(data == NULL);
+
+  store_lru_ops.close(&lru);
+  TEST_CHECK(lru == NULL);
+
+  // A reopened Store sees the records cached by the old one
+  db = sops->open(path);
+  TEST_CHECK(db != NULL);
+  lru = store_lru_wrap(sops, db, path, 4096);
+  TEST_CHECK(lru != NULL);
+  TEST_CHECK(store_lru_ops.store(lru, key, strlen(key), (void *) value, 10) == 0);
+  store_lru_ops.close(&lru);
+
+  db = sops->open(path);
+  TEST_CHECK(db != NULL);
+  lru = store_lru_wrap(sops, db, path, 4096);
+  TEST_CHECK(lru != NULL);
+  TEST_CHECK(sops->delete_record(db, key, strlen(key)) == 0);
+  data = store_lru_ops.fetch(lru, key, strlen(key), &vlen);
+  TEST_CHECK((data != NULL) && (vlen == 10) && (memcmp(data, value, 10) == 0));
+  store_lru_ops.free(lru, &data);
+  TEST_CHECK(store_lru_ops.store(lru, key, strlen(key), (void *) value, 10) == 0);
+  store_lru_ops.close(&lru);
+
+  // Unless the database was changed after it was closed
+  const char *value2 = "abcdefghijklmnopqrst";
+  db = sops->open(path);
+  TEST_CHECK(db != NULL);
+  TEST_CHECK(sops->store(db, key, strlen(key), (void *) value2, 20) == 0);
+  sops->close(&db);
+
+  db = sops->open(path);
+  TEST_CHECK(db != NULL);
+  lru = store_lru_wrap(sops, db, path, 4096);
+  TEST_CHECK(lru != NULL);
+  data = store_lru_ops.fetch(lru, key, strlen(key), &vlen);
+  TEST_CHECK((data != NULL) && (vlen == 20) && (memcmp(data, value2, 20) == 0));
+  store_lru_ops.free(lru, &data);
+  store_lru_ops.close(&lru);
+
+  store_lru_cleanup();
+}